@@ -22,6 +22,10 @@
 
 const struct gdb_exception exception_none = { (enum return_reason) 0, GDB_NO_ERROR, NULL };
 
+/* See common-exceptions.h.  */
+
+int exceptions_thread_confined;
+
 /* Possible catcher states.  */
 enum catcher_state {
   /* Initial state, a new catcher has just been created.  */
@@ -286,7 +290,10 @@ throw_exception_sjlj (struct gdb_exception exception)
 static ATTRIBUTE_NORETURN void
 throw_exception_cxx (struct gdb_exception exception)
 {
-  do_cleanups (all_cleanups ());
+  /* The cleanup chain belongs to the main thread; leave it alone when
+     several threads may be throwing.  */
+  if (!exceptions_thread_confined)
+    do_cleanups (all_cleanups ());
 
   if (exception.reason == RETURN_QUIT)
     {
@@ -345,6 +352,18 @@ throw_it (enum return_reason reason, enum errors error, const char *fmt,
   int depth = try_scope_depth;
 #endif
 
+#if GDB_XCPT != GDB_XCPT_SJMP
+  if (exceptions_thread_confined)
+    {
+      /* The message stack is shared by all threads, so the catcher
+	 takes ownership of the message instead.  */
+      e.reason = reason;
+      e.error = error;
+      e.message = xstrvprintf (fmt, ap);
+      throw_exception (e);
+    }
+#endif
+
   gdb_assert (depth > 0);
 
   /* Note: The new message may use an old message's text.  */
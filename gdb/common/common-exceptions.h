@@ -311,6 +311,14 @@ extern void throw_error (enum errors error, const char *fmt, ...)
 extern void throw_quit (const char *fmt, ...)
      ATTRIBUTE_NORETURN ATTRIBUTE_PRINTF (1, 2);
 
+/* Non-zero while code may be throwing exceptions from more than one
+   thread at a time (see worker-threads.h in GDB).  Throwing then
+   neither runs the cleanup chain nor uses the shared message stack:
+   the message is allocated with xstrvprintf and must be freed by the
+   code that catches the exception.  This is only supported when
+   exceptions are mapped to C++ try/catch.  */
+extern int exceptions_thread_confined;
+
 /* A pre-defined non-exception.  */
 extern const struct gdb_exception exception_none;
 
@@ -21,6 +21,7 @@
 #include "complaints.h"
 #include "command.h"
 #include "gdbcmd.h"
+#include "worker-threads.h"
 
 extern void _initialize_complaints (void);
 
@@ -160,11 +161,33 @@ vcomplaint (struct complaints **c, const char *file,
 	    int line, const char *fmt,
 	    va_list args)
 {
-  struct complaints *complaints = get_complaints (c);
-  struct complain *complaint = find_complaint (complaints, file, 
-					       line, fmt);
+  struct complaints *complaints;
+  struct complain *complaint;
   enum complaint_series series;
 
+  if (worker_threads_active ())
+    {
+      int silent;
+
+      /* Worker threads may only count complaints.  One that has to be
+	 printed makes the worker give its job back to the main thread,
+	 which will then issue the complaint itself.  */
+      worker_threads_lock ();
+      complaints = get_complaints (c);
+      complaint = find_complaint (complaints, file, line, fmt);
+      silent = complaint->counter >= stop_whining;
+      if (silent)
+	complaint->counter++;
+      worker_threads_unlock ();
+
+      if (!silent)
+	error (_("complaint issued on a worker thread"));
+      return;
+    }
+
+  complaints = get_complaints (c);
+  complaint = find_complaint (complaints, file, line, fmt);
+
   gdb_assert (complaints != NULL);
 
   complaint->counter++;
@@ -70,6 +70,8 @@
 #include "filestuff.h"
 #include "build-id.h"
 #include "namespace.h"
+#include "worker-threads.h"
+#include "index-cache.h"
 
 #include <fcntl.h>
 #include <sys/types.h>
@@ -294,6 +296,10 @@ struct dwarf2_per_objfile
   /* The mapped index, or NULL if .gdb_index is missing or not being used.  */
   struct mapped_index *index_table;
 
+  /* If INDEX_TABLE was read from the index cache rather than from the
+     .gdb_index section, the cache entry holding it.  */
+  struct index_cache_entry index_cache_entry;
+
   /* When using index_table, this keeps track of all quick_file_names entries.
      TUs typically share line table entries with a CU, so we maintain a
      separate table of all line table entries to support the sharing.
@@ -425,6 +431,30 @@ struct delayed_method_info
 typedef struct delayed_method_info delayed_method_info;
 DEF_VEC_O (delayed_method_info);
 
+/* A partial symbol found by load_partial_dies while prescanning a CU
+   on a worker thread.  Adding it to the objfile is left to the main
+   thread; see finish_prescanned_partial_dies.  */
+
+struct deferred_psymbol
+{
+  /* The name of the symbol.  */
+  const char *name;
+
+  /* Non-zero if NAME still has to be passed through
+     dwarf2_canonicalize_name.  */
+  int canonicalize;
+
+  /* The address class of the symbol.  */
+  enum address_class aclass;
+
+  /* Non-zero if the symbol goes to the objfile's global partial
+     symbols, zero if it goes to the static ones.  */
+  int is_global;
+};
+
+typedef struct deferred_psymbol deferred_psymbol;
+DEF_VEC_O (deferred_psymbol);
+
 /* Internal state when decoding a particular compilation unit.  */
 struct dwarf2_cu
 {
@@ -555,6 +585,15 @@ struct dwarf2_cu
      this information, but later versions do.  */
 
   unsigned int processing_has_namespace_info : 1;
+
+  /* Set while this CU is being prescanned on a worker thread by
+     prescan_psymtab_comp_unit.  Anything that would change state
+     outside the CU is then either deferred or refused.  */
+  unsigned int prescanning : 1;
+
+  /* The partial symbols found while prescanning, in the order they
+     were found.  */
+  VEC (deferred_psymbol) *deferred_psymbols;
 };
 
 /* Persistent data held for a compilation unit, even when not
@@ -1127,6 +1166,11 @@ struct partial_die_info
     /* Flag set if spec_offset uses DW_FORM_GNU_ref_alt.  */
     unsigned int spec_is_dwz : 1;
 
+    /* Flag set if NAME has not been passed through
+       dwarf2_canonicalize_name yet, because the DIE was read on a
+       worker thread.  */
+    unsigned int needs_canonical_name : 1;
+
     /* The name of this DIE.  Normally the value of DW_AT_name, but
        sometimes a default name for unnamed DIEs.  */
     const char *name;
@@ -1404,6 +1448,8 @@ static struct partial_symtab *create_partial_symtab
 
 static void dwarf2_build_psymtabs_hard (struct objfile *);
 
+static void dwarf2_store_index_cache (struct objfile *);
+
 static void scan_partial_symbols (struct partial_die_info *,
 				  CORE_ADDR *, CORE_ADDR *,
 				  int, struct dwarf2_cu *);
@@ -1807,6 +1853,9 @@ static struct dwarf2_per_cu_data *dwarf2_find_containing_comp_unit
 static void init_one_comp_unit (struct dwarf2_cu *cu,
 				struct dwarf2_per_cu_data *per_cu);
 
+static void init_worker_comp_unit (struct dwarf2_cu *cu,
+				   struct dwarf2_per_cu_data *per_cu);
+
 static void prepare_one_comp_unit (struct dwarf2_cu *cu,
 				   struct die_info *comp_unit_die,
 				   enum language pretend_language);
@@ -1829,6 +1878,9 @@ static int create_all_type_units (struct objfile *);
 static void load_full_comp_unit (struct dwarf2_per_cu_data *,
 				 enum language);
 
+static void dw2_expand_cus (struct objfile *, VEC (dwarf2_per_cu_ptr) *,
+			    expand_symtabs_exp_notify_ftype *, void *);
+
 static void process_full_comp_unit (struct dwarf2_per_cu_data *,
 				    enum language);
 
@@ -2303,6 +2355,13 @@ dwarf2_read_section (struct objfile *objfile, struct dwarf2_section_info *info)
 
   if (info->readin)
     return;
+
+  /* Worker threads can only use sections that were read in before
+     they started; see process_psymtab_comp_units_in_parallel.  */
+  if (worker_threads_active ())
+    error (_("Dwarf Error: section %s not read in advance [in module %s]"),
+	   get_section_name (info), get_section_file_name (info));
+
   info->buffer = NULL;
   info->readin = 1;
 
@@ -2488,6 +2547,9 @@ dwarf2_get_dwz_file (void)
   if (dwarf2_per_objfile->dwz_file != NULL)
     return dwarf2_per_objfile->dwz_file;
 
+  if (worker_threads_active ())
+    error (_("could not open '.gnu_debugaltlink' file on a worker thread"));
+
   bfd_set_error (bfd_error_no_error);
   data = bfd_get_alt_debug_link_info (dwarf2_per_objfile->objfile->obfd,
 				      &buildid_len_arg, &buildid);
@@ -2683,7 +2745,11 @@ create_quick_file_names_table (unsigned int nr_initial_entries)
 static void
 load_cu (struct dwarf2_per_cu_data *per_cu)
 {
-  if (per_cu->is_debug_types)
+  /* The DIEs may have been read ahead by a worker thread; see
+     dw2_expand_cus.  */
+  if (per_cu->cu != NULL && per_cu->cu->dies != NULL)
+    ;
+  else if (per_cu->is_debug_types)
     load_full_type_unit (per_cu);
   else
     load_full_comp_unit (per_cu, language_minimal);
@@ -3061,44 +3127,25 @@ find_slot_in_mapped_hash (struct mapped_index *index, const char *name,
     }
 }
 
-/* A helper function that reads the .gdb_index from SECTION and fills
-   in MAP.  FILENAME is the name of the file containing the section;
-   it is used for error reporting.  DEPRECATED_OK is nonzero if it is
-   ok to use deprecated sections.
-
-   CU_LIST, CU_LIST_ELEMENTS, TYPES_LIST, and TYPES_LIST_ELEMENTS are
-   out parameters that are filled in with information about the CU and
-   TU lists in the section.
-
-   Returns 1 if all went well, 0 otherwise.  */
+/* A helper function that reads the index contents ADDR, SIZE bytes
+   long, and fills in MAP.  The other arguments are as for
+   read_index_from_section.  */
 
 static int
-read_index_from_section (struct objfile *objfile,
-			 const char *filename,
-			 int deprecated_ok,
-			 struct dwarf2_section_info *section,
-			 struct mapped_index *map,
-			 const gdb_byte **cu_list,
-			 offset_type *cu_list_elements,
-			 const gdb_byte **types_list,
-			 offset_type *types_list_elements)
+read_index_from_buffer (const char *filename,
+			int deprecated_ok,
+			const gdb_byte *addr,
+			bfd_size_type size,
+			struct mapped_index *map,
+			const gdb_byte **cu_list,
+			offset_type *cu_list_elements,
+			const gdb_byte **types_list,
+			offset_type *types_list_elements)
 {
-  const gdb_byte *addr;
   offset_type version;
   offset_type *metadata;
   int i;
 
-  if (dwarf2_section_empty_p (section))
-    return 0;
-
-  /* Older elfutils strip versions could keep the section in the main
-     executable while splitting it for the separate debug info file.  */
-  if ((get_section_flags (section) & SEC_HAS_CONTENTS) == 0)
-    return 0;
-
-  dwarf2_read_section (objfile, section);
-
-  addr = section->buffer;
   /* Version check.  */
   version = MAYBE_SWAP (*(offset_type *) addr);
   /* Versions earlier than 3 emitted every copy of a psymbol.  This
@@ -3152,7 +3199,7 @@ to use the section anyway."),
     return 0;
 
   map->version = version;
-  map->total_size = section->size;
+  map->total_size = size;
 
   metadata = (offset_type *) (addr + sizeof (offset_type));
 
@@ -3184,6 +3231,118 @@ to use the section anyway."),
   return 1;
 }
 
+/* A helper function that reads the .gdb_index from SECTION and fills
+   in MAP.  FILENAME is the name of the file containing the section;
+   it is used for error reporting.  DEPRECATED_OK is nonzero if it is
+   ok to use deprecated sections.
+
+   CU_LIST, CU_LIST_ELEMENTS, TYPES_LIST, and TYPES_LIST_ELEMENTS are
+   out parameters that are filled in with information about the CU and
+   TU lists in the section.
+
+   Returns 1 if all went well, 0 otherwise.  */
+
+static int
+read_index_from_section (struct objfile *objfile,
+			 const char *filename,
+			 int deprecated_ok,
+			 struct dwarf2_section_info *section,
+			 struct mapped_index *map,
+			 const gdb_byte **cu_list,
+			 offset_type *cu_list_elements,
+			 const gdb_byte **types_list,
+			 offset_type *types_list_elements)
+{
+  if (dwarf2_section_empty_p (section))
+    return 0;
+
+  /* Older elfutils strip versions could keep the section in the main
+     executable while splitting it for the separate debug info file.  */
+  if ((get_section_flags (section) & SEC_HAS_CONTENTS) == 0)
+    return 0;
+
+  dwarf2_read_section (objfile, section);
+
+  return read_index_from_buffer (filename, deprecated_ok,
+				 section->buffer, section->size, map,
+				 cu_list, cu_list_elements,
+				 types_list, types_list_elements);
+}
+
+/* Return non-zero if OBJFILE uses a separate '.dwz' debug file.
+   Unlike dwarf2_get_dwz_file, this only looks for the
+   .gnu_debugaltlink section, and never errors out because the file
+   cannot be found.  */
+
+static int
+objfile_has_dwz_link (struct objfile *objfile)
+{
+  return bfd_get_section_by_name (objfile->obfd, ".gnu_debugaltlink") != NULL;
+}
+
+/* Like read_index_from_section, but read the index OBJFILE's entry in
+   the index cache, if there is one.  On success, the entry is kept in
+   dwarf2_per_objfile->index_cache_entry.  */
+
+static int
+read_index_from_cache (struct objfile *objfile,
+		       struct mapped_index *map,
+		       const gdb_byte **cu_list,
+		       offset_type *cu_list_elements,
+		       const gdb_byte **types_list,
+		       offset_type *types_list_elements)
+{
+  const struct bfd_build_id *build_id;
+  struct index_cache_entry entry;
+  offset_type i;
+
+  if (!index_cache_enabled_p ())
+    return 0;
+
+  /* The cache only holds indices GDB wrote itself, which never cover
+     a .dwz file; see dwarf2_store_index_cache.  */
+  build_id = build_id_bfd_get (objfile->obfd);
+  if (build_id == NULL || objfile_has_dwz_link (objfile))
+    return 0;
+
+  if (!index_cache_lookup (build_id, &entry))
+    return 0;
+
+  if (entry.size < 7 * sizeof (offset_type)
+      || !read_index_from_buffer (objfile_name (objfile), 0,
+			       entry.data, entry.size, map,
+			       cu_list, cu_list_elements,
+			       types_list, types_list_elements))
+    {
+      index_cache_release (&entry);
+      return 0;
+    }
+
+  /* The build-id should guarantee that the index matches the file,
+     but a corrupt or foreign cache entry must not send the reader
+     outside .debug_info.  */
+  dwarf2_read_section (objfile, &dwarf2_per_objfile->info);
+  for (i = 0; i < *cu_list_elements; i += 2)
+    {
+      ULONGEST offset = extract_unsigned_integer (*cu_list + i * 8, 8,
+						  BFD_ENDIAN_LITTLE);
+      ULONGEST length = extract_unsigned_integer (*cu_list + i * 8 + 8, 8,
+						  BFD_ENDIAN_LITTLE);
+
+      if (offset > dwarf2_per_objfile->info.size
+	  || length > dwarf2_per_objfile->info.size - offset)
+	{
+	  warning (_("Ignoring invalid cached index for %s."),
+		   objfile_name (objfile));
+	  index_cache_release (&entry);
+	  return 0;
+	}
+    }
+
+  dwarf2_per_objfile->index_cache_entry = entry;
+  return 1;
+}
+
 
 /* Read the index file.  If everything went ok, initialize the "quick"
    elements of all the CUs and return 1.  Otherwise, return 0.  */
@@ -3200,7 +3359,10 @@ dwarf2_read_index (struct objfile *objfile)
 				use_deprecated_index_sections,
 				&dwarf2_per_objfile->gdb_index, &local_map,
 				&cu_list, &cu_list_elements,
-				&types_list, &types_list_elements))
+				&types_list, &types_list_elements)
+      && !read_index_from_cache (objfile, &local_map,
+				 &cu_list, &cu_list_elements,
+				 &types_list, &types_list_elements))
     return 0;
 
   /* Don't use the index if it's empty.  */
@@ -3806,17 +3968,19 @@ dw2_expand_symtabs_for_function (struct objfile *objfile,
 static void
 dw2_expand_all_symtabs (struct objfile *objfile)
 {
+  VEC (dwarf2_per_cu_ptr) *per_cus = NULL;
+  struct cleanup *cleanup;
   int i;
 
   dw2_setup (objfile);
 
+  cleanup = make_cleanup (VEC_cleanup (dwarf2_per_cu_ptr), &per_cus);
   for (i = 0; i < (dwarf2_per_objfile->n_comp_units
 		   + dwarf2_per_objfile->n_type_units); ++i)
-    {
-      struct dwarf2_per_cu_data *per_cu = dw2_get_cutu (i);
+    VEC_safe_push (dwarf2_per_cu_ptr, per_cus, dw2_get_cutu (i));
 
-      dw2_instantiate_symtab (per_cu);
-    }
+  dw2_expand_cus (objfile, per_cus, NULL, NULL);
+  do_cleanups (cleanup);
 }
 
 static void
@@ -3885,6 +4049,9 @@ dw2_expand_symtabs_matching
   int i;
   offset_type iter;
   struct mapped_index *index;
+  VEC (dwarf2_per_cu_ptr) *per_cus = NULL;
+  char *queued;
+  struct cleanup *back_to;
 
   dw2_setup (objfile);
 
@@ -3972,6 +4139,13 @@ dw2_expand_symtabs_matching
       do_cleanups (cleanup);
     }
 
+  /* Collect the CUs to expand first, in the order in which they are
+     found, so that dw2_expand_cus can read their DIEs in parallel.  */
+  queued = XCNEWVEC (char, (dwarf2_per_objfile->n_comp_units
+			    + dwarf2_per_objfile->n_type_units));
+  back_to = make_cleanup (xfree, queued);
+  make_cleanup (VEC_cleanup (dwarf2_per_cu_ptr), &per_cus);
+
   for (iter = 0; iter < index->symbol_table_slots; ++iter)
     {
       offset_type idx = 2 * iter;
@@ -4053,23 +4227,18 @@ dw2_expand_symtabs_matching
 	    }
 
 	  per_cu = dw2_get_cutu (cu_index);
-	  if (file_matcher == NULL || per_cu->v.quick->mark)
+	  if ((file_matcher == NULL || per_cu->v.quick->mark)
+	      && per_cu->v.quick->compunit_symtab == NULL
+	      && !queued[cu_index])
 	    {
-	      int symtab_was_null =
-		(per_cu->v.quick->compunit_symtab == NULL);
-
-	      dw2_instantiate_symtab (per_cu);
-
-	      if (expansion_notify != NULL
-		  && symtab_was_null
-		  && per_cu->v.quick->compunit_symtab != NULL)
-		{
-		  expansion_notify (per_cu->v.quick->compunit_symtab,
-				    data);
-		}
+	      queued[cu_index] = 1;
+	      VEC_safe_push (dwarf2_per_cu_ptr, per_cus, per_cu);
 	    }
 	}
     }
+
+  dw2_expand_cus (objfile, per_cus, expansion_notify, data);
+  do_cleanups (back_to);
 }
 
 /* A helper for dw2_find_pc_sect_compunit_symtab which finds the most specific
@@ -4286,6 +4455,8 @@ dwarf2_build_psymtabs (struct objfile *objfile)
 
       dwarf2_build_psymtabs_hard (objfile);
       discard_cleanups (cleanups);
+
+      dwarf2_store_index_cache (objfile);
     }
   CATCH (except, RETURN_MASK_ERROR)
     {
@@ -5935,6 +6106,40 @@ create_partial_symtab (struct dwarf2_per_cu_data *per_cu, const char *name)
   return pst;
 }
 
+/* The result of prescanning one CU on a worker thread; see
+   prescan_psymtab_comp_unit.  */
+
+struct psymtab_prescan
+{
+  /* The CU that was prescanned.  */
+  struct dwarf2_per_cu_data *per_cu;
+
+  /* Non-zero if the CU should be prescanned.  A CU that an earlier
+     CU already read in, and that is in the cache, is left to the main
+     thread.  */
+  int wanted;
+
+  /* The value of PER_CU->load_all_dies when the prescan started.  */
+  int load_all_dies;
+
+  /* Non-zero if the prescan completed.  Otherwise the main thread
+     reads the CU itself.  */
+  int done;
+
+  /* The CU's reading state, with its abbrev table and partial DIEs
+     loaded.  This is not linked from PER_CU until the main thread
+     takes it over.  */
+  struct dwarf2_cu *cu;
+
+  /* The CU's top level DIE, and whether it has children.  */
+  struct die_info *comp_unit_die;
+  int has_children;
+
+  /* The first partial DIE below COMP_UNIT_DIE, as returned by
+     load_partial_dies.  */
+  struct partial_die_info *first_die;
+};
+
 /* The DATA object passed to process_psymtab_comp_unit_reader has this
    type.  */
 
@@ -5948,8 +6153,71 @@ struct process_psymtab_comp_unit_data
      language.  */
 
   enum language pretend_language;
+
+  /* If non-NULL, the partial DIEs of the CU were already loaded by
+     this prescan.  */
+
+  struct psymtab_prescan *prescan;
 };
 
+/* Canonicalize the names of PDI, its siblings and all their children
+   that were left alone while prescanning CU.  */
+
+static void
+canonicalize_prescanned_names (struct partial_die_info *pdi,
+			       struct dwarf2_cu *cu)
+{
+  struct obstack *obstack = &cu->objfile->per_bfd->storage_obstack;
+
+  for (; pdi != NULL; pdi = pdi->die_sibling)
+    {
+      if (pdi->needs_canonical_name)
+	{
+	  pdi->name = dwarf2_canonicalize_name (pdi->name, cu, obstack);
+	  pdi->needs_canonical_name = 0;
+	}
+      if (pdi->die_child != NULL)
+	canonicalize_prescanned_names (pdi->die_child, cu);
+    }
+}
+
+/* Do the part of load_partial_dies that prescan_psymtab_comp_unit had
+   to leave to the main thread: canonicalize names and add the
+   partial symbols that load_partial_dies adds directly.  PRESCAN is
+   the result of the prescan of CU.  Return the first partial DIE of
+   the CU, like load_partial_dies.  */
+
+static struct partial_die_info *
+finish_prescanned_partial_dies (struct psymtab_prescan *prescan,
+				struct dwarf2_cu *cu)
+{
+  struct objfile *objfile = cu->objfile;
+  struct deferred_psymbol *deferred;
+  int ix;
+
+  canonicalize_prescanned_names (prescan->first_die, cu);
+
+  for (ix = 0;
+       VEC_iterate (deferred_psymbol, cu->deferred_psymbols, ix, deferred);
+       ++ix)
+    {
+      const char *name = deferred->name;
+
+      if (deferred->canonicalize)
+	name = dwarf2_canonicalize_name (name, cu,
+					 &objfile->per_bfd->storage_obstack);
+      add_psymbol_to_list (name, strlen (name), 0, VAR_DOMAIN,
+			   deferred->aclass,
+			   deferred->is_global
+			   ? &objfile->global_psymbols
+			   : &objfile->static_psymbols,
+			   0, cu->language, objfile);
+    }
+  VEC_free (deferred_psymbol, cu->deferred_psymbols);
+
+  return prescan->first_die;
+}
+
 /* die_reader_func for process_psymtab_comp_unit.  */
 
 static void
@@ -6019,7 +6287,10 @@ process_psymtab_comp_unit_reader (const struct die_reader_specs *reader,
       lowpc = ((CORE_ADDR) -1);
       highpc = ((CORE_ADDR) 0);
 
-      first_die = load_partial_dies (reader, info_ptr, 1);
+      if (info->prescan != NULL)
+	first_die = finish_prescanned_partial_dies (info->prescan, cu);
+      else
+	first_die = load_partial_dies (reader, info_ptr, 1);
 
       scan_partial_symbols (first_die, &lowpc, &highpc,
 			    cu_bounds_kind <= PC_BOUNDS_INVALID, cu);
@@ -6102,6 +6373,7 @@ process_psymtab_comp_unit (struct dwarf2_per_cu_data *this_cu,
   gdb_assert (! this_cu->is_debug_types);
   info.want_partial_unit = want_partial_unit;
   info.pretend_language = pretend_language;
+  info.prescan = NULL;
   init_cutu_and_read_dies (this_cu, NULL, 0, 0,
 			   process_psymtab_comp_unit_reader,
 			   &info);
@@ -6110,6 +6382,136 @@ process_psymtab_comp_unit (struct dwarf2_per_cu_data *this_cu,
   age_cached_comp_units ();
 }
 
+/* Prescan a CU for dwarf2_build_psymtabs_hard on a worker thread.
+   This does the expensive part of process_psymtab_comp_unit that only
+   touches the CU itself: reading the CU header, the abbrev table, the
+   top level DIE and the partial DIEs.  Anything unusual, such as
+   dummy CUs, DWO stubs, errors or complaints that need printing, is
+   left to the main thread by returning, or throwing, before the
+   prescan is marked done.
+
+   This is a worker_func_ftype; DATA is the array of psymtab_prescan
+   objects and INDEX selects the one to fill in.  */
+
+static void
+prescan_psymtab_comp_unit (int index, void *data)
+{
+  struct psymtab_prescan *prescan = ((struct psymtab_prescan *) data) + index;
+  struct dwarf2_per_cu_data *this_cu = prescan->per_cu;
+  struct dwarf2_section_info *section = this_cu->section;
+  struct dwarf2_section_info *abbrev_section;
+  bfd *abfd = get_section_bfd_owner (section);
+  const gdb_byte *begin_info_ptr, *info_ptr;
+  struct die_reader_specs reader;
+  struct dwarf2_cu *cu;
+
+  if (!prescan->wanted)
+    return;
+
+  prescan->load_all_dies = this_cu->load_all_dies;
+
+  cu = XNEW (struct dwarf2_cu);
+  init_worker_comp_unit (cu, this_cu);
+  cu->prescanning = 1;
+  prescan->cu = cu;
+
+  begin_info_ptr = info_ptr = section->buffer + this_cu->offset.sect_off;
+  abbrev_section = get_abbrev_section_for_cu (this_cu);
+  info_ptr = read_and_check_comp_unit_head (&cu->header, section,
+					    abbrev_section, info_ptr, 0);
+  if (info_ptr >= begin_info_ptr + this_cu->length
+      || peek_abbrev_code (abfd, info_ptr) == 0)
+    return;
+
+  dwarf2_read_abbrevs (cu, abbrev_section);
+
+  init_cu_die_reader (&reader, cu, section, NULL);
+  info_ptr = read_full_die (&reader, &prescan->comp_unit_die, info_ptr,
+			    &prescan->has_children);
+  if (prescan->comp_unit_die->tag == DW_TAG_partial_unit
+      || dwarf2_attr (prescan->comp_unit_die, DW_AT_GNU_dwo_name, cu) != NULL)
+    return;
+
+  prepare_one_comp_unit (cu, prescan->comp_unit_die, language_minimal);
+
+  if (prescan->has_children)
+    prescan->first_die = load_partial_dies (&reader, info_ptr, 1);
+
+  prescan->done = 1;
+}
+
+/* Free CU, which was created on a worker thread and not taken over
+   by the main thread.  Unlike free_heap_comp_unit, this leaves
+   CU->per_cu->cu alone: it was never set to CU.  */
+
+static void
+free_worker_comp_unit (struct dwarf2_cu *cu)
+{
+  dwarf2_free_abbrev_table (cu);
+  VEC_free (deferred_psymbol, cu->deferred_psymbols);
+  obstack_free (&cu->comp_unit_obstack, NULL);
+  xfree (cu);
+}
+
+/* Release the reading state of PRESCAN that was not taken over by the
+   main thread.  */
+
+static void
+discard_psymtab_prescan (struct psymtab_prescan *prescan)
+{
+  if (prescan->cu == NULL)
+    return;
+
+  free_worker_comp_unit (prescan->cu);
+  prescan->cu = NULL;
+}
+
+/* Build the psymtab for the CU prescanned by PRESCAN, on the main
+   thread.  This is process_psymtab_comp_unit, except that the partial
+   DIEs are taken from the prescan when possible.  */
+
+static void
+process_prescanned_psymtab_comp_unit (struct psymtab_prescan *prescan)
+{
+  struct dwarf2_per_cu_data *this_cu = prescan->per_cu;
+  struct dwarf2_cu *cu = prescan->cu;
+  struct process_psymtab_comp_unit_data info;
+  struct die_reader_specs reader;
+  struct cleanup *cleanups;
+
+  /* If the prescan gave up, or a CU read since then found that this
+     CU needs all of its DIEs loaded, read it the normal way.  */
+  if (!prescan->done || this_cu->load_all_dies != prescan->load_all_dies)
+    {
+      discard_psymtab_prescan (prescan);
+      process_psymtab_comp_unit (this_cu, 0, language_minimal);
+      return;
+    }
+
+  if (this_cu->cu != NULL)
+    free_one_cached_comp_unit (this_cu);
+
+  /* Take the CU over.  From here on it is released just like the one
+     init_cutu_and_read_dies creates.  */
+  prescan->cu = NULL;
+  this_cu->cu = cu;
+  cu->prescanning = 0;
+  cleanups = make_cleanup (free_heap_comp_unit, cu);
+  make_cleanup (dwarf2_free_abbrev_table, cu);
+
+  info.want_partial_unit = 0;
+  info.pretend_language = language_minimal;
+  info.prescan = prescan;
+  init_cu_die_reader (&reader, cu, this_cu->section, NULL);
+  process_psymtab_comp_unit_reader (&reader, NULL, prescan->comp_unit_die,
+				    prescan->has_children, &info);
+
+  do_cleanups (cleanups);
+
+  /* Age out any secondary CUs.  */
+  age_cached_comp_units ();
+}
+
 /* Reader function for build_type_psymtabs.  */
 
 static void
@@ -6458,6 +6860,102 @@ set_partial_user (struct objfile *objfile)
     }
 }
 
+/* The number of CUs prescanned per worker thread in each batch by
+   process_psymtab_comp_units_in_parallel.  Bigger batches keep the
+   threads busier, but more partial DIEs are held in memory at once.  */
+
+#define PSYMTAB_PRESCAN_BATCH_PER_THREAD 16
+
+/* A batch of prescanned CUs.  */
+
+struct psymtab_prescan_batch
+{
+  struct psymtab_prescan *prescans;
+  int count;
+};
+
+/* Cleanup for process_psymtab_comp_units_in_parallel: release the
+   prescans of the batch in DATA that were not taken over.  */
+
+static void
+discard_psymtab_prescan_batch (void *data)
+{
+  struct psymtab_prescan_batch *batch = (struct psymtab_prescan_batch *) data;
+  int i;
+
+  for (i = 0; i < batch->count; ++i)
+    discard_psymtab_prescan (&batch->prescans[i]);
+  xfree (batch->prescans);
+}
+
+/* Read in the sections, other than those holding the CUs themselves,
+   that worker threads reading DIEs of OBJFILE may need.  Workers
+   cannot read sections; see dwarf2_read_section.  */
+
+static void
+read_sections_for_workers (struct objfile *objfile)
+{
+  struct dwz_file *dwz;
+
+  dwarf2_read_section (objfile, &dwarf2_per_objfile->abbrev);
+  dwarf2_read_section (objfile, &dwarf2_per_objfile->str);
+  dwz = dwarf2_per_objfile->dwz_file;
+  if (dwz != NULL)
+    {
+      dwarf2_read_section (objfile, &dwz->abbrev);
+      dwarf2_read_section (objfile, &dwz->str);
+    }
+}
+
+/* Process all the CUs of OBJFILE for dwarf2_build_psymtabs_hard, using
+   NTHREADS threads.  The CUs are prescanned in batches by worker
+   threads, then the main thread builds the psymtabs from the
+   prescanned partial DIEs in the usual order, so the result is the
+   same as with process_psymtab_comp_unit alone.  */
+
+static void
+process_psymtab_comp_units_in_parallel (struct objfile *objfile,
+					int nthreads)
+{
+  struct psymtab_prescan_batch batch;
+  struct cleanup *cleanup;
+  int batch_size = nthreads * PSYMTAB_PRESCAN_BATCH_PER_THREAD;
+  int start, i;
+
+  /* The sections holding the CUs themselves were read by
+     create_all_comp_units.  */
+  read_sections_for_workers (objfile);
+
+  batch.prescans = XNEWVEC (struct psymtab_prescan, batch_size);
+  batch.count = 0;
+  cleanup = make_cleanup (discard_psymtab_prescan_batch, &batch);
+
+  for (start = 0; start < dwarf2_per_objfile->n_comp_units;
+       start += batch.count)
+    {
+      batch.count = dwarf2_per_objfile->n_comp_units - start;
+      if (batch.count > batch_size)
+	batch.count = batch_size;
+
+      memset (batch.prescans, 0, batch.count * sizeof (*batch.prescans));
+      for (i = 0; i < batch.count; ++i)
+	{
+	  struct psymtab_prescan *prescan = &batch.prescans[i];
+
+	  prescan->per_cu = dw2_get_cutu (start + i);
+	  prescan->wanted = prescan->per_cu->cu == NULL;
+	}
+
+      parallel_for_each (batch.count, prescan_psymtab_comp_unit,
+			 batch.prescans);
+
+      for (i = 0; i < batch.count; ++i)
+	process_prescanned_psymtab_comp_unit (&batch.prescans[i]);
+    }
+
+  do_cleanups (cleanup);
+}
+
 /* Build the partial symbol table by doing a quick pass through the
    .debug_info and .debug_abbrev sections.  */
 
@@ -6466,6 +6964,7 @@ dwarf2_build_psymtabs_hard (struct objfile *objfile)
 {
   struct cleanup *back_to, *addrmap_cleanup;
   struct obstack temp_obstack;
+  int nthreads;
   int i;
 
   if (dwarf_read_debug)
@@ -6493,12 +6992,18 @@ dwarf2_build_psymtabs_hard (struct objfile *objfile)
   objfile->psymtabs_addrmap = addrmap_create_mutable (&temp_obstack);
   addrmap_cleanup = make_cleanup (psymtabs_addrmap_cleanup, objfile);
 
-  for (i = 0; i < dwarf2_per_objfile->n_comp_units; ++i)
-    {
-      struct dwarf2_per_cu_data *per_cu = dw2_get_cutu (i);
+  /* Debugging output cannot come from worker threads.  */
+  nthreads = worker_thread_count ();
+  if (nthreads > 1 && dwarf2_per_objfile->n_comp_units > 1
+      && !dwarf_read_debug && !dwarf_die_debug)
+    process_psymtab_comp_units_in_parallel (objfile, nthreads);
+  else
+    for (i = 0; i < dwarf2_per_objfile->n_comp_units; ++i)
+      {
+	struct dwarf2_per_cu_data *per_cu = dw2_get_cutu (i);
 
-      process_psymtab_comp_unit (per_cu, 0, language_minimal);
-    }
+	process_psymtab_comp_unit (per_cu, 0, language_minimal);
+      }
 
   /* This has to wait until we read the CUs, we need the list of DWOs.  */
   process_skeletonless_type_units (objfile);
@@ -7755,6 +8260,254 @@ load_full_comp_unit (struct dwarf2_per_cu_data *this_cu,
 			   load_full_comp_unit_reader, &pretend_language);
 }
 
+/* The DIEs of a CU, read ahead of the CU's expansion by a worker
+   thread.  */
+
+struct full_comp_unit_prefetch
+{
+  /* The CU.  */
+  struct dwarf2_per_cu_data *per_cu;
+
+  /* Non-zero if the DIEs should be read.  */
+  unsigned int wanted : 1;
+
+  /* Non-zero if all the DIEs were read.  */
+  unsigned int done : 1;
+
+  /* The reading state, owned by the prefetch until the main thread
+     takes it over.  */
+  struct dwarf2_cu *cu;
+};
+
+/* Read the DIEs of a CU for dw2_expand_cus on a worker thread.  This
+   is load_full_comp_unit, except that the result is kept private
+   until adopt_full_comp_unit_prefetch hands it to the main thread.
+   Dummy CUs, DWO stubs, errors and complaints that need printing are
+   left to the main thread by returning, or throwing, before the
+   prefetch is marked done.
+
+   This is a worker_func_ftype; DATA is the array of
+   full_comp_unit_prefetch objects and INDEX selects the one to fill
+   in.  */
+
+static void
+prefetch_full_comp_unit (int index, void *data)
+{
+  struct full_comp_unit_prefetch *prefetch
+    = ((struct full_comp_unit_prefetch *) data) + index;
+  struct dwarf2_per_cu_data *this_cu = prefetch->per_cu;
+  struct dwarf2_section_info *section = this_cu->section;
+  struct dwarf2_section_info *abbrev_section;
+  bfd *abfd = get_section_bfd_owner (section);
+  const gdb_byte *begin_info_ptr, *info_ptr;
+  struct die_reader_specs reader;
+  struct die_info *comp_unit_die;
+  int has_children;
+  struct dwarf2_cu *cu;
+
+  if (!prefetch->wanted)
+    return;
+
+  cu = XNEW (struct dwarf2_cu);
+  init_worker_comp_unit (cu, this_cu);
+  prefetch->cu = cu;
+
+  begin_info_ptr = info_ptr = section->buffer + this_cu->offset.sect_off;
+  abbrev_section = get_abbrev_section_for_cu (this_cu);
+  info_ptr = read_and_check_comp_unit_head (&cu->header, section,
+					    abbrev_section, info_ptr, 0);
+  if (info_ptr >= begin_info_ptr + this_cu->length
+      || peek_abbrev_code (abfd, info_ptr) == 0)
+    return;
+
+  dwarf2_read_abbrevs (cu, abbrev_section);
+
+  init_cu_die_reader (&reader, cu, section, NULL);
+  info_ptr = read_full_die (&reader, &comp_unit_die, info_ptr,
+			    &has_children);
+  if (dwarf2_attr (comp_unit_die, DW_AT_GNU_dwo_name, cu) != NULL)
+    return;
+
+  cu->die_hash =
+    htab_create_alloc_ex (cu->header.length / 12,
+			  die_hash,
+			  die_eq,
+			  NULL,
+			  &cu->comp_unit_obstack,
+			  hashtab_obstack_allocate,
+			  dummy_obstack_deallocate);
+
+  if (has_children)
+    comp_unit_die->child = read_die_and_siblings (&reader, info_ptr,
+						  &info_ptr, comp_unit_die);
+  cu->dies = comp_unit_die;
+  prepare_one_comp_unit (cu, cu->dies, language_minimal);
+
+  /* As in init_cutu_and_read_dies, the abbrevs are not needed once
+     the DIEs are read.  */
+  dwarf2_free_abbrev_table (cu);
+
+  prefetch->done = 1;
+}
+
+/* Release the reading state of PREFETCH that was not taken over by
+   the main thread.  */
+
+static void
+discard_full_comp_unit_prefetch (struct full_comp_unit_prefetch *prefetch)
+{
+  if (prefetch->cu == NULL)
+    return;
+
+  free_worker_comp_unit (prefetch->cu);
+  prefetch->cu = NULL;
+}
+
+/* Make the DIEs read by PREFETCH the loaded DIEs of its CU, just as
+   if load_full_comp_unit had read them now, so that expanding the CU
+   does not read them again.  If the prefetch failed, or the CU was
+   loaded or expanded since the prefetch started, discard it
+   instead.  */
+
+static void
+adopt_full_comp_unit_prefetch (struct full_comp_unit_prefetch *prefetch)
+{
+  struct dwarf2_per_cu_data *per_cu = prefetch->per_cu;
+  struct dwarf2_cu *cu = prefetch->cu;
+
+  if (!prefetch->done
+      || per_cu->cu != NULL
+      || per_cu->v.quick->compunit_symtab != NULL)
+    {
+      discard_full_comp_unit_prefetch (prefetch);
+      return;
+    }
+
+  prefetch->cu = NULL;
+  per_cu->cu = cu;
+  cu->read_in_chain = dwarf2_per_objfile->read_in_chain;
+  dwarf2_per_objfile->read_in_chain = per_cu;
+}
+
+/* The number of CUs whose DIEs dw2_expand_cus reads ahead per worker
+   thread in each batch.  Full DIEs take much more memory than partial
+   ones, so this is smaller than PSYMTAB_PRESCAN_BATCH_PER_THREAD.  */
+
+#define FULL_PREFETCH_BATCH_PER_THREAD 4
+
+/* A batch of prefetched CUs.  */
+
+struct full_comp_unit_prefetch_batch
+{
+  struct full_comp_unit_prefetch *prefetches;
+  int count;
+};
+
+/* Cleanup for dw2_expand_cus: release the prefetches of the batch in
+   DATA that were not taken over.  */
+
+static void
+discard_full_comp_unit_prefetch_batch (void *data)
+{
+  struct full_comp_unit_prefetch_batch *batch
+    = (struct full_comp_unit_prefetch_batch *) data;
+  int i;
+
+  for (i = 0; i < batch->count; ++i)
+    discard_full_comp_unit_prefetch (&batch->prefetches[i]);
+  xfree (batch->prefetches);
+}
+
+/* Expand the symtab of PER_CU, calling EXPANSION_NOTIFY (if not NULL)
+   with DATA if this creates it.  */
+
+static void
+dw2_expand_one_cu (struct dwarf2_per_cu_data *per_cu,
+		   expand_symtabs_exp_notify_ftype *expansion_notify,
+		   void *data)
+{
+  int symtab_was_null = (per_cu->v.quick->compunit_symtab == NULL);
+
+  dw2_instantiate_symtab (per_cu);
+
+  if (expansion_notify != NULL
+      && symtab_was_null
+      && per_cu->v.quick->compunit_symtab != NULL)
+    expansion_notify (per_cu->v.quick->compunit_symtab, data);
+}
+
+/* Expand the symtabs of the CUs and TUs in PER_CUS, in order, calling
+   EXPANSION_NOTIFY (if not NULL) with DATA for each symtab this
+   creates.  With more than one worker thread, the DIEs of the CUs are
+   read in batches by the workers ahead of their expansion.  The
+   symtabs themselves are still built one at a time by the main
+   thread, in the same order, so the result is the same.  */
+
+static void
+dw2_expand_cus (struct objfile *objfile, VEC (dwarf2_per_cu_ptr) *per_cus,
+		expand_symtabs_exp_notify_ftype *expansion_notify,
+		void *data)
+{
+  struct full_comp_unit_prefetch_batch batch;
+  struct dwarf2_per_cu_data *per_cu;
+  struct cleanup *cleanup;
+  int n = VEC_length (dwarf2_per_cu_ptr, per_cus);
+  int nthreads = worker_thread_count ();
+  int batch_size, start, i;
+
+  if (nthreads <= 1 || n <= 1 || dwarf_die_debug)
+    {
+      for (i = 0; VEC_iterate (dwarf2_per_cu_ptr, per_cus, i, per_cu); ++i)
+	{
+	  QUIT;
+	  dw2_expand_one_cu (per_cu, expansion_notify, data);
+	}
+      return;
+    }
+
+  read_sections_for_workers (objfile);
+
+  batch_size = nthreads * FULL_PREFETCH_BATCH_PER_THREAD;
+  batch.prefetches = XNEWVEC (struct full_comp_unit_prefetch, batch_size);
+  batch.count = 0;
+  cleanup = make_cleanup (discard_full_comp_unit_prefetch_batch, &batch);
+
+  for (start = 0; start < n; start += batch.count)
+    {
+      batch.count = n - start;
+      if (batch.count > batch_size)
+	batch.count = batch_size;
+
+      memset (batch.prefetches, 0,
+	      batch.count * sizeof (*batch.prefetches));
+      for (i = 0; i < batch.count; ++i)
+	{
+	  struct full_comp_unit_prefetch *prefetch = &batch.prefetches[i];
+
+	  per_cu = VEC_index (dwarf2_per_cu_ptr, per_cus, start + i);
+	  prefetch->per_cu = per_cu;
+	  prefetch->wanted = (!per_cu->is_debug_types
+			      && per_cu->cu == NULL
+			      && per_cu->v.quick->compunit_symtab == NULL);
+	  if (prefetch->wanted)
+	    dwarf2_read_section (objfile, per_cu->section);
+	}
+
+      parallel_for_each (batch.count, prefetch_full_comp_unit,
+			 batch.prefetches);
+
+      for (i = 0; i < batch.count; ++i)
+	{
+	  QUIT;
+	  adopt_full_comp_unit_prefetch (&batch.prefetches[i]);
+	  dw2_expand_one_cu (batch.prefetches[i].per_cu, expansion_notify,
+			     data);
+	}
+    }
+
+  do_cleanups (cleanup);
+}
+
 /* Add a DIE to the delayed physname list.  */
 
 static void
@@ -15535,6 +16288,23 @@ is_type_tag_for_partial (int tag)
     }
 }
 
+/* Record a partial symbol for PDI, found while prescanning CU, for the
+   main thread to add later.  ACLASS and IS_GLOBAL are as described in
+   struct deferred_psymbol.  */
+
+static void
+defer_psymbol (struct dwarf2_cu *cu, struct partial_die_info *pdi,
+	       enum address_class aclass, int is_global)
+{
+  struct deferred_psymbol *deferred;
+
+  deferred = VEC_safe_push (deferred_psymbol, cu->deferred_psymbols, NULL);
+  deferred->name = pdi->name;
+  deferred->canonicalize = pdi->needs_canonical_name;
+  deferred->aclass = aclass;
+  deferred->is_global = is_global;
+}
+
 /* Load all DIEs that are interesting for partial symbols into memory.  */
 
 static struct partial_die_info *
@@ -15668,10 +16438,15 @@ load_partial_dies (const struct die_reader_specs *reader,
 	      || part_die->tag == DW_TAG_subrange_type))
 	{
 	  if (building_psymtab && part_die->name != NULL)
-	    add_psymbol_to_list (part_die->name, strlen (part_die->name), 0,
-				 VAR_DOMAIN, LOC_TYPEDEF,
-				 &objfile->static_psymbols,
-				 0, cu->language, objfile);
+	    {
+	      if (cu->prescanning)
+		defer_psymbol (cu, part_die, LOC_TYPEDEF, 0);
+	      else
+		add_psymbol_to_list (part_die->name, strlen (part_die->name),
+				     0, VAR_DOMAIN, LOC_TYPEDEF,
+				     &objfile->static_psymbols,
+				     0, cu->language, objfile);
+	    }
 	  info_ptr = locate_pdi_sibling (reader, part_die, info_ptr);
 	  continue;
 	}
@@ -15704,13 +16479,20 @@ load_partial_dies (const struct die_reader_specs *reader,
 	    complaint (&symfile_complaints,
 		       _("malformed enumerator DIE ignored"));
 	  else if (building_psymtab)
-	    add_psymbol_to_list (part_die->name, strlen (part_die->name), 0,
-				 VAR_DOMAIN, LOC_CONST,
-				 (cu->language == language_cplus
-				  || cu->language == language_java)
-				 ? &objfile->global_psymbols
-				 : &objfile->static_psymbols,
-				 0, cu->language, objfile);
+	    {
+	      int is_global = (cu->language == language_cplus
+			       || cu->language == language_java);
+
+	      if (cu->prescanning)
+		defer_psymbol (cu, part_die, LOC_CONST, is_global);
+	      else
+		add_psymbol_to_list (part_die->name, strlen (part_die->name),
+				     0, VAR_DOMAIN, LOC_CONST,
+				     is_global
+				     ? &objfile->global_psymbols
+				     : &objfile->static_psymbols,
+				     0, cu->language, objfile);
+	    }
 
 	  info_ptr = locate_pdi_sibling (reader, part_die, info_ptr);
 	  continue;
@@ -15862,9 +16644,17 @@ read_partial_die (const struct die_reader_specs *reader,
 	      part_die->name = DW_STRING (&attr);
 	      break;
 	    default:
-	      part_die->name
-		= dwarf2_canonicalize_name (DW_STRING (&attr), cu,
-					    &objfile->per_bfd->storage_obstack);
+	      if (cu->prescanning)
+		{
+		  /* Canonicalizing is not thread-safe; the main thread
+		     does it in finish_prescanned_partial_dies.  */
+		  part_die->name = DW_STRING (&attr);
+		  part_die->needs_canonical_name = 1;
+		}
+	      else
+		part_die->name
+		  = dwarf2_canonicalize_name (DW_STRING (&attr), cu,
+					      &objfile->per_bfd->storage_obstack);
 	      break;
 	    }
 	  break;
@@ -15964,7 +16754,16 @@ read_partial_die (const struct die_reader_specs *reader,
 	  if (DW_UNSND (&attr) == DW_CC_program
 	      && cu->language == language_fortran
 	      && part_die->name != NULL)
-	    set_objfile_main_name (objfile, part_die->name, language_fortran);
+	    {
+	      /* This changes the objfile, so leave the CU to the main
+		 thread.  */
+	      if (cu->prescanning)
+		error (_("Dwarf Error: Fortran main program found while "
+			 "prescanning [in module %s]"),
+		       objfile_name (objfile));
+	      set_objfile_main_name (objfile, part_die->name,
+				     language_fortran);
+	    }
 	  break;
 	case DW_AT_inline:
 	  if (DW_UNSND (&attr) == DW_INL_inlined
@@ -22114,18 +22913,29 @@ dwarf2_find_containing_comp_unit (sect_offset offset,
     }
 }
 
-/* Initialize dwarf2_cu CU, owned by PER_CU.  */
+/* Initialize dwarf2_cu CU for PER_CU, without making PER_CU point to
+   it.  Worker threads use this, as PER_CU->cu belongs to the main
+   thread.  */
 
 static void
-init_one_comp_unit (struct dwarf2_cu *cu, struct dwarf2_per_cu_data *per_cu)
+init_worker_comp_unit (struct dwarf2_cu *cu,
+		       struct dwarf2_per_cu_data *per_cu)
 {
   memset (cu, 0, sizeof (*cu));
-  per_cu->cu = cu;
   cu->per_cu = per_cu;
   cu->objfile = per_cu->objfile;
   obstack_init (&cu->comp_unit_obstack);
 }
 
+/* Initialize dwarf2_cu CU, owned by PER_CU.  */
+
+static void
+init_one_comp_unit (struct dwarf2_cu *cu, struct dwarf2_per_cu_data *per_cu)
+{
+  init_worker_comp_unit (cu, per_cu);
+  per_cu->cu = cu;
+}
+
 /* Initialize basic fields of dwarf_cu CU according to DIE COMP_UNIT_DIE.  */
 
 static void
@@ -22162,6 +22972,7 @@ free_heap_comp_unit (void *data)
   cu->per_cu->cu = NULL;
   cu->per_cu = NULL;
 
+  VEC_free (deferred_psymbol, cu->deferred_psymbols);
   obstack_free (&cu->comp_unit_obstack, NULL);
 
   xfree (cu);
@@ -22619,6 +23430,8 @@ dwarf2_per_objfile_free (struct objfile *objfile, void *d)
 
   if (data->dwz_file && data->dwz_file->dwz_bfd)
     gdb_bfd_unref (data->dwz_file->dwz_bfd);
+
+  index_cache_release (&data->index_cache_entry);
 }
 
 
@@ -23221,7 +24034,7 @@ write_obstack (FILE *file, struct obstack *obstack)
 static void
 unlink_if_set (void *p)
 {
-  char **filename = (char **) p;
+  const char **filename = (const char **) p;
   if (*filename)
     unlink (*filename);
 }
@@ -23304,20 +24117,19 @@ recursively_write_psymbols (struct objfile *objfile,
 		  1);
 }
 
-/* Create an index file for OBJFILE in the directory DIR.  */
+/* Write an index for OBJFILE to the file FILENAME.  */
 
 static void
-write_psymtabs_to_index (struct objfile *objfile, const char *dir)
+write_psymtabs_to_index_file (struct objfile *objfile, const char *filename)
 {
   struct cleanup *cleanup;
-  char *filename, *cleanup_filename;
+  const char *cleanup_filename;
   struct obstack contents, addr_obstack, constant_pool, symtab_obstack;
   struct obstack cu_list, types_cu_list;
   int i;
   FILE *out_file;
   struct mapped_symtab *symtab;
   offset_type val, size_of_contents, total_len;
-  struct stat st;
   htab_t psyms_seen;
   htab_t cu_index_htab;
   struct psymtab_cu_index_map *psymtab_cu_index_map;
@@ -23331,19 +24143,12 @@ write_psymtabs_to_index (struct objfile *objfile, const char *dir)
   if (!objfile->psymtabs || !objfile->psymtabs_addrmap)
     return;
 
-  if (stat (objfile_name (objfile), &st) < 0)
-    perror_with_name (objfile_name (objfile));
-
-  filename = concat (dir, SLASH_STRING, lbasename (objfile_name (objfile)),
-		     INDEX_SUFFIX, (char *) NULL);
-  cleanup = make_cleanup (xfree, filename);
-
   out_file = gdb_fopen_cloexec (filename, "wb");
   if (!out_file)
     error (_("Can't open `%s' for writing"), filename);
 
   cleanup_filename = filename;
-  make_cleanup (unlink_if_set, &cleanup_filename);
+  cleanup = make_cleanup (unlink_if_set, &cleanup_filename);
 
   symtab = create_mapped_symtab ();
   make_cleanup (cleanup_mapped_symtab, symtab);
@@ -23489,6 +24294,62 @@ write_psymtabs_to_index (struct objfile *objfile, const char *dir)
   do_cleanups (cleanup);
 }
 
+/* Create an index file for OBJFILE in the directory DIR.  */
+
+static void
+write_psymtabs_to_index (struct objfile *objfile, const char *dir)
+{
+  char *filename;
+  struct cleanup *cleanup;
+  struct stat st;
+
+  if (stat (objfile_name (objfile), &st) < 0)
+    perror_with_name (objfile_name (objfile));
+
+  filename = concat (dir, SLASH_STRING, lbasename (objfile_name (objfile)),
+		     INDEX_SUFFIX, (char *) NULL);
+  cleanup = make_cleanup (xfree, filename);
+
+  write_psymtabs_to_index_file (objfile, filename);
+
+  do_cleanups (cleanup);
+}
+
+/* An index_cache_writer_ftype that writes the index of the objfile
+   DATA.  */
+
+static void
+write_index_cache_file (const char *filename, void *data)
+{
+  write_psymtabs_to_index_file ((struct objfile *) data, filename);
+}
+
+/* Store the index of OBJFILE, whose partial symbols have just been
+   read, in the index cache.  */
+
+static void
+dwarf2_store_index_cache (struct objfile *objfile)
+{
+  const struct bfd_build_id *build_id;
+
+  if (!index_cache_enabled_p ())
+    return;
+
+  /* The index would have to describe the .dwz file as well, which
+     write_psymtabs_to_index_file does not do.  */
+  if (dwarf2_per_objfile->using_index
+      || objfile_has_dwz_link (objfile)
+      || objfile->psymtabs == NULL
+      || objfile->psymtabs_addrmap == NULL)
+    return;
+
+  build_id = build_id_bfd_get (objfile->obfd);
+  if (build_id == NULL)
+    return;
+
+  index_cache_store (build_id, write_index_cache_file, objfile);
+}
+
 /* Implementation of the `save gdb-index' command.
    
    Note that the file format used by this command is documented in the
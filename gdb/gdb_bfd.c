@@ -716,6 +716,50 @@ gdb_bfd_map_section (asection *sectp, bfd_size_type *size)
   return (const gdb_byte *) descriptor->data;
 }
 
+/* The closure of count_section_memory.  */
+
+struct section_memory
+{
+  bfd_size_type mapped;
+  bfd_size_type copied;
+};
+
+/* A bfd_map_over_sections callback that adds the memory used by the
+   data gdb_bfd_map_section read for SECTP to the section_memory
+   DATA.  */
+
+static void
+count_section_memory (bfd *abfd, asection *sectp, void *data)
+{
+  struct section_memory *memory = (struct section_memory *) data;
+  struct gdb_bfd_section_data *descriptor
+    = (struct gdb_bfd_section_data *) bfd_get_section_userdata (abfd, sectp);
+
+  if (descriptor == NULL || descriptor->data == NULL)
+    return;
+
+  if (descriptor->map_addr != NULL)
+    memory->mapped += descriptor->size;
+  else
+    memory->copied += descriptor->size;
+}
+
+/* See gdb_bfd.h.  */
+
+void
+gdb_bfd_section_memory (bfd *abfd, bfd_size_type *mapped,
+			bfd_size_type *copied)
+{
+  struct section_memory memory;
+
+  memory.mapped = 0;
+  memory.copied = 0;
+  bfd_map_over_sections (abfd, count_section_memory, &memory);
+
+  *mapped = memory.mapped;
+  *copied = memory.copied;
+}
+
 /* Return 32-bit CRC for ABFD.  If successful store it to *FILE_CRC_RETURN and
    return 1.  Otherwise print a warning and return 0.  ABFD seek position is
    not preserved.  */
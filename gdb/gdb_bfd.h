@@ -99,6 +99,13 @@ void gdb_bfd_record_inclusion (bfd *includer, bfd *includee);
 
 const gdb_byte *gdb_bfd_map_section (asection *section, bfd_size_type *size);
 
+/* Set *MAPPED to the number of bytes of section data of ABFD that
+   gdb_bfd_map_section mapped straight from the file, and *COPIED to
+   the number of bytes it had to read or decompress into memory.  */
+
+void gdb_bfd_section_memory (bfd *abfd, bfd_size_type *mapped,
+			     bfd_size_type *copied);
+
 /* Compute the CRC for ABFD.  The CRC is used to find and verify
    separate debug files.  When successful, this fills in *CRC_OUT and
    returns 1.  Otherwise, this issues a warning and returns 0.  */
@@ -0,0 +1,399 @@
+/* Caching of GDB/DWARF index files.
+
+   Copyright (C) 2016 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include "defs.h"
+#include "index-cache.h"
+#include "bfd.h"
+#include "gdbcmd.h"
+#include "cli/cli-setshow.h"
+#include "filestuff.h"
+#include "rsp-low.h"
+#include "readline/tilde.h"
+#include "filenames.h"
+#include <sys/stat.h>
+#include <fcntl.h>
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
+
+#ifdef USE_WIN32API
+#undef mkdir
+#define mkdir(pathname, mode) mkdir (pathname)
+#endif
+
+/* The suffix of the files in the cache directory.  */
+
+#define INDEX_CACHE_FILE_SUFFIX ".gdb-index"
+
+/* Non-zero if the cache is used, i.e., "set index-cache on".  */
+
+static int index_cache_enabled;
+
+/* The directory holding the cache, "set index-cache directory".  */
+
+static char *index_cache_directory;
+
+/* "set debug index-cache".  */
+
+static int debug_index_cache;
+
+/* The number of lookups that found, and did not find, an index in
+   this session.  */
+
+static unsigned int index_cache_hits;
+static unsigned int index_cache_misses;
+
+static struct cmd_list_element *set_index_cache_list;
+static struct cmd_list_element *show_index_cache_list;
+
+/* See index-cache.h.  */
+
+int
+index_cache_enabled_p (void)
+{
+  return (index_cache_enabled
+	  && index_cache_directory != NULL
+	  && *index_cache_directory != '\0');
+}
+
+/* Return the build-id BUILD_ID as a string of hex digits.  The result
+   is malloc'd.  */
+
+static char *
+build_id_to_hex (const struct bfd_build_id *build_id)
+{
+  char *hex = (char *) xmalloc (2 * build_id->size + 1);
+
+  bin2hex (build_id->data, hex, build_id->size);
+  return hex;
+}
+
+/* Return the name of the cache file for the file whose build-id is
+   BUILD_ID.  The result is malloc'd.  */
+
+static char *
+index_cache_file_name (const struct bfd_build_id *build_id)
+{
+  char *hex = build_id_to_hex (build_id);
+  char *filename;
+
+  filename = concat (index_cache_directory, SLASH_STRING, hex,
+		     INDEX_CACHE_FILE_SUFFIX, (char *) NULL);
+  xfree (hex);
+  return filename;
+}
+
+/* Create DIR and any missing parent directories.  Throw an error on
+   failure.  */
+
+static void
+make_index_cache_directory (const char *dir)
+{
+  char *copy = xstrdup (dir);
+  struct cleanup *back_to = make_cleanup (xfree, copy);
+  char *p;
+
+  for (p = copy + 1; ; ++p)
+    {
+      char c = *p;
+
+      if (c != '\0' && !IS_DIR_SEPARATOR (c))
+	continue;
+
+      *p = '\0';
+      if (mkdir (copy, S_IRWXU) != 0 && errno != EEXIST)
+	error (_("Unable to create directory `%s' (%s)"), copy,
+	       safe_strerror (errno));
+      *p = c;
+
+      if (c == '\0')
+	break;
+    }
+
+  do_cleanups (back_to);
+}
+
+/* Read SIZE bytes of the index file open on FD into ENTRY.  Return 1
+   on success, 0 otherwise.  */
+
+static int
+read_index_cache_file (int fd, size_t size, struct index_cache_entry *entry)
+{
+  gdb_byte *data;
+  size_t done;
+
+#ifdef HAVE_MMAP
+  data = (gdb_byte *) mmap (NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if ((void *) data != MAP_FAILED)
+    {
+      entry->data = data;
+      entry->size = size;
+      entry->mapped = 1;
+      return 1;
+    }
+#endif
+
+  data = (gdb_byte *) xmalloc (size);
+  for (done = 0; done < size; )
+    {
+      ssize_t n = read (fd, data + done, size - done);
+
+      if (n <= 0)
+	{
+	  xfree (data);
+	  return 0;
+	}
+      done += n;
+    }
+
+  entry->data = data;
+  entry->size = size;
+  entry->mapped = 0;
+  return 1;
+}
+
+/* See index-cache.h.  */
+
+int
+index_cache_lookup (const struct bfd_build_id *build_id,
+		    struct index_cache_entry *entry)
+{
+  char *filename;
+  struct stat st;
+  int fd, found = 0;
+
+  memset (entry, 0, sizeof (*entry));
+
+  if (!index_cache_enabled_p ())
+    return 0;
+
+  filename = index_cache_file_name (build_id);
+
+  fd = gdb_open_cloexec (filename, O_RDONLY | O_BINARY, 0);
+  if (fd >= 0)
+    {
+      if (fstat (fd, &st) == 0 && st.st_size > 0)
+	found = read_index_cache_file (fd, st.st_size, entry);
+      close (fd);
+    }
+
+  if (found)
+    ++index_cache_hits;
+  else
+    ++index_cache_misses;
+
+  if (debug_index_cache)
+    fprintf_unfiltered (gdb_stdlog, "index-cache: %s `%s'\n",
+			found ? "found" : "no entry", filename);
+
+  xfree (filename);
+  return found;
+}
+
+/* See index-cache.h.  */
+
+void
+index_cache_release (struct index_cache_entry *entry)
+{
+  if (entry->data == NULL)
+    return;
+
+#ifdef HAVE_MMAP
+  if (entry->mapped)
+    munmap ((void *) entry->data, entry->size);
+  else
+#endif
+    xfree ((gdb_byte *) entry->data);
+
+  memset (entry, 0, sizeof (*entry));
+}
+
+/* See index-cache.h.  */
+
+void
+index_cache_store (const struct bfd_build_id *build_id,
+		   index_cache_writer_ftype *writer, void *data)
+{
+  char *filename, *tmp_filename;
+
+  if (!index_cache_enabled_p ())
+    return;
+
+  filename = index_cache_file_name (build_id);
+  tmp_filename = xstrprintf ("%s.tmp%ld", filename, (long) getpid ());
+
+  TRY
+    {
+      make_index_cache_directory (index_cache_directory);
+      writer (tmp_filename, data);
+      if (rename (tmp_filename, filename) != 0)
+	perror_with_name (filename);
+
+      if (debug_index_cache)
+	fprintf_unfiltered (gdb_stdlog, "index-cache: stored `%s'\n",
+			    filename);
+    }
+  CATCH (except, RETURN_MASK_ERROR)
+    {
+      unlink (tmp_filename);
+      if (debug_index_cache)
+	exception_fprintf (gdb_stdlog, except,
+			   _("index-cache: couldn't store `%s': "),
+			   filename);
+    }
+  END_CATCH
+
+  xfree (tmp_filename);
+  xfree (filename);
+}
+
+/* Implement "set index-cache", which takes "on" or "off".  */
+
+static void
+set_index_cache_command (char *arg, int from_tty)
+{
+  int value;
+
+  if (arg == NULL || *arg == '\0')
+    error (_("Missing argument.  Use \"on\" or \"off\", "
+	     "or see \"help set index-cache\"."));
+
+  value = parse_cli_boolean_value (arg);
+  if (value < 0)
+    error (_("Unknown argument \"%s\".  Use \"on\" or \"off\"."), arg);
+
+  index_cache_enabled = value;
+}
+
+/* Implement "show index-cache".  */
+
+static void
+show_index_cache_command (char *arg, int from_tty)
+{
+  printf_filtered (_("The index cache is currently %s.\n"),
+		   index_cache_enabled ? _("enabled") : _("disabled"));
+  cmd_show_list (show_index_cache_list, from_tty, "");
+}
+
+/* Implement "show index-cache stats".  */
+
+static void
+show_index_cache_stats_command (char *arg, int from_tty)
+{
+  printf_filtered (_("  Cache hits (this session): %u\n"),
+		   index_cache_hits);
+  printf_filtered (_("  Cache misses (this session): %u\n"),
+		   index_cache_misses);
+}
+
+/* Tilde-expand the new value of "set index-cache directory".  */
+
+static void
+set_index_cache_directory (char *args, int from_tty,
+			   struct cmd_list_element *c)
+{
+  char *expanded = tilde_expand (index_cache_directory);
+
+  xfree (index_cache_directory);
+  index_cache_directory = expanded;
+}
+
+/* Implement "show index-cache directory".  */
+
+static void
+show_index_cache_directory (struct ui_file *file, int from_tty,
+			    struct cmd_list_element *c, const char *value)
+{
+  fprintf_filtered (file, _("The directory of the index cache is "
+			    "\"%s\".\n"), value);
+}
+
+/* Implement "show debug index-cache".  */
+
+static void
+show_debug_index_cache (struct ui_file *file, int from_tty,
+			struct cmd_list_element *c, const char *value)
+{
+  fprintf_filtered (file, _("Debugging of the index cache is %s.\n"),
+		    value);
+}
+
+/* Return the default cache directory: $XDG_CACHE_HOME/gdb, or
+   $HOME/.cache/gdb, or NULL if neither variable is set.  The result
+   is malloc'd.  */
+
+static char *
+default_index_cache_directory (void)
+{
+  const char *dir = getenv ("XDG_CACHE_HOME");
+
+  if (dir != NULL && *dir != '\0')
+    return concat (dir, SLASH_STRING, "gdb", (char *) NULL);
+
+  dir = getenv ("HOME");
+  if (dir != NULL && *dir != '\0')
+    return concat (dir, SLASH_STRING, ".cache", SLASH_STRING, "gdb",
+		   (char *) NULL);
+
+  return NULL;
+}
+
+/* Provide a prototype to silence -Wmissing-prototypes.  */
+extern initialize_file_ftype _initialize_index_cache;
+
+void
+_initialize_index_cache (void)
+{
+  index_cache_directory = default_index_cache_directory ();
+
+  add_prefix_cmd ("index-cache", class_files, set_index_cache_command, _("\
+Set index-cache options.\n\
+\"set index-cache on\" makes GDB save the index it builds for files\n\
+without a .gdb_index section, and reuse it the next time such a\n\
+file is loaded.  \"set index-cache off\" disables this."),
+		  &set_index_cache_list, "set index-cache ",
+		  1/*allow-unknown*/, &setlist);
+
+  add_prefix_cmd ("index-cache", class_files, show_index_cache_command, _("\
+Show index-cache options."),
+		  &show_index_cache_list, "show index-cache ",
+		  0/*allow-unknown*/, &showlist);
+
+  add_setshow_filename_cmd ("directory", class_files,
+			    &index_cache_directory, _("\
+Set the directory of the index cache."), _("\
+Show the directory of the index cache."), _("\
+The default is $XDG_CACHE_HOME/gdb, or $HOME/.cache/gdb if\n\
+XDG_CACHE_HOME is not set."),
+			    set_index_cache_directory,
+			    show_index_cache_directory,
+			    &set_index_cache_list, &show_index_cache_list);
+
+  add_cmd ("stats", no_set_class, show_index_cache_stats_command, _("\
+Show some stats about the index cache."),
+	   &show_index_cache_list);
+
+  add_setshow_boolean_cmd ("index-cache", class_maintenance,
+			   &debug_index_cache, _("\
+Set display of index-cache debugging messages."), _("\
+Show display of index-cache debugging messages."), _("\
+When enabled, index-cache lookups and stores are logged."),
+			   NULL, show_debug_index_cache,
+			   &setdebuglist, &showdebuglist);
+}
@@ -0,0 +1,80 @@
+/* Caching of GDB/DWARF index files.
+
+   Copyright (C) 2016 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifndef INDEX_CACHE_H
+#define INDEX_CACHE_H
+
+/* The index cache keeps a copy of the index GDB builds for an object
+   file without a .gdb_index section, so that later sessions debugging
+   the same file can skip building partial symbols.  Entries are kept
+   in a per-user directory and are keyed by the build-id of the file
+   they describe; files without a build-id are never cached.  */
+
+struct bfd_build_id;
+
+/* The contents of a cached index, as returned by index_cache_lookup.  */
+
+struct index_cache_entry
+{
+  /* The index itself, and its size in bytes.  */
+  const gdb_byte *data;
+  size_t size;
+
+  /* Non-zero if DATA was mmapped rather than allocated with
+     xmalloc.  */
+  int mapped;
+};
+
+/* Return non-zero if the index cache is enabled ("set index-cache
+   on").  */
+
+extern int index_cache_enabled_p (void);
+
+/* Look up the index stored for the file whose build-id is BUILD_ID.
+   If there is one, fill in *ENTRY and return 1.  Otherwise return 0.
+   The index is mapped read-only; it stays valid until *ENTRY is
+   passed to index_cache_release.  */
+
+extern int index_cache_lookup (const struct bfd_build_id *build_id,
+			       struct index_cache_entry *entry);
+
+/* Release the index described by ENTRY, which was filled in by
+   index_cache_lookup.  ENTRY may also be all zeros, in which case
+   this does nothing.  */
+
+extern void index_cache_release (struct index_cache_entry *entry);
+
+/* The type of the function index_cache_store calls to write an index
+   to the file named FILENAME.  DATA is the closure passed to
+   index_cache_store.  It may throw an error.  */
+
+typedef void (index_cache_writer_ftype) (const char *filename, void *data);
+
+/* Store an index for the file whose build-id is BUILD_ID in the
+   cache, by calling WRITER (FILENAME, DATA).  WRITER writes to a
+   temporary file, which only replaces the cache entry once it is
+   complete, so that concurrent GDB sessions never see a partial
+   index.  Errors are not propagated; they are only reported with
+   "set debug index-cache on".  */
+
+extern void index_cache_store (const struct bfd_build_id *build_id,
+			       index_cache_writer_ftype *writer,
+			       void *data);
+
+#endif /* INDEX_CACHE_H */
@@ -26,6 +26,9 @@
 #include <signal.h>
 #include "gdb_sys_time.h"
 #include <time.h>
+#if defined HAVE_SYS_RESOURCE_H
+#include <sys/resource.h>
+#endif
 #include "command.h"
 #include "gdbcmd.h"
 #include "symtab.h"
@@ -390,11 +393,34 @@ maintenance_info_sections (char *arg, int from_tty)
     }
 }
 
+/* Print the peak resident set size of GDB, if the host provides
+   it.  */
+
+static void
+print_peak_rss (void)
+{
+#ifdef HAVE_GETRUSAGE
+  struct rusage usage;
+  long kib;
+
+  if (getrusage (RUSAGE_SELF, &usage) != 0)
+    return;
+
+  kib = usage.ru_maxrss;
+#ifdef __APPLE__
+  /* Darwin reports bytes rather than kilobytes.  */
+  kib /= 1024;
+#endif
+  printf_filtered (_("Peak resident set size: %ld KiB\n"), kib);
+#endif
+}
+
 static void
 maintenance_print_statistics (char *args, int from_tty)
 {
   print_objfile_statistics ();
   print_symbol_bcache_statistics ();
+  print_peak_rss ();
 }
 
 static void
@@ -528,6 +528,29 @@ frob_address (struct objfile *objfile, CORE_ADDR *pc)
   return 0;
 }
 
+/* Return the index of the last element of ADDRS, an array of COUNT
+   addresses sorted in ascending order, that is less than or equal to
+   PC.  Return -1 if PC is less than all of them.  */
+
+static int
+find_msymbol_index (const CORE_ADDR *addrs, int count, CORE_ADDR pc)
+{
+  int lo = 0;
+  int hi = count;
+
+  while (lo < hi)
+    {
+      int mid = lo + (hi - lo) / 2;
+
+      if (addrs[mid] <= pc)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+
+  return lo - 1;
+}
+
 /* Search through the minimal symbol table for each objfile and find
    the symbol whose address is the largest address that is still less
    than or equal to PC, and matches SECTION (which is not NULL).
@@ -548,11 +571,10 @@ lookup_minimal_symbol_by_pc_section_1 (CORE_ADDR pc_in,
 				       struct obj_section *section,
 				       int want_trampoline)
 {
-  int lo;
   int hi;
-  int newobj;
   struct objfile *objfile;
   struct minimal_symbol *msymbol;
+  const CORE_ADDR *addrs;
   struct minimal_symbol *best_symbol = NULL;
   struct objfile *best_objfile = NULL;
   struct bound_minimal_symbol result;
@@ -588,55 +610,26 @@ lookup_minimal_symbol_by_pc_section_1 (CORE_ADDR pc_in,
 	{
 	  int best_zero_sized = -1;
 
-          msymbol = objfile->per_bfd->msymbols;
-	  lo = 0;
-	  hi = objfile->per_bfd->minimal_symbol_count - 1;
-
-	  /* This code assumes that the minimal symbols are sorted by
-	     ascending address values.  If the pc value is greater than or
-	     equal to the first symbol's address, then some symbol in this
-	     minimal symbol table is a suitable candidate for being the
-	     "best" symbol.  This includes the last real symbol, for cases
-	     where the pc value is larger than any address in this vector.
-
-	     By iterating until the address associated with the current
-	     hi index (the endpoint of the test interval) is less than
-	     or equal to the desired pc value, we accomplish two things:
-	     (1) the case where the pc value is larger than any minimal
-	     symbol address is trivially solved, (2) the address associated
-	     with the hi index is always the one we want when the interation
-	     terminates.  In essence, we are iterating the test interval
-	     down until the pc value is pushed out of it from the high end.
-
-	     Warning: this code is trickier than it would appear at first.  */
-
-	  if (frob_address (objfile, &pc)
-	      && pc >= MSYMBOL_VALUE_RAW_ADDRESS (&msymbol[lo]))
-	    {
-	      while (MSYMBOL_VALUE_RAW_ADDRESS (&msymbol[hi]) > pc)
-		{
-		  /* pc is still strictly less than highest address.  */
-		  /* Note "new" will always be >= lo.  */
-		  newobj = (lo + hi) / 2;
-		  if ((MSYMBOL_VALUE_RAW_ADDRESS (&msymbol[newobj]) >= pc)
-		      || (lo == newobj))
-		    {
-		      hi = newobj;
-		    }
-		  else
-		    {
-		      lo = newobj;
-		    }
-		}
-
-	      /* If we have multiple symbols at the same address, we want
-	         hi to point to the last one.  That way we can find the
-	         right symbol if it has an index greater than hi.  */
-	      while (hi < objfile->per_bfd->minimal_symbol_count - 1
-		     && (MSYMBOL_VALUE_RAW_ADDRESS (&msymbol[hi])
-			 == MSYMBOL_VALUE_RAW_ADDRESS (&msymbol[hi + 1])))
-		hi++;
+	  msymbol = objfile->per_bfd->msymbols;
+	  addrs = objfile->per_bfd->msymbol_addresses;
+
+	  /* The minimal symbols are sorted by ascending address values.
+	     If there are several symbols at the address we find, HI is
+	     the last one; that way we can find the right symbol if it
+	     has an index greater than HI.  If the pc value is larger
+	     than any address in the table, HI is the last real symbol.
+	     If it is smaller than all of them, no symbol in this table
+	     is a candidate.  */
+
+	  if (frob_address (objfile, &pc))
+	    hi = find_msymbol_index (addrs,
+				     objfile->per_bfd->minimal_symbol_count,
+				     pc);
+	  else
+	    hi = -1;
 
+	  if (hi >= 0)
+	    {
 	      /* Skip various undesirable symbols.  */
 	      while (hi >= 0)
 		{
@@ -682,8 +675,7 @@ lookup_minimal_symbol_by_pc_section_1 (CORE_ADDR pc_in,
 		      && MSYMBOL_TYPE (&msymbol[hi - 1]) == want_type
 		      && (MSYMBOL_SIZE (&msymbol[hi])
 			  == MSYMBOL_SIZE (&msymbol[hi - 1]))
-		      && (MSYMBOL_VALUE_RAW_ADDRESS (&msymbol[hi])
-			  == MSYMBOL_VALUE_RAW_ADDRESS (&msymbol[hi - 1]))
+		      && addrs[hi] == addrs[hi - 1]
 		      && (MSYMBOL_OBJ_SECTION (objfile, &msymbol[hi])
 			  == MSYMBOL_OBJ_SECTION (objfile, &msymbol[hi - 1])))
 		    {
@@ -712,10 +704,8 @@ lookup_minimal_symbol_by_pc_section_1 (CORE_ADDR pc_in,
 		     the cancellable variants, but both have sizes.  */
 		  if (hi > 0
 		      && MSYMBOL_SIZE (&msymbol[hi]) != 0
-		      && pc >= (MSYMBOL_VALUE_RAW_ADDRESS (&msymbol[hi])
-				+ MSYMBOL_SIZE (&msymbol[hi]))
-		      && pc < (MSYMBOL_VALUE_RAW_ADDRESS (&msymbol[hi - 1])
-			       + MSYMBOL_SIZE (&msymbol[hi - 1])))
+		      && pc >= addrs[hi] + MSYMBOL_SIZE (&msymbol[hi])
+		      && pc < addrs[hi - 1] + MSYMBOL_SIZE (&msymbol[hi - 1]))
 		    {
 		      hi--;
 		      continue;
@@ -744,8 +734,7 @@ lookup_minimal_symbol_by_pc_section_1 (CORE_ADDR pc_in,
 
 	      if (hi >= 0
 		  && MSYMBOL_SIZE (&msymbol[hi]) != 0
-		  && pc >= (MSYMBOL_VALUE_RAW_ADDRESS (&msymbol[hi])
-			    + MSYMBOL_SIZE (&msymbol[hi])))
+		  && pc >= addrs[hi] + MSYMBOL_SIZE (&msymbol[hi]))
 		{
 		  if (best_zero_sized != -1)
 		    hi = best_zero_sized;
@@ -760,8 +749,7 @@ lookup_minimal_symbol_by_pc_section_1 (CORE_ADDR pc_in,
 
 	      if (hi >= 0
 		  && ((best_symbol == NULL) ||
-		      (MSYMBOL_VALUE_RAW_ADDRESS (best_symbol) <
-		       MSYMBOL_VALUE_RAW_ADDRESS (&msymbol[hi]))))
+		      MSYMBOL_VALUE_RAW_ADDRESS (best_symbol) < addrs[hi]))
 		{
 		  best_symbol = &msymbol[hi];
 		  best_objfile = objfile;
@@ -1328,6 +1316,13 @@ install_minimal_symbols (struct objfile *objfile)
       objfile->per_bfd->minimal_symbol_count = mcount;
       objfile->per_bfd->msymbols = msymbols;
 
+      /* Record the addresses separately, for lookups by PC.  */
+      objfile->per_bfd->msymbol_addresses
+	= XOBNEWVEC (&objfile->per_bfd->storage_obstack, CORE_ADDR, mcount);
+      for (bindex = 0; bindex < mcount; bindex++)
+	objfile->per_bfd->msymbol_addresses[bindex]
+	  = MSYMBOL_VALUE_RAW_ADDRESS (&msymbols[bindex]);
+
       /* Now build the hash tables; we can't do this incrementally
          at an earlier point since we weren't finished with the obstack
 	 yet.  (And if the msymbol obstack gets moved, all the internal
@@ -235,6 +235,14 @@ struct objfile_per_bfd_storage
   struct minimal_symbol *msymbols;
   int minimal_symbol_count;
 
+  /* The unrelocated addresses of the symbols in MSYMBOLS, in the same
+     order.  Looking up a minimal symbol by address binary-searches
+     this array instead of MSYMBOLS, so that the search touches a few
+     cache lines rather than one whole minimal symbol per probe.  This
+     is NULL if MINIMAL_SYMBOL_COUNT is zero.  */
+
+  CORE_ADDR *msymbol_addresses;
+
   /* The number of minimal symbols read, before any minimal symbol
      de-duplication is applied.  Note in particular that this has only
      a passing relationship with the actual size of the table above;
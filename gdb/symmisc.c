@@ -39,6 +39,9 @@
 #include "readline/readline.h"
 
 #include "psymtab.h"
+#include "gdb_bfd.h"
+#include "minsyms.h"
+#include "value.h"
 
 #ifndef DEV_TTY
 #define DEV_TTY "/dev/tty"
@@ -154,6 +157,16 @@ print_objfile_statistics (void)
 		     bcache_memory_used (objfile->per_bfd->macro_cache));
     printf_filtered (_("  Total memory used for file name cache: %d\n"),
 		     bcache_memory_used (objfile->per_bfd->filename_cache));
+    if (objfile->obfd != NULL)
+      {
+	bfd_size_type mapped, copied;
+
+	gdb_bfd_section_memory (objfile->obfd, &mapped, &copied);
+	printf_filtered (_("  Section data mapped from file: %s\n"),
+			 pulongest (mapped));
+	printf_filtered (_("  Section data read into memory: %s\n"),
+			 pulongest (copied));
+      }
   }
 }
 
@@ -938,6 +951,67 @@ maintenance_expand_symtabs (char *args, int from_tty)
 }
 
 
+/* Implement "maintenance time-msymbol-lookups".  Look up every minimal
+   symbol of the current program space by its own address, COUNT times
+   over, and report how fast that went.  The symbols of each objfile
+   are visited in a scattered order rather than by ascending address,
+   as PC lookups in a real session would not be nicely ordered
+   either.  */
+
+static void
+maintenance_time_msymbol_lookups (char *args, int from_tty)
+{
+  struct objfile *objfile;
+  LONGEST count = 1, i;
+  unsigned long lookups = 0, found = 0;
+  long start_time, elapsed;
+
+  if (args != NULL && *args != '\0')
+    {
+      count = parse_and_eval_long (args);
+      if (count <= 0)
+	error (_("The repeat count must be positive."));
+    }
+
+  start_time = get_run_time ();
+
+  for (i = 0; i < count; i++)
+    ALL_OBJFILES (objfile)
+      {
+	int n = objfile->per_bfd->minimal_symbol_count;
+	/* Two primes; N can't be a multiple of both.  */
+	int step = n % 7919 != 0 ? 7919 : 7927;
+	int j, k;
+
+	for (j = 0, k = 0; j < n; j++, k = (k + step) % n)
+	  {
+	    struct minimal_symbol *msymbol = &objfile->per_bfd->msymbols[k];
+	    struct obj_section *section
+	      = MSYMBOL_OBJ_SECTION (objfile, msymbol);
+	    struct bound_minimal_symbol result;
+	    CORE_ADDR addr;
+
+	    if (section == NULL)
+	      continue;
+
+	    addr = MSYMBOL_VALUE_ADDRESS (objfile, msymbol);
+	    result = lookup_minimal_symbol_by_pc_section (addr, section);
+	    ++lookups;
+	    if (result.minsym != NULL)
+	      ++found;
+	  }
+      }
+
+  elapsed = get_run_time () - start_time;
+
+  printf_filtered (_("%lu lookups (%lu found) in %ld.%06ld seconds"),
+		   lookups, found, elapsed / 1000000, elapsed % 1000000);
+  if (elapsed > 0)
+    printf_filtered (_(", %.0f lookups per second"),
+		     lookups * 1000000.0 / elapsed);
+  printf_filtered (".\n");
+}
+
 /* Return the nexting depth of a block within other blocks in its symtab.  */
 
 static int
@@ -1084,4 +1158,12 @@ Check consistency of currently expanded symtabs."),
 	   _("Expand symbol tables.\n\
 With an argument REGEXP, only expand the symbol tables with matching names."),
 	   &maintenancelist);
+
+  add_cmd ("time-msymbol-lookups", class_maintenance,
+	   maintenance_time_msymbol_lookups, _("\
+Time looking up minimal symbols by address.\n\
+Every minimal symbol of the current program space is looked up by its\n\
+own address, and the number of lookups per second is printed.\n\
+With an argument COUNT, repeat this COUNT times."),
+	   &maintenancelist);
 }
@@ -0,0 +1,60 @@
+/* This testcase is part of GDB, the GNU debugger.
+
+   Copyright 2016 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+struct point
+{
+  int x;
+  int y;
+};
+
+enum color { RED, GREEN, BLUE };
+
+typedef struct point point_t;
+
+union value
+{
+  int i;
+  double d;
+};
+
+double global_total;
+
+static double
+to_double (int i)
+{
+  union value v;
+
+  v.d = i;
+  return v.d;
+}
+
+int
+sum_points (point_t *points, int count)
+{
+  int i, sum = 0;
+
+  for (i = 0; i < count; i++)
+    sum += points[i].x + points[i].y;
+  global_total = to_double (sum);
+  return sum;
+}
+
+enum color
+next_color (enum color c)
+{
+  return (enum color) ((c + 1) % 3);
+}
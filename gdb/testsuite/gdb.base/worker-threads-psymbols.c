@@ -0,0 +1,47 @@
+/* This testcase is part of GDB, the GNU debugger.
+
+   Copyright 2016 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+struct point
+{
+  int x;
+  int y;
+};
+
+enum color { RED, GREEN, BLUE };
+
+typedef struct point point_t;
+
+int global_counter;
+static int static_counter;
+
+extern int sum_points (point_t *, int);
+extern enum color next_color (enum color);
+
+static int
+bump_counter (void)
+{
+  return ++static_counter;
+}
+
+int
+main (void)
+{
+  point_t points[2] = { { 1, 2 }, { 3, 4 } };
+
+  global_counter = sum_points (points, 2) + bump_counter ();
+  return next_color (RED) == GREEN ? 0 : 1;
+}
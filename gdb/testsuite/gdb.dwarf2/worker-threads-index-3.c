@@ -0,0 +1,32 @@
+/* This testcase is part of GDB, the GNU debugger.
+
+   Copyright 2016 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+enum scale_kind { SCALE_NONE, SCALE_DOUBLE };
+
+struct scale
+{
+  enum scale_kind kind;
+  int factor;
+};
+
+static struct scale cu3_scales[] = { { SCALE_NONE, 1 }, { SCALE_DOUBLE, 2 } };
+
+int
+cu3_func_scale (int i, int which)
+{
+  return i * cu3_scales[which].factor;
+}
@@ -0,0 +1,42 @@
+/* This testcase is part of GDB, the GNU debugger.
+
+   Copyright 2016 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+struct pair
+{
+  int first;
+  int second;
+};
+
+extern int cu2_func_sum (struct pair *);
+extern int cu3_func_scale (int, int);
+
+int cu1_var;
+
+static int
+cu1_func_helper (int i)
+{
+  return i * 2;
+}
+
+int
+main (void)
+{
+  struct pair p = { 1, 2 };
+
+  cu1_var = cu1_func_helper (cu2_func_sum (&p));
+  return cu3_func_scale (cu1_var, 0);
+}
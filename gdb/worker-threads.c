@@ -0,0 +1,266 @@
+/* Running independent pieces of work on worker threads.
+
+   Copyright (C) 2016 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include "defs.h"
+#include "worker-threads.h"
+#include "gdbcmd.h"
+
+/* Errors thrown on a worker thread can only be caught there if
+   exceptions are C++ exceptions; the setjmp/longjmp implementation
+   keeps a single, global stack of catchers.  */
+#if defined (HAVE_PTHREAD_H) && GDB_XCPT != GDB_XCPT_SJMP
+#define WORKER_THREADS_SUPPORTED 1
+#endif
+
+#ifdef WORKER_THREADS_SUPPORTED
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+/* The value of "maint set worker-threads".  -1 means "unlimited",
+   i.e., one thread per online processor.  The default, 0, does all
+   work on the main thread.  */
+
+static int worker_threads_setting = 0;
+
+/* Non-zero while parallel_for_each is running items.  */
+
+static int worker_threads_running;
+
+#ifdef WORKER_THREADS_SUPPORTED
+
+/* Serializes handing out items in parallel_for_each.  */
+
+static pthread_mutex_t next_item_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* The lock taken by worker_threads_lock.  */
+
+static pthread_mutex_t shared_state_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* The state shared by the threads running one parallel_for_each.  */
+
+struct parallel_for_each_data
+{
+  /* The function to call, and its closure.  */
+  worker_func_ftype *func;
+  void *data;
+
+  /* The number of items.  */
+  int count;
+
+  /* The next item to hand out.  Protected by next_item_lock.  */
+  int next;
+
+  /* Non-zero if some item was interrupted by a quit.  Protected by
+     next_item_lock.  */
+  int quit;
+};
+
+/* Run items from DATA until there are none left.  */
+
+static void
+run_items (struct parallel_for_each_data *data)
+{
+  while (1)
+    {
+      int index;
+
+      pthread_mutex_lock (&next_item_lock);
+      index = data->next++;
+      pthread_mutex_unlock (&next_item_lock);
+
+      if (index >= data->count)
+	break;
+
+      /* TRY/CATCH saves and restores the global cleanup chain, so it
+	 cannot be used here; plain try/catch is enough as long as
+	 exceptions_thread_confined is set.  */
+      try
+	{
+	  data->func (index, data->data);
+	}
+      catch (struct gdb_exception_RETURN_MASK_ERROR &ex)
+	{
+	  xfree ((char *) ex.message);
+	}
+      catch (struct gdb_exception_RETURN_MASK_QUIT &ex)
+	{
+	  /* The user asked to stop.  Hand out no more items, and let
+	     parallel_for_each throw the quit again on the main thread
+	     once all the threads are done.  */
+	  xfree ((char *) ex.message);
+	  pthread_mutex_lock (&next_item_lock);
+	  data->quit = 1;
+	  data->next = data->count;
+	  pthread_mutex_unlock (&next_item_lock);
+	}
+    }
+}
+
+/* The start routine of the worker threads.  */
+
+static void *
+worker_thread_main (void *arg)
+{
+  run_items ((struct parallel_for_each_data *) arg);
+  return NULL;
+}
+
+#endif /* WORKER_THREADS_SUPPORTED */
+
+/* See worker-threads.h.  */
+
+int
+worker_thread_count (void)
+{
+#ifdef WORKER_THREADS_SUPPORTED
+  int count = worker_threads_setting;
+
+#ifdef _SC_NPROCESSORS_ONLN
+  if (count < 0)
+    count = sysconf (_SC_NPROCESSORS_ONLN);
+#endif
+
+  return count > 1 ? count : 1;
+#else
+  return 1;
+#endif
+}
+
+/* See worker-threads.h.  */
+
+void
+parallel_for_each (int count, worker_func_ftype *func, void *data)
+{
+#ifdef WORKER_THREADS_SUPPORTED
+  struct parallel_for_each_data for_each_data;
+  int nthreads = worker_thread_count ();
+  pthread_t *threads;
+  sigset_t all_signals, old_mask;
+  int started, i;
+
+  gdb_assert (!worker_threads_running);
+
+  if (nthreads > count)
+    nthreads = count;
+
+  for_each_data.func = func;
+  for_each_data.data = data;
+  for_each_data.count = count;
+  for_each_data.next = 0;
+  for_each_data.quit = 0;
+
+  worker_threads_running = 1;
+  exceptions_thread_confined = 1;
+
+  /* Signals must keep being delivered to the main thread, whose
+     handlers expect to run there; the workers inherit this mask.  */
+  sigfillset (&all_signals);
+  pthread_sigmask (SIG_BLOCK, &all_signals, &old_mask);
+
+  threads = XNEWVEC (pthread_t, nthreads);
+  started = 0;
+  for (i = 1; i < nthreads; ++i)
+    if (pthread_create (&threads[started], NULL, worker_thread_main,
+			&for_each_data) == 0)
+      ++started;
+
+  pthread_sigmask (SIG_SETMASK, &old_mask, NULL);
+
+  /* Whatever threads we did get, the calling thread helps out too.  */
+  run_items (&for_each_data);
+
+  for (i = 0; i < started; ++i)
+    pthread_join (threads[i], NULL);
+  xfree (threads);
+
+  exceptions_thread_confined = 0;
+  worker_threads_running = 0;
+
+  if (for_each_data.quit)
+    quit ();
+#else
+  /* Callers check worker_thread_count first.  */
+  gdb_assert_not_reached ("worker threads are not supported");
+#endif
+}
+
+/* See worker-threads.h.  */
+
+int
+worker_threads_active (void)
+{
+  return worker_threads_running;
+}
+
+/* See worker-threads.h.  */
+
+void
+worker_threads_lock (void)
+{
+#ifdef WORKER_THREADS_SUPPORTED
+  if (worker_threads_running)
+    pthread_mutex_lock (&shared_state_lock);
+#endif
+}
+
+/* See worker-threads.h.  */
+
+void
+worker_threads_unlock (void)
+{
+#ifdef WORKER_THREADS_SUPPORTED
+  if (worker_threads_running)
+    pthread_mutex_unlock (&shared_state_lock);
+#endif
+}
+
+/* Implement "maint show worker-threads".  */
+
+static void
+show_worker_threads (struct ui_file *file, int from_tty,
+		     struct cmd_list_element *c, const char *value)
+{
+  if (worker_threads_setting < 0)
+    fprintf_filtered (file, _("The number of worker threads GDB "
+			      "can use is unlimited (currently %d).\n"),
+		      worker_thread_count ());
+  else
+    fprintf_filtered (file, _("The number of worker threads GDB "
+			      "can use is %s.\n"), value);
+}
+
+/* Provide a prototype to silence -Wmissing-prototypes.  */
+extern initialize_file_ftype _initialize_worker_threads;
+
+void
+_initialize_worker_threads (void)
+{
+  add_setshow_zuinteger_unlimited_cmd ("worker-threads", class_maintenance,
+				       &worker_threads_setting, _("\
+Set the number of worker threads GDB can use."), _("\
+Show the number of worker threads GDB can use."), _("\
+GDB can use extra threads to speed up some CPU-intensive work, such as\n\
+reading DWARF debugging information entries.  \"unlimited\" means one\n\
+thread per processor; 0 or 1, the default, means that all work is done\n\
+by GDB's main thread."),
+				       NULL, show_worker_threads,
+				       &maintenance_set_cmdlist,
+				       &maintenance_show_cmdlist);
+}
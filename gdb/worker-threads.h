@@ -0,0 +1,73 @@
+/* Running independent pieces of work on worker threads.
+
+   Copyright (C) 2016 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifndef WORKER_THREADS_H
+#define WORKER_THREADS_H
+
+/* Most of GDB is not thread-safe: the cleanup chain, the exception
+   machinery, obstacks, bcaches and the symbol tables all assume a
+   single thread.  Worker threads are therefore only used for work
+   that can be split into items which touch nothing but their own
+   state, with the results merged back by the main thread afterwards.
+
+   While the items run, errors thrown with error () are confined to the
+   thread that threw them (see exceptions_thread_confined), so an item
+   that hits something it cannot handle can simply throw and leave the
+   job to the main thread.  Items must not use cleanups, TRY/CATCH or
+   anything else that relies on the main thread's cleanup chain.  Code
+   that may be reached from a worker and has to update shared state
+   anyway must use worker_threads_lock.  */
+
+/* The type of the function called for each item by
+   parallel_for_each.  INDEX is the item number and DATA is the
+   closure passed to parallel_for_each.  */
+
+typedef void (worker_func_ftype) (int index, void *data);
+
+/* Return the number of threads parallel_for_each would use, as set by
+   "maint set worker-threads".  This is always 1 if GDB was built
+   without thread support.  Callers should fall back to doing the work
+   on the main thread directly when this returns 1.  */
+
+extern int worker_thread_count (void);
+
+/* Call FUNC (I, DATA) for each I from 0 to COUNT - 1, spreading the
+   calls over up to worker_thread_count threads, including the calling
+   thread.  Items are handed out in increasing order, but may complete
+   in any order.  Returns when all items have been processed.
+
+   An error thrown by FUNC is caught and discarded; FUNC is expected to
+   record for itself whether an item was completed.  */
+
+extern void parallel_for_each (int count, worker_func_ftype *func,
+			       void *data);
+
+/* Return non-zero if called while parallel_for_each is running
+   items.  */
+
+extern int worker_threads_active (void);
+
+/* Acquire and release the lock that serializes updates to shared
+   state made by code that runs on worker threads.  These do nothing
+   outside parallel_for_each.  */
+
+extern void worker_threads_lock (void);
+extern void worker_threads_unlock (void);
+
+#endif /* WORKER_THREADS_H */
@@ -1722,7 +1722,7 @@ class AArch64_relobj : public Sized_relobj_file<size, big_endian>
   AArch64_relobj(const std::string& name, Input_file* input_file, off_t offset,
 		 const typename elfcpp::Ehdr<size, big_endian>& ehdr)
     : Sized_relobj_file<size, big_endian>(name, input_file, offset, ehdr),
-      stub_tables_()
+      stub_tables_(), reloc_stub_requests_(), stub_scan_limit_(0)
   { }
 
   ~AArch64_relobj()
@@ -1751,11 +1751,52 @@ class AArch64_relobj : public Sized_relobj_file<size, big_endian>
 	      Output_section*, const Symbol_table*,
 	      The_target_aarch64*);
 
-  // Scan all relocation sections for stub generation.
+  // Scan all relocation sections for stub generation.  The stubs
+  // needed are recorded, to be added by add_requested_reloc_stubs.
+  // This may run for different objects at the same time.
   void
   scan_sections_for_stubs(The_target_aarch64*, const Symbol_table*,
 			  const Layout*);
 
+  // Scan all text sections for errata.
+  void
+  scan_sections_for_errata(The_target_aarch64*, const Symbol_table*);
+
+  // Record that a branch relocation in section SHNDX against GSYM, or
+  // the local symbol R_SYM if GSYM is NULL, with ADDEND needs a stub
+  // of STUB_TYPE to reach DESTINATION.
+  void
+  add_reloc_stub_request(int stub_type, const Sized_symbol<size>* gsym,
+			 unsigned int r_sym,
+			 typename elfcpp::Elf_types<size>::Elf_Swxword addend,
+			 unsigned int shndx, AArch64_address destination)
+  {
+    Reloc_stub_request r = { stub_type, gsym, r_sym, addend, shndx,
+			     destination };
+    this->reloc_stub_requests_.push_back(r);
+  }
+
+  // Add the stubs recorded by the last scan_sections_for_stubs to the
+  // stub tables, in the order in which they were found.
+  void
+  add_requested_reloc_stubs();
+
+  // Note that the result of the last scan_sections_for_stubs depends
+  // on ADDRESS.
+  void
+  note_stub_scan_address(AArch64_address address)
+  {
+    if (address > this->stub_scan_limit_)
+      this->stub_scan_limit_ = address;
+  }
+
+  // Return the highest address on which the result of the last
+  // scan_sections_for_stubs depends.  If nothing at or below this
+  // address has moved, scanning again would find the same stubs.
+  AArch64_address
+  stub_scan_limit() const
+  { return this->stub_scan_limit_; }
+
   // Whether a section is a scannable text section.
   bool
   text_section_is_scannable(const elfcpp::Shdr<size, big_endian>&, unsigned int,
@@ -1835,11 +1876,30 @@ class AArch64_relobj : public Sized_relobj_file<size, big_endian>
 				    const Relobj::Output_sections&,
 				    const Symbol_table*, const unsigned char*);
 
+  // A branch relocation which needs a stub.
+  struct Reloc_stub_request
+  {
+    int stub_type;
+    const Sized_symbol<size>* gsym;
+    unsigned int r_sym;
+    typename elfcpp::Elf_types<size>::Elf_Swxword addend;
+    unsigned int shndx;
+    AArch64_address destination;
+  };
+
   // List of stub tables.
   Stub_table_list stub_tables_;
 
   // Mapping symbol information sorted by (section index, section_offset).
   Mapping_symbol_info mapping_symbol_info_;
+
+  // Stubs found by the last scan_sections_for_stubs and not yet added
+  // to the stub tables.
+  std::vector<Reloc_stub_request> reloc_stub_requests_;
+
+  // The highest address on which the last scan_sections_for_stubs
+  // depends.
+  AArch64_address stub_scan_limit_;
 };  // End of AArch64_relobj
 
 
@@ -2259,6 +2319,9 @@ AArch64_relobj<size, big_endian>::scan_sections_for_stubs(
     const Symbol_table* symtab,
     const Layout* layout)
 {
+  this->reloc_stub_requests_.clear();
+  this->stub_scan_limit_ = 0;
+
   unsigned int shnum = this->shnum();
   const unsigned int shdr_size = elfcpp::Elf_sizes<size>::shdr_size;
 
@@ -2283,9 +2346,6 @@ AArch64_relobj<size, big_endian>::scan_sections_for_stubs(
   for (unsigned int i = 1; i < shnum; ++i, p += shdr_size)
     {
       const elfcpp::Shdr<size, big_endian> shdr(p);
-      if (parameters->options().fix_cortex_a53_843419()
-	  || parameters->options().fix_cortex_a53_835769())
-	scan_errata(i, shdr, out_sections[i], symtab, target);
       if (this->section_needs_reloc_stub_scanning(shdr, out_sections, symtab,
 						  pshdrs))
 	{
@@ -2299,7 +2359,10 @@ AArch64_relobj<size, big_endian>::scan_sections_for_stubs(
 	    }
 	  else
 	    {
-	      // Currently this only happens for a relaxed section.
+	      // Currently this only happens for a relaxed section.  The
+	      // lookup may build the maps of the output section, which
+	      // is shared with other objects.
+	      Hold_optional_lock hl(target->relaxed_section_lookup_lock());
 	      const Output_relaxed_input_section* poris =
 		  out_sections[index]->find_relaxed_input_section(this, index);
 	      gold_assert(poris != NULL);
@@ -2335,6 +2398,64 @@ AArch64_relobj<size, big_endian>::scan_sections_for_stubs(
 }
 
 
+// Scan text sections for errata.
+
+template<int size, bool big_endian>
+void
+AArch64_relobj<size, big_endian>::scan_sections_for_errata(
+    The_target_aarch64* target,
+    const Symbol_table* symtab)
+{
+  unsigned int shnum = this->shnum();
+  const unsigned int shdr_size = elfcpp::Elf_sizes<size>::shdr_size;
+
+  // Read the section headers.
+  const unsigned char* pshdrs = this->get_view(this->elf_file()->shoff(),
+					       shnum * shdr_size,
+					       true, true);
+
+  const Relobj::Output_sections& out_sections(this->output_sections());
+
+  const unsigned char* p = pshdrs + shdr_size;
+  for (unsigned int i = 1; i < shnum; ++i, p += shdr_size)
+    {
+      const elfcpp::Shdr<size, big_endian> shdr(p);
+      this->scan_errata(i, shdr, out_sections[i], symtab, target);
+    }
+}
+
+
+// Add the stubs found by the last scan_sections_for_stubs.
+
+template<int size, bool big_endian>
+void
+AArch64_relobj<size, big_endian>::add_requested_reloc_stubs()
+{
+  typedef Reloc_stub<size, big_endian> The_reloc_stub;
+  typedef typename The_reloc_stub::Key The_reloc_stub_key;
+
+  for (typename std::vector<Reloc_stub_request>::const_iterator p =
+	 this->reloc_stub_requests_.begin();
+       p != this->reloc_stub_requests_.end();
+       ++p)
+    {
+      The_stub_table* stub_table = this->stub_table(p->shndx);
+      gold_assert(stub_table != NULL);
+
+      The_reloc_stub_key key(p->stub_type, p->gsym, this, p->r_sym,
+			     p->addend);
+      The_reloc_stub* stub = stub_table->find_reloc_stub(key);
+      if (stub == NULL)
+	{
+	  stub = new The_reloc_stub(p->stub_type);
+	  stub_table->add_reloc_stub(stub, key);
+	}
+      stub->set_destination_address(p->destination);
+    }
+  this->reloc_stub_requests_.clear();
+}
+
+
 // A class to wrap an ordinary input section containing executable code.
 
 template<int size, bool big_endian>
@@ -2802,7 +2923,9 @@ class Target_aarch64 : public Sized_target<size, big_endian>
       rela_irelative_(NULL), copy_relocs_(elfcpp::R_AARCH64_COPY),
       got_mod_index_offset_(-1U),
       tlsdesc_reloc_info_(), tls_base_symbol_defined_(false),
-      stub_tables_(), stub_group_size_(0), aarch64_input_section_map_()
+      stub_tables_(), stub_group_size_(0), aarch64_input_section_map_(),
+      relax_lock_(NULL), relax_section_extents_(), relax_changed_address_(0),
+      relax_changed_section_(NULL)
   { }
 
   // Scan the relocations to determine unreferenced sections for
@@ -2969,6 +3092,12 @@ class Target_aarch64 : public Sized_target<size, big_endian>
 			 Address,
 			 section_size_type);
 
+  // Return the lock to hold while looking up a relaxed input section
+  // when scanning for stubs.
+  Lock*
+  relaxed_section_lookup_lock() const
+  { return this->relax_lock_; }
+
   // Scan a relocation section for stub.
   template<int sh_type>
   void
@@ -3084,6 +3213,15 @@ class Target_aarch64 : public Sized_target<size, big_endian>
 		      typename elfcpp::Elf_types<size>::Elf_Swxword,
 		      Address Elf_Addr);
 
+  // Return the lowest address which may have moved since the last
+  // relaxation pass.
+  Address
+  relax_moved_address(const Layout*) const;
+
+  // Record the output section extents at the end of a relaxation pass.
+  void
+  record_relax_section_extents(const Layout*);
+
   // Make an output section.
   Output_section*
   do_make_output_section(const char* name, elfcpp::Elf_Word type,
@@ -3415,6 +3553,16 @@ class Target_aarch64 : public Sized_target<size, big_endian>
   // Actual stub group size
   section_size_type stub_group_size_;
   AArch64_input_section_map aarch64_input_section_map_;
+  // Lock held while looking up relaxed input sections during the
+  // parallel scan for stubs.
+  Lock* relax_lock_;
+  // The address and size of each output section at the end of the
+  // last relaxation pass, indexed as Layout::section_list.
+  std::vector<std::pair<Address, off_t> > relax_section_extents_;
+  // The address of the stub table which grew in the last relaxation
+  // pass, and its output section.
+  Address relax_changed_address_;
+  const Output_section* relax_changed_section_;
 };  // End of Target_aarch64
 
 
@@ -3723,7 +3871,7 @@ Target_aarch64<size, big_endian>::scan_reloc_for_stub(
     typename elfcpp::Elf_types<size>::Elf_Swxword addend,
     Address address)
 {
-  const AArch64_relobj<size, big_endian>* aarch64_relobj =
+  AArch64_relobj<size, big_endian>* aarch64_relobj =
       static_cast<AArch64_relobj<size, big_endian>*>(relinfo->object);
 
   Symbol_value<size> symval;
@@ -3759,22 +3907,17 @@ Target_aarch64<size, big_endian>::scan_reloc_for_stub(
       gold_unreachable();
     }
 
+  // Whether a stub is needed depends only on these two addresses.
+  aarch64_relobj->note_stub_scan_address(address);
+  aarch64_relobj->note_stub_scan_address(destination);
+
   int stub_type = The_reloc_stub::
       stub_type_for_reloc(r_type, address, destination);
   if (stub_type == ST_NONE)
     return;
 
-  The_stub_table* stub_table = aarch64_relobj->stub_table(relinfo->data_shndx);
-  gold_assert(stub_table != NULL);
-
-  The_reloc_stub_key key(stub_type, gsym, aarch64_relobj, r_sym, addend);
-  The_reloc_stub* stub = stub_table->find_reloc_stub(key);
-  if (stub == NULL)
-    {
-      stub = new The_reloc_stub(stub_type);
-      stub_table->add_reloc_stub(stub, key);
-    }
-  stub->set_destination_address(destination);
+  aarch64_relobj->add_reloc_stub_request(stub_type, gsym, r_sym, addend,
+					 relinfo->data_shndx, destination);
 }  // End of Target_aarch64::scan_reloc_for_stub
 
 
@@ -5494,6 +5637,108 @@ Target_aarch64<size, big_endian>::new_aarch64_input_section(
 }
 
 
+// The Parallel_jobs which scan objects for relocation stubs.  Job I
+// scans the objects in the I'th group.  The members of an archive
+// share one File_read, so all the objects read from one input file
+// are in the same group, and are scanned one after another.
+
+template<int size, bool big_endian>
+class Scan_stubs_jobs : public Parallel_jobs
+{
+ public:
+  typedef AArch64_relobj<size, big_endian> The_aarch64_relobj;
+  typedef std::vector<std::vector<The_aarch64_relobj*> > Object_groups;
+
+  Scan_stubs_jobs(Target_aarch64<size, big_endian>* target,
+		  const Object_groups& groups,
+		  const Symbol_table* symtab, const Layout* layout)
+    : target_(target), groups_(groups), symtab_(symtab), layout_(layout)
+  { }
+
+ protected:
+  void
+  do_run_job(unsigned int index)
+  {
+    // The objects were locked by the caller.
+    const std::vector<The_aarch64_relobj*>& group(this->groups_[index]);
+    for (typename std::vector<The_aarch64_relobj*>::const_iterator p =
+	   group.begin();
+	 p != group.end();
+	 ++p)
+      (*p)->scan_sections_for_stubs(this->target_, this->symtab_,
+				    this->layout_);
+  }
+
+ private:
+  Target_aarch64<size, big_endian>* target_;
+  const Object_groups& groups_;
+  const Symbol_table* symtab_;
+  const Layout* layout_;
+};
+
+
+// Return the lowest address which may have moved since the end of the
+// last relaxation pass.  Everything after the stub table which grew
+// has moved, and so has any output section whose address or size has
+// changed.
+
+template<int size, bool big_endian>
+typename elfcpp::Elf_types<size>::Elf_Addr
+Target_aarch64<size, big_endian>::relax_moved_address(
+    const Layout* layout) const
+{
+  const Layout::Section_list& sections(layout->section_list());
+  if (sections.size() != this->relax_section_extents_.size())
+    return 0;
+
+  Address moved = this->relax_changed_address_;
+  for (size_t i = 0; i < sections.size(); ++i)
+    {
+      const Output_section* os = sections[i];
+      if ((os->flags() & elfcpp::SHF_ALLOC) == 0)
+	continue;
+      if (!os->is_address_valid() || !os->is_data_size_valid())
+	return 0;
+      const std::pair<Address, off_t>& old =
+	this->relax_section_extents_[i];
+      Address address = os->address();
+      if (address != old.first)
+	moved = std::min(moved, std::min(address, old.first));
+      else if (os->data_size() != old.second
+	       && os != this->relax_changed_section_)
+	moved = std::min(moved, old.first);
+    }
+  return moved;
+}
+
+
+// Record the address and size of each output section at the end of a
+// relaxation pass.
+
+template<int size, bool big_endian>
+void
+Target_aarch64<size, big_endian>::record_relax_section_extents(
+    const Layout* layout)
+{
+  const Layout::Section_list& sections(layout->section_list());
+  this->relax_section_extents_.clear();
+  this->relax_section_extents_.reserve(sections.size());
+  for (Layout::Section_list::const_iterator p = sections.begin();
+       p != sections.end();
+       ++p)
+    {
+      const Output_section* os = *p;
+      if ((os->flags() & elfcpp::SHF_ALLOC) != 0
+	  && os->is_address_valid()
+	  && os->is_data_size_valid())
+	this->relax_section_extents_.push_back(std::make_pair(os->address(),
+							      os->data_size()));
+      else
+	this->relax_section_extents_.push_back(std::make_pair(0, 0));
+    }
+}
+
+
 // Relaxation hook.  This is where we do stub generation.
 
 template<int size, bool big_endian>
@@ -5536,17 +5781,87 @@ Target_aarch64<size, big_endian>::do_relax(
 	}
     }
 
-  // Scan relocs for relocation stubs
+  if (this->relax_lock_ == NULL)
+    this->relax_lock_ = new Lock();
+
+  // Scan relocs for relocation stubs.  After the first pass, an object
+  // needs to be scanned again only if something at or below the
+  // highest address its last scan depended on has moved.  Otherwise
+  // the stubs it needs have already been added.
+  Address moved_address =
+    pass == 1 ? 0 : this->relax_moved_address(layout);
+  std::vector<The_aarch64_relobj*> objects;
   for (Input_objects::Relobj_iterator op = input_objects->relobj_begin();
        op != input_objects->relobj_end();
        ++op)
     {
       The_aarch64_relobj* aarch64_relobj =
 	  static_cast<The_aarch64_relobj*>(*op);
-      // Lock the object so we can read from it.  This is only called
-      // single-threaded from Layout::finalize, so it is OK to lock.
-      Task_lock_obj<Object> tl(task, aarch64_relobj);
-      aarch64_relobj->scan_sections_for_stubs(this, symtab, layout);
+      if (pass == 1 || aarch64_relobj->stub_scan_limit() >= moved_address)
+	objects.push_back(aarch64_relobj);
+    }
+
+  // The scans only record the stubs needed, so they can run in
+  // parallel.  Locking is not thread safe, so lock the objects here,
+  // but only so many at a time so that we don't run out of file
+  // descriptors.
+  typedef typename Scan_stubs_jobs<size, big_endian>::Object_groups
+    Object_groups;
+  const size_t max_locked_objects = 256;
+  typename std::vector<The_aarch64_relobj*>::const_iterator p =
+    objects.begin();
+  while (p != objects.end())
+    {
+      Object_groups groups;
+      std::map<const Input_file*, size_t> group_index;
+      std::vector<Relobj*> locked_objects;
+      for (;
+	   p != objects.end() && locked_objects.size() < max_locked_objects;
+	   ++p)
+	{
+	  if (!(*p)->is_locked())
+	    {
+	      (*p)->lock(task);
+	      locked_objects.push_back(*p);
+	    }
+
+	  std::pair<std::map<const Input_file*, size_t>::iterator, bool> ins =
+	    group_index.insert(std::make_pair((*p)->input_file(),
+					      groups.size()));
+	  if (ins.second)
+	    groups.push_back(std::vector<The_aarch64_relobj*>());
+	  groups[ins.first->second].push_back(*p);
+	}
+
+      Scan_stubs_jobs<size, big_endian> jobs(this, groups, symtab, layout);
+      jobs.run(groups.size());
+
+      for (std::vector<Relobj*>::const_iterator q = locked_objects.begin();
+	   q != locked_objects.end();
+	   ++q)
+	(*q)->unlock(task);
+    }
+
+  // Add the stubs in object order, so that the output does not depend
+  // on the threads.  The errata scan adds stubs directly, so it is not
+  // run in parallel.
+  bool scan_errata = (parameters->options().fix_cortex_a53_843419()
+		      || parameters->options().fix_cortex_a53_835769());
+  for (Input_objects::Relobj_iterator op = input_objects->relobj_begin();
+       op != input_objects->relobj_end();
+       ++op)
+    {
+      The_aarch64_relobj* aarch64_relobj =
+	  static_cast<The_aarch64_relobj*>(*op);
+      if (scan_errata)
+	{
+	  // Lock the object so we can read from it.  This is only
+	  // called single-threaded from Layout::finalize, so it is OK
+	  // to lock.
+	  Task_lock_obj<Object> tl(task, aarch64_relobj);
+	  aarch64_relobj->scan_sections_for_errata(this, symtab);
+	}
+      aarch64_relobj->add_requested_reloc_stubs();
     }
 
   bool any_stub_table_changed = false;
@@ -5557,6 +5872,10 @@ Target_aarch64<size, big_endian>::do_relax(
       if (stub_table->update_data_size_changed_p())
 	{
 	  The_aarch64_input_section* owner = stub_table->owner();
+	  this->relax_changed_address_ = stub_table->address();
+	  this->relax_changed_section_ =
+	    owner->relobj()->output_section(owner->shndx());
+
 	  uint64_t address = owner->address();
 	  off_t offset = owner->offset();
 	  owner->reset_address_and_file_offset();
@@ -5566,6 +5885,9 @@ Target_aarch64<size, big_endian>::do_relax(
 	}
     }
 
+  if (any_stub_table_changed)
+    this->record_relax_section_extents(layout);
+
   // Do not continue relaxation.
   bool continue_relaxation = any_stub_table_changed;
   if (!continue_relaxation)
@@ -23,13 +23,18 @@
 #include "gold.h"
 
 #include <cerrno>
+#include <cstdio>
 #include <cstring>
 #include <climits>
 #include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include "libiberty.h"
 #include "filenames.h"
 
 #include "elfcpp.h"
+#include "debug.h"
 #include "options.h"
 #include "mapfile.h"
 #include "fileread.h"
@@ -310,6 +315,16 @@ Archive::read_armap(off_t start, section_size_type size)
     reinterpret_cast<const char*>(p) + size - pnames;
   this->armap_names_.assign(pnames, names_size);
 
+  // If we have a cached copy of the symbol map, use it.
+  std::string cache_name;
+  std::string path;
+  if (parameters->options().archive_index_cache() != NULL)
+    {
+      cache_name = this->armap_cache_name(&path);
+      if (this->read_armap_cache(cache_name, path, nsyms, names_size))
+	return;
+    }
+
   this->armap_.resize(nsyms);
 
   section_offset_type name_offset = 0;
@@ -327,13 +342,294 @@ Archive::read_armap(off_t start, section_size_type size)
         }
     }
 
+  // This array keeps track of which symbols are for archive elements
+  // which we have already included in the link.
+  this->armap_checked_.resize(nsyms);
+
   if (static_cast<section_size_type>(name_offset) > names_size)
     gold_error(_("%s: bad archive symbol table names"),
 	       this->name().c_str());
+  else if (!cache_name.empty())
+    {
+      this->build_armap_index();
+      this->write_armap_cache(cache_name, path);
+    }
+}
 
-  // This array keeps track of which symbols are for archive elements
-  // which we have already included in the link.
+// Hash a name in the archive symbol map, ignoring any version.
+
+static inline uint32_t
+armap_name_hash(const char* name)
+{
+  uint32_t h = 2166136261U;
+  for (; *name != '\0' && *name != '@'; ++name)
+    {
+      h ^= static_cast<unsigned char>(*name);
+      h *= 16777619U;
+    }
+  return h;
+}
+
+// Build the hash index of the archive symbol map.
+
+void
+Archive::build_armap_index()
+{
+  size_t nsyms = this->armap_.size();
+  size_t nbuckets = 1;
+  while (nbuckets < nsyms)
+    nbuckets <<= 1;
+  this->armap_buckets_.assign(nbuckets, 0);
+  this->armap_chain_.assign(nsyms, 0);
+
+  // Walk backward so that each chain is in archive map order.
+  for (size_t i = nsyms; i > 0; --i)
+    {
+      const char* name = (this->armap_names_.data()
+			  + this->armap_[i - 1].name_offset);
+      uint32_t* bucket =
+	&this->armap_buckets_[armap_name_hash(name) & (nbuckets - 1)];
+      this->armap_chain_[i - 1] = *bucket;
+      *bucket = i;
+    }
+}
+
+// Add the unchecked entries of the archive symbol map for the symbol
+// NAME, with any version, to *PENDING.
+
+void
+Archive::find_armap_entries(const char* name, std::set<size_t>* pending) const
+{
+  if (this->armap_buckets_.empty())
+    return;
+  size_t len = strlen(name);
+  uint32_t h = armap_name_hash(name) & (this->armap_buckets_.size() - 1);
+  for (uint32_t k = this->armap_buckets_[h];
+       k != 0;
+       k = this->armap_chain_[k - 1])
+    {
+      size_t i = k - 1;
+      if (this->armap_checked_[i])
+	continue;
+      const char* armap_name = (this->armap_names_.data()
+				+ this->armap_[i].name_offset);
+      if (strncmp(armap_name, name, len) == 0
+	  && (armap_name[len] == '\0' || armap_name[len] == '@'))
+	pending->insert(i);
+    }
+}
+
+// The header of a file in the --archive-index-cache directory.  It is
+// followed by the canonical name of the archive, padded to a multiple
+// of 8 bytes; the archive map, as pairs of 64-bit name and file
+// offsets; and then the hash buckets and hash chains, as 32-bit
+// words.  The cache is only meant to be used on the host which wrote
+// it, so everything is in host byte order.
+
+struct Armap_cache_header
+{
+  char magic[8];
+  uint64_t archive_size;
+  int64_t mtime_seconds;
+  int64_t mtime_nanoseconds;
+  uint64_t names_size;
+  uint32_t nsyms;
+  uint32_t nbuckets;
+  uint32_t num_members;
+  uint32_t path_size;
+};
+
+static const char armap_cache_magic[8] =
+{
+  'G', 'O', 'L', 'D', 'A', 'R', 'M', '1'
+};
+
+// Return the name of the cache file for this archive, which is based
+// on a hash of the canonical name of the archive.  Set *PATH to the
+// canonical name.
+
+std::string
+Archive::armap_cache_name(std::string* path)
+{
+  char* canonical_name = lrealpath(this->filename().c_str());
+  *path = canonical_name;
+  free(canonical_name);
+
+  uint64_t h = 14695981039346656037ULL;
+  for (std::string::const_iterator p = path->begin(); p != path->end(); ++p)
+    {
+      h ^= static_cast<unsigned char>(*p);
+      h *= 1099511628211ULL;
+    }
+  char buf[32];
+  snprintf(buf, sizeof buf, "%016llx", static_cast<unsigned long long>(h));
+
+  std::string ret(parameters->options().archive_index_cache());
+  ret += '/';
+  ret += buf;
+  ret += ".armap";
+  return ret;
+}
+
+// Read the archive map and its index from the cache file CACHE_NAME.
+// The cache file is only used if it is for the archive PATH and it
+// matches the size and modification time of the archive.
+
+bool
+Archive::read_armap_cache(const std::string& cache_name,
+			  const std::string& path, unsigned long nsyms,
+			  section_size_type names_size)
+{
+  int o = ::open(cache_name.c_str(), O_RDONLY);
+  if (o < 0)
+    return false;
+  std::string contents;
+  struct stat st;
+  bool ok = ::fstat(o, &st) == 0;
+  if (ok)
+    {
+      contents.resize(st.st_size);
+      size_t got = 0;
+      while (ok && got < contents.size())
+	{
+	  ssize_t len = ::read(o, &contents[got], contents.size() - got);
+	  if (len <= 0)
+	    ok = false;
+	  else
+	    got += len;
+	}
+    }
+  ::close(o);
+  if (!ok || contents.size() < sizeof(Armap_cache_header))
+    return false;
+
+  Armap_cache_header hdr;
+  memcpy(&hdr, contents.data(), sizeof hdr);
+  Timespec mtime = this->file().get_mtime();
+  size_t path_size = align_address(path.size(), 8);
+  if (memcmp(hdr.magic, armap_cache_magic, sizeof hdr.magic) != 0
+      || hdr.archive_size != static_cast<uint64_t>(this->file().filesize())
+      || hdr.mtime_seconds != mtime.seconds
+      || hdr.mtime_nanoseconds != mtime.nanoseconds
+      || hdr.names_size != names_size
+      || hdr.nsyms != nsyms
+      || hdr.path_size != path.size()
+      || hdr.nbuckets == 0
+      || (hdr.nbuckets & (hdr.nbuckets - 1)) != 0
+      || (contents.size()
+	  != (sizeof hdr + path_size + nsyms * 2 * sizeof(uint64_t)
+	      + (hdr.nbuckets + nsyms) * sizeof(uint32_t)))
+      || contents.compare(sizeof hdr, path.size(), path) != 0)
+    return false;
+
+  const char* p = contents.data() + sizeof hdr + path_size;
+  this->armap_.resize(nsyms);
+  for (unsigned long i = 0; i < nsyms; ++i)
+    {
+      uint64_t v[2];
+      memcpy(v, p, sizeof v);
+      p += sizeof v;
+      if (v[0] >= names_size)
+	return false;
+      this->armap_[i].name_offset = v[0];
+      this->armap_[i].file_offset = v[1];
+    }
+
+  this->armap_buckets_.resize(hdr.nbuckets);
+  memcpy(&this->armap_buckets_[0], p, hdr.nbuckets * sizeof(uint32_t));
+  p += hdr.nbuckets * sizeof(uint32_t);
+  this->armap_chain_.resize(nsyms);
+  if (nsyms > 0)
+    memcpy(&this->armap_chain_[0], p, nsyms * sizeof(uint32_t));
+
+  // Make sure that a corrupted cache file can't send us out of
+  // bounds.
+  for (size_t i = 0; i < this->armap_buckets_.size(); ++i)
+    if (this->armap_buckets_[i] > nsyms)
+      return false;
+  for (size_t i = 0; i < this->armap_chain_.size(); ++i)
+    if (this->armap_chain_[i] > nsyms)
+      return false;
+
+  this->num_members_ = hdr.num_members;
   this->armap_checked_.resize(nsyms);
+  gold_debug(DEBUG_FILES, "Read archive index for \"%s\" from \"%s\"",
+	     path.c_str(), cache_name.c_str());
+  return true;
+}
+
+// Write the archive map and its index to the cache file CACHE_NAME.
+// The cache directory is created if it does not exist.  Failing to
+// write the cache is not an error.
+
+void
+Archive::write_armap_cache(const std::string& cache_name,
+			   const std::string& path)
+{
+  Timespec mtime = this->file().get_mtime();
+  Armap_cache_header hdr;
+  memset(&hdr, 0, sizeof hdr);
+  memcpy(hdr.magic, armap_cache_magic, sizeof hdr.magic);
+  hdr.archive_size = this->file().filesize();
+  hdr.mtime_seconds = mtime.seconds;
+  hdr.mtime_nanoseconds = mtime.nanoseconds;
+  hdr.names_size = this->armap_names_.size();
+  hdr.nsyms = this->armap_.size();
+  hdr.nbuckets = this->armap_buckets_.size();
+  hdr.num_members = this->num_members_;
+  hdr.path_size = path.size();
+
+  std::string contents(reinterpret_cast<const char*>(&hdr), sizeof hdr);
+  contents.append(path);
+  contents.append(align_address(path.size(), 8) - path.size(), '\0');
+  for (std::vector<Armap_entry>::const_iterator p = this->armap_.begin();
+       p != this->armap_.end();
+       ++p)
+    {
+      uint64_t v[2];
+      v[0] = p->name_offset;
+      v[1] = p->file_offset;
+      contents.append(reinterpret_cast<const char*>(v), sizeof v);
+    }
+  contents.append(reinterpret_cast<const char*>(&this->armap_buckets_[0]),
+		  this->armap_buckets_.size() * sizeof(uint32_t));
+  if (!this->armap_chain_.empty())
+    contents.append(reinterpret_cast<const char*>(&this->armap_chain_[0]),
+		    this->armap_chain_.size() * sizeof(uint32_t));
+
+  // Write a temporary file and rename it, so that a concurrent link
+  // never sees a partially written cache file.
+  char suffix[32];
+  snprintf(suffix, sizeof suffix, ".%ld", static_cast<long>(getpid()));
+  std::string tmp_name = cache_name + suffix;
+  int o = ::open(tmp_name.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+  if (o < 0 && errno == ENOENT)
+    {
+      // Another link may create the directory at the same time.
+      const char* dir = parameters->options().archive_index_cache();
+      if (::mkdir(dir, 0777) == 0 || errno == EEXIST)
+	o = ::open(tmp_name.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+    }
+  if (o < 0)
+    return;
+  bool ok = true;
+  size_t written = 0;
+  while (ok && written < contents.size())
+    {
+      ssize_t len = ::write(o, contents.data() + written,
+			    contents.size() - written);
+      if (len <= 0)
+	ok = false;
+      else
+	written += len;
+    }
+  if (::close(o) < 0)
+    ok = false;
+  if (!ok || ::rename(tmp_name.c_str(), cache_name.c_str()) < 0)
+    ::unlink(tmp_name.c_str());
+  else
+    gold_debug(DEBUG_FILES, "Wrote archive index for \"%s\" to \"%s\"",
+	       path.c_str(), cache_name.c_str());
 }
 
 // Read the header of an archive member at OFF.  Fail if something
@@ -761,11 +1057,12 @@ Archive::read_symbols(off_t off)
 // Select members from the archive and add them to the link.  We walk
 // through the elements in the archive map, and look each one up in
 // the symbol table.  If it exists as a strong undefined symbol, we
-// pull in the corresponding element.  We have to do this in a loop,
-// since pulling in one element may create new undefined symbols which
-// may be satisfied by other objects in the archive.  Return true in
-// the normal case, false if the first member we tried to add from
-// this archive had an incompatible target.
+// pull in the corresponding element.  Pulling in one element may
+// create new undefined symbols which may be satisfied by other
+// objects in the archive, so after the first pass we look again at
+// the entries for the symbols of each element we pulled in.  Return
+// true in the normal case, false if the first member we tried to add
+// from this archive had an incompatible target.
 
 bool
 Archive::add_symbols(Symbol_table* symtab, Layout* layout,
@@ -781,6 +1078,10 @@ Archive::add_symbols(Symbol_table* symtab, Layout* layout,
 
   input_objects->archive_start(this);
 
+  // We look at the symbol table to decide which members to include,
+  // so it must hold the symbols of the objects before this archive.
+  symtab->add_queued_symbols();
+
   const size_t armap_size = this->armap_.size();
 
   // This is a quick optimization, since we usually see many symbols
@@ -788,65 +1089,113 @@ Archive::add_symbols(Symbol_table* symtab, Layout* layout,
   // offset we saw that was present in the seen_offsets_ set.
   off_t last_seen_offset = -1;
 
-  // Track which symbols in the symbol table we've already found to be
-  // defined.
+  // After the first pass over the archive map, the only entries which
+  // can give a different answer are those for symbols named by the
+  // members we have pulled in since we last looked at them.  We keep
+  // those entries in PENDING, and visit them in the same order as
+  // another full pass would, so that we pull in the members in the
+  // same order.  We can't get the symbols of a plugin object, so with
+  // plugins we just make full passes until nothing changes.
+  const bool full_passes = parameters->options().has_plugins();
+  std::set<size_t> pending;
+  bool first_pass = true;
+  size_t next = 0;
 
   char* tmpbuf = NULL;
   size_t tmpbuflen = 0;
-  bool added_new_object;
-  do
+  bool added_new_object = false;
+  while (true)
     {
-      added_new_object = false;
-      for (size_t i = 0; i < armap_size; ++i)
+      size_t i;
+      if (first_pass)
 	{
-          if (this->armap_checked_[i])
-            continue;
-	  if (this->armap_[i].file_offset == last_seen_offset)
-            {
-              this->armap_checked_[i] = true;
-              continue;
-            }
-	  if (this->seen_offsets_.find(this->armap_[i].file_offset)
-              != this->seen_offsets_.end())
+	  if (next < armap_size)
+	    i = next++;
+	  else if (full_passes && added_new_object)
 	    {
-              this->armap_checked_[i] = true;
-	      last_seen_offset = this->armap_[i].file_offset;
+	      added_new_object = false;
+	      next = 0;
 	      continue;
 	    }
+	  else
+	    {
+	      first_pass = false;
+	      next = 0;
+	      continue;
+	    }
+	}
+      else
+	{
+	  if (pending.empty())
+	    break;
+	  std::set<size_t>::iterator p = pending.lower_bound(next);
+	  if (p == pending.end())
+	    p = pending.begin();
+	  i = *p;
+	  pending.erase(p);
+	  next = i + 1;
+	}
+
+      if (this->armap_checked_[i])
+	continue;
+      if (this->armap_[i].file_offset == last_seen_offset)
+	{
+	  this->armap_checked_[i] = true;
+	  continue;
+	}
+      if (this->seen_offsets_.find(this->armap_[i].file_offset)
+	  != this->seen_offsets_.end())
+	{
+	  this->armap_checked_[i] = true;
+	  last_seen_offset = this->armap_[i].file_offset;
+	  continue;
+	}
 
-	  const char* sym_name = (this->armap_names_.data()
-				  + this->armap_[i].name_offset);
+      const char* sym_name = (this->armap_names_.data()
+			      + this->armap_[i].name_offset);
 
-          Symbol* sym;
-          std::string why;
-          Archive::Should_include t =
-	    Archive::should_include_member(symtab, layout, sym_name, &sym,
-					   &why, &tmpbuf, &tmpbuflen);
+      Symbol* sym;
+      std::string why;
+      Archive::Should_include t =
+	Archive::should_include_member(symtab, layout, sym_name, &sym,
+				       &why, &tmpbuf, &tmpbuflen);
 
-	  if (t == Archive::SHOULD_INCLUDE_NO
-              || t == Archive::SHOULD_INCLUDE_YES)
-	    this->armap_checked_[i] = true;
+      if (t == Archive::SHOULD_INCLUDE_NO
+	  || t == Archive::SHOULD_INCLUDE_YES)
+	this->armap_checked_[i] = true;
 
-	  if (t != Archive::SHOULD_INCLUDE_YES)
-	    continue;
+      if (t != Archive::SHOULD_INCLUDE_YES)
+	continue;
 
-	  // We want to include this object in the link.
-	  last_seen_offset = this->armap_[i].file_offset;
-	  this->seen_offsets_.insert(last_seen_offset);
+      // We want to include this object in the link.
+      last_seen_offset = this->armap_[i].file_offset;
+      this->seen_offsets_.insert(last_seen_offset);
 
-	  if (!this->include_member(symtab, layout, input_objects,
-				    last_seen_offset, mapfile, sym,
-				    why.c_str()))
-	    {
-	      if (tmpbuf != NULL)
-		free(tmpbuf);
-	      return false;
-	    }
+      Object* obj;
+      if (!this->include_member(symtab, layout, input_objects,
+				last_seen_offset, mapfile, sym,
+				why.c_str(), &obj))
+	{
+	  if (tmpbuf != NULL)
+	    free(tmpbuf);
+	  return false;
+	}
+      symtab->add_queued_symbols();
 
-	  added_new_object = true;
+      if (!full_passes && obj != NULL)
+	{
+	  if (this->armap_buckets_.empty())
+	    this->build_armap_index();
+	  const Object::Symbols* syms = obj->get_global_symbols();
+	  for (Object::Symbols::const_iterator p = syms->begin();
+	       p != syms->end();
+	       ++p)
+	    if (*p != NULL)
+	      this->find_armap_entries((*p)->name(), &pending);
 	}
+
+      added_new_object = true;
     }
-  while (added_new_object);
 
   if (tmpbuf != NULL)
     free(tmpbuf);
@@ -915,7 +1264,7 @@ Archive::include_all_members(Symbol_table* symtab, Layout* layout,
            ++p)
         {
           if (!this->include_member(symtab, layout, input_objects, p->first,
-				    mapfile, NULL, "--whole-archive"))
+				    mapfile, NULL, "--whole-archive", NULL))
 	    return false;
           ++Archive::total_members;
         }
@@ -927,7 +1276,7 @@ Archive::include_all_members(Symbol_table* symtab, Layout* layout,
            ++p)
         {
           if (!this->include_member(symtab, layout, input_objects, p->off,
-				    mapfile, NULL, "--whole-archive"))
+				    mapfile, NULL, "--whole-archive", NULL))
 	    return false;
           ++Archive::total_members;
         }
@@ -980,17 +1329,22 @@ class Thin_archive_object_unlocker
 
 // Include an archive member in the link.  OFF is the file offset of
 // the member header.  WHY is the reason we are including this member.
-// Return true if we added the member or if we had an error, return
-// false if this was the first member we tried to add from this
-// archive and it had an incompatible format.
+// If POBJ is not NULL, set *POBJ to the object if we added it to the
+// link, and to NULL otherwise.  Return true if we added the member or
+// if we had an error, return false if this was the first member we
+// tried to add from this archive and it had an incompatible format.
 
 bool
 Archive::include_member(Symbol_table* symtab, Layout* layout,
 			Input_objects* input_objects, off_t off,
-			Mapfile* mapfile, Symbol* sym, const char* why)
+			Mapfile* mapfile, Symbol* sym, const char* why,
+			Object** pobj)
 {
   ++Archive::total_members_loaded;
 
+  if (pobj != NULL)
+    *pobj = NULL;
+
   std::map<off_t, Archive_member>::const_iterator p = this->members_.find(off);
   if (p != this->members_.end())
     {
@@ -1004,6 +1358,8 @@ Archive::include_member(Symbol_table* symtab, Layout* layout,
           obj->layout(symtab, layout, sd);
           obj->add_symbols(symtab, sd, layout);
 	  this->included_member_ = true;
+	  if (pobj != NULL)
+	    *pobj = obj;
         }
       delete sd;
       return true;
@@ -1038,6 +1394,8 @@ Archive::include_member(Symbol_table* symtab, Layout* layout,
     {
       pluginobj->add_symbols(symtab, NULL, layout);
       this->included_member_ = true;
+      if (pobj != NULL)
+	*pobj = obj;
       return true;
     }
 
@@ -1058,6 +1416,8 @@ Archive::include_member(Symbol_table* symtab, Layout* layout,
   }
 
   this->included_member_ = true;
+  if (pobj != NULL)
+    *pobj = obj;
   return true;
 }
 
@@ -1208,6 +1568,8 @@ Lib_group::add_symbols(Symbol_table* symtab, Layout* layout,
 
   Lib_group::total_members += this->members_.size();
 
+  symtab->add_queued_symbols();
+
   bool added_new_object;
   do
     {
@@ -1236,6 +1598,7 @@ Lib_group::add_symbols(Symbol_table* symtab, Layout* layout,
 		}
 
 	      this->include_member(symtab, layout, input_objects, member);
+	      symtab->add_queued_symbols();
 
 	      added_new_object = true;
 	    }
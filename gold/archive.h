@@ -23,6 +23,7 @@
 #ifndef GOLD_ARCHIVE_H
 #define GOLD_ARCHIVE_H
 
+#include <set>
 #include <string>
 #include <vector>
 
@@ -297,6 +298,34 @@ class Archive : public Library_base
   void
   read_armap(off_t start, section_size_type size);
 
+  // Build the hash index of the names in the archive symbol map.
+  void
+  build_armap_index();
+
+  // Return the name of the file in the --archive-index-cache
+  // directory which caches the symbol map of this archive, and set
+  // *PATH to the canonical name of the archive.
+  std::string
+  armap_cache_name(std::string* path);
+
+  // Read the symbol map and its index from the cache file CACHE_NAME,
+  // which should be for the archive PATH.  NSYMS and NAMES_SIZE are
+  // from the archive.  Return false if there is no cache file or it
+  // is out of date.
+  bool
+  read_armap_cache(const std::string& cache_name, const std::string& path,
+		   unsigned long nsyms, section_size_type names_size);
+
+  // Write the symbol map and its index to the cache file CACHE_NAME
+  // for the archive PATH.
+  void
+  write_armap_cache(const std::string& cache_name, const std::string& path);
+
+  // Add the entries of the archive symbol map for NAME which we have
+  // not yet checked to *PENDING.
+  void
+  find_armap_entries(const char* name, std::set<size_t>* pending) const;
+
   // Read an archive member header at OFF.  CACHE is whether to cache
   // the file view.  Return the size of the member, and set *PNAME to
   // the name.
@@ -335,10 +364,11 @@ class Archive : public Library_base
   bool
   include_all_members(Symbol_table*, Layout*, Input_objects*, Mapfile*);
 
-  // Include an archive member in the link.
+  // Include an archive member in the link.  If POBJ is not NULL, set
+  // *POBJ to the object if it was added to the link.
   bool
   include_member(Symbol_table*, Layout*, Input_objects*, off_t off,
-		 Mapfile*, Symbol*, const char* why);
+		 Mapfile*, Symbol*, const char* why, Object** pobj);
 
   // Return whether we found this archive by searching a directory.
   bool
@@ -388,6 +418,13 @@ class Archive : public Library_base
   std::vector<Armap_entry> armap_;
   // The names in the archive map.
   std::string armap_names_;
+  // A hash index of the archive map by symbol name, without any
+  // version.  Each bucket holds the index plus one of the first
+  // entry in its chain, or zero.
+  std::vector<uint32_t> armap_buckets_;
+  // The index plus one of the next entry in the same hash chain, or
+  // zero, for each entry in the archive map.
+  std::vector<uint32_t> armap_chain_;
   // The extended name table.
   std::string extended_names_;
   // Track which symbols in the archive map are for elements which are
@@ -22,56 +22,271 @@
 
 #include "gold.h"
 #include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
 #include "parameters.h"
 #include "options.h"
+#include "gold-threads.h"
+#include "timer.h"
 #include "compressed_output.h"
 
 namespace gold
 {
 
-// Compress UNCOMPRESSED_DATA of size UNCOMPRESSED_SIZE.  Returns true
-// if it successfully compressed, false if it failed for any reason
-// (including not having zlib support in the library).  If it returns
-// true, it allocates memory for the compressed data using new, and
-// sets *COMPRESSED_DATA and *COMPRESSED_SIZE to appropriate values.
-// It also writes a header before COMPRESSED_DATA: 4 bytes saying
-// "ZLIB", and 8 bytes indicating the uncompressed size, in big-endian
-// order.
+// The size of the pieces into which the contents of a section are
+// split for compression.  The pieces are compressed independently, in
+// parallel when using threads.  This does not depend on the number of
+// threads, so neither does the output.
 
-static bool
-zlib_compress(int header_size,
-              const unsigned char* uncompressed_data,
-              unsigned long uncompressed_size,
-              unsigned char** compressed_data,
-              unsigned long* compressed_size)
+static const unsigned long compress_chunk_size = 1024 * 1024;
+
+// The compression methods.
+
+enum Compress_method
 {
-  *compressed_size = uncompressed_size + uncompressed_size / 1000 + 128;
-  *compressed_data = new unsigned char[*compressed_size + header_size];
+  COMPRESS_ZLIB,
+  COMPRESS_ZSTD
+};
 
-  int compress_level;
-  if (parameters->options().optimize() >= 1)
-    compress_level = 9;
-  else
-    compress_level = 1;
-
-  int rc = compress2(reinterpret_cast<Bytef*>(*compressed_data) + header_size,
-                     compressed_size,
-                     reinterpret_cast<const Bytef*>(uncompressed_data),
-                     uncompressed_size,
-                     compress_level);
-  if (rc == Z_OK)
+// The result of compressing one piece of a section.
+
+struct Compressed_chunk
+{
+  Compressed_chunk()
+    : data(NULL), size(0), adler(0), ok(false)
+  { }
+
+  // The compressed data, allocated with new[].
+  unsigned char* data;
+  // The size of the compressed data.
+  unsigned long size;
+  // The Adler-32 checksum of the uncompressed piece, for zlib.
+  unsigned long adler;
+  // Whether the piece was compressed successfully.
+  bool ok;
+};
+
+// The Parallel_jobs which compress the pieces of a section.  Job I
+// compresses the I'th piece of compress_chunk_size bytes.  For zlib
+// each piece is compressed to raw deflate blocks, primed with the
+// preceding 32K of data, and all but the last piece end with a sync
+// flush, so that the pieces concatenate to a single deflate stream.
+// For zstd each piece is a separate frame; a sequence of frames is
+// itself a valid zstd stream.
+
+class Compress_jobs : public Parallel_jobs
+{
+ public:
+  Compress_jobs(Compress_method method, int level,
+		const unsigned char* data, unsigned long size,
+		std::vector<Compressed_chunk>* chunks)
+    : method_(method), level_(level), data_(data), size_(size),
+      chunks_(chunks)
+  { }
+
+ protected:
+  void
+  do_run_job(unsigned int index);
+
+ private:
+  // Compress a piece with zlib.
+  void
+  zlib_compress_chunk(unsigned int index, Compressed_chunk*);
+
+#ifdef HAVE_ZSTD
+  // Compress a piece with zstd.
+  void
+  zstd_compress_chunk(unsigned int index, Compressed_chunk*);
+#endif
+
+  Compress_method method_;
+  int level_;
+  const unsigned char* data_;
+  unsigned long size_;
+  std::vector<Compressed_chunk>* chunks_;
+};
+
+void
+Compress_jobs::do_run_job(unsigned int index)
+{
+  Compressed_chunk* chunk = &(*this->chunks_)[index];
+  switch (this->method_)
     {
-      *compressed_size += header_size;
-      return true;
+    case COMPRESS_ZLIB:
+      this->zlib_compress_chunk(index, chunk);
+      break;
+#ifdef HAVE_ZSTD
+    case COMPRESS_ZSTD:
+      this->zstd_compress_chunk(index, chunk);
+      break;
+#endif
+    default:
+      gold_unreachable();
     }
-  else
+}
+
+void
+Compress_jobs::zlib_compress_chunk(unsigned int index, Compressed_chunk* chunk)
+{
+  const unsigned long start = index * compress_chunk_size;
+  const unsigned long len = std::min(this->size_ - start, compress_chunk_size);
+  const bool last = start + len == this->size_;
+
+  z_stream strm;
+  strm.zalloc = NULL;
+  strm.zfree = NULL;
+  strm.opaque = NULL;
+  if (deflateInit2(&strm, this->level_, Z_DEFLATED, -MAX_WBITS, 8,
+		   Z_DEFAULT_STRATEGY) != Z_OK)
+    return;
+
+  // Use the end of the previous piece as the dictionary, so that the
+  // compression ratio is close to that of a single stream.
+  const unsigned long dict_size = std::min(start, 32768UL);
+  if (dict_size > 0
+      && deflateSetDictionary(&strm, this->data_ + start - dict_size,
+			      dict_size) != Z_OK)
     {
-      delete[] *compressed_data;
-      *compressed_data = NULL;
-      return false;
+      deflateEnd(&strm);
+      return;
+    }
+
+  // A sync flush adds at most an empty stored block to the bound.
+  unsigned long bound = deflateBound(&strm, len) + 8;
+  chunk->data = new unsigned char[bound];
+  strm.next_in = const_cast<Bytef*>(this->data_ + start);
+  strm.avail_in = len;
+  strm.next_out = chunk->data;
+  strm.avail_out = bound;
+  int rc = deflate(&strm, last ? Z_FINISH : Z_SYNC_FLUSH);
+  if (rc == (last ? Z_STREAM_END : Z_OK)
+      && strm.avail_in == 0
+      && strm.avail_out > 0)
+    {
+      chunk->size = bound - strm.avail_out;
+      chunk->adler = adler32(adler32(0L, Z_NULL, 0), this->data_ + start, len);
+      chunk->ok = true;
+    }
+  deflateEnd(&strm);
+}
+
+#ifdef HAVE_ZSTD
+
+void
+Compress_jobs::zstd_compress_chunk(unsigned int index, Compressed_chunk* chunk)
+{
+  const unsigned long start = index * compress_chunk_size;
+  const unsigned long len = std::min(this->size_ - start, compress_chunk_size);
+
+  size_t bound = ZSTD_compressBound(len);
+  chunk->data = new unsigned char[bound];
+  size_t rc = ZSTD_compress(chunk->data, bound, this->data_ + start, len,
+			    this->level_);
+  if (!ZSTD_isError(rc))
+    {
+      chunk->size = rc;
+      chunk->ok = true;
     }
 }
 
+#endif // defined(HAVE_ZSTD)
+
+// Compress UNCOMPRESSED_DATA of size UNCOMPRESSED_SIZE using METHOD
+// at compression level LEVEL.  Returns true if it successfully
+// compressed, false if it failed for any reason.  If it returns true,
+// it allocates memory for the compressed data using new, and sets
+// *COMPRESSED_DATA and *COMPRESSED_SIZE to appropriate values.  The
+// first HEADER_SIZE bytes of *COMPRESSED_DATA are left for the caller
+// to fill in with the compression header.  For zlib the data is a
+// single zlib stream; for a section which fits in one piece this is
+// the same as what compress2 would produce.
+
+static bool
+compress_data(Compress_method method,
+	      int level,
+	      int header_size,
+	      const unsigned char* uncompressed_data,
+	      unsigned long uncompressed_size,
+	      unsigned char** compressed_data,
+	      unsigned long* compressed_size)
+{
+  unsigned int chunk_count = ((uncompressed_size + compress_chunk_size - 1)
+			      / compress_chunk_size);
+  if (chunk_count == 0)
+    chunk_count = 1;
+
+  std::vector<Compressed_chunk> chunks(chunk_count);
+  Compress_jobs jobs(method, level, uncompressed_data, uncompressed_size,
+		     &chunks);
+  jobs.run(chunk_count);
+
+  bool ok = true;
+  unsigned long size = header_size;
+  for (unsigned int i = 0; i < chunk_count; ++i)
+    {
+      ok = ok && chunks[i].ok;
+      size += chunks[i].size;
+    }
+
+  if (ok)
+    {
+      // A zlib stream has a two byte header and ends with the
+      // Adler-32 checksum of the uncompressed data.
+      if (method == COMPRESS_ZLIB)
+	size += 2 + 4;
+
+      *compressed_data = new unsigned char[size];
+      // Clear the header, so that any reserved fields are zero.
+      memset(*compressed_data, 0, header_size);
+      unsigned char* p = *compressed_data + header_size;
+      if (method == COMPRESS_ZLIB)
+	{
+	  // The header is the one zlib itself would write.
+	  int level_flags;
+	  if (level == Z_DEFAULT_COMPRESSION || level == 6)
+	    level_flags = 2;
+	  else if (level < 2)
+	    level_flags = 0;
+	  else if (level < 6)
+	    level_flags = 1;
+	  else
+	    level_flags = 3;
+	  unsigned int header = (0x78 << 8) | (level_flags << 6);
+	  header += 31 - header % 31;
+	  elfcpp::Swap_unaligned<16, true>::writeval(p, header);
+	  p += 2;
+	}
+
+      unsigned long adler = adler32(0L, Z_NULL, 0);
+      for (unsigned int i = 0; i < chunk_count; ++i)
+	{
+	  memcpy(p, chunks[i].data, chunks[i].size);
+	  p += chunks[i].size;
+	  if (method == COMPRESS_ZLIB)
+	    {
+	      unsigned long start = i * compress_chunk_size;
+	      adler = adler32_combine(adler, chunks[i].adler,
+				      std::min(uncompressed_size - start,
+					       compress_chunk_size));
+	    }
+	}
+
+      if (method == COMPRESS_ZLIB)
+	{
+	  elfcpp::Swap_unaligned<32, true>::writeval(p, adler);
+	  p += 4;
+	}
+      gold_assert(static_cast<unsigned long>(p - *compressed_data) == size);
+      *compressed_size = size;
+    }
+
+  for (unsigned int i = 0; i < chunk_count; ++i)
+    delete[] chunks[i].data;
+
+  return ok;
+}
+
 // Decompress COMPRESSED_DATA of size COMPRESSED_SIZE, into a buffer
 // UNCOMPRESSED_DATA of size UNCOMPRESSED_SIZE.  Returns TRUE if it
 // decompressed successfully, false if it failed.  The buffer, of
@@ -115,6 +330,25 @@ zlib_decompress(const unsigned char* compressed_data,
   return true;
 }
 
+#ifdef HAVE_ZSTD
+
+// Decompress zstd COMPRESSED_DATA of size COMPRESSED_SIZE, into a
+// buffer UNCOMPRESSED_DATA of size UNCOMPRESSED_SIZE.  Returns TRUE if
+// it decompressed successfully, false if it failed.
+
+static bool
+zstd_decompress(const unsigned char* compressed_data,
+		unsigned long compressed_size,
+		unsigned char* uncompressed_data,
+		unsigned long uncompressed_size)
+{
+  size_t rc = ZSTD_decompress(uncompressed_data, uncompressed_size,
+			      compressed_data, compressed_size);
+  return !ZSTD_isError(rc) && rc == uncompressed_size;
+}
+
+#endif // defined(HAVE_ZSTD)
+
 // Read the compression header of a compressed debug section and return
 // the uncompressed size.
 
@@ -148,20 +382,19 @@ decompress_input_section(const unsigned char* compressed_data,
   if ((sh_flags & elfcpp::SHF_COMPRESSED) != 0)
     {
       unsigned int compression_header_size;
+      elfcpp::Elf_Word ch_type;
       if (size == 32)
 	{
 	  compression_header_size = elfcpp::Elf_sizes<32>::chdr_size;
 	  if (big_endian)
 	    {
 	      elfcpp::Chdr<32, true> chdr(compressed_data);
-	      if (chdr.get_ch_type() != elfcpp::ELFCOMPRESS_ZLIB)
-		return false;
+	      ch_type = chdr.get_ch_type();
 	    }
 	  else
 	    {
 	      elfcpp::Chdr<32, false> chdr(compressed_data);
-	      if (chdr.get_ch_type() != elfcpp::ELFCOMPRESS_ZLIB)
-		return false;
+	      ch_type = chdr.get_ch_type();
 	    }
 	}
       else if (size == 64)
@@ -170,23 +403,30 @@ decompress_input_section(const unsigned char* compressed_data,
 	  if (big_endian)
 	    {
 	      elfcpp::Chdr<64, true> chdr(compressed_data);
-	      if (chdr.get_ch_type() != elfcpp::ELFCOMPRESS_ZLIB)
-		return false;
+	      ch_type = chdr.get_ch_type();
 	    }
 	  else
 	    {
 	      elfcpp::Chdr<64, false> chdr(compressed_data);
-	      if (chdr.get_ch_type() != elfcpp::ELFCOMPRESS_ZLIB)
-		return false;
+	      ch_type = chdr.get_ch_type();
 	    }
 	}
       else
 	gold_unreachable();
 
-      return zlib_decompress(compressed_data + compression_header_size,
-			     compressed_size - compression_header_size,
-			     uncompressed_data,
-			     uncompressed_size);
+      if (ch_type == elfcpp::ELFCOMPRESS_ZLIB)
+	return zlib_decompress(compressed_data + compression_header_size,
+			       compressed_size - compression_header_size,
+			       uncompressed_data,
+			       uncompressed_size);
+#ifdef HAVE_ZSTD
+      if (ch_type == elfcpp::ELFCOMPRESS_ZSTD)
+	return zstd_decompress(compressed_data + compression_header_size,
+			       compressed_size - compression_header_size,
+			       uncompressed_data,
+			       uncompressed_size);
+#endif
+      return false;
     }
 
   const unsigned int zlib_header_size = 12;
@@ -211,6 +451,12 @@ decompress_input_section(const unsigned char* compressed_data,
 
 // Class Output_compressed_section.
 
+// Statistics for --stats.
+unsigned int Output_compressed_section::compressed_section_count;
+unsigned long long Output_compressed_section::total_uncompressed_size;
+unsigned long long Output_compressed_section::total_compressed_size;
+long long Output_compressed_section::total_compress_usec;
+
 // Set the final data size of a compressed section.  This is where
 // we actually compress the section data.
 
@@ -220,7 +466,7 @@ Output_compressed_section::set_final_data_size()
   off_t uncompressed_size = this->postprocessing_buffer_size();
 
   // (Try to) compress the data.
-  unsigned long compressed_size;
+  unsigned long compressed_size = 0;
   unsigned char* uncompressed_data = this->postprocessing_buffer();
 
   // At this point the contents of all regular input sections will
@@ -230,15 +476,17 @@ Output_compressed_section::set_final_data_size()
   this->write_to_postprocessing_buffer();
 
   bool success = false;
-  enum { none, gnu_zlib, gabi_zlib } compress;
+  enum { none, gnu_zlib, gabi_zlib, gabi_zstd } compress;
   int compression_header_size = 12;
   const int size = parameters->target().get_size();
-  if (strcmp(this->options_->compress_debug_sections(), "zlib-gnu") == 0)
+  const char* method = this->options_->compress_debug_sections();
+  if (strcmp(method, "zlib-gnu") == 0)
     compress = gnu_zlib;
-  else if (strcmp(this->options_->compress_debug_sections(), "zlib-gabi") == 0
-	   || strcmp(this->options_->compress_debug_sections(), "zlib") == 0)
+  else if (strcmp(method, "zlib-gabi") == 0
+	   || strcmp(method, "zlib") == 0
+	   || strcmp(method, "zstd") == 0)
     {
-      compress = gabi_zlib;
+      compress = strcmp(method, "zstd") == 0 ? gabi_zstd : gabi_zlib;
       if (size == 32)
 	compression_header_size = elfcpp::Elf_sizes<32>::chdr_size;
       else if (size == 64)
@@ -248,32 +496,57 @@ Output_compressed_section::set_final_data_size()
     }
   else
     compress = none;
+
+  // The zlib default is to compress quickly unless optimizing; zstd is
+  // fast enough at its own default level.
+  int level = this->options_->compression_level();
+  if (level < 0 && compress != gabi_zstd)
+    level = parameters->options().optimize() >= 1 ? 9 : 1;
+  else if (level < 0)
+    level = 0;
+
   if (compress != none)
-    success = zlib_compress(compression_header_size, uncompressed_data,
-			    uncompressed_size, &this->data_,
-			    &compressed_size);
+    {
+      long long start_usec = Timer::current_wall_usec();
+      success = compress_data(compress == gabi_zstd
+			      ? COMPRESS_ZSTD
+			      : COMPRESS_ZLIB,
+			      level, compression_header_size,
+			      uncompressed_data, uncompressed_size,
+			      &this->data_, &compressed_size);
+      if (success)
+	{
+	  ++compressed_section_count;
+	  total_uncompressed_size += uncompressed_size;
+	  total_compressed_size += compressed_size;
+	  total_compress_usec += Timer::current_wall_usec() - start_usec;
+	}
+    }
   if (success)
     {
       elfcpp::Elf_Xword flags = this->flags();
-      if (compress == gabi_zlib)
+      if (compress == gabi_zlib || compress == gabi_zstd)
 	{
 	  // Set the SHF_COMPRESSED bit.
 	  flags |= elfcpp::SHF_COMPRESSED;
 	  const bool is_big_endian = parameters->target().is_big_endian();
 	  uint64_t addralign = this->addralign();
+	  elfcpp::Elf_Word ch_type = (compress == gabi_zstd
+				      ? elfcpp::ELFCOMPRESS_ZSTD
+				      : elfcpp::ELFCOMPRESS_ZLIB);
 	  if (size == 32)
 	    {
 	      if (is_big_endian)
 		{
 		  elfcpp::Chdr_write<32, true> chdr(this->data_);
-		  chdr.put_ch_type(elfcpp::ELFCOMPRESS_ZLIB);
+		  chdr.put_ch_type(ch_type);
 		  chdr.put_ch_size(uncompressed_size);
 		  chdr.put_ch_addralign(addralign);
 		}
 	      else
 		{
 		  elfcpp::Chdr_write<32, false> chdr(this->data_);
-		  chdr.put_ch_type(elfcpp::ELFCOMPRESS_ZLIB);
+		  chdr.put_ch_type(ch_type);
 		  chdr.put_ch_size(uncompressed_size);
 		  chdr.put_ch_addralign(addralign);
 		}
@@ -283,14 +556,14 @@ Output_compressed_section::set_final_data_size()
 	      if (is_big_endian)
 		{
 		  elfcpp::Chdr_write<64, true> chdr(this->data_);
-		  chdr.put_ch_type(elfcpp::ELFCOMPRESS_ZLIB);
+		  chdr.put_ch_type(ch_type);
 		  chdr.put_ch_size(uncompressed_size);
 		  chdr.put_ch_addralign(addralign);
 		}
 	      else
 		{
 		  elfcpp::Chdr_write<64, false> chdr(this->data_);
-		  chdr.put_ch_type(elfcpp::ELFCOMPRESS_ZLIB);
+		  chdr.put_ch_type(ch_type);
 		  chdr.put_ch_size(uncompressed_size);
 		  chdr.put_ch_addralign(addralign);
 		}
@@ -313,12 +586,37 @@ Output_compressed_section::set_final_data_size()
     }
   else
     {
-      gold_warning(_("not compressing section data: zlib error"));
+      if (compress == gabi_zstd)
+	gold_warning(_("not compressing section data: zstd error"));
+      else
+	gold_warning(_("not compressing section data: zlib error"));
       gold_assert(this->data_ == NULL);
       this->set_data_size(uncompressed_size);
     }
 }
 
+// Print statistics about compressed sections to stderr.
+
+void
+Output_compressed_section::print_stats()
+{
+  if (compressed_section_count == 0)
+    return;
+  fprintf(stderr, _("%s: compressed sections: %u\n"),
+	  program_name, compressed_section_count);
+  fprintf(stderr, _("%s: compressed sections input size: %llu bytes\n"),
+	  program_name, total_uncompressed_size);
+  fprintf(stderr, _("%s: compressed sections output size: %llu bytes\n"),
+	  program_name, total_compressed_size);
+  double seconds = total_compress_usec / 1000000.0;
+  fprintf(stderr,
+	  _("%s: compression time: %.6f seconds (%.1f MB/s)\n"),
+	  program_name, seconds,
+	  (seconds > 0
+	   ? total_uncompressed_size / seconds / (1024 * 1024)
+	   : 0.0));
+}
+
 // Write out a compressed section.  If we couldn't compress, we just
 // write it out as normal, uncompressed data.
 
@@ -60,9 +60,13 @@ class Output_compressed_section : public Output_section
 			    const char* name, elfcpp::Elf_Word flags,
 			    elfcpp::Elf_Xword type)
     : Output_section(name, flags, type),
-      options_(options)
+      options_(options), data_(NULL)
   { this->set_requires_postprocessing(); }
 
+  // Print statistics about compressed sections to stderr.
+  static void
+  print_stats();
+
  protected:
   // Set the final data size.
   void
@@ -79,6 +83,12 @@ class Output_compressed_section : public Output_section
   unsigned char* data_;
   // The new section name if we do compress.
   std::string new_section_name_;
+
+  // Statistics for --stats.
+  static unsigned int compressed_section_count;
+  static unsigned long long total_uncompressed_size;
+  static unsigned long long total_compressed_size;
+  static long long total_compress_usec;
 };
 
 } // End namespace gold.
@@ -436,6 +436,12 @@ class Dwarf_pubnames_table
   const char*
   next_name(uint8_t* flag_byte);
 
+  // Return TRUE if this is a gnu-style table, which lists all the
+  // names of the units it covers.
+  bool
+  is_gnu_style() const
+  { return this->is_gnu_style_; }
+
  private:
   // The Dwarf_info_reader, for reading data.
   Dwarf_info_reader* dwinfo_;
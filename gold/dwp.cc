@@ -28,6 +28,9 @@
 #include <cstdlib>
 #include <cstring>
 #include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include <vector>
 #include <algorithm>
@@ -40,7 +43,9 @@
 #include "elfcpp_file.h"
 #include "dwarf.h"
 #include "dirsearch.h"
+#include "descriptors.h"
 #include "fileread.h"
+#include "gold-threads.h"
 #include "object.h"
 #include "compressed_output.h"
 #include "stringpool.h"
@@ -99,6 +104,28 @@ struct Unit_set
   { }
 };
 
+// A compilation unit or type unit found in a .debug_info.dwo or
+// .debug_types.dwo section: its offset and length within the section,
+// and its DWO id or type signature.
+
+struct Unit_info
+{
+  off_t offset;
+  off_t length;
+  uint64_t signature;
+
+  Unit_info(off_t o, off_t l, uint64_t s)
+    : offset(o), length(l), signature(s)
+  { }
+};
+typedef std::vector<Unit_info> Unit_list;
+
+// Types for mapping input string offsets to the keys of the strings
+// in the output string table.  The output string offsets are not
+// known until all the input files have been read.
+typedef std::pair<section_offset_type, Stringpool::Key> Str_offset_map_entry;
+typedef std::vector<Str_offset_map_entry> Str_offset_map;
+
 // An input file.
 // This class may represent a .dwo file, a .dwp file
 // produced by an earlier run, or an executable file whose
@@ -108,9 +135,16 @@ class Dwo_file
 {
  public:
   Dwo_file(const char* name)
-    : name_(name), obj_(NULL), input_file_(NULL), is_compressed_(),
-      sect_offsets_(), str_offset_map_()
-  { }
+    : name_(name), obj_(NULL), input_file_(NULL), machine_(0), size_(0),
+      big_endian_(false), osabi_(0), abiversion_(0), is_compressed_(),
+      file_offsets_(), sect_offsets_(), debug_types_(), debug_str_(0),
+      debug_cu_index_(0), debug_tu_index_(0), info_units_(), types_units_(),
+      str_contents_(NULL), str_len_(0), str_is_new_(false),
+      string_count_(0), str_offset_map_(NULL), input_index_(-1U)
+  {
+    for (unsigned int i = 0; i <= elfcpp::DW_SECT_MAX; i++)
+      this->debug_shndx_[i] = 0;
+  }
 
   ~Dwo_file();
 
@@ -119,7 +153,26 @@ class Dwo_file
   void
   read_executable(File_list* files);
 
-  // Read the input file and send its contents to OUTPUT_FILE.
+  // Open the input file, find its debug sections, and parse the units
+  // of a .dwo file.  This does not touch the output file, so it may
+  // be called for several input files at once.
+  void
+  open();
+
+  // Return the number of strings in the input string table.  This is
+  // valid after calling open.
+  size_t
+  string_count() const
+  { return this->string_count_; }
+
+  // Merge the input string table section into the output file, using
+  // the string ordinals starting at FIRST_ORDINAL.  This may be called
+  // for several input files at once.
+  void
+  add_strings(Dwp_output_file*, uint64_t first_ordinal);
+
+  // Send the contents of the input file to OUTPUT_FILE.  This must be
+  // called after open and add_strings.
   void
   read(Dwp_output_file* output_file);
 
@@ -130,30 +183,14 @@ class Dwo_file
   verify(const File_list& files);
 
  private:
-  // Types for mapping input string offsets to output string offsets.
-  typedef std::pair<section_offset_type, section_offset_type>
-      Str_offset_map_entry;
-  typedef std::vector<Str_offset_map_entry> Str_offset_map;
-
-  // A less-than comparison routine for Str_offset_map.
-  struct Offset_compare
-  {
-    bool
-    operator()(const Str_offset_map_entry& i1,
-	       const Str_offset_map_entry& i2) const
-    { return i1.first < i2.first; }
-  };
-
   // Create a Sized_relobj_dwo of the given size and endianness,
-  // and record the target info.  P is a pointer to the ELF header
-  // in memory.
+  // and record the target info.
   Relobj*
-  make_object(Dwp_output_file* output_file);
+  make_object();
 
   template <int size, bool big_endian>
   Relobj*
-  sized_make_object(const unsigned char* p, Input_file* input_file,
-		    Dwp_output_file* output_file);
+  sized_make_object(const unsigned char* p, Input_file* input_file);
 
   // Return the number of sections in the input object file.
   unsigned int
@@ -177,6 +214,11 @@ class Dwo_file
   section_contents(unsigned int shndx, section_size_type* plen, bool* is_new)
   { return this->obj_->decompressed_section_contents(shndx, plen, is_new); }
 
+  // Return the index of this file in the output file's list of input
+  // files, adding it if necessary.
+  unsigned int
+  input_index(Dwp_output_file* output_file);
+
   // Read the .debug_cu_index or .debug_tu_index section of a .dwp file,
   // and process the CU or TU sets.
   void
@@ -198,33 +240,16 @@ class Dwo_file
   bool
   sized_verify_dwo_list(unsigned int, const File_list& files);
 
-  // Merge the input string table section into the output file.
-  void
-  add_strings(Dwp_output_file*, unsigned int);
-
   // Copy a section from the input file to the output file.
   Section_bounds
   copy_section(Dwp_output_file* output_file, unsigned int shndx,
 	       elfcpp::DW_SECT section_id);
 
-  // Remap the string offsets in the .debug_str_offsets.dwo section.
-  const unsigned char*
-  remap_str_offsets(const unsigned char* contents, section_size_type len);
-
-  template <bool big_endian>
-  const unsigned char*
-  sized_remap_str_offsets(const unsigned char* contents, section_size_type len);
-
-  // Remap a single string offsets from an offset in the input string table
-  // to an offset in the output string table.
-  unsigned int
-  remap_str_offset(section_offset_type val);
-
   // Add a set of .debug_info.dwo or .debug_types.dwo and related sections
-  // to OUTPUT_FILE.
+  // to OUTPUT_FILE.  UNITS are the units found in the section by open.
   void
   add_unit_set(Dwp_output_file* output_file, unsigned int *debug_shndx,
-	       bool is_debug_types);
+	       bool is_debug_types, const Unit_list& units);
 
   // The filename.
   const char* name_;
@@ -232,12 +257,42 @@ class Dwo_file
   Relobj* obj_;
   // The Input_file object.
   Input_file* input_file_;
+  // ELF header parameters.
+  int machine_;
+  int size_;
+  bool big_endian_;
+  int osabi_;
+  int abiversion_;
   // Flags indicating which sections are compressed.
   std::vector<bool> is_compressed_;
+  // The file offset of each section which is not compressed, and so
+  // may be copied directly to the output file, or -1.
+  std::vector<off_t> file_offsets_;
   // Map input section index onto output section offset and size.
   std::vector<Section_bounds> sect_offsets_;
-  // Map input string offsets to output string offsets.
-  Str_offset_map str_offset_map_;
+  // The debug sections found by open.
+  unsigned int debug_shndx_[elfcpp::DW_SECT_MAX + 1];
+  std::vector<unsigned int> debug_types_;
+  unsigned int debug_str_;
+  unsigned int debug_cu_index_;
+  unsigned int debug_tu_index_;
+  // The units in the .debug_info.dwo section, and in each
+  // .debug_types.dwo section, of a .dwo file.
+  Unit_list info_units_;
+  std::vector<Unit_list> types_units_;
+  // The contents of the input string table, between open and
+  // add_strings.
+  const unsigned char* str_contents_;
+  section_size_type str_len_;
+  bool str_is_new_;
+  // The number of strings in the input string table.
+  size_t string_count_;
+  // Map input string offsets to output string keys.  This is handed
+  // over to the output file along with .debug_str_offsets.dwo.
+  Str_offset_map* str_offset_map_;
+  // The index of this file in the output file's list of input files,
+  // or -1U if it has not been added.
+  unsigned int input_index_;
 };
 
 // An ELF input file.
@@ -264,6 +319,11 @@ class Sized_relobj_dwo : public Sized_relobj<size, big_endian>
   void
   setup();
 
+  // Return the file offset of the contents of a section.
+  off_t
+  section_file_offset(unsigned int shndx)
+  { return this->elf_file_.section_contents(shndx).file_offset; }
+
  protected:
   // Return section type.
   unsigned int
@@ -452,10 +512,12 @@ class Dwp_output_file
       abiversion_(0), fd_(NULL), next_file_offset_(0), shnum_(1), sections_(),
       section_id_map_(), shoff_(0), shstrndx_(0), have_strings_(false),
       stringpool_(), shstrtab_(), cu_index_(), tu_index_(), last_type_sig_(0),
-      last_tu_slot_(0)
+      last_tu_slot_(0), input_files_()
   {
     this->section_id_map_.resize(elfcpp::DW_SECT_MAX + 1);
     this->stringpool_.set_no_zero_null();
+    if (parameters->options().threads())
+      this->stringpool_.set_concurrent();
   }
 
   // Record the target info from an input file.
@@ -463,15 +525,43 @@ class Dwp_output_file
   record_target_info(const char* name, int machine, int size, bool big_endian,
 		     int osabi, int abiversion);
 
-  // Add a string to the debug strings section.
-  section_offset_type
-  add_string(const char* str, size_t len);
+  // Reserve ordinals for COUNT strings to be added to the debug
+  // strings section, and return the first one.
+  uint64_t
+  reserve_string_ordinals(size_t count);
+
+  // Add a string to the debug strings section, using an ordinal from
+  // reserve_string_ordinals, and return its key.  This may be called
+  // by several threads at once.
+  Stringpool::Key
+  add_string(const char* str, size_t len, uint64_t ordinal);
+
+  // Record an input file whose contents may be copied directly to the
+  // output file, and return its index.
+  unsigned int
+  add_input_file(const std::string& name);
 
   // Add a section to the output file, and return the new section offset.
   section_offset_type
   add_contribution(elfcpp::DW_SECT section_id, const unsigned char* contents,
 		   section_size_type len, int align);
 
+  // Add a section whose contents are LEN bytes at INPUT_OFFSET in the
+  // input file with index INPUT_FILE, and return the new section
+  // offset.  The contents are copied when the file is finalized.
+  section_offset_type
+  add_contribution(elfcpp::DW_SECT section_id, unsigned int input_file,
+		   off_t input_offset, section_size_type len, int align);
+
+  // Add a .debug_str_offsets.dwo section, and return the new section
+  // offset.  The string offsets in CONTENTS are remapped using
+  // STR_OFFSET_MAP when the file is finalized.  The output file takes
+  // ownership of CONTENTS and STR_OFFSET_MAP.
+  section_offset_type
+  add_str_offsets_contribution(const unsigned char* contents,
+			       section_size_type len,
+			       Str_offset_map* str_offset_map, int align);
+
   // Add a set of .debug_info and related sections to the output file.
   void
   add_cu_set(Unit_set* cu_set);
@@ -490,12 +580,57 @@ class Dwp_output_file
   finalize();
 
  private:
-  // Contributions to output sections.
+  // Contributions to output sections.  The contents are either in
+  // memory, or are copied from an input file when the output file is
+  // finalized.
   struct Contribution
   {
     section_offset_type output_offset;
     section_size_type size;
+    // The contents, or NULL if they are copied from an input file.
     const unsigned char* contents;
+    // For contents copied from an input file, the index of the file
+    // in INPUT_FILES_, and the offset of the contents in the file.
+    unsigned int input_file;
+    off_t input_offset;
+    // For .debug_str_offsets.dwo, the map used to remap the string
+    // offsets, or NULL.
+    Str_offset_map* str_offset_map;
+  };
+
+  // A contribution to be copied from an input file, with its final
+  // file offset in the output file.
+  struct Input_copy
+  {
+    unsigned int input_file;
+    off_t input_offset;
+    off_t output_offset;
+    section_size_type size;
+
+    Input_copy(unsigned int i, off_t in, off_t out, section_size_type s)
+      : input_file(i), input_offset(in), output_offset(out), size(s)
+    { }
+  };
+
+  // Sort Input_copy entries by input file and then input offset.
+  struct Input_copy_compare
+  {
+    bool
+    operator()(const Input_copy& c1, const Input_copy& c2) const
+    {
+      if (c1.input_file != c2.input_file)
+	return c1.input_file < c2.input_file;
+      return c1.input_offset < c2.input_offset;
+    }
+  };
+
+  // A less-than comparison routine for Str_offset_map.
+  struct Offset_compare
+  {
+    bool
+    operator()(const Str_offset_map_entry& i1,
+	       const Str_offset_map_entry& i2) const
+    { return i1.first < i2.first; }
   };
 
   // Sections in the output file.
@@ -605,6 +740,12 @@ class Dwp_output_file
   unsigned int
   add_output_section(const char* section_name, int align);
 
+  // Add a contribution to a section in the output file.  Set the
+  // output offset of CONTRIB, and return it.
+  section_offset_type
+  do_add_contribution(elfcpp::DW_SECT section_id, Contribution* contrib,
+		      int align);
+
   // Write a new section to the output file.
   void
   write_new_section(const char* section_name, const unsigned char* contents,
@@ -632,9 +773,37 @@ class Dwp_output_file
 		   unsigned int link, unsigned int info,
 		   unsigned int align, unsigned int ent_size);
 
-  // Write the contributions to an output section.
+  // Write the contributions to an output section which are in memory,
+  // and add the ones which are copied from input files to COPIES.
+  void
+  write_contributions(const Section& sect, std::vector<Input_copy>* copies);
+
+  // Copy the contributions which come from input files.
   void
-  write_contributions(const Section& sect);
+  copy_input_contributions(std::vector<Input_copy>* copies);
+
+  // Copy LEN bytes at IN_OFFSET in the input file IN_NAME, open as
+  // IN_FD, to OUT_OFFSET in the output file.
+  void
+  copy_from_input(int in_fd, const char* in_name, off_t in_offset,
+		  off_t out_offset, section_size_type len);
+
+  // Remap the string offsets in the .debug_str_offsets.dwo section.
+  unsigned char*
+  remap_str_offsets(const unsigned char* contents, section_size_type len,
+		    const Str_offset_map* str_offset_map);
+
+  template <bool big_endian>
+  unsigned char*
+  sized_remap_str_offsets(const unsigned char* contents,
+			  section_size_type len,
+			  const Str_offset_map* str_offset_map);
+
+  // Remap a single string offset from an offset in the input string
+  // table to an offset in the output string table.
+  unsigned int
+  remap_str_offset(section_offset_type val,
+		   const Str_offset_map* str_offset_map);
 
   // Write a CU or TU index section.
   template<bool big_endian>
@@ -677,6 +846,8 @@ class Dwp_output_file
   uint64_t last_type_sig_;
   // Cache of the slot index for the last type signature.
   unsigned int last_tu_slot_;
+  // The names of the input files from which contributions are copied.
+  std::vector<std::string> input_files_;
 };
 
 // A specialization of Dwarf_info_reader, for reading dwo_names from
@@ -711,23 +882,23 @@ class Dwo_name_info_reader : public Dwarf_info_reader
   File_list* files_;
 };
 
-// A specialization of Dwarf_info_reader, for reading DWARF CUs and TUs
-// and adding them to the output file.
+// A specialization of Dwarf_info_reader, for finding the DWARF CUs
+// and TUs in a section.
 
 class Unit_reader : public Dwarf_info_reader
 {
  public:
   Unit_reader(bool is_type_unit, Relobj* object, unsigned int shndx)
     : Dwarf_info_reader(is_type_unit, object, NULL, 0, shndx, 0, 0),
-      output_file_(NULL), sections_(NULL)
+      units_(NULL)
   { }
 
   ~Unit_reader()
   { }
 
-  // Read the CUs or TUs and add them to the output file.
+  // Read the CUs or TUs and add them to UNITS.
   void
-  add_units(Dwp_output_file*, unsigned int debug_abbrev, Section_bounds*);
+  read_units(unsigned int debug_abbrev, Unit_list* units);
 
  protected:
   // Visit a compilation unit.
@@ -740,8 +911,8 @@ class Unit_reader : public Dwarf_info_reader
 		  uint64_t signature, Dwarf_die*);
 
  private:
-  Dwp_output_file* output_file_;
-  Section_bounds* sections_;
+  // The list of units to populate.
+  Unit_list* units_;
 };
 
 // Return the name of a DWARF .dwo section.
@@ -828,6 +999,10 @@ Sized_relobj_dwo<size, big_endian>::do_section_contents(
 
 Dwo_file::~Dwo_file()
 {
+  if (this->str_is_new_)
+    delete[] this->str_contents_;
+  if (this->str_offset_map_ != NULL)
+    delete this->str_offset_map_;
   if (this->obj_ != NULL)
     delete this->obj_;
   if (this->input_file_ != NULL)
@@ -840,7 +1015,7 @@ Dwo_file::~Dwo_file()
 void
 Dwo_file::read_executable(File_list* files)
 {
-  this->obj_ = this->make_object(NULL);
+  this->obj_ = this->make_object();
 
   unsigned int shnum = this->shnum();
   this->is_compressed_.resize(shnum);
@@ -880,26 +1055,18 @@ Dwo_file::read_executable(File_list* files)
     }
 }
 
-// Read the input file and send its contents to OUTPUT_FILE.
+// Open the input file, find its debug sections, and count the strings
+// in its string table.  If it is a .dwo file, parse its CUs and TUs.
 
 void
-Dwo_file::read(Dwp_output_file* output_file)
+Dwo_file::open()
 {
-  this->obj_ = this->make_object(output_file);
+  this->obj_ = this->make_object();
 
   unsigned int shnum = this->shnum();
   this->is_compressed_.resize(shnum);
   this->sect_offsets_.resize(shnum);
 
-  typedef std::vector<unsigned int> Types_list;
-  Types_list debug_types;
-  unsigned int debug_shndx[elfcpp::DW_SECT_MAX + 1];
-  for (unsigned int i = 0; i <= elfcpp::DW_SECT_MAX; i++)
-    debug_shndx[i] = 0;
-  unsigned int debug_str = 0;
-  unsigned int debug_cu_index = 0;
-  unsigned int debug_tu_index = 0;
-
   // Scan the section table and collect debug sections.
   // (Section index 0 is a dummy section; skip it.)
   for (unsigned int i = 1; i < shnum; i++)
@@ -918,63 +1085,154 @@ Dwo_file::read(Dwp_output_file* output_file)
       else
 	continue;
       if (strcmp(suffix, "info.dwo") == 0)
-	debug_shndx[elfcpp::DW_SECT_INFO] = i;
+	this->debug_shndx_[elfcpp::DW_SECT_INFO] = i;
       else if (strcmp(suffix, "types.dwo") == 0)
-	debug_types.push_back(i);
+	this->debug_types_.push_back(i);
       else if (strcmp(suffix, "abbrev.dwo") == 0)
-	debug_shndx[elfcpp::DW_SECT_ABBREV] = i;
+	this->debug_shndx_[elfcpp::DW_SECT_ABBREV] = i;
       else if (strcmp(suffix, "line.dwo") == 0)
-	debug_shndx[elfcpp::DW_SECT_LINE] = i;
+	this->debug_shndx_[elfcpp::DW_SECT_LINE] = i;
       else if (strcmp(suffix, "loc.dwo") == 0)
-	debug_shndx[elfcpp::DW_SECT_LOC] = i;
+	this->debug_shndx_[elfcpp::DW_SECT_LOC] = i;
       else if (strcmp(suffix, "str.dwo") == 0)
-	debug_str = i;
+	this->debug_str_ = i;
       else if (strcmp(suffix, "str_offsets.dwo") == 0)
-	debug_shndx[elfcpp::DW_SECT_STR_OFFSETS] = i;
+	this->debug_shndx_[elfcpp::DW_SECT_STR_OFFSETS] = i;
       else if (strcmp(suffix, "macinfo.dwo") == 0)
-	debug_shndx[elfcpp::DW_SECT_MACINFO] = i;
+	this->debug_shndx_[elfcpp::DW_SECT_MACINFO] = i;
       else if (strcmp(suffix, "macro.dwo") == 0)
-	debug_shndx[elfcpp::DW_SECT_MACRO] = i;
+	this->debug_shndx_[elfcpp::DW_SECT_MACRO] = i;
       else if (strcmp(suffix, "cu_index") == 0)
-	debug_cu_index = i;
+	this->debug_cu_index_ = i;
       else if (strcmp(suffix, "tu_index") == 0)
-	debug_tu_index = i;
+	this->debug_tu_index_ = i;
     }
 
-  // Merge the input string table into the output string table.
-  this->add_strings(output_file, debug_str);
+  // Count the number of strings in the input string table, so that
+  // we can reserve their ordinals in the output string table.
+  this->str_contents_ = this->section_contents(this->debug_str_,
+					       &this->str_len_,
+					       &this->str_is_new_);
+  const char* p = reinterpret_cast<const char*>(this->str_contents_);
+  const char* pend = p + this->str_len_;
+
+  // Check that the last string is null terminated.
+  if (this->str_len_ > 0 && pend[-1] != '\0')
+    gold_fatal(_("%s: last entry in string section '%s' "
+		 "is not null terminated"),
+	       this->name_,
+	       this->section_name(this->debug_str_).c_str());
+
+  for (const char* pt = p; pt < pend; pt += strlen(pt) + 1)
+    ++this->string_count_;
+
+  // If we found any .dwp index sections, the units are read from
+  // the index sections later.
+  if (this->debug_cu_index_ > 0 || this->debug_tu_index_ > 0)
+    return;
+
+  // Find the units in the .debug_info.dwo and .debug_types.dwo
+  // sections of a .dwo file.
+  unsigned int debug_abbrev = this->debug_shndx_[elfcpp::DW_SECT_ABBREV];
+  if (debug_abbrev == 0
+      && (this->debug_shndx_[elfcpp::DW_SECT_INFO] > 0
+	  || !this->debug_types_.empty()))
+    gold_fatal(_("%s: no .debug_abbrev.dwo section found"), this->name_);
+
+  if (this->debug_shndx_[elfcpp::DW_SECT_INFO] > 0)
+    {
+      Unit_reader reader(false, this->obj_,
+			 this->debug_shndx_[elfcpp::DW_SECT_INFO]);
+      reader.read_units(debug_abbrev, &this->info_units_);
+    }
+
+  this->types_units_.resize(this->debug_types_.size());
+  for (unsigned int i = 0; i < this->debug_types_.size(); ++i)
+    {
+      Unit_reader reader(true, this->obj_, this->debug_types_[i]);
+      reader.read_units(debug_abbrev, &this->types_units_[i]);
+    }
+}
+
+// Merge the input string table section into the output file.
+
+void
+Dwo_file::add_strings(Dwp_output_file* output_file, uint64_t first_ordinal)
+{
+  const char* p = reinterpret_cast<const char*>(this->str_contents_);
+  const char* pend = p + this->str_len_;
+
+  this->str_offset_map_ = new Str_offset_map();
+  this->str_offset_map_->reserve(this->string_count_ + 1);
+
+  // Add the strings to the output string table, and record their keys
+  // in the map.  The final entry, with key 0, maps the end of the
+  // input string table to offset 0.
+  section_offset_type i = 0;
+  uint64_t ordinal = first_ordinal;
+  while (p < pend)
+    {
+      size_t len = strlen(p);
+      Stringpool::Key key = output_file->add_string(p, len, ordinal);
+      this->str_offset_map_->push_back(std::make_pair(i, key));
+      ++ordinal;
+      p += len + 1;
+      i += len + 1;
+    }
+  this->str_offset_map_->push_back(std::make_pair(i, 0));
+  gold_assert(ordinal == first_ordinal + this->string_count_);
+
+  if (this->str_is_new_)
+    delete[] this->str_contents_;
+  this->str_contents_ = NULL;
+  this->str_is_new_ = false;
+}
+
+// Send the contents of the input file to OUTPUT_FILE.
+
+void
+Dwo_file::read(Dwp_output_file* output_file)
+{
+  output_file->record_target_info(this->name_, this->machine_, this->size_,
+				  this->big_endian_, this->osabi_,
+				  this->abiversion_);
+
+  unsigned int debug_shndx[elfcpp::DW_SECT_MAX + 1];
+  for (unsigned int i = 0; i <= elfcpp::DW_SECT_MAX; i++)
+    debug_shndx[i] = this->debug_shndx_[i];
 
   // If we found any .dwp index sections, read those and add the section
   // sets to the output file.
-  if (debug_cu_index > 0 || debug_tu_index > 0)
+  if (this->debug_cu_index_ > 0 || this->debug_tu_index_ > 0)
     {
-      if (debug_cu_index > 0)
-	this->read_unit_index(debug_cu_index, debug_shndx, output_file, false);
-      if (debug_tu_index > 0)
+      if (this->debug_cu_index_ > 0)
+	this->read_unit_index(this->debug_cu_index_, debug_shndx, output_file,
+			      false);
+      if (this->debug_tu_index_ > 0)
         {
-	  if (debug_types.size() > 1)
+	  if (this->debug_types_.size() > 1)
 	    gold_fatal(_("%s: .dwp file must have no more than one "
 			 ".debug_types.dwo section"), this->name_);
-          if (debug_types.size() == 1)
-            debug_shndx[elfcpp::DW_SECT_TYPES] = debug_types[0];
+          if (this->debug_types_.size() == 1)
+            debug_shndx[elfcpp::DW_SECT_TYPES] = this->debug_types_[0];
           else
             debug_shndx[elfcpp::DW_SECT_TYPES] = 0;
-	  this->read_unit_index(debug_tu_index, debug_shndx, output_file, true);
+	  this->read_unit_index(this->debug_tu_index_, debug_shndx,
+				output_file, true);
 	}
       return;
     }
 
   // If we found no index sections, this is a .dwo file.
   if (debug_shndx[elfcpp::DW_SECT_INFO] > 0)
-    this->add_unit_set(output_file, debug_shndx, false);
+    this->add_unit_set(output_file, debug_shndx, false, this->info_units_);
 
   debug_shndx[elfcpp::DW_SECT_INFO] = 0;
-  for (Types_list::const_iterator tp = debug_types.begin();
-       tp != debug_types.end();
-       ++tp)
+  for (unsigned int i = 0; i < this->debug_types_.size(); ++i)
     {
-      debug_shndx[elfcpp::DW_SECT_TYPES] = *tp;
-      this->add_unit_set(output_file, debug_shndx, true);
+      debug_shndx[elfcpp::DW_SECT_TYPES] = this->debug_types_[i];
+      this->add_unit_set(output_file, debug_shndx, true,
+			 this->types_units_[i]);
     }
 }
 
@@ -985,7 +1243,7 @@ Dwo_file::read(Dwp_output_file* output_file)
 bool
 Dwo_file::verify(const File_list& files)
 {
-  this->obj_ = this->make_object(NULL);
+  this->obj_ = this->make_object();
 
   unsigned int shnum = this->shnum();
   this->is_compressed_.resize(shnum);
@@ -1024,7 +1282,7 @@ Dwo_file::verify(const File_list& files)
 // and record the target info.
 
 Relobj*
-Dwo_file::make_object(Dwp_output_file* output_file)
+Dwo_file::make_object()
 {
   // Open the input file.
   Input_file* input_file = new Input_file(this->name_);
@@ -1058,15 +1316,13 @@ Dwo_file::make_object(Dwp_output_file* output_file)
     {
       if (big_endian)
 #ifdef HAVE_TARGET_32_BIG
-	return this->sized_make_object<32, true>(elf_header, input_file,
-						 output_file);
+	return this->sized_make_object<32, true>(elf_header, input_file);
 #else
 	gold_unreachable();
 #endif
       else
 #ifdef HAVE_TARGET_32_LITTLE
-	return this->sized_make_object<32, false>(elf_header, input_file,
-						  output_file);
+	return this->sized_make_object<32, false>(elf_header, input_file);
 #else
 	gold_unreachable();
 #endif
@@ -1075,15 +1331,13 @@ Dwo_file::make_object(Dwp_output_file* output_file)
     {
       if (big_endian)
 #ifdef HAVE_TARGET_64_BIG
-	return this->sized_make_object<64, true>(elf_header, input_file,
-						 output_file);
+	return this->sized_make_object<64, true>(elf_header, input_file);
 #else
 	gold_unreachable();
 #endif
       else
 #ifdef HAVE_TARGET_64_LITTLE
-	return this->sized_make_object<64, false>(elf_header, input_file,
-						  output_file);
+	return this->sized_make_object<64, false>(elf_header, input_file);
 #else
 	gold_unreachable();
 #endif
@@ -1097,18 +1351,27 @@ Dwo_file::make_object(Dwp_output_file* output_file)
 
 template <int size, bool big_endian>
 Relobj*
-Dwo_file::sized_make_object(const unsigned char* p, Input_file* input_file,
-			    Dwp_output_file* output_file)
+Dwo_file::sized_make_object(const unsigned char* p, Input_file* input_file)
 {
   elfcpp::Ehdr<size, big_endian> ehdr(p);
   Sized_relobj_dwo<size, big_endian>* obj =
       new Sized_relobj_dwo<size, big_endian>(this->name_, input_file, ehdr);
   obj->setup();
-  if (output_file != NULL)
-    output_file->record_target_info(
-	this->name_, ehdr.get_e_machine(), size, big_endian,
-	ehdr.get_e_ident()[elfcpp::EI_OSABI],
-	ehdr.get_e_ident()[elfcpp::EI_ABIVERSION]);
+
+  this->machine_ = ehdr.get_e_machine();
+  this->size_ = size;
+  this->big_endian_ = big_endian;
+  this->osabi_ = ehdr.get_e_ident()[elfcpp::EI_OSABI];
+  this->abiversion_ = ehdr.get_e_ident()[elfcpp::EI_ABIVERSION];
+
+  // Record where the sections which are not compressed are, so that
+  // they can be copied to the output file without reading them.
+  unsigned int shnum = obj->shnum();
+  this->file_offsets_.resize(shnum, -1);
+  for (unsigned int i = 1; i < shnum; ++i)
+    if (!obj->section_is_compressed(i, NULL))
+      this->file_offsets_[i] = obj->section_file_offset(i);
+
   return obj;
 }
 
@@ -1191,11 +1454,15 @@ Dwo_file::sized_read_unit_index(unsigned int shndx,
 					 static_cast<elfcpp::DW_SECT>(i));
     }
 
-  // Get the contents of the .debug_info.dwo or .debug_types.dwo section.
-  section_size_type info_len;
-  bool info_is_new;
-  const unsigned char* info_contents =
-      this->section_contents(info_shndx, &info_len, &info_is_new);
+  // Get the contents of the .debug_info.dwo or .debug_types.dwo section,
+  // unless it can be copied directly from the input file.
+  off_t info_file_offset = this->file_offsets_[info_shndx];
+  section_size_type info_len = 0;
+  bool info_is_new = false;
+  const unsigned char* info_contents = NULL;
+  if (info_file_offset == -1)
+    info_contents = this->section_contents(info_shndx, &info_len,
+					   &info_is_new);
 
   // Loop over the slots of the hash table.
   for (unsigned int i = 0; i < nslots; ++i)
@@ -1232,22 +1499,31 @@ Dwo_file::sized_read_unit_index(unsigned int shndx,
 	      psrow += sizeof(uint32_t);
 	    }
 
-	  const unsigned char* unit_start =
-	      info_contents + unit_set->sections[info_sect].offset;
+	  section_offset_type unit_offset =
+	      unit_set->sections[info_sect].offset;
 	  section_size_type unit_length = unit_set->sections[info_sect].size;
-
-	  // Dwp_output_file::add_contribution writes the .debug_info.dwo
-	  // section directly to the output file, so we only need to
-	  // duplicate contributions for .debug_types.dwo section.
-	  if (is_tu_index)
+	  section_offset_type off;
+	  if (info_contents == NULL)
+	    off = output_file->add_contribution(info_sect,
+						this->input_index(output_file),
+						info_file_offset + unit_offset,
+						unit_length, 1);
+	  else
 	    {
-	      unsigned char *copy = new unsigned char[unit_length];
-	      memcpy(copy, unit_start, unit_length);
-	      unit_start = copy;
+	      const unsigned char* unit_start = info_contents + unit_offset;
+
+	      // Dwp_output_file::add_contribution writes the .debug_info.dwo
+	      // section directly to the output file, so we only need to
+	      // duplicate contributions for .debug_types.dwo section.
+	      if (is_tu_index)
+		{
+		  unsigned char *copy = new unsigned char[unit_length];
+		  memcpy(copy, unit_start, unit_length);
+		  unit_start = copy;
+		}
+	      off = output_file->add_contribution(info_sect, unit_start,
+						  unit_length, 1);
 	    }
-	  section_offset_type off =
-	      output_file->add_contribution(info_sect, unit_start,
-					    unit_length, 1);
 	  unit_set->sections[info_sect].offset = off;
 	  if (is_tu_index)
 	    output_file->add_tu_set(unit_set);
@@ -1360,52 +1636,24 @@ Dwo_file::sized_verify_dwo_list(unsigned int shndx, const File_list& files)
   return nmissing == 0;
 }
 
-// Merge the input string table section into the output file.
+// Return the index of this file in the output file's list of input
+// files, adding it if necessary.
 
-void
-Dwo_file::add_strings(Dwp_output_file* output_file, unsigned int debug_str)
+unsigned int
+Dwo_file::input_index(Dwp_output_file* output_file)
 {
-  section_size_type len;
-  bool is_new;
-  const unsigned char* pdata = this->section_contents(debug_str, &len, &is_new);
-  const char* p = reinterpret_cast<const char*>(pdata);
-  const char* pend = p + len;
-
-  // Check that the last string is null terminated.
-  if (pend[-1] != '\0')
-    gold_fatal(_("%s: last entry in string section '%s' "
-		 "is not null terminated"),
-	       this->name_,
-	       this->section_name(debug_str).c_str());
-
-  // Count the number of strings in the section, and size the map.
-  size_t count = 0;
-  for (const char* pt = p; pt < pend; pt += strlen(pt) + 1)
-    ++count;
-  this->str_offset_map_.reserve(count + 1);
-
-  // Add the strings to the output string table, and record the new offsets
-  // in the map.
-  section_offset_type i = 0;
-  section_offset_type new_offset;
-  while (p < pend)
-    {
-      size_t len = strlen(p);
-      new_offset = output_file->add_string(p, len);
-      this->str_offset_map_.push_back(std::make_pair(i, new_offset));
-      p += len + 1;
-      i += len + 1;
-    }
-  new_offset = 0;
-  this->str_offset_map_.push_back(std::make_pair(i, new_offset));
-  if (is_new)
-    delete[] pdata;
+  if (this->input_index_ == -1U)
+    this->input_index_ =
+      output_file->add_input_file(this->input_file_->filename());
+  return this->input_index_;
 }
 
 // Copy a section from the input file to the output file.
 // Return the offset and length of this input section's contribution
-// in the output section.  If copying .debug_str_offsets.dwo, remap
-// the string offsets for the output string table.
+// in the output section.  Sections which are not compressed are copied
+// directly from the input file when the output file is finalized.
+// If copying .debug_str_offsets.dwo, the string offsets are remapped
+// for the output string table when the output file is finalized.
 
 Section_bounds
 Dwo_file::copy_section(Dwp_output_file* output_file, unsigned int shndx,
@@ -1416,32 +1664,49 @@ Dwo_file::copy_section(Dwp_output_file* output_file, unsigned int shndx,
   if (this->sect_offsets_[shndx].size > 0)
     return this->sect_offsets_[shndx];
 
-  // Get the section contents. Upon return, if IS_NEW is true, the memory
-  // has been allocated via new; if false, the memory is part of the mapped
-  // input file, and we will need to duplicate it so that it will persist
-  // after we close the input file.
   section_size_type len;
-  bool is_new;
-  const unsigned char* contents = this->section_contents(shndx, &len, &is_new);
-
-  if (section_id == elfcpp::DW_SECT_STR_OFFSETS)
+  section_offset_type off;
+  if (section_id != elfcpp::DW_SECT_STR_OFFSETS
+      && this->file_offsets_[shndx] != -1)
     {
-      const unsigned char* remapped = this->remap_str_offsets(contents, len);
-      if (is_new)
-	delete[] contents;
-      contents = remapped;
+      len = convert_to_section_size_type(this->obj_->section_size(shndx));
+      off = output_file->add_contribution(section_id,
+					  this->input_index(output_file),
+					  this->file_offsets_[shndx], len, 1);
     }
-  else if (!is_new)
+  else
     {
-      unsigned char* copy = new unsigned char[len];
-      memcpy(copy, contents, len);
-      contents = copy;
-    }
+      // Get the section contents. Upon return, if IS_NEW is true, the
+      // memory has been allocated via new; if false, the memory is part
+      // of the mapped input file, and we will need to duplicate it so
+      // that it will persist after we close the input file.
+      bool is_new;
+      const unsigned char* contents =
+	this->section_contents(shndx, &len, &is_new);
+      if (!is_new)
+	{
+	  unsigned char* copy = new unsigned char[len];
+	  memcpy(copy, contents, len);
+	  contents = copy;
+	}
 
-  // Add the contents of the input section to the output section.
-  // The output file takes ownership of the memory pointed to by CONTENTS.
-  section_offset_type off = output_file->add_contribution(section_id, contents,
-							  len, 1);
+      // Add the contents of the input section to the output section.
+      // The output file takes ownership of the memory pointed to by
+      // CONTENTS, and of the string offset map.
+      if (section_id != elfcpp::DW_SECT_STR_OFFSETS)
+	off = output_file->add_contribution(section_id, contents, len, 1);
+      else
+	{
+	  if ((len & 3) != 0)
+	    gold_fatal(_("%s: .debug_str_offsets.dwo section size not "
+			 "a multiple of 4"),
+		       this->name_);
+	  off = output_file->add_str_offsets_contribution(contents, len,
+							  this->str_offset_map_,
+							  1);
+	  this->str_offset_map_ = NULL;
+	}
+    }
 
   // Store the output section bounds.
   Section_bounds bounds(off, len);
@@ -1450,79 +1715,20 @@ Dwo_file::copy_section(Dwp_output_file* output_file, unsigned int shndx,
   return bounds;
 }
 
-// Remap the 
-const unsigned char*
-Dwo_file::remap_str_offsets(const unsigned char* contents,
-			    section_size_type len)
-{
-  if ((len & 3) != 0)
-    gold_fatal(_("%s: .debug_str_offsets.dwo section size not a multiple of 4"),
-	       this->name_);
-
-  if (this->obj_->is_big_endian())
-    return this->sized_remap_str_offsets<true>(contents, len);
-  else
-    return this->sized_remap_str_offsets<false>(contents, len);
-}
-
-template <bool big_endian>
-const unsigned char*
-Dwo_file::sized_remap_str_offsets(const unsigned char* contents,
-				  section_size_type len)
-{
-  unsigned char* remapped = new unsigned char[len];
-  const unsigned char* p = contents;
-  unsigned char* q = remapped;
-  while (len > 0)
-    {
-      unsigned int val = elfcpp::Swap_unaligned<32, big_endian>::readval(p);
-      val = this->remap_str_offset(val);
-      elfcpp::Swap_unaligned<32, big_endian>::writeval(q, val);
-      len -= 4;
-      p += 4;
-      q += 4;
-    }
-  return remapped;
-}
-
-unsigned int
-Dwo_file::remap_str_offset(section_offset_type val)
-{
-  Str_offset_map_entry entry;
-  entry.first = val;
-
-  Str_offset_map::const_iterator p =
-      std::lower_bound(this->str_offset_map_.begin(),
-		       this->str_offset_map_.end(),
-		       entry, Offset_compare());
-
-  if (p == this->str_offset_map_.end() || p->first > val)
-    {
-      if (p == this->str_offset_map_.begin())
-	return 0;
-      --p;
-      gold_assert(p->first <= val);
-    }
-
-  return p->second + (val - p->first);
-}
-
 // Add a set of .debug_info.dwo or .debug_types.dwo and related sections
 // to OUTPUT_FILE.
 
 void
 Dwo_file::add_unit_set(Dwp_output_file* output_file, unsigned int *debug_shndx,
-		       bool is_debug_types)
+		       bool is_debug_types, const Unit_list& units)
 {
-  unsigned int shndx = (is_debug_types
-			? debug_shndx[elfcpp::DW_SECT_TYPES]
-			: debug_shndx[elfcpp::DW_SECT_INFO]);
+  elfcpp::DW_SECT info_sect = (is_debug_types
+			       ? elfcpp::DW_SECT_TYPES
+			       : elfcpp::DW_SECT_INFO);
+  unsigned int shndx = debug_shndx[info_sect];
 
   gold_assert(shndx != 0);
 
-  if (debug_shndx[elfcpp::DW_SECT_ABBREV] == 0)
-    gold_fatal(_("%s: no .debug_abbrev.dwo section found"), this->name_);
-
   // Copy the related sections and track the section offsets and sizes.
   Section_bounds sections[elfcpp::DW_SECT_MAX + 1];
   for (int i = elfcpp::DW_SECT_ABBREV; i <= elfcpp::DW_SECT_MAX; ++i)
@@ -1532,11 +1738,58 @@ Dwo_file::add_unit_set(Dwp_output_file* output_file, unsigned int *debug_shndx,
 					 static_cast<elfcpp::DW_SECT>(i));
     }
 
-  // Parse the .debug_info or .debug_types section and add each compilation
-  // or type unit to the output file, along with the contributions to the
-  // related sections.
-  Unit_reader reader(is_debug_types, this->obj_, shndx);
-  reader.add_units(output_file, debug_shndx[elfcpp::DW_SECT_ABBREV], sections);
+  // Get the contents of the .debug_info.dwo or .debug_types.dwo section,
+  // unless it can be copied directly from the input file.
+  off_t file_offset = this->file_offsets_[shndx];
+  section_size_type len;
+  bool is_new = false;
+  const unsigned char* contents = NULL;
+  if (file_offset == -1)
+    contents = this->section_contents(shndx, &len, &is_new);
+
+  // Add each compilation or type unit found by open to the output file,
+  // along with the contributions to the related sections.
+  for (Unit_list::const_iterator p = units.begin(); p != units.end(); ++p)
+    {
+      if (is_debug_types && output_file->lookup_tu(p->signature))
+	continue;
+
+      Unit_set* unit_set = new Unit_set();
+      unit_set->signature = p->signature;
+      for (unsigned int i = elfcpp::DW_SECT_ABBREV;
+	   i <= elfcpp::DW_SECT_MAX;
+	   ++i)
+	unit_set->sections[i] = sections[i];
+
+      section_offset_type off;
+      if (contents == NULL)
+	off = output_file->add_contribution(info_sect,
+					    this->input_index(output_file),
+					    file_offset + p->offset,
+					    p->length, 1);
+      else if (!is_debug_types)
+	{
+	  // Dwp_output_file::add_contribution writes the .debug_info.dwo
+	  // section directly to the output file, so we do not need to
+	  // duplicate the section contents.
+	  off = output_file->add_contribution(info_sect, contents + p->offset,
+					      p->length, 1);
+	}
+      else
+	{
+	  unsigned char* copy = new unsigned char[p->length];
+	  memcpy(copy, contents + p->offset, p->length);
+	  off = output_file->add_contribution(info_sect, copy, p->length, 1);
+	}
+      unit_set->sections[info_sect] = Section_bounds(off, p->length);
+      if (is_debug_types)
+	output_file->add_tu_set(unit_set);
+      else
+	output_file->add_cu_set(unit_set);
+    }
+
+  if (is_new)
+    delete[] contents;
 }
 
 // Class Dwp_output_file.
@@ -1579,18 +1832,36 @@ Dwp_output_file::record_target_info(const char*, int machine,
     gold_fatal(_("%s: %s"), this->name_, strerror(errno));
 }
 
+// Reserve ordinals for COUNT strings to be added to the debug strings
+// section.  The strings are laid out in ordinal order, so the string
+// table does not depend on the order in which the threads add them.
+
+uint64_t
+Dwp_output_file::reserve_string_ordinals(size_t count)
+{
+  if (count > 0)
+    this->have_strings_ = true;
+  return this->stringpool_.reserve_ordinals(count);
+}
+
 // Add a string to the debug strings section.
 
-section_offset_type
-Dwp_output_file::add_string(const char* str, size_t len)
+Stringpool::Key
+Dwp_output_file::add_string(const char* str, size_t len, uint64_t ordinal)
 {
   Stringpool::Key key;
-  this->stringpool_.add_with_length(str, len, true, &key);
-  this->have_strings_ = true;
-  // We aren't supposed to call get_offset() until after
-  // calling set_string_offsets(), but the offsets will
-  // not change unless optimizing the string pool.
-  return this->stringpool_.get_offset_from_key(key);
+  this->stringpool_.add_with_ordinal(str, len, ordinal, true, &key);
+  return key;
+}
+
+// Record an input file whose contents may be copied directly to the
+// output file.
+
+unsigned int
+Dwp_output_file::add_input_file(const std::string& name)
+{
+  this->input_files_.push_back(name);
+  return this->input_files_.size() - 1;
 }
 
 // Align the file offset to the given boundary.
@@ -1611,12 +1882,7 @@ Dwp_output_file::add_output_section(const char* section_name, int align)
   return this->shnum_++;
 }
 
-// Add a contribution to a section in the output file, and return the offset
-// of the contribution within the output section.  The .debug_info.dwo section
-// is expected to be the largest one, so we will write the contents of this
-// section directly to the output file as we receive contributions, allowing
-// us to free that memory as soon as possible. We will save the remaining
-// contributions until we finalize the layout of the output file.
+// Add a contribution whose contents are in memory.
 
 section_offset_type
 Dwp_output_file::add_contribution(elfcpp::DW_SECT section_id,
@@ -1624,6 +1890,54 @@ Dwp_output_file::add_contribution(elfcpp::DW_SECT section_id,
 				  section_size_type len,
 				  int align)
 {
+  Contribution contrib = { 0, len, contents, 0, 0, NULL };
+  return this->do_add_contribution(section_id, &contrib, align);
+}
+
+// Add a contribution which is copied from an input file when the
+// output file is finalized.  This avoids reading the contents into
+// memory, and lets the kernel copy them directly where it can.
+
+section_offset_type
+Dwp_output_file::add_contribution(elfcpp::DW_SECT section_id,
+				  unsigned int input_file,
+				  off_t input_offset,
+				  section_size_type len,
+				  int align)
+{
+  Contribution contrib = { 0, len, NULL, input_file, input_offset, NULL };
+  return this->do_add_contribution(section_id, &contrib, align);
+}
+
+// Add a .debug_str_offsets.dwo contribution.  We can't remap the string
+// offsets until we know the layout of the output string table.
+
+section_offset_type
+Dwp_output_file::add_str_offsets_contribution(const unsigned char* contents,
+					      section_size_type len,
+					      Str_offset_map* str_offset_map,
+					      int align)
+{
+  Contribution contrib = { 0, len, contents, 0, 0, str_offset_map };
+  return this->do_add_contribution(elfcpp::DW_SECT_STR_OFFSETS, &contrib,
+				   align);
+}
+
+// Add a contribution to a section in the output file, and return the offset
+// of the contribution within the output section.  The .debug_info.dwo section
+// is expected to be the largest one, so we will write the contents of this
+// section directly to the output file as we receive contributions, allowing
+// us to free that memory as soon as possible.  (Contributions copied from
+// input files are only given their place in the file.)  We will save the
+// remaining contributions until we finalize the layout of the output file.
+
+section_offset_type
+Dwp_output_file::do_add_contribution(elfcpp::DW_SECT section_id,
+				     Contribution* contrib,
+				     int align)
+{
+  const unsigned char* contents = contrib->contents;
+  section_size_type len = contrib->size;
   const char* section_name = get_dwarf_section_name(section_id);
   gold_assert(static_cast<size_t>(section_id) < this->section_id_map_.size());
   unsigned int shndx = this->section_id_map_[section_id];
@@ -1668,10 +1982,18 @@ Dwp_output_file::add_contribution(elfcpp::DW_SECT section_id,
       section_offset = file_offset - section.offset;
       section.size = file_offset + len - section.offset;
 
-      ::fseek(this->fd_, file_offset, SEEK_SET);
-      if (::fwrite(contents, 1, len, this->fd_) < len)
-	gold_fatal(_("%s: error writing section '%s'"), this->name_,
-		   section_name);
+      if (contents != NULL)
+	{
+	  ::fseek(this->fd_, file_offset, SEEK_SET);
+	  if (::fwrite(contents, 1, len, this->fd_) < len)
+	    gold_fatal(_("%s: error writing section '%s'"), this->name_,
+		       section_name);
+	}
+      else
+	{
+	  contrib->output_offset = section_offset;
+	  section.contributions.push_back(*contrib);
+	}
       this->next_file_offset_ = file_offset + len;
     }
   else
@@ -1681,8 +2003,8 @@ Dwp_output_file::add_contribution(elfcpp::DW_SECT section_id,
 	section.align = align;
       section_offset = align_offset(section.size, align);
       section.size = section_offset + len;
-      Contribution contrib = { section_offset, len, contents };
-      section.contributions.push_back(contrib);
+      contrib->output_offset = section_offset;
+      section.contributions.push_back(*contrib);
     }
 
   return section_offset;
@@ -1838,24 +2160,32 @@ Dwp_output_file::finalize()
 {
   unsigned char* buf;
 
+  // Lay out the debug string table, so that we can remap the string
+  // offsets in .debug_str_offsets.dwo.
+  if (this->have_strings_)
+    this->stringpool_.set_string_offsets();
+
   // Write the accumulated output sections.
+  std::vector<Input_copy> copies;
   for (unsigned int i = 0; i < this->sections_.size(); i++)
     {
       Section& sect = this->sections_[i];
-      // If the offset has already been assigned, the section has been written.
-      if (sect.offset > 0 || sect.size == 0)
-	continue;
-      off_t file_offset = this->next_file_offset_;
-      file_offset = align_offset(file_offset, sect.align);
-      sect.offset = file_offset;
-      this->write_contributions(sect);
-      this->next_file_offset_ = file_offset + sect.size;
+      // If the offset has already been assigned, the section has been
+      // written, except for any contributions copied from input files.
+      if (sect.offset == 0 && sect.size > 0)
+	{
+	  off_t file_offset = this->next_file_offset_;
+	  file_offset = align_offset(file_offset, sect.align);
+	  sect.offset = file_offset;
+	  this->next_file_offset_ = file_offset + sect.size;
+	}
+      this->write_contributions(sect, &copies);
     }
+  this->copy_input_contributions(&copies);
 
   // Write the debug string table.
   if (this->have_strings_)
     {
-      this->stringpool_.set_string_offsets();
       section_size_type len = this->stringpool_.get_strtab_size();
       buf = new unsigned char[len];
       this->stringpool_.write_to_buffer(buf, len);
@@ -1927,21 +2257,208 @@ Dwp_output_file::finalize()
   this->fd_ = NULL;
 }
 
-// Write the contributions to an output section.
+// Write the contributions to an output section which are in memory,
+// remapping the string offsets in .debug_str_offsets.dwo, and add the
+// contributions which come from input files to COPIES.
 
 void
-Dwp_output_file::write_contributions(const Section& sect)
+Dwp_output_file::write_contributions(const Section& sect,
+				     std::vector<Input_copy>* copies)
 {
   for (unsigned int i = 0; i < sect.contributions.size(); ++i)
     {
       const Contribution& c = sect.contributions[i];
+      if (c.contents == NULL)
+	{
+	  copies->push_back(Input_copy(c.input_file, c.input_offset,
+				       sect.offset + c.output_offset, c.size));
+	  continue;
+	}
+      const unsigned char* contents = c.contents;
+      if (c.str_offset_map != NULL)
+	{
+	  contents = this->remap_str_offsets(c.contents, c.size,
+					     c.str_offset_map);
+	  delete[] c.contents;
+	  delete c.str_offset_map;
+	}
       ::fseek(this->fd_, sect.offset + c.output_offset, SEEK_SET);
-      if (::fwrite(c.contents, 1, c.size, this->fd_) < c.size)
+      if (::fwrite(contents, 1, c.size, this->fd_) < c.size)
 	gold_fatal(_("%s: error writing section '%s'"), this->name_, sect.name);
-      delete[] c.contents;
+      delete[] contents;
     }
 }
 
+// Copy the contributions which come from input files.  We copy all the
+// contributions from one input file together, so that we only open
+// each input file once.
+
+void
+Dwp_output_file::copy_input_contributions(std::vector<Input_copy>* copies)
+{
+  if (copies->empty())
+    return;
+
+  // We write to the file descriptor directly, so flush any buffered
+  // output first.
+  if (::fflush(this->fd_) != 0)
+    gold_fatal(_("%s: %s"), this->name_, strerror(errno));
+
+  std::sort(copies->begin(), copies->end(), Input_copy_compare());
+
+  unsigned int current = -1U;
+  int in_fd = -1;
+  for (std::vector<Input_copy>::const_iterator p = copies->begin();
+       p != copies->end();
+       ++p)
+    {
+      const char* in_name = this->input_files_[p->input_file].c_str();
+      if (p->input_file != current)
+	{
+	  if (in_fd >= 0)
+	    release_descriptor(in_fd, true);
+	  in_fd = open_descriptor(-1, in_name, O_RDONLY);
+	  if (in_fd < 0)
+	    gold_fatal(_("%s: can't open: %s"), in_name, strerror(errno));
+	  current = p->input_file;
+	}
+      this->copy_from_input(in_fd, in_name, p->input_offset,
+			    p->output_offset, p->size);
+    }
+  if (in_fd >= 0)
+    release_descriptor(in_fd, true);
+}
+
+// Copy LEN bytes at IN_OFFSET in an input file to OUT_OFFSET in the
+// output file.  We use copy_file_range where we can, which copies the
+// data within the kernel, or lets the file system share the blocks.
+// Otherwise we copy through a buffer.
+
+void
+Dwp_output_file::copy_from_input(int in_fd, const char* in_name,
+				 off_t in_offset, off_t out_offset,
+				 section_size_type len)
+{
+  int out_fd = fileno(this->fd_);
+
+#ifdef HAVE_COPY_FILE_RANGE
+  static bool use_copy_file_range = true;
+  while (len > 0 && use_copy_file_range)
+    {
+      loff_t in_off = in_offset;
+      loff_t out_off = out_offset;
+      ssize_t bytes = ::copy_file_range(in_fd, &in_off, out_fd, &out_off,
+					len, 0);
+      if (bytes > 0)
+	{
+	  in_offset += bytes;
+	  out_offset += bytes;
+	  len -= bytes;
+	}
+      else if (bytes == 0)
+	gold_fatal(_("%s: file too short"), in_name);
+      else if (errno == ENOSYS || errno == EXDEV || errno == EINVAL
+	       || errno == EOPNOTSUPP)
+	use_copy_file_range = false;
+      else if (errno != EINTR)
+	gold_fatal(_("%s: copy_file_range failed: %s"), in_name,
+		   strerror(errno));
+    }
+#endif
+
+  unsigned char buf[65536];
+  while (len > 0)
+    {
+      size_t chunk = std::min(static_cast<size_t>(len), sizeof buf);
+      ssize_t bytes = ::pread(in_fd, buf, chunk, in_offset);
+      if (bytes < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  gold_fatal(_("%s: pread failed: %s"), in_name, strerror(errno));
+	}
+      if (bytes == 0)
+	gold_fatal(_("%s: file too short"), in_name);
+      for (ssize_t done = 0; done < bytes; )
+	{
+	  ssize_t written = ::pwrite(out_fd, buf + done, bytes - done,
+				     out_offset + done);
+	  if (written < 0 && errno == EINTR)
+	    continue;
+	  if (written <= 0)
+	    gold_fatal(_("%s: %s"), this->name_, strerror(errno));
+	  done += written;
+	}
+      in_offset += bytes;
+      out_offset += bytes;
+      len -= bytes;
+    }
+}
+
+// Remap the string offsets in a .debug_str_offsets.dwo section, using
+// STR_OFFSET_MAP to find the strings in the output string table.
+
+unsigned char*
+Dwp_output_file::remap_str_offsets(const unsigned char* contents,
+				   section_size_type len,
+				   const Str_offset_map* str_offset_map)
+{
+  if (this->big_endian_)
+    return this->sized_remap_str_offsets<true>(contents, len, str_offset_map);
+  else
+    return this->sized_remap_str_offsets<false>(contents, len,
+						str_offset_map);
+}
+
+template <bool big_endian>
+unsigned char*
+Dwp_output_file::sized_remap_str_offsets(const unsigned char* contents,
+					 section_size_type len,
+					 const Str_offset_map* str_offset_map)
+{
+  unsigned char* remapped = new unsigned char[len];
+  const unsigned char* p = contents;
+  unsigned char* q = remapped;
+  while (len > 0)
+    {
+      unsigned int val = elfcpp::Swap_unaligned<32, big_endian>::readval(p);
+      val = this->remap_str_offset(val, str_offset_map);
+      elfcpp::Swap_unaligned<32, big_endian>::writeval(q, val);
+      len -= 4;
+      p += 4;
+      q += 4;
+    }
+  return remapped;
+}
+
+unsigned int
+Dwp_output_file::remap_str_offset(section_offset_type val,
+				  const Str_offset_map* str_offset_map)
+{
+  Str_offset_map_entry entry;
+  entry.first = val;
+
+  Str_offset_map::const_iterator p =
+      std::lower_bound(str_offset_map->begin(),
+		       str_offset_map->end(),
+		       entry, Offset_compare());
+
+  if (p == str_offset_map->end() || p->first > val)
+    {
+      if (p == str_offset_map->begin())
+	return 0;
+      --p;
+      gold_assert(p->first <= val);
+    }
+
+  // Key 0 marks the end of the input string table, which maps to
+  // offset 0.
+  section_offset_type offset = 0;
+  if (p->second != 0)
+    offset = this->stringpool_.get_offset_from_key(p->second);
+  return offset + (val - p->first);
+}
+
 // Write a new section to the output file.
 
 void
@@ -2220,15 +2737,12 @@ Dwo_name_info_reader::visit_compilation_unit(off_t, off_t, Dwarf_die* die)
 
 // Class Unit_reader.
 
-// Read the CUs or TUs and add them to the output file.
+// Read the CUs or TUs and add them to UNITS.
 
 void
-Unit_reader::add_units(Dwp_output_file* output_file,
-		       unsigned int debug_abbrev,
-		       Section_bounds* sections)
+Unit_reader::read_units(unsigned int debug_abbrev, Unit_list* units)
 {
-  this->output_file_ = output_file;
-  this->sections_ = sections;
+  this->units_ = units;
   this->set_abbrev_shndx(debug_abbrev);
   this->parse();
 }
@@ -2236,54 +2750,61 @@ Unit_reader::add_units(Dwp_output_file* output_file,
 // Visit a compilation unit.
 
 void
-Unit_reader::visit_compilation_unit(off_t, off_t cu_length, Dwarf_die* die)
+Unit_reader::visit_compilation_unit(off_t cu_offset, off_t cu_length,
+				    Dwarf_die* die)
 {
   if (cu_length == 0)
     return;
 
-  Unit_set* unit_set = new Unit_set();
-  unit_set->signature = die->uint_attribute(elfcpp::DW_AT_GNU_dwo_id);
-  for (unsigned int i = elfcpp::DW_SECT_ABBREV; i <= elfcpp::DW_SECT_MAX; ++i)
-    unit_set->sections[i] = this->sections_[i];
-
-  // Dwp_output_file::add_contribution writes the .debug_info.dwo section
-  // directly to the output file, so we do not need to duplicate the
-  // section contents, and add_contribution does not need to free the memory.
-  section_offset_type off =
-      this->output_file_->add_contribution(elfcpp::DW_SECT_INFO,
-					   this->buffer_at_offset(0),
-					   cu_length, 1);
-  Section_bounds bounds(off, cu_length);
-  unit_set->sections[elfcpp::DW_SECT_INFO] = bounds;
-  this->output_file_->add_cu_set(unit_set);
+  uint64_t dwo_id = die->uint_attribute(elfcpp::DW_AT_GNU_dwo_id);
+  this->units_->push_back(Unit_info(cu_offset, cu_length, dwo_id));
 }
 
 // Visit a type unit.
 
 void
-Unit_reader::visit_type_unit(off_t, off_t tu_length, off_t,
+Unit_reader::visit_type_unit(off_t tu_offset, off_t tu_length, off_t,
 			     uint64_t signature, Dwarf_die*)
 {
   if (tu_length == 0)
     return;
-  if (this->output_file_->lookup_tu(signature))
-    return;
 
-  Unit_set* unit_set = new Unit_set();
-  unit_set->signature = signature;
-  for (unsigned int i = elfcpp::DW_SECT_ABBREV; i <= elfcpp::DW_SECT_MAX; ++i)
-    unit_set->sections[i] = this->sections_[i];
-
-  unsigned char* contents = new unsigned char[tu_length];
-  memcpy(contents, this->buffer_at_offset(0), tu_length);
-  section_offset_type off =
-      this->output_file_->add_contribution(elfcpp::DW_SECT_TYPES, contents,
-					   tu_length, 1);
-  Section_bounds bounds(off, tu_length);
-  unit_set->sections[elfcpp::DW_SECT_TYPES] = bounds;
-  this->output_file_->add_tu_set(unit_set);
+  this->units_->push_back(Unit_info(tu_offset, tu_length, signature));
 }
 
+// The jobs which process a group of input files in parallel.  When
+// ADD_STRINGS_ is false, job I opens the I'th file.  When ADD_STRINGS_
+// is true, job I adds the strings of the I'th file to the output
+// string table, using the I'th entry of FIRST_ORDINALS_.
+
+class Dwo_file_jobs : public Parallel_jobs
+{
+ public:
+  Dwo_file_jobs(const std::vector<Dwo_file*>& files, bool add_strings,
+		Dwp_output_file* output_file,
+		const std::vector<uint64_t>* first_ordinals)
+    : files_(files), add_strings_(add_strings), output_file_(output_file),
+      first_ordinals_(first_ordinals)
+  { }
+
+ protected:
+  void
+  do_run_job(unsigned int index)
+  {
+    if (!this->add_strings_)
+      this->files_[index]->open();
+    else
+      this->files_[index]->add_strings(this->output_file_,
+				       (*this->first_ordinals_)[index]);
+  }
+
+ private:
+  const std::vector<Dwo_file*>& files_;
+  bool add_strings_;
+  Dwp_output_file* output_file_;
+  const std::vector<uint64_t>* first_ordinals_;
+};
+
 }; // End namespace gold
 
 using namespace gold;
@@ -2292,6 +2813,8 @@ using namespace gold;
 
 enum Dwp_options {
   VERIFY_ONLY = 0x101,
+  THREADS,
+  THREAD_COUNT
 };
 
 struct option dwp_options[] =
@@ -2299,6 +2822,8 @@ struct option dwp_options[] =
     { "exec", required_argument, NULL, 'e' },
     { "help", no_argument, NULL, 'h' },
     { "output", required_argument, NULL, 'o' },
+    { "threads", no_argument, NULL, THREADS },
+    { "thread-count", required_argument, NULL, THREAD_COUNT },
     { "verbose", no_argument, NULL, 'v' },
     { "verify-only", no_argument, NULL, VERIFY_ONLY },
     { "version", no_argument, NULL, 'V' },
@@ -2315,6 +2840,9 @@ usage(FILE* fd, int exit_status)
   fprintf(fd, _("  -e EXE, --exec EXE       Get list of dwo files from EXE"
 					   " (defaults output to EXE.dwp)\n"));
   fprintf(fd, _("  -o FILE, --output FILE   Set output dwp file name\n"));
+  fprintf(fd, _("  --threads                Read input files in several"
+					   " threads\n"));
+  fprintf(fd, _("  --thread-count COUNT     Number of threads to use\n"));
   fprintf(fd, _("  -v, --verbose            Verbose output\n"));
   fprintf(fd, _("  --verify-only            Verify output file against"
 					   " exec file\n"));
@@ -2378,6 +2906,8 @@ main(int argc, char** argv)
   const char* exe_filename = NULL;
   bool verbose = false;
   bool verify_only = false;
+  bool threads = false;
+  int thread_count = 0;
   int c;
   while ((c = getopt_long(argc, argv, "e:ho:vV", dwp_options, NULL)) != -1)
     {
@@ -2397,6 +2927,18 @@ main(int argc, char** argv)
 	  case VERIFY_ONLY:
 	    verify_only = true;
 	    break;
+	  case THREADS:
+	    threads = true;
+	    break;
+	  case THREAD_COUNT:
+	    {
+	      char* endptr;
+	      long count = strtol(optarg, &endptr, 0);
+	      if (*endptr != '\0' || count < 0 || count > INT_MAX)
+		gold_fatal(_("invalid thread count: %s"), optarg);
+	      thread_count = count;
+	    }
+	    break;
 	  case 'V':
 	    print_version();
 	  case '?':
@@ -2405,6 +2947,17 @@ main(int argc, char** argv)
 	}
     }
 
+#ifndef ENABLE_THREADS
+  if (threads)
+    {
+      gold_warning(_("ignoring --threads: "
+		     "%s was compiled without thread support"),
+		   program_name);
+      threads = false;
+    }
+#endif
+  options.set_threads_options(threads, thread_count);
+
   if (output_filename.empty())
     {
       if (exe_filename == NULL)
@@ -2436,14 +2989,42 @@ main(int argc, char** argv)
       return ok ? EXIT_SUCCESS : EXIT_FAILURE;
     }
 
-  // Process each file, adding its contents to the output file.
+  // Process the files in groups.  We open the files in a group, and
+  // add their strings to the output string table, in parallel if
+  // using threads.  Then we add the contents of each file to the
+  // output file in order.  The size of a group does not depend on the
+  // number of threads, so neither does the output file.
+  const size_t files_per_group = 64;
   Dwp_output_file output_file(output_filename.c_str());
-  for (File_list::const_iterator f = files.begin(); f != files.end(); ++f)
+  for (size_t start = 0; start < files.size(); start += files_per_group)
     {
-      if (verbose)
-	fprintf(stderr, "%s\n", f->dwo_name.c_str());
-      Dwo_file dwo_file(f->dwo_name.c_str());
-      dwo_file.read(&output_file);
+      size_t count = std::min(files.size() - start, files_per_group);
+
+      std::vector<Dwo_file*> dwo_files;
+      dwo_files.reserve(count);
+      for (size_t i = 0; i < count; ++i)
+	dwo_files.push_back(new Dwo_file(files[start + i].dwo_name.c_str()));
+
+      Dwo_file_jobs open_jobs(dwo_files, false, NULL, NULL);
+      open_jobs.run(count);
+
+      std::vector<uint64_t> first_ordinals;
+      first_ordinals.reserve(count);
+      for (size_t i = 0; i < count; ++i)
+	first_ordinals.push_back(
+	    output_file.reserve_string_ordinals(dwo_files[i]->string_count()));
+
+      Dwo_file_jobs string_jobs(dwo_files, true, &output_file,
+				&first_ordinals);
+      string_jobs.run(count);
+
+      for (size_t i = 0; i < count; ++i)
+	{
+	  if (verbose)
+	    fprintf(stderr, "%s\n", files[start + i].dwo_name.c_str());
+	  dwo_files[i]->read(&output_file);
+	  delete dwo_files[i];
+	}
     }
   output_file.finalize();
 
@@ -29,6 +29,7 @@
 #include "dwarf.h"
 #include "symtab.h"
 #include "reloc.h"
+#include "gold-threads.h"
 #include "ehframe.h"
 
 namespace gold
@@ -188,8 +189,8 @@ Eh_frame_hdr::do_sized_write(Output_file* of)
       this->get_fde_addresses<size, big_endian>(of, &this->fde_offsets_,
 						&fde_addresses);
 
-      std::sort(fde_addresses.begin(), fde_addresses.end(),
-		Fde_address_compare<size>());
+      parallel_sort(fde_addresses.begin(), fde_addresses.end(),
+		    Fde_address_compare<size>());
 
       typename elfcpp::Elf_types<size>::Elf_Addr output_address;
       output_address = this->address();
@@ -290,11 +291,51 @@ Eh_frame_hdr::get_fde_pc(
   return pc;
 }
 
+// The jobs which find the PCs of the FDEs for the exception frame
+// header.  Job I handles the I'th group of CHUNK_SIZE_ FDEs.
+
+template<int size, bool big_endian>
+class Eh_frame_hdr_fde_jobs : public Parallel_jobs
+{
+ public:
+  typedef typename elfcpp::Elf_types<size>::Elf_Addr Address;
+
+  Eh_frame_hdr_fde_jobs(Eh_frame_hdr* hdr, Address eh_frame_address,
+			const unsigned char* eh_frame_contents,
+			const Eh_frame_hdr::Fde_offsets* fde_offsets,
+			size_t chunk_size,
+			Eh_frame_hdr::Fde_addresses<size>* fde_addresses)
+    : hdr_(hdr), eh_frame_address_(eh_frame_address),
+      eh_frame_contents_(eh_frame_contents), fde_offsets_(fde_offsets),
+      chunk_size_(chunk_size), fde_addresses_(fde_addresses)
+  { }
+
+ protected:
+  void
+  do_run_job(unsigned int index)
+  {
+    size_t start = index * this->chunk_size_;
+    size_t end = std::min(start + this->chunk_size_,
+			  this->fde_offsets_->size());
+    this->hdr_->template get_fde_addresses_range<size, big_endian>(
+	this->eh_frame_address_, this->eh_frame_contents_,
+	this->fde_offsets_, start, end, this->fde_addresses_);
+  }
+
+ private:
+  Eh_frame_hdr* hdr_;
+  Address eh_frame_address_;
+  const unsigned char* eh_frame_contents_;
+  const Eh_frame_hdr::Fde_offsets* fde_offsets_;
+  size_t chunk_size_;
+  Eh_frame_hdr::Fde_addresses<size>* fde_addresses_;
+};
+
 // Given an array of FDE offsets in the .eh_frame section, return an
 // array of offsets from the exception frame header to the FDE's
 // output PC and to the output address of the FDE itself.  We get the
 // FDE's PC by actually looking in the .eh_frame section we just wrote
-// to the output file.
+// to the output file.  A large array is split among several threads.
 
 template<int size, bool big_endian>
 void
@@ -309,18 +350,38 @@ Eh_frame_hdr::get_fde_addresses(Output_file* of,
   const unsigned char* eh_frame_contents = of->get_input_view(eh_frame_offset,
 							      eh_frame_size);
 
-  for (Fde_offsets::const_iterator p = fde_offsets->begin();
-       p != fde_offsets->end();
-       ++p)
+  const size_t chunk_size = 65536;
+  size_t count = fde_offsets->size();
+  Eh_frame_hdr_fde_jobs<size, big_endian> jobs(this, eh_frame_address,
+					       eh_frame_contents,
+					       fde_offsets, chunk_size,
+					       fde_addresses);
+  jobs.run((count + chunk_size - 1) / chunk_size);
+
+  of->free_input_view(eh_frame_offset, eh_frame_size, eh_frame_contents);
+}
+
+// Fill in entries [START, END) of FDE_ADDRESSES from FDE_OFFSETS.
+
+template<int size, bool big_endian>
+void
+Eh_frame_hdr::get_fde_addresses_range(
+    typename elfcpp::Elf_types<size>::Elf_Addr eh_frame_address,
+    const unsigned char* eh_frame_contents,
+    const Fde_offsets* fde_offsets,
+    size_t start,
+    size_t end,
+    Fde_addresses<size>* fde_addresses)
+{
+  for (size_t i = start; i < end; ++i)
     {
+      const Fde_offset& fo((*fde_offsets)[i]);
       typename elfcpp::Elf_types<size>::Elf_Addr fde_pc;
       fde_pc = this->get_fde_pc<size, big_endian>(eh_frame_address,
 						  eh_frame_contents,
-						  p->first, p->second);
-      fde_addresses->push_back(fde_pc, eh_frame_address + p->first);
+						  fo.first, fo.second);
+      fde_addresses->set(i, fde_pc, eh_frame_address + fo.first);
     }
-
-  of->free_input_view(eh_frame_offset, eh_frame_size, eh_frame_contents);
 }
 
 // Class Fde.
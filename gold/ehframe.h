@@ -36,6 +36,9 @@ namespace gold
 template<int size, bool big_endian>
 class Track_relocs;
 
+template<int size, bool big_endian>
+class Eh_frame_hdr_fde_jobs;
+
 class Eh_frame;
 
 // This class manages the .eh_frame_hdr section, which holds the data
@@ -102,14 +105,15 @@ class Eh_frame_hdr : public Output_section_data
     typedef typename std::vector<Fde_address> Fde_address_list;
     typedef typename Fde_address_list::iterator iterator;
 
-    Fde_addresses(unsigned int reserve)
-      : fde_addresses_()
-    { this->fde_addresses_.reserve(reserve); }
+    Fde_addresses(unsigned int count)
+      : fde_addresses_(count)
+    { }
 
+    // Set entry I.  Different entries may be set by different threads.
     void
-    push_back(Address pc_address, Address fde_address)
+    set(size_t i, Address pc_address, Address fde_address)
     {
-      this->fde_addresses_.push_back(std::make_pair(pc_address, fde_address));
+      this->fde_addresses_[i] = std::make_pair(pc_address, fde_address);
     }
 
     iterator
@@ -124,16 +128,24 @@ class Eh_frame_hdr : public Output_section_data
     Fde_address_list fde_addresses_;
   };
 
-  // Compare Fde_address objects.
+  // Compare Fde_address objects.  FDEs with the same PC are sorted by
+  // address, so that the table does not depend on how it was sorted.
   template<int size>
   struct Fde_address_compare
   {
     bool
     operator()(const typename Fde_addresses<size>::Fde_address& f1,
 	       const typename Fde_addresses<size>::Fde_address& f2) const
-    { return f1.first < f2.first; }
+    {
+      if (f1.first != f2.first)
+	return f1.first < f2.first;
+      return f1.second < f2.second;
+    }
   };
 
+  template<int size, bool big_endian>
+  friend class Eh_frame_hdr_fde_jobs;
+
   // Return the PC to which an FDE refers.
   template<int size, bool big_endian>
   typename elfcpp::Elf_types<size>::Elf_Addr
@@ -148,6 +160,15 @@ class Eh_frame_hdr : public Output_section_data
 		    const Fde_offsets* fde_offsets,
 		    Fde_addresses<size>* fde_addresses);
 
+  // Convert entries [START, END) of FDE_OFFSETS to Fde_addresses.
+  template<int size, bool big_endian>
+  void
+  get_fde_addresses_range(
+      typename elfcpp::Elf_types<size>::Elf_Addr eh_frame_address,
+      const unsigned char* eh_frame_contents,
+      const Fde_offsets* fde_offsets, size_t start, size_t end,
+      Fde_addresses<size>* fde_addresses);
+
   // The .eh_frame section.
   Output_section* eh_frame_section_;
   // The .eh_frame section data.
@@ -119,13 +119,18 @@ Errors::warning(const char* format, va_list args)
   this->increment_counter(&this->warning_count_);
 }
 
-// Print an informational message.
+// Print an informational message.  Plugins may call this from
+// several threads at once, so write the message and the newline with
+// a single call.
 
 void
 Errors::info(const char* format, va_list args)
 {
-  vfprintf(stderr, format, args);
-  fputc('\n', stderr);
+  char* buf = NULL;
+  if (vasprintf(&buf, format, args) < 0)
+    gold_nomem();
+  fprintf(stderr, "%s\n", buf);
+  free(buf);
 }
 
 // Report an error at a reloc location.
@@ -38,6 +38,7 @@
 
 #include <sys/stat.h>
 #include "filenames.h"
+#include "md5.h"
 
 #include "debug.h"
 #include "parameters.h"
@@ -114,6 +115,51 @@ get_mtime(const char* filename, Timespec* mtime)
   return true;
 }
 
+// Compute the MD5 checksum of the contents of an unopened file.
+
+bool
+get_file_checksum(const char* filename, unsigned char* checksum)
+{
+  int o = open_descriptor(-1, filename, O_RDONLY);
+  if (o < 0)
+    return false;
+
+  bool ret = false;
+  struct stat file_stat;
+  if (::fstat(o, &file_stat) == 0)
+    {
+      size_t size = file_stat.st_size;
+      void* p = (size == 0
+		 ? MAP_FAILED
+		 : ::mmap(NULL, size, PROT_READ, MAP_PRIVATE, o, 0));
+      if (p != MAP_FAILED)
+	{
+	  md5_buffer(static_cast<const char*>(p), size, checksum);
+	  ::munmap(p, size);
+	  ret = true;
+	}
+      else
+	{
+	  // Fall back to reading the file, as for an empty file or a
+	  // file system which does not support mmap.
+	  struct md5_ctx ctx;
+	  md5_init_ctx(&ctx);
+	  char buf[65536];
+	  ssize_t len;
+	  while ((len = ::read(o, buf, sizeof buf)) > 0)
+	    md5_process_bytes(buf, len, &ctx);
+	  if (len == 0)
+	    {
+	      md5_finish_ctx(&ctx, checksum);
+	      ret = true;
+	    }
+	}
+    }
+
+  release_descriptor(o, true);
+  return ret;
+}
+
 // Class File_read.
 
 // A lock for the File_read static variables.
@@ -124,6 +170,13 @@ static Initialize_lock file_counts_initialize_lock(&file_counts_lock);
 unsigned long long File_read::total_mapped_bytes;
 unsigned long long File_read::current_mapped_bytes;
 unsigned long long File_read::maximum_mapped_bytes;
+unsigned long long File_read::total_view_hits;
+unsigned long long File_read::total_view_misses;
+unsigned long long File_read::evicted_views;
+unsigned long long File_read::evicted_bytes;
+File_read::View* File_read::lru_head;
+File_read::View* File_read::lru_tail;
+unsigned long long File_read::lru_bytes;
 
 // Class File_read::View.
 
@@ -136,6 +189,13 @@ File_read::View::~View()
       free(const_cast<unsigned char*>(this->data_));
       break;
     case DATA_MMAPPED:
+      if (File_read::max_mapped_input() != 0)
+	{
+	  file_counts_initialize_lock.initialize();
+	  Hold_optional_lock hl(file_counts_lock);
+	  if (this->on_lru_)
+	    File_read::lru_remove(this);
+	}
       if (::munmap(const_cast<unsigned char*>(this->data_), this->size_) != 0)
 	gold_warning(_("munmap failed: %s"), strerror(errno));
       if (!parameters->options_valid() || parameters->options().stats())
@@ -267,9 +327,13 @@ File_read::release()
       File_read::current_mapped_bytes += this->mapped_bytes_;
       if (File_read::current_mapped_bytes > File_read::maximum_mapped_bytes)
 	File_read::maximum_mapped_bytes = File_read::current_mapped_bytes;
+      File_read::total_view_hits += this->view_hits_;
+      File_read::total_view_misses += this->view_misses_;
     }
 
   this->mapped_bytes_ = 0;
+  this->view_hits_ = 0;
+  this->view_misses_ = 0;
 
   // Only clear views if there is only one attached object.  Otherwise
   // we waste time trying to clear cached archive views.  Similarly
@@ -342,7 +406,10 @@ File_read::find_view(off_t start, section_size_type size,
   // we can return it.
   if (this->whole_file_view_)
     if (byteshift == -1U || byteshift == 0)
-      return this->whole_file_view_;
+      {
+	File_read::touch_view(this->whole_file_view_);
+	return this->whole_file_view_;
+      }
 
   off_t page = File_read::page_offset(start);
 
@@ -359,6 +426,7 @@ File_read::find_view(off_t start, section_size_type size,
 	  if (byteshift == -1U || byteshift == p->second->byteshift())
 	    {
 	      p->second->set_accessed();
+	      File_read::touch_view(p->second);
 	      return p->second;
 	    }
 
@@ -428,10 +496,12 @@ File_read::read(off_t start, section_size_type size, void* p)
   const File_read::View* pv = this->find_view(start, size, -1U, NULL);
   if (pv != NULL)
     {
+      ++this->view_hits_;
       memcpy(p, pv->data() + (start - pv->start() + pv->byteshift()), size);
       return;
     }
 
+  ++this->view_misses_;
   this->do_read(start, size, p);
 }
 
@@ -521,6 +591,7 @@ File_read::make_view(off_t start, section_size_type size,
 					   cache, ownership);
 
   this->add_view(v);
+  File_read::touch_view(v);
 
   return v;
 }
@@ -575,11 +646,14 @@ File_read::find_or_make_view(off_t offset, off_t start,
 				       &vshifted);
   if (v != NULL)
     {
+      ++this->view_hits_;
       if (cache)
 	v->set_cache();
       return v;
     }
 
+  ++this->view_misses_;
+
   // If VSHIFTED is not NULL, then it has the data we need, but with
   // the wrong byteshift.
   v = vshifted;
@@ -762,6 +836,88 @@ File_read::read_multiple(off_t base, const Read_multiple& rm)
     }
 }
 
+// Return the limit set by --max-mapped-input, or 0 if there is none.
+// Options may not yet be ready, e.g., when reading a version script.
+
+inline uint64_t
+File_read::max_mapped_input()
+{
+  if (!parameters->options_valid())
+    return 0;
+  return parameters->options().max_mapped_input();
+}
+
+// Remove V from the list of mapped views.  The lock for the File_read
+// static variables must be held when this is called.
+
+void
+File_read::lru_remove(View* v)
+{
+  gold_assert(v->on_lru_);
+  if (v->lru_prev_ != NULL)
+    v->lru_prev_->lru_next_ = v->lru_next_;
+  else
+    File_read::lru_head = v->lru_next_;
+  if (v->lru_next_ != NULL)
+    v->lru_next_->lru_prev_ = v->lru_prev_;
+  else
+    File_read::lru_tail = v->lru_prev_;
+  v->lru_prev_ = NULL;
+  v->lru_next_ = NULL;
+  v->on_lru_ = false;
+  File_read::lru_bytes -= v->size();
+}
+
+// Note that the view V has been used.  If --max-mapped-input is in
+// effect and V is mapped from the file, move V to the front of the
+// list of mapped views.  Then, while the views on the list map more
+// than the limit, give back the memory of the least recently used
+// view with madvise.  This is safe even if the view is still in use,
+// possibly by another thread: the pages of a private read-only file
+// mapping are simply read from the file again when they are next
+// touched.  The views themselves stay mapped until they are released
+// as usual.
+
+void
+File_read::touch_view(View* v)
+{
+  uint64_t limit = File_read::max_mapped_input();
+  if (limit == 0 || !v->is_mapped())
+    return;
+
+  file_counts_initialize_lock.initialize();
+  Hold_optional_lock hl(file_counts_lock);
+
+  if (v->on_lru_)
+    {
+      if (File_read::lru_head == v)
+	return;
+      File_read::lru_remove(v);
+    }
+
+  v->lru_prev_ = NULL;
+  v->lru_next_ = File_read::lru_head;
+  if (File_read::lru_head != NULL)
+    File_read::lru_head->lru_prev_ = v;
+  else
+    File_read::lru_tail = v;
+  File_read::lru_head = v;
+  v->on_lru_ = true;
+  File_read::lru_bytes += v->size();
+
+  while (File_read::lru_bytes > limit && File_read::lru_tail != v)
+    {
+      View* old = File_read::lru_tail;
+#if defined(HAVE_MMAP) && defined(MADV_DONTNEED)
+      ::madvise(const_cast<unsigned char*>(old->data()), old->size(),
+		MADV_DONTNEED);
+#endif
+      ++File_read::evicted_views;
+      File_read::evicted_bytes += old->size();
+      File_read::lru_remove(old);
+    }
+}
+
 // Mark all views as no longer cached.
 
 void
@@ -856,6 +1012,13 @@ File_read::print_stats()
 	  program_name, File_read::total_mapped_bytes);
   fprintf(stderr, _("%s: maximum bytes mapped for read at one time: %llu\n"),
 	  program_name, File_read::maximum_mapped_bytes);
+  fprintf(stderr, _("%s: file read requests: %llu; found in views: %llu\n"),
+	  program_name,
+	  File_read::total_view_hits + File_read::total_view_misses,
+	  File_read::total_view_hits);
+  if (File_read::max_mapped_input() != 0)
+    fprintf(stderr, _("%s: mapped views given back: %llu (%llu bytes)\n"),
+	    program_name, File_read::evicted_views, File_read::evicted_bytes);
 }
 
 // Class File_view.
@@ -58,6 +58,16 @@ struct Timespec
 bool
 get_mtime(const char* filename, Timespec* mtime);
 
+// Size of the checksum computed by get_file_checksum.
+const int file_checksum_size = 16;
+
+// Compute the MD5 checksum of the contents of an unopened file, and
+// store it in CHECKSUM, which must be file_checksum_size bytes long.
+// Returns false if the file can not be read.
+
+bool
+get_file_checksum(const char* filename, unsigned char* checksum);
+
 class Position_dependent_options;
 class Input_file_argument;
 class Dirsearch;
@@ -72,7 +82,7 @@ class File_read
   File_read()
     : name_(), descriptor_(-1), is_descriptor_opened_(false), object_count_(0),
       size_(0), token_(false), views_(), saved_views_(), mapped_bytes_(0),
-      released_(true), whole_file_view_(NULL)
+      view_hits_(0), view_misses_(0), released_(true), whole_file_view_(NULL)
   { }
 
   ~File_read();
@@ -247,6 +257,16 @@ class File_read
   // --stats.
   static unsigned long long maximum_mapped_bytes;
 
+  // Number of requests for file data which found, or did not find, an
+  // existing view if --stats.
+  static unsigned long long total_view_hits;
+  static unsigned long long total_view_misses;
+
+  // Number of views whose memory was given back for --max-mapped-input,
+  // and the bytes they mapped.
+  static unsigned long long evicted_views;
+  static unsigned long long evicted_bytes;
+
   // A view into the file.
   class View
   {
@@ -267,7 +287,7 @@ class File_read
 	 unsigned int byteshift, bool cache, Data_ownership data_ownership)
       : start_(start), size_(size), data_(data), lock_count_(0),
 	byteshift_(byteshift), cache_(cache), data_ownership_(data_ownership),
-	accessed_(true)
+	accessed_(true), lru_prev_(NULL), lru_next_(NULL), on_lru_(false)
     { }
 
     ~View();
@@ -327,10 +347,18 @@ class File_read
     is_permanent_view() const
     { return this->data_ownership_ == DATA_NOT_OWNED; }
 
+    // Returns TRUE if the data is mapped from the file, so that the
+    // memory can be given back and read again on demand.
+    bool
+    is_mapped() const
+    { return this->data_ownership_ == DATA_MMAPPED; }
+
    private:
     View(const View&);
     View& operator=(const View&);
 
+    friend class File_read;
+
     // The file offset of the start of the view.
     off_t start_;
     // The size of the view.
@@ -350,6 +378,11 @@ class File_read
     Data_ownership data_ownership_;
     // Whether the view has been accessed recently.
     bool accessed_;
+    // The neighbouring views on the list of mapped views used for
+    // --max-mapped-input, and whether this view is on the list.
+    View* lru_prev_;
+    View* lru_next_;
+    bool on_lru_;
   };
 
   friend class View;
@@ -361,6 +394,26 @@ class File_read
   // A simple list of Views.
   typedef std::list<View*> Saved_views;
 
+  // The list of mapped views whose memory has not been given back,
+  // most recently used first, for --max-mapped-input.  Protected by
+  // the lock for the File_read static variables.
+  static View* lru_head;
+  static View* lru_tail;
+  // The number of bytes mapped by the views on the list.
+  static unsigned long long lru_bytes;
+
+  // Return the value of --max-mapped-input, or 0 if there is no limit.
+  static uint64_t
+  max_mapped_input();
+
+  // Note that the view V has been used, for --max-mapped-input.
+  static void
+  touch_view(View* v);
+
+  // Remove V from the list of mapped views.
+  static void
+  lru_remove(View* v);
+
   // Open the descriptor if necessary.
   void
   reopen_descriptor();
@@ -434,6 +487,11 @@ class File_read
   // while the file is locked.  When we unlock the file, we transfer
   // the total to total_mapped_bytes, and reset this to zero.
   size_t mapped_bytes_;
+  // Number of requests which found, or did not find, an existing
+  // view.  These are transferred to total_view_hits and
+  // total_view_misses when the file is released, like mapped_bytes_.
+  unsigned long long view_hits_;
+  unsigned long long view_misses_;
   // Whether the file was released.
   bool released_;
   // A view containing the whole file.  May be NULL if we mmap only
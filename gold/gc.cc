@@ -22,45 +22,237 @@
 
 
 #include "gold.h"
+
+#include <algorithm>
+#include <functional>
+
 #include "object.h"
 #include "gc.h"
 #include "symtab.h"
+#include "gold-threads.h"
 
 namespace gold
 {
 
-// Garbage collection uses a worklist style algorithm to determine the 
-// transitive closure of all referenced sections.
-void 
+// Return the index in the reference graph of the SHNDX-th section of
+// OBJ.  The sections of each object get consecutive indexes.
+
+unsigned int
+Garbage_collection::section_index(Relobj* obj, unsigned int shndx)
+{
+  if (obj != this->last_object_)
+    {
+      std::pair<Object_bases::iterator, bool> ins =
+	this->object_bases_.insert(std::make_pair(obj, this->section_count_));
+      if (ins.second)
+	this->section_count_ += obj->shnum();
+      this->last_object_ = obj;
+      this->last_base_ = ins.first->second;
+    }
+  gold_assert(shndx < obj->shnum());
+  return this->last_base_ + shndx;
+}
+
+// Convert the list of references into compressed sparse row form:
+// the references from each section are stored together in refs_, in
+// the order of the section indexes.
+
+void
+Garbage_collection::build_graph()
+{
+  parallel_sort(this->edges_.begin(), this->edges_.end(),
+		std::less<uint64_t>());
+  this->edges_.erase(std::unique(this->edges_.begin(), this->edges_.end()),
+		     this->edges_.end());
+
+  this->ref_offsets_.assign(this->section_count_ + 1, 0);
+  this->refs_.resize(this->edges_.size());
+  for (size_t i = 0; i < this->edges_.size(); ++i)
+    {
+      ++this->ref_offsets_[(this->edges_[i] >> 32) + 1];
+      this->refs_[i] = static_cast<unsigned int>(this->edges_[i]);
+    }
+  for (unsigned int i = 0; i < this->section_count_; ++i)
+    this->ref_offsets_[i + 1] += this->ref_offsets_[i];
+
+  std::vector<uint64_t>().swap(this->edges_);
+}
+
+// Set the bit for section I in MARKS.  Return true if it was not
+// already set.
+
+static inline bool
+gc_mark_section(unsigned int* marks, unsigned int i)
+{
+  unsigned int* word = marks + i / 32;
+  unsigned int bit = 1U << (i % 32);
+  if ((*word & bit) != 0)
+    return false;
+#if defined(ENABLE_THREADS) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+  return (__sync_fetch_and_or(word, bit) & bit) == 0;
+#else
+  *word |= bit;
+  return true;
+#endif
+}
+
+// The number of sections a worker takes from the shared pool at a
+// time when marking.
+
+static const size_t gc_mark_batch_size = 256;
+
+// The Parallel_jobs which mark the sections reachable from the
+// sections in a shared pool.  Each job is a worker with its own
+// queue.  A worker takes sections from the pool when its queue is
+// empty, and gives back half of its queue when the queue gets long,
+// so that idle workers have something to do.  The workers stop when
+// the pool is empty and none of them has anything left in its queue.
+
+class Gc_mark_jobs : public Parallel_jobs
+{
+ public:
+  Gc_mark_jobs(const std::vector<unsigned int>& ref_offsets,
+	       const std::vector<unsigned int>& refs,
+	       unsigned int* marks, std::vector<unsigned int>* pool)
+    : ref_offsets_(ref_offsets), refs_(refs), marks_(marks), lock_(),
+      condvar_(lock_), pool_(pool), busy_(0)
+  { }
+
+ protected:
+  void
+  do_run_job(unsigned int)
+  {
+    std::vector<unsigned int> queue;
+    bool busy = false;
+    while (this->get_work(&queue, &busy))
+      {
+	while (!queue.empty())
+	  {
+	    unsigned int i = queue.back();
+	    queue.pop_back();
+	    for (unsigned int j = this->ref_offsets_[i];
+		 j < this->ref_offsets_[i + 1];
+		 ++j)
+	      {
+		unsigned int dst = this->refs_[j];
+		if (gc_mark_section(this->marks_, dst))
+		  queue.push_back(dst);
+	      }
+	    if (queue.size() >= 4 * gc_mark_batch_size)
+	      this->give_work(&queue);
+	  }
+      }
+  }
+
+ private:
+  // Move some sections from the pool into the empty *QUEUE.  *BUSY
+  // is whether this worker was counted as having work.  Return false
+  // if there is no more work to do.
+  bool
+  get_work(std::vector<unsigned int>* queue, bool* busy)
+  {
+    Hold_lock hl(this->lock_);
+    if (*busy)
+      {
+	*busy = false;
+	--this->busy_;
+      }
+    while (this->pool_->empty())
+      {
+	if (this->busy_ == 0)
+	  {
+	    this->condvar_.broadcast();
+	    return false;
+	  }
+	this->condvar_.wait();
+      }
+    size_t count = std::min(this->pool_->size(), gc_mark_batch_size);
+    queue->assign(this->pool_->end() - count, this->pool_->end());
+    this->pool_->resize(this->pool_->size() - count);
+    *busy = true;
+    ++this->busy_;
+    return true;
+  }
+
+  // Move half of *QUEUE into the pool.
+  void
+  give_work(std::vector<unsigned int>* queue)
+  {
+    size_t count = queue->size() / 2;
+    Hold_lock hl(this->lock_);
+    this->pool_->insert(this->pool_->end(), queue->end() - count,
+			queue->end());
+    queue->resize(queue->size() - count);
+    this->condvar_.broadcast();
+  }
+
+  const std::vector<unsigned int>& ref_offsets_;
+  const std::vector<unsigned int>& refs_;
+  unsigned int* marks_;
+  Lock lock_;
+  Condvar condvar_;
+  // Sections which have been marked but whose references have not
+  // been followed, and which are not in the queue of any worker.
+  std::vector<unsigned int>* pool_;
+  // The number of workers with a non-empty queue.
+  unsigned int busy_;
+};
+
+// Return whether the SHNDX-th section of OBJ is garbage, which is
+// to say that it is not reachable from any of the sections on the
+// work list.
+
+bool
+Garbage_collection::is_section_garbage(Relobj* obj, unsigned int shndx) const
+{
+  gold_assert(this->is_worklist_ready_);
+  Object_bases::const_iterator p = this->object_bases_.find(obj);
+  if (p == this->object_bases_.end())
+    return true;
+  unsigned int i = p->second + shndx;
+  return (this->marks_[i / 32] & (1U << (i % 32))) == 0;
+}
+
+// Garbage collection uses a worklist style algorithm to determine the
+// transitive closure of all referenced sections.  The references are
+// followed in parallel when using threads, since the result does not
+// depend on the order in which the sections are visited.
+
+void
 Garbage_collection::do_transitive_closure()
 {
-  while (!this->worklist().empty())
+  std::vector<unsigned int> roots;
+  roots.reserve(this->worklist().size());
+  for (Worklist_type::const_iterator p = this->worklist().begin();
+       p != this->worklist().end();
+       ++p)
+    roots.push_back(this->section_index(p->first, p->second));
+  Worklist_type().swap(this->worklist());
+
+  this->build_graph();
+
+  this->marks_.assign((this->section_count_ + 31) / 32, 0);
+  std::vector<unsigned int> pool;
+  for (std::vector<unsigned int>::const_iterator p = roots.begin();
+       p != roots.end();
+       ++p)
+    if (gc_mark_section(&this->marks_[0], *p))
+      pool.push_back(*p);
+
+  // It isn't worth starting threads for a small graph.
+  unsigned int workers = 1;
+#ifdef __GCC_HAVE_SYNC_COMPARE_AND_SWAP_4
+  if (this->refs_.size() >= 64 * 1024)
+    workers = 16;
+#endif
+
+  if (!pool.empty())
     {
-      // Add elements from the work list to the referenced list
-      // one by one.
-      Section_id entry = this->worklist().back();
-      this->worklist().pop_back();
-      if (!this->referenced_list().insert(entry).second)
-        continue;
-      Garbage_collection::Section_ref::iterator find_it = 
-                this->section_reloc_map().find(entry);
-      if (find_it == this->section_reloc_map().end()) 
-          continue;
-      const Garbage_collection::Sections_reachable &v = find_it->second;
-      // Scan the vector of references for each work_list entry. 
-      for (Garbage_collection::Sections_reachable::const_iterator it_v =
-               v.begin();
-           it_v != v.end();
-           ++it_v)
-        {
-          // Do not add already processed sections to the work_list. 
-          if (this->referenced_list().find(*it_v)
-              == this->referenced_list().end())
-            {
-              this->worklist().push_back(*it_v);
-            }
-        }
+      Gc_mark_jobs jobs(this->ref_offsets_, this->refs_, &this->marks_[0],
+			&pool);
+      jobs.run(workers);
     }
+
   this->worklist_ready();
 }
 
@@ -47,7 +47,6 @@ class Garbage_collection
  public:
 
   typedef Unordered_set<Section_id, Section_id_hash> Sections_reachable;
-  typedef std::map<Section_id, Sections_reachable> Section_ref;
   typedef std::vector<Section_id> Worklist_type;
   // This maps the name of the section which can be represented as a C
   // identifier (cident) to the list of sections that have that name.
@@ -55,19 +54,13 @@ class Garbage_collection
   typedef std::map<std::string, Sections_reachable> Cident_section_map;
 
   Garbage_collection()
-  : is_worklist_ready_(false)
+  : is_worklist_ready_(false), object_bases_(), section_count_(0),
+    last_object_(NULL), last_base_(0), edges_(), ref_offsets_(), refs_(),
+    marks_()
   { }
 
   // Accessor methods for the private members.
 
-  Sections_reachable&
-  referenced_list()
-  { return referenced_list_; }
-
-  Section_ref&
-  section_reloc_map()
-  { return this->section_reloc_map_; }
-
   Worklist_type&
   worklist()
   { return this->work_list_; }
@@ -83,10 +76,10 @@ class Garbage_collection
   void
   do_transitive_closure();
 
+  // Return whether the SHNDX-th section of OBJ is garbage.  This may
+  // only be called after do_transitive_closure.
   bool
-  is_section_garbage(Relobj* obj, unsigned int shndx)
-  { return (this->referenced_list().find(Section_id(obj, shndx))
-            == this->referenced_list().end()); }
+  is_section_garbage(Relobj* obj, unsigned int shndx) const;
 
   Cident_section_map*
   cident_sections()
@@ -103,18 +96,48 @@ class Garbage_collection
   add_reference(Relobj* src_object, unsigned int src_shndx,
 		Relobj* dst_object, unsigned int dst_shndx)
   {
-    Section_id src_id(src_object, src_shndx);
-    Section_id dst_id(dst_object, dst_shndx);
-    Sections_reachable& reachable = this->section_reloc_map_[src_id];
-    reachable.insert(dst_id);
+    uint64_t src = this->section_index(src_object, src_shndx);
+    uint64_t dst = this->section_index(dst_object, dst_shndx);
+    uint64_t edge = (src << 32) | dst;
+    // A section often refers to the same section several times in a
+    // row, so don't bother to record those twice.
+    if (this->edges_.empty() || this->edges_.back() != edge)
+      this->edges_.push_back(edge);
   }
 
  private:
+  // Return the index in the reference graph of the SHNDX-th section of
+  // OBJ, numbering the sections of OBJ if we haven't seen it before.
+  unsigned int
+  section_index(Relobj* obj, unsigned int shndx);
+
+  // Convert the references in edges_ into ref_offsets_ and refs_.
+  void
+  build_graph();
+
+  // Map each object to the index of its first section in the
+  // reference graph.
+  typedef Unordered_map<const Relobj*, unsigned int> Object_bases;
 
   Worklist_type work_list_;
   bool is_worklist_ready_;
-  Section_ref section_reloc_map_;
-  Sections_reachable referenced_list_;
+  // The index of section 0 of each object we have seen.
+  Object_bases object_bases_;
+  // The number of sections in the reference graph.
+  unsigned int section_count_;
+  // The object we last looked up in object_bases_, and its base.
+  const Relobj* last_object_;
+  unsigned int last_base_;
+  // The references we have seen, with the index of the source section
+  // in the high 32 bits and that of the destination in the low 32
+  // bits.  This is emptied by build_graph.
+  std::vector<uint64_t> edges_;
+  // The references from section I are refs_[ref_offsets_[I]] up to
+  // refs_[ref_offsets_[I + 1]].
+  std::vector<unsigned int> ref_offsets_;
+  std::vector<unsigned int> refs_;
+  // A bit for each section, set if the section is referenced.
+  std::vector<unsigned int> marks_;
   Cident_section_map cident_sections_;
 };
 
@@ -351,16 +374,14 @@ gc_process_relocs(
                 symtab->gc()->cident_sections()->find(std::string(cident_section_name));
               if (ele == symtab->gc()->cident_sections()->end())
                 continue;
-	      Section_id src_id(src_obj, src_indx);
-              Garbage_collection::Sections_reachable&
-                v(symtab->gc()->section_reloc_map()[src_id]);
               Garbage_collection::Sections_reachable& cident_secn(ele->second);
               for (Garbage_collection::Sections_reachable::iterator it_v
                      = cident_secn.begin();
                    it_v != cident_secn.end();
                    ++it_v)
                 {
-                  v.insert(*it_v);
+                  symtab->gc()->add_reference(src_obj, src_indx,
+                                              it_v->first, it_v->second);
                 }
             }
         }
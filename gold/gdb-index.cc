@@ -28,6 +28,7 @@
 #include "object.h"
 #include "output.h"
 #include "demangle.h"
+#include "workqueue.h"
 
 namespace gold
 {
@@ -171,6 +172,208 @@ mapped_index_string_hash(const unsigned char* str)
   return r;
 }
 
+class Gdb_index_info_reader;
+
+// The .debug_info and .debug_types sections of an input object, and
+// the results of scanning them.  The objects are scanned in parallel
+// by Gdb_index_scan_task, so everything the scan finds is kept here,
+// with CU and TU indexes local to the object, until
+// Gdb_index::add_object_scan adds it to the index.
+
+class Gdb_index::Object_scan
+{
+ public:
+  // A symbol found by the scan.  NAME points into NAMES_.
+  struct Symbol
+  {
+    Symbol(int cu_index_arg, const char* name_arg, unsigned int hash_arg,
+	   uint8_t flags_arg)
+      : cu_index(cu_index_arg), name(name_arg), hash(hash_arg),
+	flags(flags_arg)
+    { }
+
+    int cu_index;
+    const char* name;
+    unsigned int hash;
+    uint8_t flags;
+  };
+
+  Object_scan(Relobj* object)
+    : cu_count(0), cu_nopubnames_count(0), tu_count(0),
+      tu_nopubnames_count(0), object_(object), sections_(), comp_units_(),
+      type_units_(), ranges_(), symbols_(), names_(), cu_pubname_map_(),
+      cu_pubtype_map_(), pubnames_table_(NULL), pubtypes_table_(NULL),
+      stmt_list_offset_(-1)
+  { }
+
+  ~Object_scan();
+
+  // Return the input object.
+  Relobj*
+  object() const
+  { return this->object_; }
+
+  // Record a section to scan.
+  void
+  add_section(bool is_type_unit, unsigned int shndx,
+	      unsigned int reloc_shndx, unsigned int reloc_type)
+  {
+    this->sections_.push_back(Section(is_type_unit, shndx, reloc_shndx,
+				      reloc_type));
+  }
+
+  // Scan the sections.  The object must be locked.
+  void
+  scan();
+
+  // Add a compilation unit, returning its local index.
+  int
+  add_comp_unit(off_t cu_offset, off_t cu_length)
+  {
+    this->comp_units_.push_back(Comp_unit(cu_offset, cu_length));
+    return this->comp_units_.size() - 1;
+  }
+
+  // Add a type unit, returning its local index.
+  int
+  add_type_unit(off_t tu_offset, off_t type_offset, uint64_t signature)
+  {
+    this->type_units_.push_back(Type_unit(tu_offset, type_offset, signature));
+    return this->type_units_.size() - 1;
+  }
+
+  // Add an address range.
+  void
+  add_address_range_list(unsigned int cu_index, Dwarf_range_list* ranges)
+  {
+    this->ranges_.push_back(Per_cu_range_list(this->object_, cu_index,
+					      ranges));
+  }
+
+  // Add a symbol.  FLAGS are the gdb_index version 7 flags to be
+  // stored in the high-byte of the cu_index field.
+  void
+  add_symbol(int cu_index, const char* sym_name, uint8_t flags);
+
+  // Return the offset into the pubnames table for the cu at the given
+  // offset.
+  off_t
+  find_pubname_offset(off_t cu_offset);
+
+  // Return the offset into the pubtypes table for the cu at the
+  // given offset.
+  off_t
+  find_pubtype_offset(off_t cu_offset);
+
+  // Return TRUE if we have already processed the pubnames and types
+  // set of the CUs and TUS associated with the statement list at
+  // OFFSET.
+  bool
+  pubnames_read(off_t offset) const
+  { return this->stmt_list_offset_ == offset; }
+
+  // Record that we have already read the pubnames associated with
+  // OFFSET.
+  void
+  set_pubnames_read(off_t offset)
+  { this->stmt_list_offset_ = offset; }
+
+  // Return a pointer to the given table.
+  Dwarf_pubnames_table*
+  pubnames_table()
+  { return this->pubnames_table_; }
+
+  Dwarf_pubnames_table*
+  pubtypes_table()
+  { return this->pubtypes_table_; }
+
+  // Return the compilation units.
+  const std::vector<Comp_unit>&
+  comp_units() const
+  { return this->comp_units_; }
+
+  // Return the type units.
+  const std::vector<Type_unit>&
+  type_units() const
+  { return this->type_units_; }
+
+  // Return the address ranges.
+  const std::vector<Per_cu_range_list>&
+  ranges() const
+  { return this->ranges_; }
+
+  // Return the symbols, in the order they were found.
+  const std::vector<Symbol>&
+  symbols() const
+  { return this->symbols_; }
+
+  // Statistics, added up by Gdb_index_info_reader::add_stats.
+  // Number of DWARF compilation units processed.
+  unsigned int cu_count;
+  // Number of DWARF compilation units without pubnames/pubtypes.
+  unsigned int cu_nopubnames_count;
+  // Number of DWARF type units processed.
+  unsigned int tu_count;
+  // Number of DWARF type units without pubnames/pubtypes.
+  unsigned int tu_nopubnames_count;
+
+ private:
+  // A .debug_info or .debug_types section to scan.
+  struct Section
+  {
+    Section(bool is_type_unit_arg, unsigned int shndx_arg,
+	    unsigned int reloc_shndx_arg, unsigned int reloc_type_arg)
+      : is_type_unit(is_type_unit_arg), shndx(shndx_arg),
+	reloc_shndx(reloc_shndx_arg), reloc_type(reloc_type_arg)
+    { }
+
+    bool is_type_unit;
+    unsigned int shndx;
+    unsigned int reloc_shndx;
+    unsigned int reloc_type;
+  };
+
+  typedef Unordered_map<off_t, off_t> Pubname_offset_map;
+
+  // Create a map from dies to pubnames.
+  Dwarf_pubnames_table*
+  map_pubtable_to_dies(unsigned int attr,
+                       Gdb_index_info_reader* dwinfo,
+                       const unsigned char* symbols,
+                       off_t symbols_size);
+
+  // Wrapper for map_pubtable_to_dies
+  void
+  map_pubnames_and_types_to_dies(Gdb_index_info_reader* dwinfo,
+                                 const unsigned char* symbols,
+                                 off_t symbols_size);
+
+  // The input object.
+  Relobj* object_;
+  // The sections to scan.
+  std::vector<Section> sections_;
+  // The list of DWARF compilation units.
+  std::vector<Comp_unit> comp_units_;
+  // The list of DWARF type units.
+  std::vector<Type_unit> type_units_;
+  // The list of address ranges.
+  std::vector<Per_cu_range_list> ranges_;
+  // The symbols.
+  std::vector<Symbol> symbols_;
+  // The symbol names.
+  Stringpool names_;
+  // Maps from CU offsets to offsets in the pubnames and pubtypes
+  // tables.
+  Pubname_offset_map cu_pubname_map_;
+  Pubname_offset_map cu_pubtype_map_;
+  // Tables to store the pubnames section of the object.
+  Dwarf_pubnames_table* pubnames_table_;
+  Dwarf_pubnames_table* pubtypes_table_;
+  // Stmt list offset of the CUs and TUs associated with the last
+  // read pubnames and pubtypes sections.
+  off_t stmt_list_offset_;
+};
+
 // A specialization of Dwarf_info_reader, for building the .gdb_index.
 
 class Gdb_index_info_reader : public Dwarf_info_reader
@@ -183,15 +386,19 @@ class Gdb_index_info_reader : public Dwarf_info_reader
 			unsigned int shndx,
 			unsigned int reloc_shndx,
 			unsigned int reloc_type,
-			Gdb_index* gdb_index)
+			Gdb_index::Object_scan* scan)
     : Dwarf_info_reader(is_type_unit, object, symbols, symbols_size, shndx,
 			reloc_shndx, reloc_type),
-      gdb_index_(gdb_index), cu_index_(0), cu_language_(0)
+      scan_(scan), cu_index_(0), cu_language_(0)
   { }
 
   ~Gdb_index_info_reader()
   { this->clear_declarations(); }
 
+  // Add the statistics of a scanned object.
+  static void
+  add_stats(const Gdb_index::Object_scan* scan);
+
   // Print usage statistics.
   static void
   print_stats();
@@ -285,9 +492,9 @@ class Gdb_index_info_reader : public Dwarf_info_reader
   void
   clear_declarations();
 
-  // The Gdb_index section.
-  Gdb_index* gdb_index_;
-  // The current CU index (negative for a TU).
+  // The scan of the object, which collects what we find.
+  Gdb_index::Object_scan* scan_;
+  // The current CU index, local to the object (negative for a TU).
   int cu_index_;
   // The language of the current CU or TU.
   unsigned int cu_language_;
@@ -321,8 +528,8 @@ void
 Gdb_index_info_reader::visit_compilation_unit(off_t cu_offset, off_t cu_length,
 					      Dwarf_die* root_die)
 {
-  ++Gdb_index_info_reader::dwarf_cu_count;
-  this->cu_index_ = this->gdb_index_->add_comp_unit(cu_offset, cu_length);
+  ++this->scan_->cu_count;
+  this->cu_index_ = this->scan_->add_comp_unit(cu_offset, cu_length);
   this->visit_top_die(root_die);
 }
 
@@ -333,10 +540,10 @@ Gdb_index_info_reader::visit_type_unit(off_t tu_offset, off_t,
 				       off_t type_offset, uint64_t signature,
 				       Dwarf_die* root_die)
 {
-  ++Gdb_index_info_reader::dwarf_tu_count;
+  ++this->scan_->tu_count;
   // Use a negative index to flag this as a TU instead of a CU.
-  this->cu_index_ = -1 - this->gdb_index_->add_type_unit(tu_offset, type_offset,
-							 signature);
+  this->cu_index_ = -1 - this->scan_->add_type_unit(tu_offset, type_offset,
+						    signature);
   this->visit_top_die(root_die);
 }
 
@@ -381,9 +588,9 @@ Gdb_index_info_reader::visit_top_die(Dwarf_die* die)
 		return;
 	      }
 	    if (die->tag() == elfcpp::DW_TAG_compile_unit)
-	      ++Gdb_index_info_reader::dwarf_cu_nopubnames_count;
+	      ++this->scan_->cu_nopubnames_count;
 	    else
-	      ++Gdb_index_info_reader::dwarf_tu_nopubnames_count;
+	      ++this->scan_->tu_nopubnames_count;
 	    this->visit_children(die, NULL);
 	  }
 	break;
@@ -437,8 +644,7 @@ Gdb_index_info_reader::visit_die(Dwarf_die* die, Dwarf_die* context)
 	    // If the DIE is not a declaration, add it to the index.
 	    std::string full_name = this->get_qualified_name(die, context);
 	    if (!full_name.empty())
-	      this->gdb_index_->add_symbol(this->cu_index_,
-                                           full_name.c_str(), 0);
+	      this->scan_->add_symbol(this->cu_index_, full_name.c_str(), 0);
 	  }
 	break;
       case elfcpp::DW_TAG_typedef:
@@ -477,8 +683,7 @@ Gdb_index_info_reader::visit_die(Dwarf_die* die, Dwarf_die* context)
 	      if (full_name.empty())
 		full_name = this->get_qualified_name(die, context);
 	      if (!full_name.empty())
-		this->gdb_index_->add_symbol(this->cu_index_,
-					     full_name.c_str(), 0);
+		this->scan_->add_symbol(this->cu_index_, full_name.c_str(), 0);
 	    }
 
 	  // We're interested in the children only for namespaces and
@@ -825,8 +1030,7 @@ Gdb_index_info_reader::record_cu_ranges(Dwarf_die* die)
     {
       Dwarf_range_list* ranges = this->read_range_list(shndx, ranges_offset);
       if (ranges != NULL)
-	this->gdb_index_->add_address_range_list(this->object(),
-						 this->cu_index_, ranges);
+	this->scan_->add_address_range_list(this->cu_index_, ranges);
       return;
     }
 
@@ -851,8 +1055,7 @@ Gdb_index_info_reader::record_cu_ranges(Dwarf_die* die)
         {
 	  Dwarf_range_list* ranges = new Dwarf_range_list();
 	  ranges->add(shndx, low_pc, high_pc);
-	  this->gdb_index_->add_address_range_list(this->object(),
-						   this->cu_index_, ranges);
+	  this->scan_->add_address_range_list(this->cu_index_, ranges);
         }
     }
 }
@@ -877,7 +1080,7 @@ Gdb_index_info_reader::read_pubtable(Dwarf_pubnames_table* table, off_t offset)
       if (name == NULL)
         break;
 
-      this->gdb_index_->add_symbol(this->cu_index_, name, flag_byte);
+      this->scan_->add_symbol(this->cu_index_, name, flag_byte);
     }
   return true;
 }
@@ -916,22 +1119,26 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
           // have read. If it does, then no need to read the pubnames.
           // If it doesn't, then the caller will have to parse the
           // dies manually to find the names.
-          return this->gdb_index_->pubnames_read(this->object(),
-                                                 stmt_list_off);
-        }
-      else
-        {
-          // No attribute on the CU means that no pubnames were read.
-          return false;
+          return this->scan_->pubnames_read(stmt_list_off);
         }
+
+      // No attribute on the CU normally means that there are no
+      // pubnames.  However, a GNU-style pubnames table lists all the
+      // names of the CUs it covers, so if there is one for this CU we
+      // can use it rather than parsing the dies.
+      Dwarf_pubnames_table* pubnames = this->scan_->pubnames_table();
+      if (pubnames == NULL
+	  || !pubnames->is_gnu_style()
+	  || this->scan_->find_pubname_offset(this->cu_offset()) == -1)
+	return false;
     }
 
-  // We found the attribute, so we can check if the corresponding
-  // pubnames have been read.
-  if (this->gdb_index_->pubnames_read(this->object(), stmt_list_off))
+  // We found the attribute or a GNU-style table, so we can check if
+  // the corresponding pubnames have been read.
+  if (this->scan_->pubnames_read(stmt_list_off))
     return true;
 
-  this->gdb_index_->set_pubnames_read(this->object(), stmt_list_off);
+  this->scan_->set_pubnames_read(stmt_list_off);
 
   // We have an attribute, and the pubnames haven't been read, so read
   // them.
@@ -939,12 +1146,12 @@ Gdb_index_info_reader::read_pubnames_and_pubtypes(Dwarf_die* die)
   // In some of the cases, we could rely on the previous value of
   // offset here, but sorting out which cases complicates the logic
   // enough that it isn't worth it. So just look up the offset again.
-  offset = this->gdb_index_->find_pubname_offset(this->cu_offset());
-  names = this->read_pubtable(this->gdb_index_->pubnames_table(), offset);
+  offset = this->scan_->find_pubname_offset(this->cu_offset());
+  names = this->read_pubtable(this->scan_->pubnames_table(), offset);
 
   bool types = false;
-  offset = this->gdb_index_->find_pubtype_offset(this->cu_offset());
-  types = this->read_pubtable(this->gdb_index_->pubtypes_table(), offset);
+  offset = this->scan_->find_pubtype_offset(this->cu_offset());
+  types = this->read_pubtable(this->scan_->pubtypes_table(), offset);
   return names || types;
 }
 
@@ -964,6 +1171,19 @@ Gdb_index_info_reader::clear_declarations()
   this->declarations_.clear();
 }
 
+// Add the statistics of a scanned object.
+
+void
+Gdb_index_info_reader::add_stats(const Gdb_index::Object_scan* scan)
+{
+  Gdb_index_info_reader::dwarf_cu_count += scan->cu_count;
+  Gdb_index_info_reader::dwarf_cu_nopubnames_count +=
+    scan->cu_nopubnames_count;
+  Gdb_index_info_reader::dwarf_tu_count += scan->tu_count;
+  Gdb_index_info_reader::dwarf_tu_nopubnames_count +=
+    scan->tu_nopubnames_count;
+}
+
 // Print usage statistics.
 void
 Gdb_index_info_reader::print_stats()
@@ -978,41 +1198,84 @@ Gdb_index_info_reader::print_stats()
           program_name, Gdb_index_info_reader::dwarf_tu_nopubnames_count);
 }
 
-// Class Gdb_index.
-
-// Construct the .gdb_index section.
+// Class Gdb_index::Object_scan.
 
-Gdb_index::Gdb_index(Output_section* gdb_index_section)
-  : Output_section_data(4),
-    pubnames_table_(NULL),
-    pubtypes_table_(NULL),
-    gdb_index_section_(gdb_index_section),
-    comp_units_(),
-    type_units_(),
-    ranges_(),
-    cu_vector_list_(),
-    cu_vector_offsets_(NULL),
-    stringpool_(),
-    tu_offset_(0),
-    addr_offset_(0),
-    symtab_offset_(0),
-    cu_pool_offset_(0),
-    stringpool_offset_(0),
-    pubnames_object_(NULL),
-    stmt_list_offset_(-1)
+Gdb_index::Object_scan::~Object_scan()
 {
-  this->gdb_symtab_ = new Gdb_hashtab<Gdb_symbol>();
+  delete this->pubnames_table_;
+  delete this->pubtypes_table_;
 }
 
-Gdb_index::~Gdb_index()
+// Scan the .debug_info and .debug_types sections of the object.
+
+void
+Gdb_index::Object_scan::scan()
 {
-  // Free the memory used by the symbol table.
-  delete this->gdb_symtab_;
-  // Free the memory used by the CU vectors.
-  for (unsigned int i = 0; i < this->cu_vector_list_.size(); ++i)
-    delete this->cu_vector_list_[i];
+  // We need the symbol table to interpret the relocs, if there are
+  // any.
+  bool has_relocs = false;
+  for (std::vector<Section>::const_iterator p = this->sections_.begin();
+       p != this->sections_.end();
+       ++p)
+    if (p->reloc_shndx != 0)
+      has_relocs = true;
+
+  const unsigned char* symbols = NULL;
+  section_size_type symbols_size = 0;
+  if (has_relocs)
+    {
+      for (unsigned int i = 1; i < this->object_->shnum(); ++i)
+	if (this->object_->section_type(i) == elfcpp::SHT_SYMTAB)
+	  {
+	    symbols = this->object_->section_contents(i, &symbols_size,
+						      false);
+	    break;
+	  }
+    }
+
+  // The pubnames and pubtypes tables hold on to the reader used to
+  // read them, so we keep the first reader until we are done.
+  Gdb_index_info_reader* first_dwinfo = NULL;
+  for (std::vector<Section>::const_iterator p = this->sections_.begin();
+       p != this->sections_.end();
+       ++p)
+    {
+      Gdb_index_info_reader* dwinfo =
+	new Gdb_index_info_reader(p->is_type_unit, this->object_,
+				  symbols, symbols_size, p->shndx,
+				  p->reloc_shndx, p->reloc_type, this);
+      if (first_dwinfo == NULL)
+	{
+	  first_dwinfo = dwinfo;
+	  this->map_pubnames_and_types_to_dies(dwinfo, symbols, symbols_size);
+	}
+      dwinfo->parse();
+      if (dwinfo != first_dwinfo)
+	delete dwinfo;
+    }
+
+  // We are done with the pubnames and pubtypes.
+  delete this->pubnames_table_;
+  this->pubnames_table_ = NULL;
+  delete this->pubtypes_table_;
+  this->pubtypes_table_ = NULL;
+  this->cu_pubname_map_.clear();
+  this->cu_pubtype_map_.clear();
+  delete first_dwinfo;
 }
 
+// Add a symbol.  We copy the name, since it may point into a section
+// which we are about to release.
+
+void
+Gdb_index::Object_scan::add_symbol(int cu_index, const char* sym_name,
+				   uint8_t flags)
+{
+  const char* name = this->names_.add(sym_name, true, NULL);
+  unsigned int hash = mapped_index_string_hash(
+      reinterpret_cast<const unsigned char*>(name));
+  this->symbols_.push_back(Symbol(cu_index, name, hash, flags));
+}
 
 // Scan the pubnames and pubtypes sections and build a map of the
 // various cus and tus they refer to, so we can process the entries
@@ -1020,11 +1283,10 @@ Gdb_index::~Gdb_index()
 // Return the just-read table so it can be cached.
 
 Dwarf_pubnames_table*
-Gdb_index::map_pubtable_to_dies(unsigned int attr,
-                                Gdb_index_info_reader* dwinfo,
-                                Relobj* object,
-                                const unsigned char* symbols,
-                                off_t symbols_size)
+Gdb_index::Object_scan::map_pubtable_to_dies(unsigned int attr,
+					     Gdb_index_info_reader* dwinfo,
+					     const unsigned char* symbols,
+					     off_t symbols_size)
 {
   uint64_t section_offset = 0;
   Dwarf_pubnames_table* table;
@@ -1042,8 +1304,11 @@ Gdb_index::map_pubtable_to_dies(unsigned int attr,
     }
 
   map->clear();
-  if (!table->read_section(object, symbols, symbols_size))
-    return NULL;
+  if (!table->read_section(this->object_, symbols, symbols_size))
+    {
+      delete table;
+      return NULL;
+    }
 
   while (table->read_header(section_offset))
     {
@@ -1057,30 +1322,28 @@ Gdb_index::map_pubtable_to_dies(unsigned int attr,
 // Wrapper for map_pubtable_to_dies
 
 void
-Gdb_index::map_pubnames_and_types_to_dies(Gdb_index_info_reader* dwinfo,
-                                          Relobj* object,
-                                          const unsigned char* symbols,
-                                          off_t symbols_size)
+Gdb_index::Object_scan::map_pubnames_and_types_to_dies(
+    Gdb_index_info_reader* dwinfo,
+    const unsigned char* symbols,
+    off_t symbols_size)
 {
-  // This is a new object, so reset the relevant variables.
-  this->pubnames_object_ = object;
   this->stmt_list_offset_ = -1;
 
   delete this->pubnames_table_;
   this->pubnames_table_
       = this->map_pubtable_to_dies(elfcpp::DW_AT_GNU_pubnames, dwinfo,
-                                   object, symbols, symbols_size);
+                                   symbols, symbols_size);
   delete this->pubtypes_table_;
   this->pubtypes_table_
       = this->map_pubtable_to_dies(elfcpp::DW_AT_GNU_pubtypes, dwinfo,
-                                   object, symbols, symbols_size);
+                                   symbols, symbols_size);
 }
 
 // Given a cu_offset, find the associated section of the pubnames
 // table.
 
 off_t
-Gdb_index::find_pubname_offset(off_t cu_offset)
+Gdb_index::Object_scan::find_pubname_offset(off_t cu_offset)
 {
   Pubname_offset_map::iterator it = this->cu_pubname_map_.find(cu_offset);
   if (it != this->cu_pubname_map_.end())
@@ -1092,7 +1355,7 @@ Gdb_index::find_pubname_offset(off_t cu_offset)
 // table.
 
 off_t
-Gdb_index::find_pubtype_offset(off_t cu_offset)
+Gdb_index::Object_scan::find_pubtype_offset(off_t cu_offset)
 {
   Pubname_offset_map::iterator it = this->cu_pubtype_map_.find(cu_offset);
   if (it != this->cu_pubtype_map_.end())
@@ -1100,33 +1363,182 @@ Gdb_index::find_pubtype_offset(off_t cu_offset)
   return -1;
 }
 
-// Scan a .debug_info or .debug_types input section.
+// A task to scan the .debug_info and .debug_types sections of an
+// input object for the .gdb_index section.
+
+class Gdb_index_scan_task : public Task
+{
+ public:
+  // BLOCKER is held until the scan is done.
+  Gdb_index_scan_task(Gdb_index::Object_scan* scan, Task_token* blocker)
+    : scan_(scan), blocker_(blocker)
+  { }
+
+  // The standard Task methods.
+
+  Task_token*
+  is_runnable();
+
+  void
+  locks(Task_locker*);
+
+  void
+  run(Workqueue*);
+
+  std::string
+  get_name() const
+  { return "Gdb_index_scan_task " + this->scan_->object()->name(); }
+
+ private:
+  Gdb_index::Object_scan* scan_;
+  Task_token* blocker_;
+};
+
+// We need to lock the object to read it.
+
+Task_token*
+Gdb_index_scan_task::is_runnable()
+{
+  Relobj* object = this->scan_->object();
+  if (object->is_locked())
+    return object->token();
+  return NULL;
+}
+
+// Return the locks we hold: one on the file and one on the blocker.
+
+void
+Gdb_index_scan_task::locks(Task_locker* tl)
+{
+  Task_token* token = this->scan_->object()->token();
+  if (token != NULL)
+    tl->add(this, token);
+  tl->add(this, this->blocker_);
+}
+
+// Scan the object.
+
+void
+Gdb_index_scan_task::run(Workqueue*)
+{
+  this->scan_->scan();
+  this->scan_->object()->release();
+}
+
+// Class Gdb_index.
+
+// Construct the .gdb_index section.
+
+Gdb_index::Gdb_index(Output_section* gdb_index_section)
+  : Output_section_data(4),
+    object_scans_(),
+    gdb_index_section_(gdb_index_section),
+    comp_units_(),
+    type_units_(),
+    ranges_(),
+    cu_vector_list_(),
+    cu_vector_offsets_(NULL),
+    stringpool_(),
+    tu_offset_(0),
+    addr_offset_(0),
+    symtab_offset_(0),
+    cu_pool_offset_(0),
+    stringpool_offset_(0)
+{
+  this->gdb_symtab_ = new Gdb_hashtab<Gdb_symbol>();
+}
+
+Gdb_index::~Gdb_index()
+{
+  // Free the memory used by the symbol table.
+  delete this->gdb_symtab_;
+  // Free the memory used by the CU vectors.
+  for (unsigned int i = 0; i < this->cu_vector_list_.size(); ++i)
+    delete this->cu_vector_list_[i];
+  for (unsigned int i = 0; i < this->object_scans_.size(); ++i)
+    delete this->object_scans_[i];
+}
+
+// Record a .debug_info or .debug_types input section to be scanned.
+// The sections of an object are recorded one after another.
 
 void
-Gdb_index::scan_debug_info(bool is_type_unit,
-			   Relobj* object,
-			   const unsigned char* symbols,
-			   off_t symbols_size,
-			   unsigned int shndx,
-			   unsigned int reloc_shndx,
-			   unsigned int reloc_type)
+Gdb_index::add_debug_info_section(bool is_type_unit,
+				  Relobj* object,
+				  unsigned int shndx,
+				  unsigned int reloc_shndx,
+				  unsigned int reloc_type)
 {
-  Gdb_index_info_reader dwinfo(is_type_unit, object,
-			       symbols, symbols_size,
-			       shndx, reloc_shndx,
-			       reloc_type, this);
-  if (object != this->pubnames_object_)
-    map_pubnames_and_types_to_dies(&dwinfo, object, symbols, symbols_size);
-  dwinfo.parse();
+  if (this->object_scans_.empty()
+      || this->object_scans_.back()->object() != object)
+    this->object_scans_.push_back(new Object_scan(object));
+  this->object_scans_.back()->add_section(is_type_unit, shndx, reloc_shndx,
+					  reloc_type);
+}
+
+// Queue a task to scan each object.  BLOCKER is already held by
+// running tasks, so add the blockers under the workqueue lock.
+
+void
+Gdb_index::queue_scan_tasks(Workqueue* workqueue, Task_token* blocker)
+{
+  for (std::vector<Object_scan*>::const_iterator p =
+	 this->object_scans_.begin();
+       p != this->object_scans_.end();
+       ++p)
+    {
+      workqueue->add_blocker(blocker);
+      workqueue->queue(new Gdb_index_scan_task(*p, blocker));
+    }
+}
+
+// Add the results of scanning an input object.  The CU and TU indexes
+// of the object are turned into indexes into the lists for the whole
+// link.  Adding the symbols in the order they were found gives the
+// same index as scanning the objects one after another would.
+
+void
+Gdb_index::add_object_scan(Object_scan* scan)
+{
+  int cu_base = this->comp_units_.size();
+  int tu_base = this->type_units_.size();
+
+  this->comp_units_.insert(this->comp_units_.end(),
+			   scan->comp_units().begin(),
+			   scan->comp_units().end());
+  this->type_units_.insert(this->type_units_.end(),
+			   scan->type_units().begin(),
+			   scan->type_units().end());
+
+  for (std::vector<Per_cu_range_list>::const_iterator p =
+	 scan->ranges().begin();
+       p != scan->ranges().end();
+       ++p)
+    this->ranges_.push_back(Per_cu_range_list(p->object,
+					      cu_base + p->cu_index,
+					      p->ranges));
+
+  for (std::vector<Object_scan::Symbol>::const_iterator p =
+	 scan->symbols().begin();
+       p != scan->symbols().end();
+       ++p)
+    {
+      // A negative index refers to a TU.
+      int cu_index = (p->cu_index >= 0
+		      ? cu_base + p->cu_index
+		      : p->cu_index - tu_base);
+      this->add_symbol(cu_index, p->name, p->hash, p->flags);
+    }
+
+  Gdb_index_info_reader::add_stats(scan);
 }
 
 // Add a symbol.
 
 void
-Gdb_index::add_symbol(int cu_index, const char* sym_name, uint8_t flags)
+Gdb_index::add_symbol(int cu_index, const char* sym_name, unsigned int hash,
+		      uint8_t flags)
 {
-  unsigned int hash = mapped_index_string_hash(
-      reinterpret_cast<const unsigned char*>(sym_name));
   Gdb_symbol* sym = new Gdb_symbol();
   this->stringpool_.add(sym_name, true, &sym->name_key);
   sym->hashval = hash;
@@ -1156,32 +1568,22 @@ Gdb_index::add_symbol(int cu_index, const char* sym_name, uint8_t flags)
     cu_vec->push_back(std::make_pair(cu_index, flags));
 }
 
-// Return TRUE if we have already processed the pubnames associated
-// with the statement list at the given OFFSET.
-
-bool
-Gdb_index::pubnames_read(const Relobj* object, off_t offset)
-{
-  bool ret = (this->pubnames_object_ == object
-	      && this->stmt_list_offset_ == offset);
-  return ret;
-}
-
-// Record that we have processed the pubnames associated with the
-// statement list for OBJECT at the given OFFSET.
-
-void
-Gdb_index::set_pubnames_read(const Relobj* object, off_t offset)
-{
-  this->pubnames_object_ = object;
-  this->stmt_list_offset_ = offset;
-}
-
 // Set the size of the .gdb_index section.
 
 void
 Gdb_index::set_final_data_size()
 {
+  // Add the results of the scans of the input objects, in order.
+  for (std::vector<Object_scan*>::const_iterator p =
+	 this->object_scans_.begin();
+       p != this->object_scans_.end();
+       ++p)
+    {
+      this->add_object_scan(*p);
+      delete *p;
+    }
+  this->object_scans_.clear();
+
   // Finalize the string pool.
   this->stringpool_.set_string_offsets();
 
@@ -37,13 +37,11 @@ namespace gold
 class Output_section;
 class Output_file;
 class Mapfile;
-template<int size, bool big_endian>
-class Sized_relobj;
+class Workqueue;
+class Task_token;
 class Dwarf_range_list;
 template <typename T>
 class Gdb_hashtab;
-class Gdb_index_info_reader;
-class Dwarf_pubnames_table;
 
 // This class manages the .gdb_index section, which is a fast
 // lookup table for DWARF information used by the gdb debugger.
@@ -52,77 +50,32 @@ class Dwarf_pubnames_table;
 class Gdb_index : public Output_section_data
 {
  public:
+  // The .debug_info and .debug_types sections of an input object,
+  // and the results of scanning them.  This is defined in
+  // gdb-index.cc.
+  class Object_scan;
+
   Gdb_index(Output_section* gdb_index_section);
 
   ~Gdb_index();
 
-  // Scan a .debug_info or .debug_types input section.
-  void scan_debug_info(bool is_type_unit,
-		       Relobj* object,
-		       const unsigned char* symbols,
-		       off_t symbols_size,
-		       unsigned int shndx,
-		       unsigned int reloc_shndx,
-		       unsigned int reloc_type);
-
-  // Add a compilation unit.
-  int
-  add_comp_unit(off_t cu_offset, off_t cu_length)
-  {
-    this->comp_units_.push_back(Comp_unit(cu_offset, cu_length));
-    return this->comp_units_.size() - 1;
-  }
-
-  // Add a type unit.
-  int
-  add_type_unit(off_t tu_offset, off_t type_offset, uint64_t signature)
-  {
-    this->type_units_.push_back(Type_unit(tu_offset, type_offset, signature));
-    return this->type_units_.size() - 1;
-  }
-
-  // Add an address range.
-  void
-  add_address_range_list(Relobj* object, unsigned int cu_index,
-			 Dwarf_range_list* ranges)
-  {
-    this->ranges_.push_back(Per_cu_range_list(object, cu_index, ranges));
-  }
-
-  // Add a symbol.  FLAGS are the gdb_index version 7 flags to be stored in
-  // the high-byte of the cu_index field.
+  // Record a .debug_info or .debug_types input section to be scanned
+  // by the tasks queued by queue_scan_tasks.
   void
-  add_symbol(int cu_index, const char* sym_name, uint8_t flags);
-
-  // Return the offset into the pubnames table for the cu at the given
-  // offset.
-  off_t
-  find_pubname_offset(off_t cu_offset);
-
-  // Return the offset into the pubtypes table for the cu at the
-  // given offset.
-  off_t
-  find_pubtype_offset(off_t cu_offset);
-
-  // Return TRUE if we have already processed the pubnames and types
-  // set for OBJECT of the CUs and TUS associated with the statement
-  // list at OFFSET.
-  bool
-  pubnames_read(const Relobj* object, off_t offset);
-
-  // Record that we have already read the pubnames associated with
-  // OBJECT and OFFSET.
+  add_debug_info_section(bool is_type_unit,
+			 Relobj* object,
+			 unsigned int shndx,
+			 unsigned int reloc_shndx,
+			 unsigned int reloc_type);
+
+  // Queue a task for each input object to scan its .debug_info and
+  // .debug_types sections.  The tasks run in parallel, each
+  // collecting the CUs, TUs, address ranges and symbols of one
+  // object; the results are added to the index in the order of the
+  // objects when the size of the section is set.  Each task holds a
+  // blocker on BLOCKER.
   void
-  set_pubnames_read(const Relobj* object, off_t offset);
-
-  // Return a pointer to the given table.
-  Dwarf_pubnames_table*
-  pubnames_table()
-  { return pubnames_table_; }
-
-  Dwarf_pubnames_table*
-  pubtypes_table()
-  { return pubtypes_table_; }
+  queue_scan_tasks(Workqueue*, Task_token* blocker);
 
   // Print usage statistics.
   static void
@@ -148,21 +101,6 @@ class Gdb_index : public Output_section_data
   do_print_to_mapfile(Mapfile* mapfile) const
   { mapfile->print_output_data(this, _("** gdb_index")); }
 
-  // Create a map from dies to pubnames.
-  Dwarf_pubnames_table*
-  map_pubtable_to_dies(unsigned int attr,
-                       Gdb_index_info_reader* dwinfo,
-                       Relobj* object,
-                       const unsigned char* symbols,
-                       off_t symbols_size);
-
-  // Wrapper for map_pubtable_to_dies
-  void
-  map_pubnames_and_types_to_dies(Gdb_index_info_reader* dwinfo,
-                                 Relobj* object,
-                                 const unsigned char* symbols,
-                                 off_t symbols_size);
-
  private:
   // An entry in the compilation unit list.
   struct Comp_unit
@@ -216,21 +154,20 @@ class Gdb_index : public Output_section_data
 
   typedef std::vector<std::pair<int, uint8_t> > Cu_vector;
 
-  typedef Unordered_map<off_t, off_t> Pubname_offset_map;
-  Pubname_offset_map cu_pubname_map_;
-  Pubname_offset_map cu_pubtype_map_;
-
-  // Scan the given pubtable and build a map of the various dies it
-  // refers to, so we can process the entries when we encounter the
-  // die.
+  // Add a symbol whose name hashes to HASH.  FLAGS are the gdb_index
+  // version 7 flags to be stored in the high-byte of the cu_index
+  // field.
   void
-  map_pubtable_to_dies(Dwarf_pubnames_table* table,
-                       Pubname_offset_map* map);
+  add_symbol(int cu_index, const char* sym_name, unsigned int hash,
+	     uint8_t flags);
 
-  // Tables to store the pubnames section of the current object.
-  Dwarf_pubnames_table* pubnames_table_;
-  Dwarf_pubnames_table* pubtypes_table_;
+  // Add the results of scanning an input object to the index.
+  void
+  add_object_scan(Object_scan*);
 
+  // The scans of the input objects, in order.  These are added to
+  // the index, and deleted, by set_final_data_size.
+  std::vector<Object_scan*> object_scans_;
   // The .gdb_index section.
   Output_section* gdb_index_section_;
   // The list of DWARF compilation units.
@@ -253,10 +190,6 @@ class Gdb_index : public Output_section_data
   off_t symtab_offset_;
   off_t cu_pool_offset_;
   off_t stringpool_offset_;
-  // Object, stmt list offset of the CUs and TUs associated with the
-  // last read pubnames and pubtypes sections.
-  const Relobj* pubnames_object_;
-  off_t stmt_list_offset_;
 };
 
 } // End namespace gold.
@@ -22,7 +22,10 @@
 
 #include "gold.h"
 
+#include <cerrno>
 #include <cstring>
+#include <list>
+#include <unistd.h>
 
 #ifdef ENABLE_THREADS
 #include <pthread.h>
@@ -56,6 +59,13 @@ class Lock_impl_nothreads : public Lock_impl
     this->acquired_ = true;
   }
 
+  bool
+  try_acquire()
+  {
+    this->acquire();
+    return true;
+  }
+
   void
   release()
   {
@@ -83,6 +93,8 @@ class Lock_impl_threads : public Lock_impl
 
   void acquire();
 
+  bool try_acquire();
+
   void release();
 
 private:
@@ -131,6 +143,17 @@ Lock_impl_threads::acquire()
     gold_fatal(_("pthread_mutex_lock failed: %s"), strerror(err));
 }
 
+bool
+Lock_impl_threads::try_acquire()
+{
+  int err = pthread_mutex_trylock(&this->mutex_);
+  if (err == 0)
+    return true;
+  if (err != EBUSY)
+    gold_fatal(_("pthread_mutex_trylock failed: %s"), strerror(err));
+  return false;
+}
+
 void
 Lock_impl_threads::release()
 {
@@ -447,4 +470,298 @@ Initialize_lock::do_run_once(void*)
   *this->pplock_ = new Lock();
 }
 
+// Class Parallel_jobs_runner.  This holds the state shared by the
+// threads running a set of Parallel_jobs.
+
+class Parallel_jobs_runner
+{
+ public:
+  Parallel_jobs_runner(Parallel_jobs* jobs, unsigned int count)
+    : jobs_(jobs), count_(count), next_(0), lock_(), max_helpers_(0),
+      helpers_(0)
+  { }
+
+  // Run jobs until there are none left.
+  void
+  run();
+
+ private:
+  friend class Parallel_jobs_pool;
+
+  // The jobs to run.
+  Parallel_jobs* jobs_;
+  // The number of jobs.
+  unsigned int count_;
+  // The next job to start.
+  unsigned int next_;
+  // Lock controlling access to next_.
+  Lock lock_;
+  // The largest number of helper threads which may run these jobs.
+  // This and helpers_ are protected by the lock of the
+  // Parallel_jobs_pool.
+  int max_helpers_;
+  // The number of helper threads running these jobs.
+  int helpers_;
+};
+
+void
+Parallel_jobs_runner::run()
+{
+  while (true)
+    {
+      unsigned int index;
+      {
+	Hold_lock hl(this->lock_);
+	if (this->next_ >= this->count_)
+	  return;
+	index = this->next_;
+	++this->next_;
+      }
+      this->jobs_->do_run_job(index);
+    }
+}
+
+#ifdef ENABLE_THREADS
+
+// Class Parallel_jobs_pool.  This is the pool of helper threads which
+// run Parallel_jobs.  The threads are created as they are first
+// needed, and then wait for more jobs until gold exits, so they are
+// shared by all the tasks which run jobs.  Since those tasks are
+// themselves running on workqueue threads, we count each thread which
+// calls Parallel_jobs::run against the thread count, so that the
+// number of threads running jobs at once is limited by the thread
+// count for the current phase of the link no matter how many tasks
+// run jobs at the same time.
+
+class Parallel_jobs_pool
+{
+ public:
+  Parallel_jobs_pool()
+    : lock_(), condvar_(this->lock_), runners_(), threads_(0),
+      idle_threads_(0), running_(0)
+  { }
+
+  // Run the jobs of RUNNER on the calling thread and on any helper
+  // threads which are free, and wait until they are all done.
+  void
+  run(Parallel_jobs_runner* runner);
+
+  // A function to pass to pthread_create.  This is called with a
+  // pointer to the pool.
+  static void*
+  thread_body(void*);
+
+ private:
+  // This class can not be copied.
+  Parallel_jobs_pool(const Parallel_jobs_pool&);
+  Parallel_jobs_pool& operator=(const Parallel_jobs_pool&);
+
+  // Return the largest number of threads which may run jobs at once.
+  static int
+  thread_limit();
+
+  // Run jobs on a helper thread.  This never returns.
+  void
+  process();
+
+  // Lock for the remaining members.
+  Lock lock_;
+  // Signalled when a runner is added, when a thread stops running
+  // jobs, and when the last helper thread of a runner is done.
+  Condvar condvar_;
+  // The runners which may use more helper threads, in the order in
+  // which they were started.
+  std::list<Parallel_jobs_runner*> runners_;
+  // The number of helper threads.
+  int threads_;
+  // The number of helper threads which are not running jobs.
+  int idle_threads_;
+  // The number of threads running jobs, including the threads which
+  // called Parallel_jobs::run.
+  int running_;
+};
+
+// Return the thread count for the current phase.
+
+int
+Parallel_jobs_pool::thread_limit()
+{
+  int thread_count = Parallel_jobs::thread_count_;
+  if (thread_count == 0)
+    thread_count = parameters->options().thread_count();
+#ifdef _SC_NPROCESSORS_ONLN
+  if (thread_count == 0)
+    thread_count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  return thread_count > 1 ? thread_count : 1;
+}
+
+// Run the jobs of RUNNER.
+
+void
+Parallel_jobs_pool::run(Parallel_jobs_runner* runner)
+{
+  this->lock_.acquire();
+
+  int limit = Parallel_jobs_pool::thread_limit();
+  ++this->running_;
+  runner->max_helpers_ = std::min(static_cast<long>(runner->count_),
+				  static_cast<long>(limit)) - 1;
+  if (runner->max_helpers_ > 0)
+    {
+      this->runners_.push_back(runner);
+
+      while (this->threads_ < limit - 1
+	     && this->idle_threads_ < runner->max_helpers_)
+	{
+	  pthread_attr_t attr;
+	  int err = pthread_attr_init(&attr);
+	  if (err != 0)
+	    gold_fatal(_("pthread_attr_init failed: %s"), strerror(err));
+	  err = pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	  if (err != 0)
+	    gold_fatal(_("pthread_attr_setdetachstate failed: %s"),
+		       strerror(err));
+	  pthread_t tid;
+	  err = pthread_create(&tid, &attr, &Parallel_jobs_pool::thread_body,
+			       reinterpret_cast<void*>(this));
+	  if (err != 0)
+	    gold_fatal(_("pthread_create failed: %s"), strerror(err));
+	  err = pthread_attr_destroy(&attr);
+	  if (err != 0)
+	    gold_fatal(_("pthread_attr_destroy failed: %s"), strerror(err));
+	  ++this->threads_;
+	  ++this->idle_threads_;
+	}
+
+      this->condvar_.broadcast();
+    }
+
+  this->lock_.release();
+
+  runner->run();
+
+  this->lock_.acquire();
+
+  // No more helpers may start on RUNNER, and the ones which did must
+  // be done before RUNNER goes away.
+  if (runner->max_helpers_ > 0)
+    this->runners_.remove(runner);
+  while (runner->helpers_ > 0)
+    this->condvar_.wait();
+  --this->running_;
+  this->condvar_.broadcast();
+
+  this->lock_.release();
+}
+
+// Wait for a runner which can use another thread, while the thread
+// count allows it, and help run its jobs.
+
+void
+Parallel_jobs_pool::process()
+{
+  this->lock_.acquire();
+  while (true)
+    {
+      Parallel_jobs_runner* runner = NULL;
+      if (this->running_ < Parallel_jobs_pool::thread_limit())
+	{
+	  for (std::list<Parallel_jobs_runner*>::const_iterator p =
+		 this->runners_.begin();
+	       p != this->runners_.end();
+	       ++p)
+	    {
+	      if ((*p)->helpers_ < (*p)->max_helpers_)
+		{
+		  runner = *p;
+		  break;
+		}
+	    }
+	}
+
+      if (runner == NULL)
+	{
+	  this->condvar_.wait();
+	  continue;
+	}
+
+      ++runner->helpers_;
+      ++this->running_;
+      --this->idle_threads_;
+
+      this->lock_.release();
+      runner->run();
+      this->lock_.acquire();
+
+      --runner->helpers_;
+      --this->running_;
+      ++this->idle_threads_;
+      this->condvar_.broadcast();
+    }
+}
+
+// Passed to pthread_create.
+
+extern "C"
+void*
+Parallel_jobs_pool::thread_body(void* arg)
+{
+  reinterpret_cast<Parallel_jobs_pool*>(arg)->process();
+  return NULL;
+}
+
+// The pool, which is created the first time that jobs are run with
+// --threads.
+
+static Parallel_jobs_pool* parallel_jobs_pool;
+
+class Parallel_jobs_pool_once : public Once
+{
+ public:
+  Parallel_jobs_pool_once()
+  { }
+
+ protected:
+  void
+  do_run_once(void*)
+  { parallel_jobs_pool = new Parallel_jobs_pool(); }
+};
+
+static Parallel_jobs_pool_once parallel_jobs_pool_once;
+
+#endif // defined(ENABLE_THREADS)
+
+// Class Parallel_jobs.
+
+int Parallel_jobs::thread_count_;
+
+// Set the thread count for the current phase.
+
+void
+Parallel_jobs::set_thread_count(int thread_count)
+{
+  Parallel_jobs::thread_count_ = thread_count;
+}
+
+// Run COUNT jobs.  With --threads, the calling thread runs jobs
+// together with threads from the pool.
+
+void
+Parallel_jobs::run(unsigned int count)
+{
+  Parallel_jobs_runner runner(this, count);
+
+#ifdef ENABLE_THREADS
+  if (parameters->options().threads() && count > 1)
+    {
+      parallel_jobs_pool_once.run_once(NULL);
+      parallel_jobs_pool->run(&runner);
+      return;
+    }
+#endif // defined(ENABLE_THREADS)
+
+  runner.run();
+}
+
 } // End namespace gold.
@@ -31,6 +31,8 @@
 #ifndef GOLD_THREADS_H
 #define GOLD_THREADS_H
 
+#include <algorithm>
+
 namespace gold
 {
 
@@ -53,6 +55,9 @@ class Lock_impl
   virtual void
   acquire() = 0;
 
+  virtual bool
+  try_acquire() = 0;
+
   virtual void
   release() = 0;
 };
@@ -71,6 +76,12 @@ class Lock
   acquire()
   { this->lock_->acquire(); }
 
+  // Acquire the lock if it is not held by some other thread.  Return
+  // whether the lock was acquired.  This never blocks.
+  bool
+  try_acquire()
+  { return this->lock_->try_acquire(); }
+
   // Release the lock.
   void
   release()
@@ -262,6 +273,134 @@ class Initialize_lock : public Once
   Lock** const pplock_;
 };
 
+// A set of jobs which may be run in parallel.  This is for a task
+// which has a large amount of work which can be split into pieces.
+// A task may not wait for other tasks, so rather than queueing more
+// tasks this runs the jobs on the calling thread and on a pool of
+// helper threads shared by all tasks, and returns when they are all
+// done.  This is an abstract parent class; any
+// actual use will involve a child of this.
+
+class Parallel_jobs
+{
+ public:
+  Parallel_jobs()
+  { }
+
+  virtual
+  ~Parallel_jobs()
+  { }
+
+  // Run jobs 0 through COUNT - 1, and wait for all of them to
+  // finish.  The jobs are started in order, but without --threads
+  // they are simply run one after another in this thread.
+  void
+  run(unsigned int count);
+
+  // Set the largest number of threads which may run jobs at once,
+  // counting the threads which called run.  This is called as the
+  // link enters each phase, with the value of --thread-count-initial,
+  // --thread-count-middle or --thread-count-final.  Zero means to use
+  // --thread-count, or by default one thread per processor.
+  static void
+  set_thread_count(int thread_count);
+
+ protected:
+  // This must be implemented by the child class.  Jobs with different
+  // values of INDEX may run at the same time.
+  virtual void
+  do_run_job(unsigned int index) = 0;
+
+ private:
+  friend class Parallel_jobs_runner;
+  friend class Parallel_jobs_pool;
+
+  // This class can not be copied.
+  Parallel_jobs(const Parallel_jobs&);
+  Parallel_jobs& operator=(const Parallel_jobs&);
+
+  // The thread count for the current phase, as passed to
+  // set_thread_count.
+  static int thread_count_;
+};
+
+// The jobs used by parallel_sort.  When MERGE_ is false, job I sorts
+// the I'th run of WIDTH_ elements.  When MERGE_ is true, job I merges
+// the I'th pair of adjacent sorted runs of WIDTH_ elements.
+
+template<typename Iterator, typename Compare>
+class Parallel_sort_jobs : public Parallel_jobs
+{
+ public:
+  Parallel_sort_jobs(Iterator first, size_t size, size_t width, bool merge,
+		     Compare comp)
+    : first_(first), size_(size), width_(width), merge_(merge), comp_(comp)
+  { }
+
+ protected:
+  void
+  do_run_job(unsigned int index)
+  {
+    size_t start = index * (this->merge_ ? 2 : 1) * this->width_;
+    size_t middle = std::min(start + this->width_, this->size_);
+    if (!this->merge_)
+      std::sort(this->first_ + start, this->first_ + middle, this->comp_);
+    else
+      {
+	size_t end = std::min(middle + this->width_, this->size_);
+	if (middle < end)
+	  std::inplace_merge(this->first_ + start, this->first_ + middle,
+			     this->first_ + end, this->comp_);
+      }
+  }
+
+ private:
+  Iterator first_;
+  size_t size_;
+  size_t width_;
+  bool merge_;
+  Compare comp_;
+};
+
+// Sort the random access range [FIRST, LAST) using COMP, splitting
+// the work among several threads if the range is large.  Large ranges
+// are sorted in runs which are then merged.  The number of runs
+// depends only on the size of the range, so that the result is the
+// same whether or not we are using threads, even if COMP does not
+// impose a total order.
+
+template<typename Iterator, typename Compare>
+void
+parallel_sort(Iterator first, Iterator last, Compare comp)
+{
+  // The smallest run we sort on a separate thread, and the largest
+  // number of runs.
+  const size_t min_run_size = 16384;
+  const unsigned int max_runs = 64;
+
+  size_t size = last - first;
+  unsigned int runs = 1;
+  while (runs < max_runs && size / (runs * 2) >= min_run_size)
+    runs *= 2;
+  if (runs == 1)
+    {
+      std::sort(first, last, comp);
+      return;
+    }
+
+  size_t width = (size + runs - 1) / runs;
+  Parallel_sort_jobs<Iterator, Compare> sort_jobs(first, size, width, false,
+						  comp);
+  sort_jobs.run(runs);
+  for (; width < size; width *= 2)
+    {
+      unsigned int merges = (size + 2 * width - 1) / (2 * width);
+      Parallel_sort_jobs<Iterator, Compare> merge_jobs(first, size, width,
+						       true, comp);
+      merge_jobs.run(merges);
+    }
+}
+
 } // End namespace gold.
 
 #endif // !defined(GOLD_THREADS_H)
@@ -190,6 +190,8 @@ queue_initial_tasks(const General_options& options,
       gold_fatal(_("no input files"));
     }
 
+  Parallel_jobs::set_thread_count(options.thread_count_initial());
+
   int thread_count = options.thread_count_initial();
   if (thread_count == 0)
     thread_count = cmdline.number_of_input_files();
@@ -443,6 +445,10 @@ queue_middle_gc_tasks(const General_options& options,
 		      Workqueue* workqueue,
 		      Mapfile* mapfile)
 {
+  // All the symbols must be in the symbol table before we look at
+  // the relocs.
+  symtab->add_queued_symbols();
+
   // Read_relocs for all the objects must be done and processed to find
   // unused sections before any scanning of the relocs can take place.
   Task_token* this_blocker = NULL;
@@ -492,6 +498,10 @@ queue_middle_tasks(const General_options& options,
   if (timer != NULL)
     timer->stamp(0);
 
+  // Add the symbols of any relocatable objects which were queued by
+  // --concurrent-symbol-table.
+  symtab->add_queued_symbols();
+
   // Add any symbols named with -u options to the symbol table.
   symtab->add_undefined_symbols_from_command_line(layout);
 
@@ -569,6 +579,10 @@ queue_middle_tasks(const General_options& options,
 	(*p)->update_section_layout(layout->get_section_order_map());
     }
 
+  // If we have a call graph profile, use it to order the functions.
+  if (parameters->options().call_graph_profile())
+    layout->order_sections_from_call_graph(symtab, task);
+
   if (parameters->options().gc_sections()
       || parameters->options().icf_enabled())
     {
@@ -597,6 +611,8 @@ queue_middle_tasks(const General_options& options,
       && layout->incremental_base() == NULL)
     parameters_force_valid_target();
 
+  Parallel_jobs::set_thread_count(options.thread_count_middle());
+
   int thread_count = options.thread_count_middle();
   if (thread_count == 0)
     thread_count = std::max(2, input_objects->number_of_input_objects());
@@ -771,6 +787,12 @@ queue_middle_tasks(const General_options& options,
 	}
     }
 
+  // Scan the debug info for the .gdb_index section.  These tasks run
+  // in parallel with the ones above, and the layout waits for them
+  // too.
+  if (parameters->options().gdb_index())
+    layout->queue_gdb_index_tasks(workqueue, this_blocker);
+
   // When all those tasks are complete, we can start laying out the
   // output file.
   workqueue->queue(new Task_function(new Layout_task_runner(options,
@@ -798,6 +820,8 @@ queue_final_tasks(const General_options& options,
   if (timer != NULL)
     timer->stamp(1);
 
+  Parallel_jobs::set_thread_count(options.thread_count_final());
+
   int thread_count = options.thread_count_final();
   if (thread_count == 0)
     thread_count = std::max(2, input_objects->number_of_input_objects());
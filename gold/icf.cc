@@ -23,20 +23,22 @@
 // Identical Code Folding Algorithm
 // ----------------------------------
 // Detecting identical functions is done here and the basic algorithm
-// is as follows.  A checksum is computed on each foldable section using
-// its contents and relocations.  If the symbol name corresponding to
-// a relocation is known it is used to compute the checksum.  If the
-// symbol name is not known the stringified name of the object and the
-// section number pointed to by the relocation is used.  The checksums
-// are stored as keys in a hash map and a section is identical to some
-// other section if its checksum is already present in the hash map.
-// Checksum collisions are handled by using a multimap and explicitly
-// checking the contents when two sections have the same checksum.
+// is as follows.  The contents of each foldable section are hashed,
+// and sections whose contents are unique are dropped right away.  For
+// the remaining sections a buffer is formed from the section contents
+// and the relocations to sections that cannot be folded.  If the
+// symbol name corresponding to such a relocation is known it is used,
+// otherwise the stringified name of the object and the section number
+// pointed to by the relocation is used.  These buffers are hashed, and
+// sections with identical buffers are put in the same class.  Hash
+// collisions are handled by explicitly comparing the buffers of
+// sections with the same hash.  The buffers are only built and hashed
+// once, and the hashing is done in parallel when using threads.
 //
 // However, two functions A and B with identical text but with
 // relocations pointing to different foldable sections can be identical if
 // the corresponding foldable sections to which their relocations point to
-// turn out to be identical.  Hence, this checksumming process must be
+// turn out to be identical.  Hence, this grouping process must be
 // done repeatedly until convergence is obtained.  Here is an example for
 // the following case :
 //
@@ -48,15 +50,19 @@
 // The functions funcA and funcB are identical if functions foo() and
 // goo() are identical.
 //
-// Hence, as described above, we repeatedly do the checksumming,
-// assigning identical functions to the same group, until convergence is
-// obtained.  Now, we have two different ways to do this depending on how
-// we initialize.
+// Hence, we repeatedly partition the sections, assigning identical
+// functions to the same group, until convergence is obtained.  Each
+// iteration only hashes the class of the buffer together with the
+// groups, as found by the previous iteration, of the foldable sections
+// to which the relocations point.  This needs no access to the section
+// contents, and is again done in parallel when using threads.  Now,
+// we have two different ways to do this depending on how we
+// initialize.
 //
 // Algorithm I :
 // -----------
-// We can start with marking all functions as different and repeatedly do
-// the checksumming.  This has the advantage that we do not need to wait
+// We can start with marking all functions as different and repeatedly
+// merge the groups.  This has the advantage that we do not need to wait
 // for convergence. We can stop at any point and correctness will be
 // guaranteed although not all cases would have been found.  However, this
 // has a problem that some cases can never be found even if it is run until
@@ -79,19 +85,22 @@
 // Algorithm II :
 // ------------
 // Here we start with marking all functions as identical and then repeat
-// the checksumming until convergence.  This can detect the above case
+// splitting the groups until convergence.  This can detect the above case
 // mentioned above.  It can detect all cases that Algorithm I can and more.
 // However, the caveat is that it has to be run to convergence.  It cannot
 // be stopped arbitrarily like Algorithm I as correctness cannot be
 // guaranteed.  Algorithm II is not implemented.
 //
-// Algorithm I is used because experiments show that about three
-// iterations are more than enough to achieve convergence. Algorithm I can
-// handle recursive calls if it is changed to use a special common symbol
-// for recursive relocs.  This seems to be the most common case that
-// Algorithm I could not catch as is.  Mutually recursive calls are not
-// frequent and Algorithm I wins because of its ability to be stopped
-// arbitrarily.
+// Algorithm I is used because experiments show that a few iterations
+// are enough to achieve convergence.  Every iteration updates all the
+// groups at once from the groups of the previous one, so it may take
+// one or two iterations more than updating the groups in place one
+// section at a time would.  By default we therefore iterate until
+// convergence.  Algorithm I can handle recursive calls if it is changed
+// to use a special common symbol for recursive relocs.  This seems to be
+// the most common case that Algorithm I could not catch as is.  Mutually
+// recursive calls are not frequent and Algorithm I wins because of its
+// ability to be stopped arbitrarily.
 //
 // Caveat with using function pointers :
 // ------------------------------------
@@ -147,72 +156,12 @@
 #include "demangle.h"
 #include "elfcpp.h"
 #include "int_encoding.h"
+#include "gold-threads.h"
+#include "timer.h"
 
 namespace gold
 {
 
-// This function determines if a section or a group of identical
-// sections has unique contents.  Such unique sections or groups can be
-// declared final and need not be processed any further.
-// Parameters :
-// ID_SECTION : Vector mapping a section index to a Section_id pair.
-// IS_SECN_OR_GROUP_UNIQUE : To check if a section or a group of identical
-//                            sections is already known to be unique.
-// SECTION_CONTENTS : Contains the section's text and relocs to sections
-//                    that cannot be folded.   SECTION_CONTENTS are NULL
-//                    implies that this function is being called for the
-//                    first time before the first iteration of icf.
-
-static void
-preprocess_for_unique_sections(const std::vector<Section_id>& id_section,
-                               std::vector<bool>* is_secn_or_group_unique,
-                               std::vector<std::string>* section_contents)
-{
-  Unordered_map<uint32_t, unsigned int> uniq_map;
-  std::pair<Unordered_map<uint32_t, unsigned int>::iterator, bool>
-    uniq_map_insert;
-
-  for (unsigned int i = 0; i < id_section.size(); i++)
-    {
-      if ((*is_secn_or_group_unique)[i])
-        continue;
-
-      uint32_t cksum;
-      Section_id secn = id_section[i];
-      section_size_type plen;
-      if (section_contents == NULL)
-        {
-          // Lock the object so we can read from it.  This is only called
-          // single-threaded from queue_middle_tasks, so it is OK to lock.
-          // Unfortunately we have no way to pass in a Task token.
-          const Task* dummy_task = reinterpret_cast<const Task*>(-1);
-          Task_lock_obj<Object> tl(dummy_task, secn.first);
-          const unsigned char* contents;
-          contents = secn.first->section_contents(secn.second,
-                                                  &plen,
-                                                  false);
-          cksum = xcrc32(contents, plen, 0xffffffff);
-        }
-      else
-        {
-          const unsigned char* contents_array = reinterpret_cast
-            <const unsigned char*>((*section_contents)[i].c_str());
-          cksum = xcrc32(contents_array, (*section_contents)[i].length(),
-                         0xffffffff);
-        }
-      uniq_map_insert = uniq_map.insert(std::make_pair(cksum, i));
-      if (uniq_map_insert.second)
-        {
-          (*is_secn_or_group_unique)[i] = true;
-        }
-      else
-        {
-          (*is_secn_or_group_unique)[i] = false;
-          (*is_secn_or_group_unique)[uniq_map_insert.first->second] = false;
-        }
-    }
-}
-
 // For SHF_MERGE sections that use REL relocations, the addend is stored in
 // the text section at the relocation offset.  Read  the addend value given
 // the pointer to the addend in the text section and the addend size.
@@ -254,27 +203,20 @@ get_rel_addend(const unsigned char* reloc_addend_ptr,
 
 // This returns the buffer containing the section's contents, both
 // text and relocs.  Relocs are differentiated as those pointing to
-// sections that could be folded and those that cannot.  Only relocs
-// pointing to sections that could be folded are recomputed on
-// subsequent invocations of this function.
+// sections that could be folded and those that cannot.  Relocs
+// pointing to sections that could be folded are only marked in the
+// buffer; the unique numbers of the sections they point to are
+// returned separately, as these sections may later turn out to be
+// identical to others.
 // Parameters  :
-// FIRST_ITERATION    : true if it is the first invocation.
 // SECN               : Section for which contents are desired.
-// SECTION_NUM        : Unique section number of this section.
-// NUM_TRACKED_RELOCS : Vector reference to store the number of relocs
-//                      to ICF sections.
-// KEPT_SECTION_ID    : Vector which maps folded sections to kept sections.
-// SECTION_CONTENTS   : Store the section's text and relocs to non-ICF
-//                      sections.
+// TRACKED_RELOCS     : Vector to store the unique section numbers of
+//                      the ICF sections pointed to by the relocs.
 
 static std::string
-get_section_contents(bool first_iteration,
-                     const Section_id& secn,
-                     unsigned int section_num,
-                     unsigned int* num_tracked_relocs,
+get_section_contents(const Section_id& secn,
                      Symbol_table* symtab,
-                     const std::vector<unsigned int>& kept_section_id,
-                     std::vector<std::string>* section_contents)
+                     std::vector<unsigned int>* tracked_relocs)
 {
   // Lock the object so we can read from it.  This is only called
   // single-threaded from queue_middle_tasks, so it is OK to lock.
@@ -283,17 +225,14 @@ get_section_contents(bool first_iteration,
   Task_lock_obj<Object> tl(dummy_task, secn.first);
 
   section_size_type plen;
-  const unsigned char* contents = NULL;
-  if (first_iteration)
-    contents = secn.first->section_contents(secn.second, &plen, false);
+  const unsigned char* contents =
+    secn.first->section_contents(secn.second, &plen, false);
 
-  // The buffer to hold all the contents including relocs.  A checksum
+  // The buffer to hold all the contents including relocs.  A hash
   // is then computed on this buffer.
   std::string buffer;
-  std::string icf_reloc_buffer;
 
-  if (num_tracked_relocs)
-    *num_tracked_relocs = 0;
+  tracked_relocs->clear();
 
   Icf::Reloc_info_list& reloc_info_list = 
     symtab->icf()->reloc_info_list();
@@ -301,9 +240,6 @@ get_section_contents(bool first_iteration,
   Icf::Reloc_info_list::iterator it_reloc_info_list =
     reloc_info_list.find(secn);
 
-  buffer.clear();
-  icf_reloc_buffer.clear();
-
   // Process relocs and put them into the buffer.
 
   if (it_reloc_info_list != reloc_info_list.end())
@@ -327,8 +263,7 @@ get_section_contents(bool first_iteration,
 
       for (; it_v != v.end(); ++it_v, ++it_s, ++it_a, ++it_o, ++it_addend_size)
         {
-	  if (first_iteration
-	      && it_v->first != NULL)
+	  if (it_v->first != NULL)
 	    {
 	      Symbol_location loc;
 	      loc.object = it_v->first;
@@ -364,15 +299,12 @@ get_section_contents(bool first_iteration,
 	  // object is NULL.
 	  if (it_v->first == NULL)
             {
-	      if (first_iteration)
-                {
-		  // If the symbol name is available, use it.
-                  if ((*it_s) != NULL)
-                      buffer.append((*it_s)->name());
-                  // Append the addend.
-                  buffer.append(addend_str);
-                  buffer.append("@");
-		}
+	      // If the symbol name is available, use it.
+	      if ((*it_s) != NULL)
+		buffer.append((*it_s)->name());
+	      // Append the addend.
+	      buffer.append(addend_str);
+	      buffer.append("@");
 	      continue;
 	    }
 
@@ -383,12 +315,9 @@ get_section_contents(bool first_iteration,
           if (reloc_secn.first == secn.first
               && reloc_secn.second == secn.second)
             {
-              if (first_iteration)
-                {
-                  buffer.append("R");
-                  buffer.append(addend_str);
-                  buffer.append("@");
-                }
+              buffer.append("R");
+              buffer.append(addend_str);
+              buffer.append("@");
               continue;
             }
           Icf::Uniq_secn_id_map& section_id_map =
@@ -403,30 +332,15 @@ get_section_contents(bool first_iteration,
               && section_id_map_it != section_id_map.end())
             {
               // This is a reloc to a section that might be folded.
-              if (num_tracked_relocs)
-                (*num_tracked_relocs)++;
-
-              char kept_section_str[10];
-              unsigned int secn_id = section_id_map_it->second;
-              snprintf(kept_section_str, sizeof(kept_section_str), "%u",
-                       kept_section_id[secn_id]);
-              if (first_iteration)
-                {
-                  buffer.append("ICF_R");
-                  buffer.append(addend_str);
-                }
-              icf_reloc_buffer.append(kept_section_str);
-              // Append the addend.
-              icf_reloc_buffer.append(addend_str);
-              icf_reloc_buffer.append("@");
+              // The section it points to is matched separately.
+              tracked_relocs->push_back(section_id_map_it->second);
+              buffer.append("ICF_R");
+              buffer.append(addend_str);
+              buffer.append("@");
             }
           else
             {
               // This is a reloc to a section that cannot be folded.
-              // Process it only in the first iteration.
-              if (!first_iteration)
-                continue;
-
               uint64_t secn_flags = (it_v->first)->section_flags(it_v->second);
               // This reloc points to a merge section.  Hash the
               // contents of this section.
@@ -541,153 +455,224 @@ get_section_contents(bool first_iteration,
         }
     }
 
-  if (first_iteration)
-    {
-      buffer.append("Contents = ");
-      buffer.append(reinterpret_cast<const char*>(contents), plen);
-      // Store the section contents that dont change to avoid recomputing
-      // during the next call to this function.
-      (*section_contents)[section_num] = buffer;
-    }
-  else
-    {
-      gold_assert(buffer.empty());
-      // Reuse the contents computed in the previous iteration.
-      buffer.append((*section_contents)[section_num]);
-    }
-
-  buffer.append(icf_reloc_buffer);
+  buffer.append("Contents = ");
+  buffer.append(reinterpret_cast<const char*>(contents), plen);
   return buffer;
 }
 
-// This function computes a checksum on each section to detect and form
-// groups of identical sections.  The first iteration does this for all 
-// sections.
-// Further iterations do this only for the kept sections from each group to
-// determine if larger groups of identical sections could be formed.  The
-// first section in each group is the kept section for that group.
+// The number of sections hashed by each of the parallel jobs below.
+
+static const unsigned int icf_sections_per_job = 256;
+
+// Return the number of jobs needed to hash COUNT sections.
+
+static inline unsigned int
+icf_job_count(size_t count)
+{
+  return (count + icf_sections_per_job - 1) / icf_sections_per_job;
+}
+
+// The Parallel_jobs which hash a list of buffers.  Job I hashes
+// the buffers from I * icf_sections_per_job on, and stores the hash
+// of each buffer at the unique section number of the section it
+// belongs to.
+
+class Icf_hash_jobs : public Parallel_jobs
+{
+ public:
+  // A buffer to hash, and the unique number of its section.
+  struct Buffer
+  {
+    Buffer(const char* data_arg, size_t len_arg, unsigned int section_arg)
+      : data(data_arg), len(len_arg), section_num(section_arg)
+    { }
+
+    const char* data;
+    size_t len;
+    unsigned int section_num;
+  };
+
+  typedef std::vector<Buffer> Buffers;
+
+  Icf_hash_jobs(const Buffers& buffers, std::vector<size_t>* hashes)
+    : buffers_(buffers), hashes_(hashes)
+  { }
+
+ protected:
+  void
+  do_run_job(unsigned int index)
+  {
+    size_t start = index * icf_sections_per_job;
+    size_t end = std::min(start + icf_sections_per_job,
+			  this->buffers_.size());
+    for (size_t i = start; i < end; ++i)
+      {
+	const Buffer& b(this->buffers_[i]);
+	(*this->hashes_)[b.section_num] = string_hash<char>(b.data, b.len);
+      }
+  }
+
+ private:
+  const Buffers& buffers_;
+  std::vector<size_t>* hashes_;
+};
+
+// Return the hash of the group key of section SECTION_NUM.  The key
+// is formed from the class of its contents and the kept sections of
+// the sections pointed to by its relocs to ICF sections.
+// Parameters :
+// CONTENT_CLASS      : Vector mapping a section to the first section
+//                      with identical contents and non-ICF relocs.
+// TRACKED_RELOCS     : Vector mapping a section to the sections pointed
+//                      to by its relocs to ICF sections.
+// KEPT_SECTION_ID    : Vector which maps folded sections to kept sections.
+
+static size_t
+group_key_hash(unsigned int section_num,
+               const std::vector<unsigned int>& content_class,
+               const std::vector<std::vector<unsigned int> >& tracked_relocs,
+               const std::vector<unsigned int>& kept_section_id)
+{
+  size_t h = content_class[section_num];
+  const std::vector<unsigned int>& relocs(tracked_relocs[section_num]);
+  for (std::vector<unsigned int>::const_iterator p = relocs.begin();
+       p != relocs.end();
+       ++p)
+    h = (h ^ kept_section_id[*p]) * 16777619;
+  return h;
+}
+
+// Return true if sections SECN1 and SECN2 have the same group key.
+// The parameters are as for group_key_hash.
+
+static bool
+same_group_key(unsigned int secn1, unsigned int secn2,
+               const std::vector<unsigned int>& content_class,
+               const std::vector<std::vector<unsigned int> >& tracked_relocs,
+               const std::vector<unsigned int>& kept_section_id)
+{
+  if (content_class[secn1] != content_class[secn2])
+    return false;
+  const std::vector<unsigned int>& relocs1(tracked_relocs[secn1]);
+  const std::vector<unsigned int>& relocs2(tracked_relocs[secn2]);
+  // Sections in the same content class have the same number of
+  // relocs to ICF sections.
+  gold_assert(relocs1.size() == relocs2.size());
+  for (size_t i = 0; i < relocs1.size(); ++i)
+    if (kept_section_id[relocs1[i]] != kept_section_id[relocs2[i]])
+      return false;
+  return true;
+}
+
+// The Parallel_jobs which hash the group keys of the sections which
+// might be folded.  Job I handles the sections from
+// I * icf_sections_per_job on.
+
+class Icf_group_key_jobs : public Parallel_jobs
+{
+ public:
+  Icf_group_key_jobs(
+      const std::vector<unsigned int>& sections,
+      const std::vector<unsigned int>& content_class,
+      const std::vector<std::vector<unsigned int> >& tracked_relocs,
+      const std::vector<unsigned int>& kept_section_id,
+      std::vector<size_t>* hashes)
+    : sections_(sections), content_class_(content_class),
+      tracked_relocs_(tracked_relocs), kept_section_id_(kept_section_id),
+      hashes_(hashes)
+  { }
+
+ protected:
+  void
+  do_run_job(unsigned int index)
+  {
+    size_t start = index * icf_sections_per_job;
+    size_t end = std::min(start + icf_sections_per_job,
+			  this->sections_.size());
+    for (size_t i = start; i < end; ++i)
+      {
+	unsigned int section_num = this->sections_[i];
+	(*this->hashes_)[section_num] =
+	  group_key_hash(section_num, this->content_class_,
+			 this->tracked_relocs_, this->kept_section_id_);
+      }
+  }
+
+ private:
+  const std::vector<unsigned int>& sections_;
+  const std::vector<unsigned int>& content_class_;
+  const std::vector<std::vector<unsigned int> >& tracked_relocs_;
+  const std::vector<unsigned int>& kept_section_id_;
+  std::vector<size_t>* hashes_;
+};
+
+// This function does one iteration of forming groups of identical
+// sections.  Two sections are put in the same group if they are in
+// the same content class, and their relocs to ICF sections point to
+// sections which were in the same group after the previous iteration.
+// The first section in each group is the kept section for that group.
+// The groups only ever grow, so we may stop after any iteration.
+// Returns true if no group changed.
 //
-// CRC32 is the checksumming algorithm and can have collisions.  That is,
-// two sections with different contents can have the same checksum. Hence,
-// a multimap is used to maintain more than one group of checksum
-// identical sections.  A section is added to a group only after its
-// contents are explicitly compared with the kept section of the group.
+// The group keys are hashed in parallel.  Sections with the same hash
+// have their keys explicitly compared, so hash collisions are
+// harmless.
 //
 // Parameters  :
-// ITERATION_NUM           : Invocation instance of this function.
-// NUM_TRACKED_RELOCS : Vector reference to store the number of relocs
-//                      to ICF sections.
+// SECTIONS           : The sections which might be folded, in order.
+// CONTENT_CLASS      : Vector mapping a section to the first section
+//                      with identical contents and non-ICF relocs.
+// TRACKED_RELOCS     : Vector mapping a section to the sections pointed
+//                      to by its relocs to ICF sections.
 // KEPT_SECTION_ID    : Vector which maps folded sections to kept sections.
-// ID_SECTION         : Vector mapping a section to an unique integer.
-// IS_SECN_OR_GROUP_UNIQUE : To check if a section or a group of identical
-//                            sections is already known to be unique.
-// SECTION_CONTENTS   : Store the section's text and relocs to non-ICF
-//                      sections.
 
 static bool
-match_sections(unsigned int iteration_num,
-               Symbol_table* symtab,
-               std::vector<unsigned int>* num_tracked_relocs,
-               std::vector<unsigned int>* kept_section_id,
-               const std::vector<Section_id>& id_section,
-               std::vector<bool>* is_secn_or_group_unique,
-               std::vector<std::string>* section_contents)
+match_sections(const std::vector<unsigned int>& sections,
+               const std::vector<unsigned int>& content_class,
+               const std::vector<std::vector<unsigned int> >& tracked_relocs,
+               std::vector<unsigned int>* kept_section_id)
 {
-  Unordered_multimap<uint32_t, unsigned int> section_cksum;
-  std::pair<Unordered_multimap<uint32_t, unsigned int>::iterator,
-            Unordered_multimap<uint32_t, unsigned int>::iterator> key_range;
+  std::vector<size_t> hashes(kept_section_id->size());
+  Icf_group_key_jobs jobs(sections, content_class, tracked_relocs,
+                          *kept_section_id, &hashes);
+  jobs.run(icf_job_count(sections.size()));
+
+  // The new groups are formed from the old ones, so we can't change
+  // KEPT_SECTION_ID until we are done.
+  std::vector<unsigned int> new_kept_section_id(*kept_section_id);
+  Unordered_multimap<size_t, unsigned int> groups;
   bool converged = true;
 
-  if (iteration_num == 1)
-    preprocess_for_unique_sections(id_section,
-                                   is_secn_or_group_unique,
-                                   NULL);
-  else
-    preprocess_for_unique_sections(id_section,
-                                   is_secn_or_group_unique,
-                                   section_contents);
-
-  std::vector<std::string> full_section_contents;
-
-  for (unsigned int i = 0; i < id_section.size(); i++)
+  for (std::vector<unsigned int>::const_iterator p = sections.begin();
+       p != sections.end();
+       ++p)
     {
-      full_section_contents.push_back("");
-      if ((*is_secn_or_group_unique)[i])
-        continue;
-
-      Section_id secn = id_section[i];
-      std::string this_secn_contents;
-      uint32_t cksum;
-      if (iteration_num == 1)
-        {
-          unsigned int num_relocs = 0;
-          this_secn_contents = get_section_contents(true, secn, i, &num_relocs,
-                                                    symtab, (*kept_section_id),
-                                                    section_contents);
-          (*num_tracked_relocs)[i] = num_relocs;
-        }
+      unsigned int section_num = *p;
+      std::pair<Unordered_multimap<size_t, unsigned int>::iterator,
+                Unordered_multimap<size_t, unsigned int>::iterator>
+        key_range = groups.equal_range(hashes[section_num]);
+      Unordered_multimap<size_t, unsigned int>::iterator it;
+      for (it = key_range.first; it != key_range.second; ++it)
+        if (same_group_key(it->second, section_num, content_class,
+                           tracked_relocs, *kept_section_id))
+          break;
+
+      unsigned int kept_section;
+      if (it != key_range.second)
+        kept_section = it->second;
       else
         {
-          if ((*kept_section_id)[i] != i)
-            {
-              // This section is already folded into something.  See
-              // if it should point to a different kept section.
-              unsigned int kept_section = (*kept_section_id)[i];
-              if (kept_section != (*kept_section_id)[kept_section])
-                {
-                  (*kept_section_id)[i] = (*kept_section_id)[kept_section];
-                }
-              continue;
-            }
-          this_secn_contents = get_section_contents(false, secn, i, NULL,
-                                                    symtab, (*kept_section_id),
-                                                    section_contents);
+          // Start a new group with this section.
+          groups.insert(std::make_pair(hashes[section_num], section_num));
+          kept_section = section_num;
         }
 
-      const unsigned char* this_secn_contents_array =
-            reinterpret_cast<const unsigned char*>(this_secn_contents.c_str());
-      cksum = xcrc32(this_secn_contents_array, this_secn_contents.length(),
-                     0xffffffff);
-      size_t count = section_cksum.count(cksum);
-
-      if (count == 0)
-        {
-          // Start a group with this cksum.
-          section_cksum.insert(std::make_pair(cksum, i));
-          full_section_contents[i] = this_secn_contents;
-        }
-      else
-        {
-          key_range = section_cksum.equal_range(cksum);
-          Unordered_multimap<uint32_t, unsigned int>::iterator it;
-          // Search all the groups with this cksum for a match.
-          for (it = key_range.first; it != key_range.second; ++it)
-            {
-              unsigned int kept_section = it->second;
-              if (full_section_contents[kept_section].length()
-                  != this_secn_contents.length())
-                  continue;
-              if (memcmp(full_section_contents[kept_section].c_str(),
-                         this_secn_contents.c_str(),
-                         this_secn_contents.length()) != 0)
-                  continue;
-              (*kept_section_id)[i] = kept_section;
-              converged = false;
-              break;
-            }
-          if (it == key_range.second)
-            {
-              // Create a new group for this cksum.
-              section_cksum.insert(std::make_pair(cksum, i));
-              full_section_contents[i] = this_secn_contents;
-            }
-        }
-      // If there are no relocs to foldable sections do not process
-      // this section any further.
-      if (iteration_num == 1 && (*num_tracked_relocs)[i] == 0)
-        (*is_secn_or_group_unique)[i] = true;
+      if (kept_section != (*kept_section_id)[section_num])
+        converged = false;
+      new_kept_section_id[section_num] = kept_section;
     }
 
+  kept_section_id->swap(new_kept_section_id);
   return converged;
 }
 
@@ -710,79 +695,179 @@ is_function_ctor_or_dtor(const std::string& section_name)
 }
 
 // This is the main ICF function called in gold.cc.  This does the
-// initialization and calls match_sections repeatedly (twice by default)
-// which computes the crc checksums and detects identical functions.
+// initialization, hashes the sections and calls match_sections
+// repeatedly (until convergence by default) which detects identical
+// functions.
 
 void
 Icf::find_identical_sections(const Input_objects* input_objects,
                              Symbol_table* symtab)
 {
+  long long start_usec = Timer::current_wall_usec();
   unsigned int section_num = 0;
-  std::vector<unsigned int> num_tracked_relocs;
-  std::vector<bool> is_secn_or_group_unique;
-  std::vector<std::string> section_contents;
+  std::vector<size_t> contents_hash;
   const Target& target = parameters->target();
 
-  // Decide which sections are possible candidates first.
+  // Lock the objects so we can read from them.  This is only called
+  // single-threaded from queue_middle_tasks, so it is OK to lock.
+  // Unfortunately we have no way to pass in a Task token.
+  const Task* dummy_task = reinterpret_cast<const Task*>(-1);
 
-  for (Input_objects::Relobj_iterator p = input_objects->relobj_begin();
-       p != input_objects->relobj_end();
-       ++p)
-    {
-      // Lock the object so we can read from it.  This is only called
-      // single-threaded from queue_middle_tasks, so it is OK to lock.
-      // Unfortunately we have no way to pass in a Task token.
-      const Task* dummy_task = reinterpret_cast<const Task*>(-1);
-      Task_lock_obj<Object> tl(dummy_task, *p);
+  // Decide which sections are possible candidates first, and hash
+  // their contents.  We work through the objects in batches, keeping
+  // the objects of a batch locked until their sections have been
+  // hashed.  We limit the number of objects in a batch so that we
+  // don't run out of file descriptors.
+  const size_t max_locked_objects = 256;
 
-      for (unsigned int i = 0;i < (*p)->shnum(); ++i)
+  Input_objects::Relobj_iterator p = input_objects->relobj_begin();
+  while (p != input_objects->relobj_end())
+    {
+      Icf_hash_jobs::Buffers buffers;
+      std::vector<Relobj*> locked_objects;
+      for (;
+           (p != input_objects->relobj_end()
+            && locked_objects.size() < max_locked_objects);
+           ++p)
         {
-	  const std::string section_name = (*p)->section_name(i);
-          if (!is_section_foldable_candidate(section_name))
-            continue;
-          if (!(*p)->is_section_included(i))
-            continue;
-          if (parameters->options().gc_sections()
-              && symtab->gc()->is_section_garbage(*p, i))
-              continue;
-	  // With --icf=safe, check if the mangled function name is a ctor
-	  // or a dtor.  The mangled function name can be obtained from the
-	  // section name by stripping the section prefix.
-	  if (parameters->options().icf_safe_folding()
-              && !is_function_ctor_or_dtor(section_name)
-	      && (!target.can_check_for_function_pointers()
-                  || section_has_function_pointers(*p, i)))
+          if (!(*p)->is_locked())
             {
-	      continue;
+              (*p)->lock(dummy_task);
+              locked_objects.push_back(*p);
+            }
+
+          for (unsigned int i = 0;i < (*p)->shnum(); ++i)
+            {
+              const std::string section_name = (*p)->section_name(i);
+              if (!is_section_foldable_candidate(section_name))
+                continue;
+              if (!(*p)->is_section_included(i))
+                continue;
+              if (parameters->options().gc_sections()
+                  && symtab->gc()->is_section_garbage(*p, i))
+                  continue;
+              // With --icf=safe, check if the mangled function name is a
+              // ctor or a dtor.  The mangled function name can be
+              // obtained from the section name by stripping the section
+              // prefix.
+              if (parameters->options().icf_safe_folding()
+                  && !is_function_ctor_or_dtor(section_name)
+                  && (!target.can_check_for_function_pointers()
+                      || section_has_function_pointers(*p, i)))
+                {
+                  continue;
+                }
+              this->id_section_.push_back(Section_id(*p, i));
+              this->section_id_[Section_id(*p, i)] = section_num;
+              this->kept_section_id_.push_back(section_num);
+
+              section_size_type plen;
+              const unsigned char* contents =
+                (*p)->section_contents(i, &plen, false);
+              buffers.push_back(
+                  Icf_hash_jobs::Buffer(reinterpret_cast<const char*>(contents),
+                                        plen, section_num));
+              section_num++;
             }
-          this->id_section_.push_back(Section_id(*p, i));
-          this->section_id_[Section_id(*p, i)] = section_num;
-          this->kept_section_id_.push_back(section_num);
-          num_tracked_relocs.push_back(0);
-          is_secn_or_group_unique.push_back(false);
-          section_contents.push_back("");
-          section_num++;
         }
+
+      contents_hash.resize(section_num);
+      Icf_hash_jobs jobs(buffers, &contents_hash);
+      jobs.run(icf_job_count(buffers.size()));
+
+      for (std::vector<Relobj*>::const_iterator q = locked_objects.begin();
+           q != locked_objects.end();
+           ++q)
+        (*q)->unlock(dummy_task);
     }
 
+  // A section whose contents are unique can not be folded.  For the
+  // other sections, get the contents together with the relocs, and
+  // hash them.
+  Unordered_map<size_t, unsigned int> contents_hash_count;
+  for (unsigned int i = 0; i < section_num; i++)
+    ++contents_hash_count[contents_hash[i]];
+
+  std::vector<std::string> section_contents(section_num);
+  std::vector<std::vector<unsigned int> > tracked_relocs(section_num);
+  Icf_hash_jobs::Buffers buffers;
+  for (unsigned int i = 0; i < section_num; i++)
+    {
+      if (contents_hash_count[contents_hash[i]] < 2)
+        continue;
+      section_contents[i] = get_section_contents(this->id_section_[i],
+                                                 symtab,
+                                                 &tracked_relocs[i]);
+      buffers.push_back(Icf_hash_jobs::Buffer(section_contents[i].data(),
+                                              section_contents[i].length(),
+                                              i));
+    }
+
+  std::vector<size_t> section_hash(section_num);
+  Icf_hash_jobs jobs(buffers, &section_hash);
+  jobs.run(icf_job_count(buffers.size()));
+
+  // Put the sections with identical contents and non-ICF relocs in
+  // the same content class, named after its first section.
+  std::vector<unsigned int> content_class(section_num);
+  std::vector<unsigned int> content_class_size(section_num, 0);
+  Unordered_multimap<size_t, unsigned int> content_classes;
+  for (Icf_hash_jobs::Buffers::const_iterator b = buffers.begin();
+       b != buffers.end();
+       ++b)
+    {
+      unsigned int i = b->section_num;
+      std::pair<Unordered_multimap<size_t, unsigned int>::iterator,
+                Unordered_multimap<size_t, unsigned int>::iterator>
+        key_range = content_classes.equal_range(section_hash[i]);
+      Unordered_multimap<size_t, unsigned int>::iterator it;
+      for (it = key_range.first; it != key_range.second; ++it)
+        if (section_contents[it->second] == section_contents[i])
+          break;
+      if (it != key_range.second)
+        content_class[i] = it->second;
+      else
+        {
+          content_classes.insert(std::make_pair(section_hash[i], i));
+          content_class[i] = i;
+        }
+      ++content_class_size[content_class[i]];
+    }
+
+  // Only sections which share their content class might be folded.
+  std::vector<unsigned int> sections;
+  for (Icf_hash_jobs::Buffers::const_iterator b = buffers.begin();
+       b != buffers.end();
+       ++b)
+    if (content_class_size[content_class[b->section_num]] > 1)
+      sections.push_back(b->section_num);
+
+  // We don't need the contents any more.
+  buffers.clear();
+  section_contents.clear();
+
   unsigned int num_iterations = 0;
 
-  // Default number of iterations to run ICF is 2.
+  // By default, or with --icf-iterations=0, run ICF until convergence.
+  // The groups only ever grow, so this takes at most as many
+  // iterations as there are sections.  Since the iterations only hash
+  // the groups of the relocation targets, they are cheap.
   unsigned int max_iterations = (parameters->options().icf_iterations() > 0)
                             ? parameters->options().icf_iterations()
-                            : 2;
+                            : -1U;
 
   bool converged = false;
 
   while (!converged && (num_iterations < max_iterations))
     {
       num_iterations++;
-      converged = match_sections(num_iterations, symtab,
-                                 &num_tracked_relocs, &this->kept_section_id_,
-                                 this->id_section_, &is_secn_or_group_unique,
-                                 &section_contents);
+      converged = match_sections(sections, content_class, tracked_relocs,
+                                 &this->kept_section_id_);
     }
 
+  this->num_iterations_ = num_iterations;
+  this->icf_usec_ = Timer::current_wall_usec() - start_usec;
+
   if (parameters->options().print_icf_sections())
     {
       if (converged)
@@ -822,6 +907,25 @@ Icf::find_identical_sections(const Input_objects* input_objects,
   this->icf_ready();
 }
 
+// Print statistical information to stderr.
+
+void
+Icf::print_stats() const
+{
+  unsigned int folded = 0;
+  for (unsigned int i = 0; i < this->kept_section_id_.size(); ++i)
+    if (this->kept_section_id_[i] != i)
+      ++folded;
+  fprintf(stderr, _("%s: ICF sections: %u; folded: %u\n"),
+          program_name,
+          static_cast<unsigned int>(this->id_section_.size()), folded);
+  fprintf(stderr, _("%s: ICF iterations: %u\n"),
+          program_name, this->num_iterations_);
+  fprintf(stderr, _("%s: ICF time: %lld.%06lld\n"),
+          program_name, this->icf_usec_ / 1000000,
+          this->icf_usec_ % 1000000);
+}
+
 // Unfolds the section denoted by OBJ and SHNDX if folded.
 
 void
@@ -68,7 +68,7 @@ class Icf
   : id_section_(), section_id_(), kept_section_id_(),
     fptr_section_id_(),
     icf_ready_(false),
-    reloc_info_list_()
+    reloc_info_list_(), num_iterations_(0), icf_usec_(0)
   { }
 
   // Returns the kept folded identical section corresponding to
@@ -142,6 +142,11 @@ class Icf
   section_to_int_map()
   { return this->section_id_; }
 
+  // Print statistical information to stderr.  This is used for
+  // --stats.
+  void
+  print_stats() const;
+
  private:
 
   // Maps integers to sections.
@@ -160,6 +165,12 @@ class Icf
   bool icf_ready_;
   // This list is populated by gc_process_relocs in gc.h.
   Reloc_info_list reloc_info_list_;
+  // The number of iterations run by find_identical_sections, for
+  // statistics.
+  unsigned int num_iterations_;
+  // The time in microseconds taken by find_identical_sections, for
+  // statistics.
+  long long icf_usec_;
 };
 
 // This function returns true if this section corresponds to a function that
@@ -96,7 +96,7 @@ dump_incremental_inputs(const char* argv0, const char* filename,
   Incremental_inputs_reader<size, big_endian>
       incremental_inputs(inc->inputs_reader());
 
-  if (incremental_inputs.version() != 2)
+  if (incremental_inputs.version() != 3)
     {
       fprintf(stderr, "%s: %s: unknown incremental version %d\n", argv0,
               filename, incremental_inputs.version());
@@ -133,6 +133,12 @@ dump_incremental_inputs(const char* argv0, const char* filename,
 	     mtime.nanoseconds,
 	     ctime(&mtime.seconds));
 
+      const unsigned char* checksum = input_file.get_checksum();
+      printf("    Checksum: ");
+      for (int j = 0; j < file_checksum_size; ++j)
+	printf("%02x", checksum[j]);
+      printf("\n");
+
       printf("    Serial Number: %d\n", input_file.arg_serial());
       printf("    In System Directory: %s\n",
 	     input_file.is_in_system_directory() ? "true" : "false");
@@ -37,13 +37,27 @@
 #include "target.h"
 #include "fileread.h"
 #include "script.h"
+#include "gold-threads.h"
 
 namespace gold {
 
 // Version number for the .gnu_incremental_inputs section.
 // Version 1 was the initial checkin.
 // Version 2 adds some padding to ensure 8-byte alignment where necessary.
-const unsigned int INCREMENTAL_LINK_VERSION = 2;
+// Version 3 adds a checksum of the contents of each input file.
+const unsigned int INCREMENTAL_LINK_VERSION = 3;
+
+// Return TRUE if CHECKSUM is all zeroes, which means that the checksum
+// of the input file was not recorded.
+
+static bool
+is_zero_checksum(const unsigned char* checksum)
+{
+  for (int i = 0; i < file_checksum_size; ++i)
+    if (checksum[i] != 0)
+      return false;
+  return true;
+}
 
 // This class manages the .gnu_incremental_inputs section, which holds
 // the header information, a directory of input files, and separate
@@ -473,6 +487,7 @@ Sized_incremental_binary<size, big_endian>::do_file_has_changed(
     unsigned int n) const
 {
   Input_entry_reader input_file = this->inputs_reader_.input_file(n);
+  const unsigned int input_file_index = n;
   Incremental_disposition disp = INCREMENTAL_CHECK;
 
   // For files named in scripts, find the file that was actually named
@@ -506,12 +521,35 @@ Sized_incremental_binary<size, big_endian>::do_file_has_changed(
       return true;
     }
 
-  if (new_mtime.seconds > old_mtime.seconds)
-    return true;
+  if (new_mtime.seconds < old_mtime.seconds)
+    return false;
   if (new_mtime.seconds == old_mtime.seconds
-      && new_mtime.nanoseconds > old_mtime.nanoseconds)
+      && new_mtime.nanoseconds <= old_mtime.nanoseconds)
+    return false;
+
+  // The timestamp has changed.  If we recorded a checksum of the
+  // contents, the file has only changed if the contents have, so
+  // that a file which was rebuilt or touched without being modified
+  // does not force its contributions to be relinked.
+  const unsigned char* old_checksum = input_file.get_checksum();
+  if (is_zero_checksum(old_checksum))
     return true;
-  return false;
+
+  if (this->contents_changed_.empty())
+    this->contents_changed_.resize(this->inputs_reader_.input_file_count(), 0);
+  if (this->contents_changed_[input_file_index] == 0)
+    {
+      unsigned char new_checksum[file_checksum_size];
+      if (get_file_checksum(filename, new_checksum)
+	  && memcmp(new_checksum, old_checksum, file_checksum_size) == 0)
+	{
+	  gold_debug(DEBUG_INCREMENTAL, "%s: contents unchanged", filename);
+	  this->contents_changed_[input_file_index] = -1;
+	}
+      else
+	this->contents_changed_[input_file_index] = 1;
+    }
+  return this->contents_changed_[input_file_index] > 0;
 }
 
 // Initialize the layout of the output file based on the existing
@@ -1029,6 +1067,11 @@ Incremental_inputs::report_archive_begin(Library_base* arch,
       new Incremental_archive_entry(filename_key, arg_serial, mtime);
   arch->set_incremental_info(entry);
 
+  // The members of a --start-lib/--end-lib group are separate files,
+  // and their checksums are recorded instead.
+  if (arch->filename() != "/group/")
+    this->checksum_files_.push_back(std::make_pair(entry, arch->filename()));
+
   if (script_info != NULL)
     {
       Incremental_script_entry* script_entry = script_info->incremental_info();
@@ -1131,6 +1174,10 @@ Incremental_inputs::report_object(Object* obj, unsigned int arg_serial,
   if (obj->as_needed())
     input_entry->set_as_needed();
 
+  // For members of an archive the checksum of the archive is recorded.
+  if (arch == NULL || arch->filename() == "/group/")
+    this->checksum_files_.push_back(std::make_pair(input_entry, obj->name()));
+
   this->inputs_.push_back(input_entry);
 
   if (script_info != NULL)
@@ -1185,6 +1232,7 @@ Incremental_inputs::report_script(Script_info* script,
   this->strtab_->add(script->filename().c_str(), false, &filename_key);
   Incremental_script_entry* entry =
       new Incremental_script_entry(filename_key, arg_serial, script, mtime);
+  this->checksum_files_.push_back(std::make_pair(entry, script->filename()));
   this->inputs_.push_back(entry);
   script->set_incremental_info(entry);
 }
@@ -1193,12 +1241,83 @@ Incremental_inputs::report_script(Script_info* script,
 // Layout::finalize.
 
 void
-Incremental_inputs::finalize()
+Incremental_inputs::finalize(Incremental_binary* base)
 {
+  this->record_checksums(base);
+
   // Finalize the string table.
   this->strtab_->set_string_offsets();
 }
 
+// The Parallel_jobs which compute the checksums of a list of input
+// files.  Job I computes the checksum of the I'th file.
+
+class Incremental_checksum_jobs : public Parallel_jobs
+{
+ public:
+  Incremental_checksum_jobs(const Incremental_inputs::Checksum_list& files)
+    : files_(files)
+  { }
+
+ protected:
+  void
+  do_run_job(unsigned int index)
+  {
+    unsigned char checksum[file_checksum_size];
+    if (get_file_checksum(this->files_[index].second.c_str(), checksum))
+      this->files_[index].first->set_checksum(checksum);
+  }
+
+ private:
+  const Incremental_inputs::Checksum_list& files_;
+};
+
+// Record the checksums of the contents of the input files.  A file
+// which has the same timestamp as in the base file of an incremental
+// update keeps the checksum recorded there; the others are read and
+// checksummed in parallel.  If a file can not be read, its checksum
+// is left as zeroes, and only its timestamp will be checked.
+
+void
+Incremental_inputs::record_checksums(Incremental_binary* base)
+{
+  typedef Unordered_map<std::string, unsigned int> Base_file_map;
+  Base_file_map base_files;
+  if (base != NULL)
+    {
+      unsigned int count = base->input_file_count();
+      for (unsigned int i = 0; i < count; ++i)
+	base_files[base->get_input_reader(i)->filename()] = i;
+    }
+
+  Checksum_list files;
+  for (Checksum_list::const_iterator p = this->checksum_files_.begin();
+       p != this->checksum_files_.end();
+       ++p)
+    {
+      Incremental_input_entry* entry = p->first;
+      Base_file_map::const_iterator q = base_files.find(p->second);
+      if (q != base_files.end())
+	{
+	  const Incremental_binary::Input_reader* reader =
+	      base->get_input_reader(q->second);
+	  Timespec mtime = reader->get_mtime();
+	  if (reader->type() == entry->type()
+	      && mtime.seconds == entry->get_mtime().seconds
+	      && mtime.nanoseconds == entry->get_mtime().nanoseconds
+	      && !is_zero_checksum(reader->get_checksum()))
+	    {
+	      entry->set_checksum(reader->get_checksum());
+	      continue;
+	    }
+	}
+      files.push_back(*p);
+    }
+
+  Incremental_checksum_jobs jobs(files);
+  jobs.run(files.size());
+}
+
 // Create the .gnu_incremental_inputs, _symtab, and _relocs input sections.
 
 void
@@ -1497,7 +1616,8 @@ Output_section_incremental_inputs<size, big_endian>::write_input_files(
       Swap32::writeval(pov + 16, mtime.nanoseconds);
       Swap16::writeval(pov + 20, flags);
       Swap16::writeval(pov + 22, (*p)->arg_serial());
-      gold_assert(this->input_entry_size == 24);
+      memcpy(pov + 24, (*p)->get_checksum(), file_checksum_size);
+      gold_assert(this->input_entry_size == 24 + file_checksum_size);
       pov += this->input_entry_size;
     }
   return pov;
@@ -2093,7 +2213,7 @@ Sized_relobj_incr<size, big_endian>::do_layout(
        ++p)
     {
       unsigned int i = *p;
-      layout->add_to_gdb_index(false, this, NULL, 0, i, 0, 0);
+      layout->add_to_gdb_index(false, this, i, 0, 0);
     }
   for (std::vector<unsigned int>::const_iterator p
 	   = debug_types_sections.begin();
@@ -2101,7 +2221,7 @@ Sized_relobj_incr<size, big_endian>::do_layout(
        ++p)
     {
       unsigned int i = *p;
-      layout->add_to_gdb_index(true, this, 0, 0, i, 0, 0);
+      layout->add_to_gdb_index(true, this, i, 0, 0);
     }
 }
 
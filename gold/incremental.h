@@ -102,7 +102,7 @@ class Incremental_input_entry
     : filename_key_(filename_key), file_index_(0), offset_(0), info_offset_(0),
       arg_serial_(arg_serial), mtime_(mtime), is_in_system_directory_(false),
       as_needed_(false)
-  { }
+  { memset(this->checksum_, 0, file_checksum_size); }
 
   virtual
   ~Incremental_input_entry()
@@ -156,6 +156,17 @@ class Incremental_input_entry
   get_mtime() const
   { return this->mtime_; }
 
+  // Set the checksum of the contents of the input file.
+  void
+  set_checksum(const unsigned char* checksum)
+  { memcpy(this->checksum_, checksum, file_checksum_size); }
+
+  // Get the checksum of the contents of the input file.  This is all
+  // zeroes if the checksum is not known.
+  const unsigned char*
+  get_checksum() const
+  { return this->checksum_; }
+
   // Record that the file was found in a system directory.
   void
   set_is_in_system_directory()
@@ -248,6 +259,9 @@ class Incremental_input_entry
   // Last modification time of the file.
   Timespec mtime_;
 
+  // Checksum of the contents of the file.
+  unsigned char checksum_[file_checksum_size];
+
   // TRUE if the file was found in a system directory.
   bool is_in_system_directory_;
 
@@ -557,9 +571,13 @@ class Incremental_inputs
 {
  public:
   typedef std::vector<Incremental_input_entry*> Input_list;
+  // A list of input file entries whose checksums must be recorded,
+  // with the names of the files.
+  typedef std::vector<std::pair<Incremental_input_entry*, std::string> >
+      Checksum_list;
 
   Incremental_inputs()
-    : inputs_(), command_line_(), command_line_key_(0),
+    : inputs_(), checksum_files_(), command_line_(), command_line_key_(0),
       strtab_(new Stringpool()), current_object_(NULL),
       current_object_entry_(NULL), inputs_section_(NULL),
       symtab_section_(NULL), relocs_section_(NULL),
@@ -611,9 +629,10 @@ class Incremental_inputs
   set_reloc_count(unsigned int count)
   { this->reloc_count_ = count; }
 
-  // Prepare for layout.  Called from Layout::finalize.
+  // Prepare for layout.  Called from Layout::finalize.  BASE is the
+  // base file for an incremental update, or NULL.
   void
-  finalize();
+  finalize(Incremental_binary* base);
 
   // Create the .gnu_incremental_inputs and related sections.
   void
@@ -670,9 +689,16 @@ class Incremental_inputs
   relocs_entsize() const;
 
  private:
+  // Record the checksums of the input files.
+  void
+  record_checksums(Incremental_binary* base);
+
   // The list of input files.
   Input_list inputs_;
 
+  // The input files whose checksums must be recorded.
+  Checksum_list checksum_files_;
+
   // Canonical form of the command line, as will be stored in
   // .gnu_incremental_strtab.
   std::string command_line_;
@@ -760,8 +786,9 @@ class Incremental_inputs_reader
   // (3 x 4-byte fields, plus 4 bytes padding.)
   static const unsigned int header_size = 16;
   // Size of an input file entry.
-  // (2 x 4-byte fields, 1 x 12-byte field, 2 x 2-byte fields.)
-  static const unsigned int input_entry_size = 24;
+  // (2 x 4-byte fields, 1 x 12-byte field, 2 x 2-byte fields,
+  // 1 x 16-byte field.)
+  static const unsigned int input_entry_size = 40;
   // Size of the first part of the supplemental info block for
   // relocatable objects and archive members.
   // (7 x 4-byte fields, plus 4 bytes padding.)
@@ -846,6 +873,12 @@ class Incremental_inputs_reader
       return t;
     }
 
+    // Return the checksum of the file contents.  This is all zeroes
+    // if the checksum was not recorded.
+    const unsigned char*
+    get_checksum() const
+    { return this->inputs_->p_ + this->offset_ + 24; }
+
     // Return the type of input file.
     Incremental_input_type
     type() const
@@ -1380,6 +1413,10 @@ class Incremental_binary
     get_mtime() const
     { return this->do_get_mtime(); }
 
+    const unsigned char*
+    get_checksum() const
+    { return this->do_get_checksum(); }
+
     Incremental_input_type
     type() const
     { return this->do_type(); }
@@ -1403,6 +1440,9 @@ class Incremental_binary
     virtual Timespec
     do_get_mtime() const = 0;
 
+    virtual const unsigned char*
+    do_get_checksum() const = 0;
+
     virtual Incremental_input_type
     do_type() const = 0;
 
@@ -1596,7 +1636,7 @@ class Sized_incremental_binary : public Incremental_binary
       input_objects_(), section_map_(), symbol_map_(), copy_relocs_(),
       main_symtab_loc_(), main_strtab_loc_(), has_incremental_info_(false),
       inputs_reader_(), symtab_reader_(), relocs_reader_(), got_plt_reader_(),
-      input_entry_readers_()
+      input_entry_readers_(), contents_changed_()
   { this->setup_readers(); }
 
   // Returns TRUE if the file contains incremental info.
@@ -1721,6 +1761,10 @@ class Sized_incremental_binary : public Incremental_binary
     do_get_mtime() const
     { return this->reader_.get_mtime(); }
 
+    const unsigned char*
+    do_get_checksum() const
+    { return this->reader_.get_checksum(); }
+
     Incremental_input_type
     do_type() const
     { return this->reader_.type(); }
@@ -1805,6 +1849,10 @@ class Sized_incremental_binary : public Incremental_binary
   Incremental_relocs_reader<size, big_endian> relocs_reader_;
   Incremental_got_plt_reader<big_endian> got_plt_reader_;
   std::vector<Sized_input_reader> input_entry_readers_;
+  // For each input file whose timestamp has changed, whether its
+  // contents have changed as well: 0 if this has not been checked yet,
+  // 1 if they have, and -1 if they have not.
+  mutable std::vector<signed char> contents_changed_;
 };
 
 // An incremental Relobj.  This class represents a relocatable object
@@ -469,6 +469,7 @@ Layout::Layout(int number_of_input_files, Script_options* script_options)
     section_segment_map_(),
     input_section_position_(),
     input_section_glob_(),
+    call_graph_profile_(),
     incremental_base_(NULL),
     free_list_()
 {
@@ -1570,15 +1571,13 @@ Layout::add_eh_frame_for_plt(Output_data* plt, const unsigned char* cie_data,
     }
 }
 
-// Scan a .debug_info or .debug_types section, and add summary
-// information to the .gdb_index section.
+// Record a .debug_info or .debug_types section to be scanned for
+// summary information for the .gdb_index section.
 
 template<int size, bool big_endian>
 void
 Layout::add_to_gdb_index(bool is_type_unit,
 			 Sized_relobj<size, big_endian>* object,
-			 const unsigned char* symbols,
-			 off_t symbols_size,
 			 unsigned int shndx,
 			 unsigned int reloc_shndx,
 			 unsigned int reloc_type)
@@ -1597,9 +1596,17 @@ Layout::add_to_gdb_index(bool is_type_unit,
       os->set_after_input_sections();
     }
 
-  this->gdb_index_data_->scan_debug_info(is_type_unit, object, symbols,
-					 symbols_size, shndx, reloc_shndx,
-					 reloc_type);
+  this->gdb_index_data_->add_debug_info_section(is_type_unit, object, shndx,
+						reloc_shndx, reloc_type);
+}
+
+// Queue the tasks which scan the sections for the .gdb_index section.
+
+void
+Layout::queue_gdb_index_tasks(Workqueue* workqueue, Task_token* blocker)
+{
+  if (this->gdb_index_data_ != NULL)
+    this->gdb_index_data_->queue_scan_tasks(workqueue, blocker);
 }
 
 // Add POSD to an output section using NAME, TYPE, and FLAGS.  Return
@@ -2648,6 +2655,315 @@ Layout::read_layout_from_file()
     }
 }
 
+// Read the call graph profile from the file specified with option
+// --call-graph-profile.  Each line has the name of a calling function,
+// the name of a called function, and the number of times the call was
+// seen, separated by white space.  This is the kind of information
+// which can be collected with "perf record -b".  Lines starting with
+// '#' are comments.
+
+void
+Layout::read_call_graph_profile()
+{
+  const char* filename = parameters->options().call_graph_profile();
+  std::ifstream in;
+  std::string line;
+
+  in.open(filename);
+  if (!in)
+    gold_fatal(_("unable to open --call-graph-profile file %s: %s"),
+	       filename, strerror(errno));
+
+  this->set_section_ordering_specified();
+
+  unsigned int lineno = 0;
+  while (std::getline(in, line))
+    {
+      ++lineno;
+      std::string fields[3];
+      size_t nfields = 0;
+      size_t pos = 0;
+      while (nfields < 3)
+	{
+	  pos = line.find_first_not_of(" \t\r", pos);
+	  if (pos == std::string::npos || line[pos] == '#')
+	    break;
+	  size_t end = line.find_first_of(" \t\r", pos);
+	  fields[nfields++] = line.substr(pos, end - pos);
+	  pos = end;
+	}
+      if (nfields == 0)
+	continue;
+
+      char* endp = NULL;
+      unsigned long long count = 0;
+      if (nfields == 3)
+	count = strtoull(fields[2].c_str(), &endp, 10);
+      if (nfields != 3 || endp == fields[2].c_str() || *endp != '\0')
+	{
+	  gold_error(_("%s:%u: invalid call graph profile entry"),
+		     filename, lineno);
+	  continue;
+	}
+      if (count != 0)
+	this->call_graph_profile_.push_back(Call_graph_edge(fields[0],
+							    fields[1],
+							    count));
+    }
+}
+
+// A cluster of sections for Layout::order_sections_from_call_graph.
+// The clustering is the C3 algorithm from "Optimizing Function
+// Placement for Large-Scale Data-Center Applications" by Ottoni and
+// Maher.
+
+struct Call_graph_cluster
+{
+  Call_graph_cluster()
+    : sections(), size(0), weight(0), initial_weight(0), best_pred(-1U),
+      best_pred_weight(0), output_section(NULL)
+  { }
+
+  // Return the number of calls into the cluster per byte.
+  double
+  density() const
+  { return static_cast<double>(this->weight) / this->size; }
+
+  // The sections in the cluster, in order.  This is empty if the
+  // cluster has been merged into another one.
+  std::vector<unsigned int> sections;
+  // The total size of the sections.
+  uint64_t size;
+  // The number of calls into the sections.
+  uint64_t weight;
+  // The number of calls into the first section.
+  uint64_t initial_weight;
+  // The section which calls the first section most often, and how
+  // often it does so.
+  unsigned int best_pred;
+  uint64_t best_pred_weight;
+  // The output section of the first section.
+  Output_section* output_section;
+};
+
+// Sort clusters by decreasing density, keeping the original order
+// for clusters of the same density.
+
+class Call_graph_cluster_density_compare
+{
+ public:
+  Call_graph_cluster_density_compare(
+      const std::vector<Call_graph_cluster>& clusters)
+    : clusters_(clusters)
+  { }
+
+  bool
+  operator()(unsigned int i1, unsigned int i2) const
+  {
+    double d1 = this->clusters_[i1].density();
+    double d2 = this->clusters_[i2].density();
+    if (d1 != d2)
+      return d1 > d2;
+    return i1 < i2;
+  }
+
+ private:
+  const std::vector<Call_graph_cluster>& clusters_;
+};
+
+// Return the cluster which section I has been merged into.
+
+static unsigned int
+call_graph_cluster_leader(std::vector<unsigned int>* leaders, unsigned int i)
+{
+  unsigned int leader = i;
+  while ((*leaders)[leader] != leader)
+    leader = (*leaders)[leader];
+  while ((*leaders)[i] != leader)
+    {
+      unsigned int next = (*leaders)[i];
+      (*leaders)[i] = leader;
+      i = next;
+    }
+  return leader;
+}
+
+// Use the call graph profile to order the input sections of the
+// executable output sections, so that functions which call each
+// other often are placed next to each other, and the most frequently
+// called functions are placed together.  Functions are found
+// through the symbol table.  This is called after all the input
+// sections have been laid out, so that we know their sizes.  TASK is
+// used to lock the objects while we get the section sizes.
+
+void
+Layout::order_sections_from_call_graph(const Symbol_table* symtab,
+				       const Task* task)
+{
+  // A cluster is never allowed to grow larger than this.
+  const uint64_t max_cluster_size = 1024 * 1024;
+
+  // Find the sections of the functions in the profile.  Each section
+  // starts out in a cluster of its own.
+  typedef Unordered_map<Section_id, unsigned int, Section_id_hash>
+    Section_indexes;
+  Section_indexes section_indexes;
+  std::vector<Section_id> sections;
+  std::vector<Call_graph_cluster> clusters;
+  typedef std::map<std::pair<unsigned int, unsigned int>, uint64_t>
+    Edge_weights;
+  Edge_weights edges;
+  for (std::vector<Call_graph_edge>::const_iterator p =
+	 this->call_graph_profile_.begin();
+       p != this->call_graph_profile_.end();
+       ++p)
+    {
+      unsigned int ends[2];
+      const std::string* names[2] = { &p->caller, &p->callee };
+      bool ok = true;
+      for (int i = 0; i < 2 && ok; ++i)
+	{
+	  ok = false;
+	  const Symbol* sym = symtab->lookup(names[i]->c_str());
+	  if (sym == NULL)
+	    break;
+	  if (sym->is_forwarder())
+	    sym = symtab->resolve_forwards(sym);
+	  bool is_ordinary;
+	  unsigned int shndx = sym->shndx(&is_ordinary);
+	  if (sym->source() != Symbol::FROM_OBJECT
+	      || !sym->is_defined()
+	      || !is_ordinary
+	      || sym->object()->is_dynamic())
+	    break;
+	  Relobj* relobj = static_cast<Relobj*>(sym->object());
+	  Output_section* os = relobj->output_section(shndx);
+	  if (os == NULL || (os->flags() & elfcpp::SHF_EXECINSTR) == 0)
+	    break;
+	  Section_id secn(relobj, shndx);
+	  std::pair<Section_indexes::iterator, bool> ins =
+	    section_indexes.insert(std::make_pair(secn, sections.size()));
+	  if (ins.second)
+	    {
+	      sections.push_back(secn);
+	      clusters.push_back(Call_graph_cluster());
+	      clusters.back().sections.push_back(ins.first->second);
+	      clusters.back().output_section = os;
+	    }
+	  ends[i] = ins.first->second;
+	  ok = true;
+	}
+
+      // Only calls between different sections in the same output
+      // section can be helped by placing the sections together.
+      if (ok
+	  && ends[0] != ends[1]
+	  && (clusters[ends[0]].output_section
+	      == clusters[ends[1]].output_section))
+	edges[std::make_pair(ends[0], ends[1])] += p->count;
+    }
+
+  if (sections.empty())
+    return;
+
+  // Get the section sizes, locking each object only once.
+  std::vector<std::pair<Relobj*, unsigned int> > by_object;
+  by_object.reserve(sections.size());
+  for (unsigned int i = 0; i < sections.size(); ++i)
+    by_object.push_back(std::make_pair(sections[i].first, i));
+  std::sort(by_object.begin(), by_object.end());
+  for (unsigned int i = 0; i < by_object.size(); )
+    {
+      Relobj* relobj = by_object[i].first;
+      Task_lock_obj<Object> tlo(task, relobj);
+      for (; i < by_object.size() && by_object[i].first == relobj; ++i)
+	{
+	  unsigned int index = by_object[i].second;
+	  clusters[index].size =
+	    std::max(relobj->section_size(sections[index].second),
+		     static_cast<uint64_t>(1));
+	}
+    }
+
+  for (Edge_weights::const_iterator p = edges.begin(); p != edges.end(); ++p)
+    {
+      Call_graph_cluster* callee = &clusters[p->first.second];
+      callee->weight += p->second;
+      callee->initial_weight += p->second;
+      if (p->second > callee->best_pred_weight)
+	{
+	  callee->best_pred = p->first.first;
+	  callee->best_pred_weight = p->second;
+	}
+    }
+
+  // Visit the sections from the most to the least densely called.
+  // Append the cluster of each section to the cluster of its most
+  // frequent caller, unless that caller is responsible for only a
+  // small part of the calls, or the result would be too large, or
+  // the result would be much less dense than the caller's cluster.
+  std::vector<unsigned int> leaders(sections.size());
+  std::vector<unsigned int> order(sections.size());
+  for (unsigned int i = 0; i < sections.size(); ++i)
+    leaders[i] = order[i] = i;
+  std::stable_sort(order.begin(), order.end(),
+		   Call_graph_cluster_density_compare(clusters));
+  for (std::vector<unsigned int>::const_iterator p = order.begin();
+       p != order.end();
+       ++p)
+    {
+      Call_graph_cluster* c = &clusters[*p];
+      if (c->best_pred == -1U
+	  || c->best_pred_weight * 10 <= c->initial_weight)
+	continue;
+      unsigned int pred_leader = call_graph_cluster_leader(&leaders,
+							   c->best_pred);
+      if (pred_leader == *p)
+	continue;
+      Call_graph_cluster* pred = &clusters[pred_leader];
+      if (c->size + pred->size > max_cluster_size)
+	continue;
+      double new_density = (static_cast<double>(pred->weight + c->weight)
+			    / (pred->size + c->size));
+      if (new_density * 8 < pred->density())
+	continue;
+
+      leaders[*p] = pred_leader;
+      pred->sections.insert(pred->sections.end(), c->sections.begin(),
+			    c->sections.end());
+      pred->size += c->size;
+      pred->weight += c->weight;
+      c->sections.clear();
+    }
+
+  // Place the clusters from the most to the least densely called.
+  std::vector<unsigned int> cluster_order;
+  for (unsigned int i = 0; i < clusters.size(); ++i)
+    if (!clusters[i].sections.empty())
+      cluster_order.push_back(i);
+  std::stable_sort(cluster_order.begin(), cluster_order.end(),
+		   Call_graph_cluster_density_compare(clusters));
+
+  this->section_order_map_.clear();
+  unsigned int position = 1;
+  for (std::vector<unsigned int>::const_iterator p = cluster_order.begin();
+       p != cluster_order.end();
+       ++p)
+    {
+      const std::vector<unsigned int>& secs(clusters[*p].sections);
+      for (std::vector<unsigned int>::const_iterator q = secs.begin();
+	   q != secs.end();
+	   ++q)
+	this->section_order_map_[sections[*q]] = position++;
+    }
+
+  for (Section_list::const_iterator p = this->section_list_.begin();
+       p != this->section_list_.end();
+       ++p)
+    if (((*p)->flags() & elfcpp::SHF_EXECINSTR) != 0)
+      (*p)->update_section_layout(&this->section_order_map_);
+}
+
 // Finalize the layout.  When this is called, we have created all the
 // output sections and all the output segments which are based on
 // input sections.  We have several things to do, and we have to do
@@ -2684,6 +3000,17 @@ off_t
 Layout::finalize(const Input_objects* input_objects, Symbol_table* symtab,
 		 Target* target, const Task* task)
 {
+  // When using threads, the strings of merged string sections are
+  // added here, in parallel, rather than as each input section is
+  // laid out.
+  if (parameters->options().threads())
+    {
+      for (Section_list::const_iterator p = this->section_list_.begin();
+	   p != this->section_list_.end();
+	   ++p)
+	(*p)->add_pending_merge_input_sections(task);
+    }
+
   target->finalize_sections(this, input_objects, symtab);
 
   this->count_local_symbols(task, input_objects);
@@ -2810,7 +3137,7 @@ Layout::finalize(const Input_objects* input_objects, Symbol_table* symtab,
   // Create the incremental inputs sections.
   if (this->incremental_inputs_)
     {
-      this->incremental_inputs_->finalize();
+      this->incremental_inputs_->finalize(this->incremental_base_);
       this->create_incremental_info_sections(symtab);
     }
 
@@ -5937,8 +6264,6 @@ template
 void
 Layout::add_to_gdb_index(bool is_type_unit,
 			 Sized_relobj<32, false>* object,
-			 const unsigned char* symbols,
-			 off_t symbols_size,
 			 unsigned int shndx,
 			 unsigned int reloc_shndx,
 			 unsigned int reloc_type);
@@ -5949,8 +6274,6 @@ template
 void
 Layout::add_to_gdb_index(bool is_type_unit,
 			 Sized_relobj<32, true>* object,
-			 const unsigned char* symbols,
-			 off_t symbols_size,
 			 unsigned int shndx,
 			 unsigned int reloc_shndx,
 			 unsigned int reloc_type);
@@ -5961,8 +6284,6 @@ template
 void
 Layout::add_to_gdb_index(bool is_type_unit,
 			 Sized_relobj<64, false>* object,
-			 const unsigned char* symbols,
-			 off_t symbols_size,
 			 unsigned int shndx,
 			 unsigned int reloc_shndx,
 			 unsigned int reloc_type);
@@ -5973,8 +6294,6 @@ template
 void
 Layout::add_to_gdb_index(bool is_type_unit,
 			 Sized_relobj<64, true>* object,
-			 const unsigned char* symbols,
-			 off_t symbols_size,
 			 unsigned int shndx,
 			 unsigned int reloc_shndx,
 			 unsigned int reloc_type);
@@ -594,6 +594,16 @@ class Layout
   void
   read_layout_from_file();
 
+  // Read the call graph profile from the file specified with linker
+  // option --call-graph-profile.
+  void
+  read_call_graph_profile();
+
+  // Order the input sections of executable output sections using the
+  // call graph profile.
+  void
+  order_sections_from_call_graph(const Symbol_table*, const Task*);
+
   // Layout an input reloc section when doing a relocatable link.  The
   // section is RELOC_SHNDX in OBJECT, with data in SHDR.
   // DATA_SECTION is the reloc section to which it refers.  RR is the
@@ -653,18 +663,21 @@ class Layout
 		       size_t cie_length, const unsigned char* fde_data,
 		       size_t fde_length);
 
-  // Scan a .debug_info or .debug_types section, and add summary
-  // information to the .gdb_index section.
+  // Record a .debug_info or .debug_types section to be scanned for
+  // summary information for the .gdb_index section.
   template<int size, bool big_endian>
   void
   add_to_gdb_index(bool is_type_unit,
 		   Sized_relobj<size, big_endian>* object,
-		   const unsigned char* symbols,
-		   off_t symbols_size,
 		   unsigned int shndx,
 		   unsigned int reloc_shndx,
 		   unsigned int reloc_type);
 
+  // Queue the tasks which scan the sections passed to
+  // add_to_gdb_index.  Each task holds a blocker on BLOCKER.
+  void
+  queue_gdb_index_tasks(Workqueue*, Task_token* blocker);
+
   // Handle a GNU stack note.  This is called once per input object
   // file.  SEEN_GNU_STACK is true if the object file has a
   // .note.GNU-stack section.  GNU_STACK_FLAGS is the section flags
@@ -1028,6 +1041,20 @@ class Layout
   };
   typedef std::vector<Group_signature> Group_signatures;
 
+  // A call from one function to another, read from the
+  // --call-graph-profile file, and the number of times it was seen.
+  struct Call_graph_edge
+  {
+    Call_graph_edge(const std::string& callera, const std::string& calleea,
+		    uint64_t counta)
+      : caller(callera), callee(calleea), count(counta)
+    { }
+
+    std::string caller;
+    std::string callee;
+    uint64_t count;
+  };
+
   // Create a note section, filling in the header.
   Output_section*
   create_note(const char* name, int note_type, const char* section_name,
@@ -1440,6 +1467,8 @@ class Layout
   Unordered_map<std::string, unsigned int> input_section_position_;
   // Vector of glob only patterns in the section_ordering file.
   std::vector<std::string> input_section_glob_;
+  // The calls listed in the --call-graph-profile file.
+  std::vector<Call_graph_edge> call_graph_profile_;
   // For incremental links, the base file to be modified.
   Incremental_binary* incremental_base_;
   // For incremental links, a list of free space within the file.
@@ -48,6 +48,7 @@
 #include "icf.h"
 #include "incremental.h"
 #include "gdb-index.h"
+#include "compressed_output.h"
 #include "timer.h"
 
 using namespace gold;
@@ -235,6 +236,9 @@ main(int argc, char** argv)
   if (parameters->options().section_ordering_file())
     layout.read_layout_from_file();
 
+  if (parameters->options().call_graph_profile())
+    layout.read_call_graph_profile();
+
   // Load plugin libraries.
   if (command_line.options().has_plugins())
     command_line.options().plugins()->load_plugins(&layout);
@@ -251,6 +255,9 @@ main(int argc, char** argv)
   // Run the main task processing loop.
   workqueue.process(0);
 
+  // Write the task trace for --trace-tasks.
+  workqueue.write_trace();
+
   if (command_line.options().print_output_format())
     print_output_format();
 
@@ -295,14 +302,19 @@ main(int argc, char** argv)
       fprintf(stderr, _("%s: total space allocated by malloc: %d bytes\n"),
 	      program_name, m.arena);
 #endif
+      workqueue.print_stats();
       File_read::print_stats();
       Archive::print_stats();
       Lib_group::print_stats();
       fprintf(stderr, _("%s: output file size: %lld bytes\n"),
 	      program_name, static_cast<long long>(layout.output_file_size()));
+      Output_file::print_stats();
       symtab.print_stats();
       layout.print_stats();
+      if (parameters->options().icf_enabled())
+	icf.print_stats();
       Gdb_index::print_stats();
+      Output_compressed_section::print_stats();
       Free_list::print_stats();
     }
 
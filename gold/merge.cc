@@ -25,6 +25,9 @@
 #include <cstdlib>
 #include <algorithm>
 
+#include "parameters.h"
+#include "options.h"
+#include "gold-threads.h"
 #include "merge.h"
 #include "compressed_output.h"
 
@@ -431,23 +434,54 @@ Output_merge_data::do_print_merge_stats(const char* section_name)
 
 // Class Output_merge_string.
 
-// Add an input section to a merged string section.
+// Add an input section to a merged string section.  When using
+// threads, we normally just record the input section here, and add
+// its strings later, in parallel with other input sections; see
+// do_add_pending_input_sections.  We reserve a block of Stringpool
+// ordinals for the section now, so that the merged section is the
+// same as if we had added the strings one section at a time.  We
+// don't put off compressed sections, since we would have to keep the
+// uncompressed contents around until then.
 
 template<typename Char_type>
 bool
 Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
 						     unsigned int shndx)
 {
+  section_size_type uncompressed_size;
+  if (parameters->options().threads()
+      && !object->section_is_compressed(shndx, &uncompressed_size))
+    {
+      section_size_type sec_len =
+	convert_to_section_size_type(object->section_size(shndx));
+      if (sec_len % sizeof(Char_type) != 0)
+	{
+	  object->error(_("mergeable string section length not multiple of "
+			  "character size"));
+	  return false;
+	}
+
+      Merged_strings_list* merged_strings_list =
+	  new Merged_strings_list(object, shndx);
+      merged_strings_list->ordinal =
+	this->stringpool_.reserve_ordinals(sec_len / sizeof(Char_type) + 1);
+      merged_strings_list->is_pending = true;
+      this->merged_strings_lists_.push_back(merged_strings_list);
+      ++this->pending_count_;
+
+      // For script processing, we keep the input sections.
+      if (this->keeps_input_sections())
+	record_input_section(object, shndx);
+
+      return true;
+    }
+
   section_size_type sec_len;
   bool is_new;
   const unsigned char* pdata = object->decompressed_section_contents(shndx,
 								     &sec_len,
 								     &is_new);
 
-  const Char_type* p = reinterpret_cast<const Char_type*>(pdata);
-  const Char_type* pend = p + sec_len / sizeof(Char_type);
-  const Char_type* pend0 = pend;
-
   if (sec_len % sizeof(Char_type) != 0)
     {
       object->error(_("mergeable string section length not multiple of "
@@ -457,20 +491,49 @@ Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
       return false;
     }
 
-  if (pend[-1] != 0)
+  Merged_strings_list* merged_strings_list =
+      new Merged_strings_list(object, shndx);
+  this->merged_strings_lists_.push_back(merged_strings_list);
+  if (parameters->options().threads())
+    merged_strings_list->ordinal =
+      this->stringpool_.reserve_ordinals(sec_len / sizeof(Char_type) + 1);
+
+  this->add_strings(merged_strings_list, pdata, sec_len);
+  this->finish_input_section(merged_strings_list);
+
+  // For script processing, we keep the input sections.
+  if (this->keeps_input_sections())
+    record_input_section(object, shndx);
+
+  if (is_new)
+    delete[] pdata;
+
+  return true;
+}
+
+// Add the strings of an input section to the Stringpool, and record
+// their keys.  String I in the section uses the ordinal
+// MERGED_STRINGS_LIST->ORDINAL + I.
+
+template<typename Char_type>
+void
+Output_merge_string<Char_type>::add_strings(
+    Merged_strings_list* merged_strings_list,
+    const unsigned char* pdata,
+    section_size_type sec_len)
+{
+  const Char_type* p = reinterpret_cast<const Char_type*>(pdata);
+  const Char_type* pend = p + sec_len / sizeof(Char_type);
+  const Char_type* pend0 = pend;
+
+  if (p < pend && pend[-1] != 0)
     {
-      gold_warning(_("%s: last entry in mergeable string section '%s' "
-		     "not null terminated"),
-		   object->name().c_str(),
-		   object->section_name(shndx).c_str());
+      merged_strings_list->is_unterminated = true;
       // Find the end of the last NULL-terminated string in the buffer.
       while (pend0 > p && pend0[-1] != 0)
 	--pend0;
     }
 
-  Merged_strings_list* merged_strings_list =
-      new Merged_strings_list(object, shndx);
-  this->merged_strings_lists_.push_back(merged_strings_list);
   Merged_strings& merged_strings = merged_strings_list->merged_strings;
 
   // Count the number of non-null strings in the section and size the list.
@@ -497,6 +560,7 @@ Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
 				 & (this->addralign() - 1));
   bool has_misaligned_strings = false;
 
+  uint64_t ordinal = merged_strings_list->ordinal;
   while (p < pend)
     {
       size_t len = p < pend0 ? string_length(p) : pend - p;
@@ -508,7 +572,8 @@ Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
 	  has_misaligned_strings = true;
 
       Stringpool::Key key;
-      this->stringpool_.add_with_length(p, len, true, &key);
+      this->stringpool_.add_with_ordinal(p, len, ordinal, true, &key);
+      ++ordinal;
 
       merged_strings.push_back(Merged_string(i, key));
       p += len + 1;
@@ -519,23 +584,125 @@ Output_merge_string<Char_type>::do_add_input_section(Relobj* object,
   // compute the length of the last string.
   merged_strings.push_back(Merged_string(i, 0));
 
-  this->input_count_ += count;
-  this->input_size_ += i;
+  merged_strings_list->count = count;
+  merged_strings_list->size = i;
+  merged_strings_list->has_misaligned_strings = has_misaligned_strings;
+}
+
+// Issue any warnings for an input section whose strings have been
+// added, and count it.  We do this one section at a time, in order,
+// so that the warnings don't depend on the number of threads.
+
+template<typename Char_type>
+void
+Output_merge_string<Char_type>::finish_input_section(
+    const Merged_strings_list* merged_strings_list)
+{
+  Relobj* object = merged_strings_list->object;
+  unsigned int shndx = merged_strings_list->shndx;
+
+  if (merged_strings_list->is_unterminated)
+    gold_warning(_("%s: last entry in mergeable string section '%s' "
+		   "not null terminated"),
+		 object->name().c_str(),
+		 object->section_name(shndx).c_str());
+
+  this->input_count_ += merged_strings_list->count;
+  this->input_size_ += merged_strings_list->size;
 
-  if (has_misaligned_strings)
+  if (merged_strings_list->has_misaligned_strings)
     gold_warning(_("%s: section %s contains incorrectly aligned strings;"
 		   " the alignment of those strings won't be preserved"),
 		 object->name().c_str(),
 		 object->section_name(shndx).c_str());
+}
 
-  // For script processing, we keep the input sections.
-  if (this->keeps_input_sections())
-    record_input_section(object, shndx);
+// The Parallel_jobs which add the strings of a batch of pending
+// input sections.  Job I handles the I'th section.
 
-  if (is_new)
-    delete[] pdata;
+template<typename Char_type>
+class Output_merge_string<Char_type>::Add_strings_jobs : public Parallel_jobs
+{
+ public:
+  Add_strings_jobs(Output_merge_string<Char_type>* merge_section,
+		   const Pending_sections& pending_sections)
+    : merge_section_(merge_section), pending_sections_(pending_sections)
+  { }
+
+ protected:
+  void
+  do_run_job(unsigned int index)
+  {
+    const Pending_section& ps(this->pending_sections_[index]);
+    this->merge_section_->add_strings(ps.merged_strings_list, ps.pdata,
+				      ps.len);
+  }
+
+ private:
+  Output_merge_string<Char_type>* merge_section_;
+  const Pending_sections& pending_sections_;
+};
+
+// Add the strings of the input sections which were put off by
+// do_add_input_section.  We work through the sections in batches.
+// For each batch we lock the input files, get the section contents,
+// add the strings of all the sections in parallel, and then unlock
+// the files again.  We limit the number of files in a batch so that
+// we don't run out of file descriptors.
 
-  return true;
+template<typename Char_type>
+void
+Output_merge_string<Char_type>::do_add_pending_input_sections(
+    const Task* task)
+{
+  const size_t max_locked_objects = 256;
+
+  typename Merged_strings_lists::const_iterator l =
+    this->merged_strings_lists_.begin();
+  while (this->pending_count_ > 0)
+    {
+      Pending_sections pending_sections;
+      std::vector<Relobj*> locked_objects;
+      for (;
+	   (l != this->merged_strings_lists_.end()
+	    && locked_objects.size() < max_locked_objects);
+	   ++l)
+	{
+	  if (!(*l)->is_pending)
+	    continue;
+
+	  Relobj* object = (*l)->object;
+	  if (!object->is_locked())
+	    {
+	      object->lock(task);
+	      locked_objects.push_back(object);
+	    }
+
+	  Pending_section ps;
+	  ps.merged_strings_list = *l;
+	  ps.pdata = object->section_contents((*l)->shndx, &ps.len, false);
+	  pending_sections.push_back(ps);
+	}
+      gold_assert(!pending_sections.empty());
+
+      Add_strings_jobs jobs(this, pending_sections);
+      jobs.run(pending_sections.size());
+
+      for (typename Pending_sections::const_iterator p =
+	     pending_sections.begin();
+	   p != pending_sections.end();
+	   ++p)
+	{
+	  this->finish_input_section(p->merged_strings_list);
+	  p->merged_strings_list->is_pending = false;
+	  --this->pending_count_;
+	}
+
+      for (std::vector<Relobj*>::const_iterator p = locked_objects.begin();
+	   p != locked_objects.end();
+	   ++p)
+	(*p)->unlock(task);
+    }
 }
 
 // Finalize the mappings from the input sections to the output
@@ -552,6 +719,7 @@ Output_merge_string<Char_type>::finalize_merged_data()
        l != this->merged_strings_lists_.end();
        ++l)
     {
+      gold_assert(!(*l)->is_pending);
       section_offset_type last_input_offset = 0;
       section_offset_type last_output_offset = 0;
       Relobj *object = (*l)->object;
@@ -201,6 +201,14 @@ class Output_merge_base : public Output_section_data
   set_keeps_input_sections()
   { this->do_set_keeps_input_sections(); }
 
+  // Finish adding any input sections whose contents were not
+  // processed when they were added.  This is called before the
+  // output sections are finalized.  TASK is the task doing the
+  // finalization; it is used to lock the input objects.
+  void
+  add_pending_input_sections(const Task* task)
+  { this->do_add_pending_input_sections(task); }
+
   // Return the object of the first merged input section.  This used
   // for script processing.  This is NULL if merge section is empty.
   Relobj*
@@ -253,6 +261,11 @@ class Output_merge_base : public Output_section_data
   do_set_keeps_input_sections()
   { this->keeps_input_sections_ = true; }
 
+  // This may be overridden by the child class.
+  virtual void
+  do_add_pending_input_sections(const Task*)
+  { }
+
   // Record the merged input section for script processing.
   void
   record_input_section(Relobj* relobj, unsigned int shndx);
@@ -402,9 +415,14 @@ class Output_merge_string : public Output_merge_base
  public:
   Output_merge_string(uint64_t addralign)
     : Output_merge_base(sizeof(Char_type), addralign), stringpool_(addralign),
-      merged_strings_lists_(), input_count_(0), input_size_(0)
+      merged_strings_lists_(), input_count_(0), input_size_(0),
+      pending_count_(0)
   {
     this->stringpool_.set_no_zero_null();
+    // When using threads, we add the strings of several input
+    // sections at once; see do_add_pending_input_sections.
+    if (parameters->options().threads())
+      this->stringpool_.set_concurrent();
   }
 
  protected:
@@ -461,6 +479,10 @@ class Output_merge_string : public Output_merge_base
     Output_merge_base::do_set_keeps_input_sections();
   }
 
+  // Add the strings of the input sections which were put off.
+  void
+  do_add_pending_input_sections(const Task*);
+
  private:
   // The name of the string type, for stats.
   const char*
@@ -490,14 +512,56 @@ class Output_merge_string : public Output_merge_base
     unsigned int shndx;
     // The list of merged strings.
     Merged_strings merged_strings;
+    // The Stringpool ordinal of the first string in the section.
+    uint64_t ordinal;
+    // The number of non-null strings in the section.
+    size_t count;
+    // The size of the input section.
+    section_size_type size;
+    // Whether the strings have not yet been added to the Stringpool.
+    bool is_pending;
+    // Whether the last string is not null terminated.
+    bool is_unterminated;
+    // Whether some strings are not aligned.
+    bool has_misaligned_strings;
 
     Merged_strings_list(Relobj* objecta, unsigned int shndxa)
-      : object(objecta), shndx(shndxa), merged_strings()
+      : object(objecta), shndx(shndxa), merged_strings(), ordinal(0),
+	count(0), size(0), is_pending(false), is_unterminated(false),
+	has_misaligned_strings(false)
     { }
   };
 
   typedef std::vector<Merged_strings_list*> Merged_strings_lists;
 
+  // A pending input section whose strings are being added, and its
+  // contents.
+  struct Pending_section
+  {
+    Merged_strings_list* merged_strings_list;
+    const unsigned char* pdata;
+    section_size_type len;
+  };
+
+  typedef std::vector<Pending_section> Pending_sections;
+
+  // The Parallel_jobs which add the strings of pending sections.
+  class Add_strings_jobs;
+  friend class Add_strings_jobs;
+
+  // Add the strings in the input section described by
+  // MERGED_STRINGS_LIST, whose contents are PDATA and LEN bytes long.
+  // This may be called by several threads at once when using
+  // threads.
+  void
+  add_strings(Merged_strings_list* merged_strings_list,
+	      const unsigned char* pdata, section_size_type len);
+
+  // Issue warnings and update statistics for an input section whose
+  // strings have been added.
+  void
+  finish_input_section(const Merged_strings_list*);
+
   // As we see the strings, we add them to a Stringpool.
   Stringpool_template<Char_type> stringpool_;
   // Map from a location in an input object to an entry in the
@@ -507,6 +571,8 @@ class Output_merge_string : public Output_merge_base
   size_t input_count_;
   // The total size of input sections.
   size_t input_size_;
+  // The number of input sections whose strings have not been added.
+  size_t pending_count_;
 };
 
 } // End namespace gold.
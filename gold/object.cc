@@ -61,6 +61,8 @@ Read_symbols_data::~Read_symbols_data()
     delete this->symbols;
   if (this->symbol_names != NULL)
     delete this->symbol_names;
+  if (this->symbol_name_hashes != NULL)
+    delete[] this->symbol_name_hashes;
   if (this->versym != NULL)
     delete this->versym;
   if (this->verdef != NULL)
@@ -918,6 +920,58 @@ Sized_relobj_file<size, big_endian>::base_read_symbols(Read_symbols_data* sd)
   sd->symbol_names = fvstrtab;
   sd->symbol_names_size =
     convert_to_section_size_type(strtabshdr.get_sh_size());
+
+  // When running with threads, many objects read their symbols at
+  // once, but adding them to the symbol table is done one object at
+  // a time.  Do the work which does not depend on the symbol table
+  // now.  With --concurrent-symbol-table the hash codes also decide
+  // which shard of the symbol table each symbol goes in.
+  if (parameters->options().threads()
+      || parameters->options().concurrent_symbol_table())
+    this->hash_symbol_names(sd);
+}
+
+// Compute the length and Stringpool hash code of the name of each
+// external symbol, stopping at any version.  These are used by
+// Symbol_table::add_from_relobj.  Symbols with an extended section
+// index need the SHT_SYMTAB_SHNDX section, which can only be read
+// while the object is locked, so for an object with such symbols we
+// leave the names to add_from_relobj.
+
+template<int size, bool big_endian>
+void
+Sized_relobj_file<size, big_endian>::hash_symbol_names(Read_symbols_data* sd)
+{
+  const int sym_size = This::sym_size;
+  const size_t symcount = ((sd->symbols_size - sd->external_symbols_offset)
+			   / sym_size);
+  const unsigned char* p = sd->symbols->data() + sd->external_symbols_offset;
+  const char* sym_names =
+    reinterpret_cast<const char*>(sd->symbol_names->data());
+
+  Symbol_name_hash* hashes = new Symbol_name_hash[symcount];
+  for (size_t i = 0; i < symcount; ++i, p += sym_size)
+    {
+      elfcpp::Sym<size, big_endian> sym(p);
+      if (sym.get_st_shndx() == elfcpp::SHN_XINDEX)
+	{
+	  delete[] hashes;
+	  return;
+	}
+      unsigned int st_name = sym.get_st_name();
+      if (st_name >= sd->symbol_names_size)
+	{
+	  // add_from_relobj will report an error.
+	  hashes[i].length = 0;
+	  hashes[i].hash_code = 0;
+	  continue;
+	}
+      const char* name = sym_names + st_name;
+      size_t len = strcspn(name, "@");
+      hashes[i].length = len;
+      hashes[i].hash_code = Stringpool::hash_string(name, len);
+    }
+  sd->symbol_name_hashes = hashes;
 }
 
 // Return the section index of symbol SYM.  Set *VALUE to its value in
@@ -1876,8 +1930,8 @@ Sized_relobj_file<size, big_endian>::do_layout(Symbol_table* symtab,
        ++p)
     {
       unsigned int i = *p;
-      layout->add_to_gdb_index(false, this, symbols_data, symbols_size,
-			       i, reloc_shndx[i], reloc_type[i]);
+      layout->add_to_gdb_index(false, this, i, reloc_shndx[i],
+			       reloc_type[i]);
     }
   for (std::vector<unsigned int>::const_iterator p
 	   = debug_types_sections.begin();
@@ -1885,8 +1939,8 @@ Sized_relobj_file<size, big_endian>::do_layout(Symbol_table* symtab,
        ++p)
     {
       unsigned int i = *p;
-      layout->add_to_gdb_index(true, this, symbols_data, symbols_size,
-			       i, reloc_shndx[i], reloc_type[i]);
+      layout->add_to_gdb_index(true, this, i, reloc_shndx[i],
+			       reloc_type[i]);
     }
 
   if (is_pass_two)
@@ -2024,6 +2078,7 @@ Sized_relobj_file<size, big_endian>::do_add_symbols(Symbol_table* symtab,
 			  sd->symbols->data() + sd->external_symbols_offset,
 			  symcount, this->local_symbol_count_,
 			  sym_names, sd->symbol_names_size,
+			  sd->symbol_name_hashes,
 			  &this->symbols_,
 			  &this->defined_count_);
 
@@ -2031,6 +2086,11 @@ Sized_relobj_file<size, big_endian>::do_add_symbols(Symbol_table* symtab,
   sd->symbols = NULL;
   delete sd->symbol_names;
   sd->symbol_names = NULL;
+  if (sd->symbol_name_hashes != NULL)
+    {
+      delete[] sd->symbol_name_hashes;
+      sd->symbol_name_hashes = NULL;
+    }
 }
 
 // Find out if this object, that is a member of a lib group, should be included
@@ -53,13 +53,25 @@ struct Symbols_data;
 template<typename Stringpool_char>
 class Stringpool_template;
 
+// The length and Stringpool hash code of the name of an external
+// symbol, not including any version.
+
+struct Symbol_name_hash
+{
+  // Length of the name in characters.
+  size_t length;
+  // Hash code, as returned by Stringpool::hash_string.
+  size_t hash_code;
+};
+
 // Data to pass from read_symbols() to add_symbols().
 
 struct Read_symbols_data
 {
   Read_symbols_data()
     : section_headers(NULL), section_names(NULL), symbols(NULL),
-      symbol_names(NULL), versym(NULL), verdef(NULL), verneed(NULL)
+      symbol_names(NULL), symbol_name_hashes(NULL), versym(NULL),
+      verdef(NULL), verneed(NULL)
   { }
 
   ~Read_symbols_data();
@@ -82,6 +94,13 @@ struct Read_symbols_data
   File_view* symbol_names;
   // Size of symbol name data in bytes.
   section_size_type symbol_names_size;
+  // Name hashes of the external symbols, indexed from
+  // external_symbols_offset.  When running with threads these are
+  // computed by read_symbols(), which runs in parallel, so that
+  // add_symbols(), which is serialized, need not scan the names
+  // again.  Otherwise this is NULL.  This is only used on relocatable
+  // objects.
+  Symbol_name_hash* symbol_name_hashes;
 
   // Version information.  This is only used on dynamic objects.
   // Version symbol data (from SHT_GNU_versym section).
@@ -1098,6 +1117,7 @@ class Relobj : public Object
       map_to_relocatable_relocs_(NULL),
       object_merge_map_(NULL),
       relocs_must_follow_section_writes_(false),
+      rd_(NULL),
       sd_(NULL),
       reloc_counts_(NULL),
       reloc_bases_(NULL),
@@ -1137,6 +1157,16 @@ class Relobj : public Object
   set_relocs_data(Read_relocs_data* rd)
   { this->rd_ = rd; }
 
+  // Whether the views of the reloc sections read by Read_relocs are
+  // kept after scanning, so that Relocate_task can use them without
+  // looking them up and validating the section headers again.
+  static bool
+  keep_relocs_for_relocate();
+
+  // Free the relocs data kept for Relocate_task, if any.
+  void
+  free_relocs_data();
+
   virtual bool
   is_output_section_offset_invalid(unsigned int shndx) const = 0;
 
@@ -1562,7 +1592,8 @@ class Relobj : public Object
   // we can apply relocations.
   bool relocs_must_follow_section_writes_;
   // Used to store the relocs data computed by the Read_relocs pass. 
-  // Used during garbage collection of unused sections.
+  // Used during garbage collection of unused sections, and kept until
+  // Relocate_task when keep_relocs_for_relocate returns true.
   Read_relocs_data* rd_;
   // Used to store the symbols data computed by the Read_symbols pass.
   // Again used during garbage collection when laying out referenced
@@ -2603,6 +2634,10 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
   void
   find_symtab(const unsigned char* pshdrs);
 
+  // Compute SD->symbol_name_hashes.
+  void
+  hash_symbol_names(Read_symbols_data* sd);
+
   // Return whether SHDR has the right flags for a GNU style exception
   // frame section.
   bool
@@ -2653,6 +2688,17 @@ class Sized_relobj_file : public Sized_relobj<size, big_endian>
 		    Views* pviews)
   { this->do_relocate_sections(symtab, layout, pshdrs, of, pviews); }
 
+  // Apply the RELOC_COUNT relocs at PRELOCS from reloc section
+  // RELOC_SHNDX, whose header is at PSHDR, to section DATA_SHNDX.
+  void
+  relocate_section_relocs(Relocate_info<size, big_endian>* relinfo,
+			  const unsigned char* pshdrs, Output_file* of,
+			  Views* pviews, const unsigned char* pshdr,
+			  unsigned int reloc_shndx, unsigned int data_shndx,
+			  unsigned int sh_type, const unsigned char* prelocs,
+			  size_t reloc_count,
+			  Sized_target<size, big_endian>* target);
+
   // Reverse the words in a section.  Used for .ctors sections mapped
   // to .init_array sections.
   void
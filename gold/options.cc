@@ -1235,6 +1235,11 @@ General_options::finalize()
   if (this->pie() && this->relocatable())
     gold_fatal(_("-pie and -r are incompatible"));
 
+  if (this->call_graph_profile() != NULL
+      && this->section_ordering_file() != NULL)
+    gold_fatal(_("--call-graph-profile and --section-ordering-file "
+		 "are incompatible"));
+
   if (!this->shared())
     {
       if (this->filter() != NULL)
@@ -1261,6 +1266,24 @@ General_options::finalize()
 		 "[0.0, 1.0)"),
 	       this->hash_bucket_empty_fraction());
 
+#ifndef HAVE_ZSTD
+  if (strcmp(this->compress_debug_sections(), "zstd") == 0)
+    gold_fatal(_("--compress-debug-sections=zstd: "
+		 "zstd support was not configured"));
+#endif
+
+  if (this->user_set_compression_level())
+    {
+      // zstd levels start at 1; its level 0 means the default.
+      bool is_zstd = strcmp(this->compress_debug_sections(), "zstd") == 0;
+      int min_level = is_zstd ? 1 : 0;
+      int max_level = is_zstd ? 22 : 9;
+      if (this->compression_level() < min_level
+	  || this->compression_level() > max_level)
+	gold_fatal(_("--compression-level value %d out of range [%d, %d]"),
+		   this->compression_level(), min_level, max_level);
+    }
+
   if (this->implicit_incremental_ && this->incremental_mode_ == INCREMENTAL_OFF)
     gold_fatal(_("Options --incremental-changed, --incremental-unchanged, "
 		 "--incremental-unknown require the use of --incremental"));
@@ -649,6 +649,11 @@ class General_options
 	      N_("(aarch64 only) Do not apply link-time values "
 	         "for dynamic relocations"));
 
+  DEFINE_string(archive_index_cache, options::TWO_DASHES, '\0', NULL,
+		N_("Cache archive symbol table indexes in DIR, "
+		   "creating it if needed"),
+		N_("DIR"));
+
   DEFINE_bool(as_needed, options::TWO_DASHES, '\0', false,
 	      N_("Only set DT_NEEDED for shared libraries if used"),
 	      N_("Always DT_NEEDED for shared libraries"));
@@ -696,14 +701,27 @@ class General_options
 		N_("Minimum output file size for '--build-id=tree' to work"
 		   " differently than '--build-id=sha1'"), N_("SIZE"));
 
+  DEFINE_string(call_graph_profile, options::TWO_DASHES, '\0', NULL,
+		N_("Order functions using the call counts in FILENAME"),
+		N_("FILENAME"));
+
   DEFINE_bool(check_sections, options::TWO_DASHES, '\0', true,
 	      N_("Check segment addresses for overlaps (default)"),
 	      N_("Do not check segment addresses for overlaps"));
 
   DEFINE_enum(compress_debug_sections, options::TWO_DASHES, '\0', "none",
 	      N_("Compress .debug_* sections in the output file"),
-	      ("[none,zlib,zlib-gnu,zlib-gabi]"),
-	      {"none", "zlib", "zlib-gnu", "zlib-gabi"});
+	      ("[none,zlib,zlib-gnu,zlib-gabi,zstd]"),
+	      {"none", "zlib", "zlib-gnu", "zlib-gabi", "zstd"});
+
+  DEFINE_int(compression_level, options::TWO_DASHES, '\0', -1,
+	     N_("Set the compression level for --compress-debug-sections: "
+		"0 to 9 for zlib, 1 to 22 for zstd"),
+	     N_("LEVEL"));
+
+  DEFINE_bool(concurrent_symbol_table, options::TWO_DASHES, '\0', false,
+	      N_("Add the symbols of several object files at once"),
+	      N_("Add the symbols of one object file at a time (default)"));
 
   DEFINE_bool(copy_dt_needed_entries, options::TWO_DASHES, '\0', false,
 	      N_("Not supported"),
@@ -945,6 +963,11 @@ class General_options
   DEFINE_string(m, options::EXACTLY_ONE_DASH, 'm', "",
 		N_("Set GNU linker emulation; obsolete"), N_("EMULATION"));
 
+  DEFINE_uint64(max_mapped_input, options::TWO_DASHES, '\0', 0,
+		N_("Give back the memory of the least recently used input "
+		   "file mappings beyond SIZE bytes (default no limit)"),
+		N_("SIZE"));
+
   DEFINE_bool(mmap_output_file, options::TWO_DASHES, '\0', true,
 	      N_("Map the output file for writing (default)."),
 	      N_("Do not map the output file for writing."));
@@ -1017,6 +1040,12 @@ class General_options
 		 N_("Pass an option to the plugin"), N_("OPTION"));
 #endif
 
+  DEFINE_bool(populate_output_file, options::TWO_DASHES, '\0', false,
+	      N_("Fault in all the pages of the output file when it is "
+		 "mapped"),
+	      N_("Fault in the pages of the output file as they are "
+		 "written (default)"));
+
   DEFINE_bool(posix_fallocate, options::TWO_DASHES, '\0', true,
 	      N_("Use posix_fallocate to reserve space in the output file"
 		 " (default)."),
@@ -1129,7 +1158,8 @@ class General_options
 	      {"none", "all", "safe"});
 
   DEFINE_uint(icf_iterations, options::TWO_DASHES , '\0', 0,
-	      N_("Number of iterations of ICF (default 2)"), N_("COUNT"));
+	      N_("Number of iterations of ICF (default 0: until convergence)"),
+	      N_("COUNT"));
 
   DEFINE_bool(print_icf_sections, options::TWO_DASHES, '\0', false,
 	      N_("List folded identical sections on stderr"),
@@ -1155,6 +1185,11 @@ class General_options
   DEFINE_bool(trace, options::TWO_DASHES, 't', false,
 	      N_("Print the name of each input file"), NULL);
 
+  DEFINE_string(trace_tasks, options::TWO_DASHES, '\0', NULL,
+		N_("Write a trace of the tasks run to FILENAME, "
+		   "in Chrome trace format"),
+		N_("FILENAME"));
+
   DEFINE_special(script, options::TWO_DASHES, 'T',
 		 N_("Read linker script"), N_("FILE"));
 
@@ -1363,6 +1398,16 @@ class General_options
   printed_version() const
   { return this->printed_version_; }
 
+  // Set the --threads and --thread-count options.  This is for
+  // programs such as dwp which use the linker's threads support
+  // without parsing a linker command line.
+  void
+  set_threads_options(bool threads, int thread_count)
+  {
+    this->set_threads(threads);
+    this->set_thread_count(thread_count);
+  }
+
   // The macro defines output() (based on --output), but that's a
   // generic name.  Provide this alternative name, which is clearer.
   const char*
@@ -34,6 +34,10 @@
 #include <sys/mman.h>
 #endif
 
+#ifdef HAVE_GETRUSAGE
+#include <sys/resource.h>
+#endif
+
 #include "libiberty.h"
 
 #include "dwarf.h"
@@ -44,6 +48,8 @@
 #include "merge.h"
 #include "descriptors.h"
 #include "layout.h"
+#include "gold-threads.h"
+#include "timer.h"
 #include "output.h"
 
 // For systems without mmap support.
@@ -3578,6 +3584,20 @@ Output_section::update_section_layout(
     }
 }
 
+// Finish adding the input sections of the merge sections.
+
+void
+Output_section::add_pending_merge_input_sections(const Task* task)
+{
+  for (Input_section_list::iterator p = this->input_sections_.begin();
+       p != this->input_sections_.end();
+       ++p)
+    {
+      if (p->is_merge_section())
+	p->output_merge_base()->add_pending_input_sections(task);
+    }
+}
+
 // Sort the input sections attached to an output section.
 
 void
@@ -4911,6 +4931,9 @@ Output_segment::print_section_list_to_mapfile(Mapfile* mapfile,
 
 // Output_file methods.
 
+// The time spent in Output_file::close, for --stats.
+long long Output_file::close_usec;
+
 Output_file::Output_file(const char* name)
   : name_(name),
     o_(-1),
@@ -5116,8 +5139,13 @@ Output_file::resize(off_t file_size)
 bool
 Output_file::map_anonymous()
 {
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_POPULATE
+  if (parameters->options().populate_output_file())
+    flags |= MAP_POPULATE;
+#endif
   void* base = ::mmap(NULL, this->file_size_, PROT_READ | PROT_WRITE,
-		      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		      flags, -1, 0);
   if (base == MAP_FAILED)
     {
       base = malloc(this->file_size_);
@@ -5164,11 +5192,20 @@ Output_file::map_no_anonymous(bool writable)
        gold_fatal(_("%s: %s"), this->name_, strerror(err));
     }
 
-  // Map the file into memory.
+  // Map the file into memory.  When writing, we can ask for all the
+  // pages to be faulted in now, which is much cheaper than taking a
+  // fault for each page as the sections are written.
   int prot = PROT_READ;
+  int flags = MAP_SHARED;
   if (writable)
-    prot |= PROT_WRITE;
-  base = ::mmap(NULL, this->file_size_, prot, MAP_SHARED, o, 0);
+    {
+      prot |= PROT_WRITE;
+#ifdef MAP_POPULATE
+      if (parameters->options().populate_output_file())
+	flags |= MAP_POPULATE;
+#endif
+    }
+  base = ::mmap(NULL, this->file_size_, prot, flags, o, 0);
 
   // The mmap call might fail because of file system issues: the file
   // system might not support mmap at all, or it might not support
@@ -5221,31 +5258,119 @@ Output_file::unmap()
   this->base_ = NULL;
 }
 
+// The size of the pieces in which the anonymous memory buffer of an
+// output file is written out.
+
+static const off_t output_file_write_chunk_size = 4 * 1024 * 1024;
+
+// The Parallel_jobs which write the anonymous memory buffer of an
+// output file to a regular file.  Job I writes the I'th piece of
+// output_file_write_chunk_size bytes.
+
+class Output_file_write_jobs : public Parallel_jobs
+{
+ public:
+  Output_file_write_jobs(const char* name, int o, const unsigned char* base,
+			 off_t file_size)
+    : name_(name), o_(o), base_(base), file_size_(file_size)
+  { }
+
+ protected:
+  void
+  do_run_job(unsigned int index)
+  {
+    off_t offset = static_cast<off_t>(index) * output_file_write_chunk_size;
+    size_t bytes_to_write = std::min(this->file_size_ - offset,
+				     output_file_write_chunk_size);
+    while (bytes_to_write > 0)
+      {
+	ssize_t bytes_written = ::pwrite(this->o_, this->base_ + offset,
+					 bytes_to_write, offset);
+	if (bytes_written == 0)
+	  {
+	    gold_error(_("%s: write: unexpected 0 return-value"), this->name_);
+	    return;
+	  }
+	else if (bytes_written < 0)
+	  {
+	    gold_error(_("%s: write: %s"), this->name_, strerror(errno));
+	    return;
+	  }
+	bytes_to_write -= bytes_written;
+	offset += bytes_written;
+      }
+  }
+
+ private:
+  const char* name_;
+  int o_;
+  const unsigned char* base_;
+  off_t file_size_;
+};
+
+// Write out the anonymous memory buffer to the file.
+
+void
+Output_file::write_anonymous_map()
+{
+  // If the output is a regular file which we opened ourselves,
+  // reserve the space first so that the file is allocated in one go,
+  // and then write it in pieces, in parallel when using threads.
+  // Otherwise, such as for a pipe, or for stdout which may be in
+  // append mode or positioned after other data, we have to write it
+  // sequentially at the current file position.
+#ifdef HAVE_PWRITE
+  struct stat statbuf;
+  if (this->o_ != STDOUT_FILENO
+      && this->o_ != STDERR_FILENO
+      && ::fstat(this->o_, &statbuf) == 0
+      && S_ISREG(statbuf.st_mode)
+      && (::fcntl(this->o_, F_GETFL) & O_APPEND) == 0
+      && ::lseek(this->o_, 0, SEEK_CUR) == 0)
+    {
+      if (this->file_size_ == 0)
+	return;
+      int err = gold_fallocate(this->o_, 0, this->file_size_);
+      if (err != 0)
+	gold_fatal(_("%s: %s"), this->name_, strerror(err));
+      unsigned int count = ((this->file_size_ + output_file_write_chunk_size
+			     - 1)
+			    / output_file_write_chunk_size);
+      Output_file_write_jobs jobs(this->name_, this->o_, this->base_,
+				  this->file_size_);
+      jobs.run(count);
+      return;
+    }
+#endif
+
+  size_t bytes_to_write = this->file_size_;
+  size_t offset = 0;
+  while (bytes_to_write > 0)
+    {
+      ssize_t bytes_written = ::write(this->o_, this->base_ + offset,
+				      bytes_to_write);
+      if (bytes_written == 0)
+	gold_error(_("%s: write: unexpected 0 return-value"), this->name_);
+      else if (bytes_written < 0)
+	gold_error(_("%s: write: %s"), this->name_, strerror(errno));
+      else
+	{
+	  bytes_to_write -= bytes_written;
+	  offset += bytes_written;
+	}
+    }
+}
+
 // Close the output file.
 
 void
 Output_file::close()
 {
+  long long start_usec = Timer::current_wall_usec();
+
   // If the map isn't file-backed, we need to write it now.
   if (this->map_is_anonymous_ && !this->is_temporary_)
-    {
-      size_t bytes_to_write = this->file_size_;
-      size_t offset = 0;
-      while (bytes_to_write > 0)
-	{
-	  ssize_t bytes_written = ::write(this->o_, this->base_ + offset,
-					  bytes_to_write);
-	  if (bytes_written == 0)
-	    gold_error(_("%s: write: unexpected 0 return-value"), this->name_);
-	  else if (bytes_written < 0)
-	    gold_error(_("%s: write: %s"), this->name_, strerror(errno));
-	  else
-	    {
-	      bytes_to_write -= bytes_written;
-	      offset += bytes_written;
-	    }
-	}
-    }
+    this->write_anonymous_map();
   this->unmap();
 
   // We don't close stdout or stderr
@@ -5255,6 +5380,25 @@ Output_file::close()
     if (::close(this->o_) < 0)
       gold_error(_("%s: close: %s"), this->name_, strerror(errno));
   this->o_ = -1;
+
+  Output_file::close_usec += Timer::current_wall_usec() - start_usec;
+}
+
+// Print statistics about writing the output file to stderr.
+
+void
+Output_file::print_stats()
+{
+  fprintf(stderr, _("%s: output file close time: %lld.%06lld seconds\n"),
+	  program_name, Output_file::close_usec / 1000000,
+	  Output_file::close_usec % 1000000);
+#ifdef HAVE_GETRUSAGE
+  struct rusage usage;
+  if (::getrusage(RUSAGE_SELF, &usage) == 0)
+    fprintf(stderr, _("%s: page faults: %ld minor, %ld major\n"),
+	    program_name, static_cast<long>(usage.ru_minflt),
+	    static_cast<long>(usage.ru_majflt));
+#endif
 }
 
 // Instantiate the templates we need.  We could use the configure
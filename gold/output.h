@@ -140,6 +140,10 @@ class Output_file
   free_input_view(off_t, size_t, const unsigned char*)
   { }
 
+  // Print statistics about writing the output file to stderr.
+  static void
+  print_stats();
+
  private:
   // Map the file into memory or, if that fails, allocate anonymous
   // memory.
@@ -158,6 +162,10 @@ class Output_file
   void
   unmap();
 
+  // Write the anonymous memory buffer to the file.
+  void
+  write_anonymous_map();
+
   // File name.
   const char* name_;
   // File descriptor.
@@ -172,6 +180,9 @@ class Output_file
   bool map_is_allocated_;
   // True if this is a temporary file which should not be output.
   bool is_temporary_;
+
+  // The time spent closing output files, in microseconds.
+  static long long close_usec;
 };
 
 // An abtract class for data which has to go into the output file.
@@ -3296,6 +3307,12 @@ class Output_section : public Output_data
   void
   update_section_layout(const Section_layout_order* order_map);
 
+  // Finish adding the input sections of the merge sections whose
+  // processing was put off; see
+  // Output_merge_base::add_pending_input_sections.
+  void
+  add_pending_merge_input_sections(const Task* task);
+
   // Update the output section flags based on input section flags.
   void
   update_flags_for_input_section(elfcpp::Elf_Xword flags);
@@ -167,6 +167,9 @@ static enum ld_plugin_status
 get_input_section_size(const struct ld_plugin_section section,
                        uint64_t* secsize);
 
+static enum ld_plugin_status
+allow_concurrent_claim_file();
+
 };
 
 #endif // ENABLE_PLUGINS
@@ -211,7 +214,7 @@ Plugin::load()
   sscanf(ver, "%d.%d", &major, &minor);
 
   // Allocate and populate a transfer vector.
-  const int tv_fixed_size = 29;
+  const int tv_fixed_size = 30;
 
   int tv_size = this->args_.size() + tv_fixed_size;
   ld_plugin_tv* tv = new ld_plugin_tv[tv_size];
@@ -345,6 +348,10 @@ Plugin::load()
   tv[i].tv_tag = LDPT_GET_INPUT_SECTION_SIZE;
   tv[i].tv_u.tv_get_input_section_size = get_input_section_size;
 
+  ++i;
+  tv[i].tv_tag = LDPT_ALLOW_CONCURRENT_CLAIM_FILE;
+  tv[i].tv_u.tv_allow_concurrent_claim_file = allow_concurrent_claim_file;
+
   ++i;
   tv[i].tv_tag = LDPT_NULL;
   tv[i].tv_u.tv_val = 0;
@@ -464,6 +471,21 @@ Plugin_manager::load_plugins(Layout* layout)
        this->current_ != this->plugins_.end();
        ++this->current_)
     (*this->current_)->load();
+
+  // If every plugin with a claim-file handler allows it, we may call
+  // the handlers for different files at the same time.
+  bool concurrent = !this->plugins_.empty();
+  for (Plugin_list::const_iterator p = this->plugins_.begin();
+       p != this->plugins_.end();
+       ++p)
+    if (!(*p)->concurrent_claim_file())
+      concurrent = false;
+  if (concurrent && parameters->options().threads())
+    {
+      bool lock_initialized = this->initialize_lock_.initialize();
+      gold_assert(lock_initialized);
+      this->concurrent_claim_file_ = true;
+    }
 }
 
 // Call the plugin claim-file handlers in turn to see if any claim the file.
@@ -475,43 +497,64 @@ Plugin_manager::claim_file(Input_file* input_file, off_t offset,
   bool lock_initialized = this->initialize_lock_.initialize();
 
   gold_assert(lock_initialized);
-  Hold_lock hl(*this->lock_);
-  if (this->in_replacement_phase_)
-    return NULL;
 
-  unsigned int handle = this->objects_.size();
-  this->input_file_ = input_file;
-  this->plugin_input_file_.name = input_file->filename().c_str();
-  this->plugin_input_file_.fd = input_file->file().descriptor();
-  this->plugin_input_file_.offset = offset;
-  this->plugin_input_file_.filesize = filesize;
-  this->plugin_input_file_.handle = reinterpret_cast<void*>(handle);
-  if (elf_object != NULL)
+  // Unless the plugins allow concurrent calls, hold the lock while
+  // calling the handlers.  Otherwise only hold it while updating the
+  // table of objects and claimed files.
+  Hold_optional_lock hl(this->concurrent_claim_file_ ? NULL : this->lock_);
+  Lock* claims_lock = this->claim_file_lock();
+
+  Claim_data claim;
+  claim.input_file = input_file;
+  claim.plugin_input_file.name = input_file->filename().c_str();
+  claim.plugin_input_file.fd = input_file->file().descriptor();
+  claim.plugin_input_file.offset = offset;
+  claim.plugin_input_file.filesize = filesize;
+
+  unsigned int handle;
+  {
+    Hold_optional_lock hlc(claims_lock);
+    if (this->in_replacement_phase_)
+      return NULL;
+
+    // Reserve the slot for this handle even if there is no ELF object,
+    // so that handles stay unique while files are being claimed.
+    handle = this->objects_.size();
     this->objects_.push_back(elf_object);
-  this->in_claim_file_handler_ = true;
+    claim.plugin_input_file.handle = reinterpret_cast<void*>(handle);
+    this->claims_[handle] = &claim;
+  }
 
-  for (this->current_ = this->plugins_.begin();
-       this->current_ != this->plugins_.end();
-       ++this->current_)
+  Pluginobj* ret = NULL;
+  for (Plugin_list::iterator p = this->plugins_.begin();
+       p != this->plugins_.end();
+       ++p)
     {
-      if ((*this->current_)->claim_file(&this->plugin_input_file_))
+      if ((*p)->claim_file(&claim.plugin_input_file))
         {
-	  this->any_claimed_ = true;
-	  this->in_claim_file_handler_ = false;
-
-          if (this->objects_.size() > handle
-              && this->objects_[handle]->pluginobj() != NULL)
-            return this->objects_[handle]->pluginobj();
-
-          // If the plugin claimed the file but did not call the
-          // add_symbols callback, we need to create the Pluginobj now.
-          Pluginobj* obj = this->make_plugin_object(handle);
-          return obj;
+	  Object* obj;
+	  {
+	    Hold_optional_lock hlc(claims_lock);
+	    this->any_claimed_ = true;
+	    obj = this->objects_[handle];
+	  }
+
+          if (obj != NULL && obj->pluginobj() != NULL)
+            ret = obj->pluginobj();
+	  else
+	    {
+	      // If the plugin claimed the file but did not call the
+	      // add_symbols callback, we need to create the Pluginobj
+	      // now.
+	      ret = this->make_plugin_object(handle);
+	    }
+	  break;
         }
     }
 
-  this->in_claim_file_handler_ = false;
-  return NULL;
+  Hold_optional_lock hlc(claims_lock);
+  this->claims_.erase(handle);
+  return ret;
 }
 
 // Save an archive.  This is used so that a plugin can add a file
@@ -747,22 +790,25 @@ Plugin_manager::cleanup()
 Pluginobj*
 Plugin_manager::make_plugin_object(unsigned int handle)
 {
-  // Make sure we aren't asked to make an object for the same handle twice.
-  if (this->objects_.size() != handle
-      && this->objects_[handle]->pluginobj() != NULL)
+  const Claim_data* claim = this->claim_data(handle);
+  if (claim == NULL)
     return NULL;
 
-  Pluginobj* obj = make_sized_plugin_object(this->input_file_,
-                                            this->plugin_input_file_.offset,
-                                            this->plugin_input_file_.filesize);
+  Hold_optional_lock hl(this->claim_file_lock());
 
+  // Make sure we aren't asked to make an object for the same handle twice.
+  if (this->objects_[handle] != NULL
+      && this->objects_[handle]->pluginobj() != NULL)
+    return NULL;
 
-  // If the elf object for this file was pushed into the objects_ vector, delete
-  // it to make room for the Pluginobj as this file is claimed.
-  if (this->objects_.size() != handle)
-    this->objects_.pop_back();
+  Pluginobj* obj =
+    make_sized_plugin_object(claim->input_file,
+			     claim->plugin_input_file.offset,
+			     claim->plugin_input_file.filesize);
 
-  this->objects_.push_back(obj);
+  // If the elf object for this file was stored in the objects_ vector,
+  // replace it with the Pluginobj as this file is claimed.
+  this->objects_[handle] = obj;
   return obj;
 }
 
@@ -773,6 +819,9 @@ ld_plugin_status
 Plugin_manager::get_input_file(unsigned int handle,
                                struct ld_plugin_input_file* file)
 {
+  if (this->object(handle) == NULL)
+    return LDPS_BAD_HANDLE;
+
   Pluginobj* obj = this->object(handle)->pluginobj();
   if (obj == NULL)
     return LDPS_BAD_HANDLE;
@@ -826,13 +875,14 @@ Plugin_manager::get_view(unsigned int handle, const void **viewp)
   off_t offset;
   size_t filesize;
   Input_file *input_file;
-  if (this->in_claim_file_handler_)
+  const Claim_data* claim = this->claim_data(handle);
+  if (claim != NULL)
     {
       // We are being called from the claim_file hook.
-      const struct ld_plugin_input_file &f = this->plugin_input_file_;
+      const struct ld_plugin_input_file &f = claim->plugin_input_file;
       offset = f.offset;
       filesize = f.filesize;
-      input_file = this->input_file_;
+      input_file = claim->input_file;
     }
   else
     {
@@ -1656,7 +1706,7 @@ get_input_section_count(const void* handle, unsigned int* count)
 {
   gold_assert(parameters->options().has_plugins());
 
-  if (!parameters->options().plugins()->in_claim_file_handler())
+  if (!parameters->options().plugins()->in_claim_file_handler(handle))
     return LDPS_ERR;
 
   Object* obj = parameters->options().plugins()->get_elf_object(handle);
@@ -1678,7 +1728,8 @@ get_input_section_type(const struct ld_plugin_section section,
 {
   gold_assert(parameters->options().has_plugins());
 
-  if (!parameters->options().plugins()->in_claim_file_handler())
+  if (!parameters->options().plugins()->in_claim_file_handler(
+	  section.handle))
     return LDPS_ERR;
 
   Object* obj
@@ -1701,7 +1752,8 @@ get_input_section_name(const struct ld_plugin_section section,
 {
   gold_assert(parameters->options().has_plugins());
 
-  if (!parameters->options().plugins()->in_claim_file_handler())
+  if (!parameters->options().plugins()->in_claim_file_handler(
+	  section.handle))
     return LDPS_ERR;
 
   Object* obj
@@ -1730,7 +1782,8 @@ get_input_section_contents(const struct ld_plugin_section section,
 {
   gold_assert(parameters->options().has_plugins());
 
-  if (!parameters->options().plugins()->in_claim_file_handler())
+  if (!parameters->options().plugins()->in_claim_file_handler(
+	  section.handle))
     return LDPS_ERR;
 
   Object* obj
@@ -1759,7 +1812,8 @@ get_input_section_alignment(const struct ld_plugin_section section,
 {
   gold_assert(parameters->options().has_plugins());
 
-  if (!parameters->options().plugins()->in_claim_file_handler())
+  if (!parameters->options().plugins()->in_claim_file_handler(
+	  section.handle))
     return LDPS_ERR;
 
   Object* obj
@@ -1782,7 +1836,8 @@ get_input_section_size(const struct ld_plugin_section section,
 {
   gold_assert(parameters->options().has_plugins());
 
-  if (!parameters->options().plugins()->in_claim_file_handler())
+  if (!parameters->options().plugins()->in_claim_file_handler(
+	  section.handle))
     return LDPS_ERR;
 
   Object* obj
@@ -1795,6 +1850,17 @@ get_input_section_size(const struct ld_plugin_section section,
   return LDPS_OK;
 }
 
+// Let the linker call the plugin's claim-file handler for several
+// input files at the same time.
+
+static enum ld_plugin_status
+allow_concurrent_claim_file()
+{
+  gold_assert(parameters->options().has_plugins());
+  parameters->options().plugins()->allow_concurrent_claim_file();
+  return LDPS_OK;
+}
+
 
 // Specify the ordering of sections in the final layout. The sections are
 // specified as (handle,shndx) pairs in the two arrays in the order in
@@ -1897,6 +1963,8 @@ unique_segment_for_sections(const char* segment_name,
 	return LDPS_BAD_HANDLE;
       unsigned int shndx = section_list[i].shndx;
       Const_section_id secn_id(static_cast<Relobj*>(obj), shndx);
+      Hold_optional_lock hl(
+	  parameters->options().plugins()->claim_file_lock());
       layout->insert_section_segment_map(secn_id, s);
     }
 
@@ -24,6 +24,7 @@
 #define GOLD_PLUGIN_H
 
 #include <list>
+#include <map>
 #include <string>
 
 #include "object.h"
@@ -60,7 +61,8 @@ class Plugin
       claim_file_handler_(NULL),
       all_symbols_read_handler_(NULL),
       cleanup_handler_(NULL),
-      cleanup_done_(false)
+      cleanup_done_(false),
+      concurrent_claim_file_(false)
   { }
 
   ~Plugin()
@@ -104,6 +106,17 @@ class Plugin
     this->args_.push_back(arg);
   }
 
+  // Record that the claim-file handler may be called concurrently.
+  void
+  set_concurrent_claim_file()
+  { this->concurrent_claim_file_ = true; }
+
+  // Return whether the claim-file handler, if any, may be called
+  // concurrently.
+  bool
+  concurrent_claim_file() const
+  { return this->claim_file_handler_ == NULL || this->concurrent_claim_file_; }
+
  private:
   Plugin(const Plugin&);
   Plugin& operator=(const Plugin&);
@@ -120,6 +133,8 @@ class Plugin
   ld_plugin_cleanup_handler cleanup_handler_;
   // TRUE if the cleanup handlers have been called.
   bool cleanup_done_;
+  // TRUE if the plugin called allow_concurrent_claim_file.
+  bool concurrent_claim_file_;
 };
 
 // A manager class for plugins.
@@ -128,10 +143,10 @@ class Plugin_manager
 {
  public:
   Plugin_manager(const General_options& options)
-    : plugins_(), objects_(), deferred_layout_objects_(), input_file_(NULL),
-      plugin_input_file_(), rescannable_(), undefined_symbols_(),
+    : plugins_(), objects_(), deferred_layout_objects_(), claims_(),
+      rescannable_(), undefined_symbols_(),
       any_claimed_(false), in_replacement_phase_(false), any_added_(false),
-      in_claim_file_handler_(false),
+      concurrent_claim_file_(false),
       options_(options), workqueue_(NULL), task_(NULL), input_objects_(NULL),
       symtab_(NULL), layout_(NULL), dirpath_(NULL), mapfile_(NULL),
       this_blocker_(NULL), extra_search_path_(), lock_(NULL),
@@ -167,10 +182,30 @@ class Plugin_manager
   Object*
   get_elf_object(const void* handle);
 
-  // True if the claim_file handler of the plugins is being called.
+  // True if the claim_file handler of the plugins is being called for
+  // the file with HANDLE.
   bool
-  in_claim_file_handler()
-  { return in_claim_file_handler_; }
+  in_claim_file_handler(const void* handle)
+  {
+    return this->claim_data(static_cast<unsigned int>(
+	reinterpret_cast<intptr_t>(handle))) != NULL;
+  }
+
+  // Record that the current plugin's claim-file handler may be called
+  // concurrently.
+  void
+  allow_concurrent_claim_file()
+  {
+    gold_assert(this->current_ != plugins_.end());
+    (*this->current_)->set_concurrent_claim_file();
+  }
+
+  // Return the lock to hold while changing linker state from a
+  // claim-file handler, or NULL if the handlers are not called
+  // concurrently.
+  Lock*
+  claim_file_lock() const
+  { return this->concurrent_claim_file_ ? this->lock_ : NULL; }
 
   // Let the plugin manager save an archive for later rescanning.
   // This takes ownership of the Archive pointer.
@@ -235,6 +270,7 @@ class Plugin_manager
   Object*
   object(unsigned int handle) const
   {
+    Hold_optional_lock hl(this->claim_file_lock());
     if (handle >= this->objects_.size())
       return NULL;
     return this->objects_[handle];
@@ -317,8 +353,18 @@ class Plugin_manager
     { this->u.input_group = input_group; }
   };
 
+  // A file being offered to the claim-file handlers.
+  struct Claim_data
+  {
+    // The input file.
+    Input_file* input_file;
+    // The description of the file passed to the plugins.
+    struct ld_plugin_input_file plugin_input_file;
+  };
+
   typedef std::list<Plugin*> Plugin_list;
   typedef std::vector<Object*> Object_list;
+  typedef std::map<unsigned int, const Claim_data*> Claims;
   typedef std::vector<Relobj*> Deferred_layout_list;
   typedef std::vector<Rescannable> Rescannable_list;
   typedef std::vector<Symbol*> Undefined_symbol_list;
@@ -331,6 +377,16 @@ class Plugin_manager
   bool
   rescannable_defines(size_t i, Symbol* sym);
 
+  // Return the data for the file with HANDLE if it is being offered
+  // to the claim-file handlers, otherwise NULL.
+  const Claim_data*
+  claim_data(unsigned int handle) const
+  {
+    Hold_optional_lock hl(this->claim_file_lock());
+    Claims::const_iterator p = this->claims_.find(handle);
+    return p == this->claims_.end() ? NULL : p->second;
+  }
+
   // The list of plugin libraries.
   Plugin_list plugins_;
   // A pointer to the current plugin.  Used while loading plugins.
@@ -343,9 +399,9 @@ class Plugin_manager
   // The list of regular objects whose layout has been deferred.
   Deferred_layout_list deferred_layout_objects_;
 
-  // The file currently up for claim by the plugins.
-  Input_file* input_file_;
-  struct ld_plugin_input_file plugin_input_file_;
+  // The files currently up for claim by the plugins, indexed by
+  // handle.  There is more than one only if concurrent_claim_file_.
+  Claims claims_;
 
   // A list of archives and input groups being saved for possible
   // later rescanning.
@@ -365,8 +421,9 @@ class Plugin_manager
   // Whether any input files or libraries were added by a plugin.
   bool any_added_;
 
-  // Set to true when the claim_file handler of a plugin is called.
-  bool in_claim_file_handler_;
+  // Whether every plugin allows its claim-file handler to be called
+  // concurrently.  If not, we hold lock_ while calling the handlers.
+  bool concurrent_claim_file_;
 
   const General_options& options_;
   Workqueue* workqueue_;
@@ -381,6 +438,8 @@ class Plugin_manager
   // An extra directory to seach for the libraries passed by
   // add_input_library.
   std::string extra_search_path_;
+  // Serializes the claim-file handlers, or, if concurrent_claim_file_,
+  // guards objects_ and claims_.
   Lock* lock_;
   Initialize_lock initialize_lock_;
 };
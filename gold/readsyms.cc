@@ -807,6 +807,7 @@ Start_group::locks(Task_locker* tl)
 void
 Start_group::run(Workqueue*)
 {
+  this->symtab_->add_queued_symbols();
   this->finish_group_->set_saw_undefined(this->symtab_->saw_undefined());
 }
 
@@ -841,6 +842,7 @@ Finish_group::locks(Task_locker* tl)
 void
 Finish_group::run(Workqueue*)
 {
+  this->symtab_->add_queued_symbols();
   size_t saw_undefined = this->saw_undefined_;
   while (saw_undefined != this->symtab_->saw_undefined())
     {
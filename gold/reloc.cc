@@ -186,7 +186,13 @@ void
 Scan_relocs::run(Workqueue*)
 {
   this->object_->scan_relocs(this->symtab_, this->layout_, this->rd_);
-  delete this->rd_;
+  if (Relobj::keep_relocs_for_relocate())
+    this->object_->set_relocs_data(this->rd_);
+  else
+    {
+      delete this->rd_;
+      this->object_->set_relocs_data(NULL);
+    }
   this->rd_ = NULL;
   this->object_->release();
 }
@@ -238,6 +244,10 @@ Relocate_task::run(Workqueue*)
 {
   this->object_->relocate(this->symtab_, this->layout_, this->of_);
 
+  // Drop the reloc views kept by Scan_relocs, so that the views are
+  // unlocked before we release the file.
+  this->object_->free_relocs_data();
+
   // This is normally the last thing we will do with an object, so
   // uncache all views.
   this->object_->clear_view_cache_marks();
@@ -253,6 +263,41 @@ Relocate_task::get_name() const
   return "Relocate_task " + this->object_->name();
 }
 
+// Relobj methods.
+
+// Return whether Scan_relocs should keep the views of the reloc
+// sections for Relocate_task.  The views are normally cached until
+// the object is relocated anyhow, so keeping them costs no extra
+// mappings, and it saves Relocate_task from looking up and checking
+// every reloc section a second time.  With --no-keep-files-mapped the
+// views are unmapped when the file is released, and the user has
+// asked us to keep the address space small, so we don't keep them.
+
+bool
+Relobj::keep_relocs_for_relocate()
+{
+  return parameters->options().keep_files_mapped();
+}
+
+// Free the relocs data kept for Relocate_task.
+
+void
+Relobj::free_relocs_data()
+{
+  if (this->rd_ != NULL)
+    {
+      for (Read_relocs_data::Relocs_list::iterator p = this->rd_->relocs.begin();
+	   p != this->rd_->relocs.end();
+	   ++p)
+	{
+	  delete p->contents;
+	  p->contents = NULL;
+	}
+      delete this->rd_;
+      this->rd_ = NULL;
+    }
+}
+
 // Read the relocs and local symbols from the object file and store
 // the information in RD.
 
@@ -440,6 +485,10 @@ Sized_relobj_file<size, big_endian>::do_scan_relocs(Symbol_table* symtab,
   if (layout->incremental_inputs() != NULL)
     this->allocate_incremental_reloc_counts();
 
+  // If the reloc views are kept for relocate_sections, they are freed
+  // by Relocate_task.
+  const bool keep_relocs = Relobj::keep_relocs_for_relocate();
+
   for (Read_relocs_data::Relocs_list::iterator p = rd->relocs.begin();
        p != rd->relocs.end();
        ++p)
@@ -486,8 +535,11 @@ Sized_relobj_file<size, big_endian>::do_scan_relocs(Symbol_table* symtab,
 					  rr);
 	}
 
-      delete p->contents;
-      p->contents = NULL;
+      if (!keep_relocs)
+	{
+	  delete p->contents;
+	  p->contents = NULL;
+	}
     }
 
   // For incremental links, finalize the allocation of relocations.
@@ -876,13 +928,19 @@ Sized_relobj_file<size, big_endian>::do_relocate_sections(
     parameters->sized_target<size, big_endian>();
 
   const Output_sections& out_sections(this->output_sections());
-  const std::vector<Address>& out_offsets(this->section_offsets());
 
   Relocate_info<size, big_endian> relinfo;
   relinfo.symtab = symtab;
   relinfo.layout = layout;
   relinfo.object = this;
 
+  // The relocs scanned by Scan_relocs, sorted by reloc section index,
+  // if they were kept.
+  const Read_relocs_data* rd = this->get_relocs_data();
+  Read_relocs_data::Relocs_list::const_iterator prd;
+  if (rd != NULL)
+    prd = rd->relocs.begin();
+
   const unsigned char* p = pshdrs + This::shdr_size;
   for (unsigned int i = 1; i < shnum; ++i, p += This::shdr_size)
     {
@@ -896,6 +954,27 @@ Sized_relobj_file<size, big_endian>::do_relocate_sections(
       if (sh_size == 0)
 	continue;
 
+      // If Scan_relocs kept this reloc section, then we already know
+      // that the section headers are valid, and we have a view.
+      if (rd != NULL)
+	{
+	  while (prd != rd->relocs.end() && prd->reloc_shndx < i)
+	    ++prd;
+	  if (prd != rd->relocs.end()
+	      && prd->reloc_shndx == i
+	      && prd->contents != NULL)
+	    {
+	      unsigned int index = prd->data_shndx;
+	      Output_section* os = out_sections[index];
+	      if (os != NULL)
+		this->relocate_section_relocs(&relinfo, pshdrs, of, pviews,
+					      p, i, index, sh_type,
+					      prd->contents->data(),
+					      prd->reloc_count, target);
+	      continue;
+	    }
+	}
+
       unsigned int index = this->adjust_shndx(shdr.get_sh_info());
       if (index >= this->shnum())
 	{
@@ -911,11 +990,6 @@ Sized_relobj_file<size, big_endian>::do_relocate_sections(
 	  // discarded.
 	  continue;
 	}
-      Address output_offset = out_offsets[index];
-
-      gold_assert((*pviews)[index].view != NULL);
-      if (parameters->options().relocatable())
-	gold_assert((*pviews)[i].view != NULL);
 
       if (this->adjust_shndx(shdr.get_sh_link()) != this->symtab_shndx_)
 	{
@@ -950,55 +1024,87 @@ Sized_relobj_file<size, big_endian>::do_relocate_sections(
 	  continue;
 	}
 
-      gold_assert(output_offset != invalid_address
-		  || this->relocs_must_follow_section_writes());
+      this->relocate_section_relocs(&relinfo, pshdrs, of, pviews, p, i, index,
+				    sh_type, prelocs, reloc_count, target);
+    }
+}
 
-      relinfo.reloc_shndx = i;
-      relinfo.reloc_shdr = p;
-      relinfo.data_shndx = index;
-      relinfo.data_shdr = pshdrs + index * This::shdr_size;
-      unsigned char* view = (*pviews)[index].view;
-      Address address = (*pviews)[index].address;
-      section_size_type view_size = (*pviews)[index].view_size;
+// Apply the RELOC_COUNT relocs at PRELOCS from reloc section
+// RELOC_SHNDX, whose header is at PSHDR, to section DATA_SHNDX.  The
+// section headers have already been checked.
 
-      Reloc_symbol_changes* reloc_map = NULL;
-      if (this->uses_split_stack() && output_offset != invalid_address)
-	{
-	  typename This::Shdr data_shdr(pshdrs + index * This::shdr_size);
-	  if ((data_shdr.get_sh_flags() & elfcpp::SHF_EXECINSTR) != 0)
-	    this->split_stack_adjust(symtab, pshdrs, sh_type, index,
-				     prelocs, reloc_count, view, view_size,
-				     &reloc_map, target);
-	}
+template<int size, bool big_endian>
+void
+Sized_relobj_file<size, big_endian>::relocate_section_relocs(
+    Relocate_info<size, big_endian>* relinfo,
+    const unsigned char* pshdrs,
+    Output_file* of,
+    Views* pviews,
+    const unsigned char* pshdr,
+    unsigned int reloc_shndx,
+    unsigned int data_shndx,
+    unsigned int sh_type,
+    const unsigned char* prelocs,
+    size_t reloc_count,
+    Sized_target<size, big_endian>* target)
+{
+  const unsigned int i = reloc_shndx;
+  const unsigned int index = data_shndx;
+  Output_section* os = this->output_section(index);
+  Address output_offset = this->section_offsets()[index];
+
+  gold_assert((*pviews)[index].view != NULL);
+  if (parameters->options().relocatable())
+    gold_assert((*pviews)[i].view != NULL);
+
+  gold_assert(output_offset != invalid_address
+	      || this->relocs_must_follow_section_writes());
+
+  relinfo->reloc_shndx = i;
+  relinfo->reloc_shdr = pshdr;
+  relinfo->data_shndx = index;
+  relinfo->data_shdr = pshdrs + index * This::shdr_size;
+  unsigned char* view = (*pviews)[index].view;
+  Address address = (*pviews)[index].address;
+  section_size_type view_size = (*pviews)[index].view_size;
+
+  Reloc_symbol_changes* reloc_map = NULL;
+  if (this->uses_split_stack() && output_offset != invalid_address)
+    {
+      typename This::Shdr data_shdr(pshdrs + index * This::shdr_size);
+      if ((data_shdr.get_sh_flags() & elfcpp::SHF_EXECINSTR) != 0)
+	this->split_stack_adjust(relinfo->symtab, pshdrs, sh_type, index,
+				 prelocs, reloc_count, view, view_size,
+				 &reloc_map, target);
+    }
 
-      Relocatable_relocs* rr = NULL;
-      if (parameters->options().emit_relocs()
-	  || parameters->options().relocatable())
-	rr = this->relocatable_relocs(i);
-      relinfo.rr = rr;
+  Relocatable_relocs* rr = NULL;
+  if (parameters->options().emit_relocs()
+      || parameters->options().relocatable())
+    rr = this->relocatable_relocs(i);
+  relinfo->rr = rr;
 
-      if (!parameters->options().relocatable())
-	{
-	  target->relocate_section(&relinfo, sh_type, prelocs, reloc_count, os,
-				   output_offset == invalid_address,
-				   view, address, view_size, reloc_map);
-	  if (parameters->options().emit_relocs())
-	    target->relocate_relocs(&relinfo, sh_type, prelocs, reloc_count,
-				    os, output_offset,
-				    view, address, view_size,
-				    (*pviews)[i].view,
-				    (*pviews)[i].view_size);
-	  if (parameters->incremental())
-	    this->incremental_relocs_write(&relinfo, sh_type, prelocs,
-					   reloc_count, os, output_offset, of);
-	}
-      else
-	target->relocate_relocs(&relinfo, sh_type, prelocs, reloc_count,
+  if (!parameters->options().relocatable())
+    {
+      target->relocate_section(relinfo, sh_type, prelocs, reloc_count, os,
+			       output_offset == invalid_address,
+			       view, address, view_size, reloc_map);
+      if (parameters->options().emit_relocs())
+	target->relocate_relocs(relinfo, sh_type, prelocs, reloc_count,
 				os, output_offset,
 				view, address, view_size,
 				(*pviews)[i].view,
 				(*pviews)[i].view_size);
+      if (parameters->incremental())
+	this->incremental_relocs_write(relinfo, sh_type, prelocs,
+				       reloc_count, os, output_offset, of);
     }
+  else
+    target->relocate_relocs(relinfo, sh_type, prelocs, reloc_count,
+			    os, output_offset,
+			    view, address, view_size,
+			    (*pviews)[i].view,
+			    (*pviews)[i].view_size);
 }
 
 // Return the output view for section SHNDX.
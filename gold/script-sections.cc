@@ -558,6 +558,9 @@ Orphan_section_placement::last_place() const
 
 // An element in a SECTIONS clause.
 
+class Input_section_spec_index;
+class Output_section_element_input;
+
 class Sections_element
 {
  public:
@@ -601,6 +604,12 @@ class Sections_element
 		      Script_sections::Section_type*, bool*)
   { return NULL; }
 
+  // Add the input section specs to INDEX.  The only real
+  // implementation is in Output_section_definition.
+  virtual void
+  add_to_spec_index(Input_section_spec_index*)
+  { }
+
   // Initialize OSP with an output section.
   virtual void
   orphan_section_init(Orphan_section_placement*,
@@ -784,6 +793,84 @@ class Sections_element_assertion : public Sections_element
   Script_assertion assertion_;
 };
 
+// An index of the input section specs in a SECTIONS clause, used to
+// find the output section for an input section name without testing
+// every spec in the script.  Each section name pattern is filed under
+// the literal text before its first wildcard character: patterns
+// without wildcards go in a hash table, and the prefixes of the others
+// go in a trie.  Looking up a section name yields the specs which
+// might match it, in script order; only those are actually tried, so
+// the first spec which matches is the same one a linear search would
+// find.
+
+class Input_section_spec_index
+{
+ public:
+  Input_section_spec_index()
+    : specs_(), exact_(), trie_(1)
+  { }
+
+  // Add a spec for output section OSD.  Specs must be added in the
+  // order in which they appear in the script.  Returns the index of
+  // the spec, to pass to add_pattern.
+  unsigned int
+  add_spec(Output_section_definition* osd,
+	   const Output_section_element_input* element);
+
+  // Record that spec SPEC may match section names which match
+  // PATTERN.  A spec with no section name patterns should be added
+  // with the pattern "*".
+  void
+  add_pattern(unsigned int spec, const std::string& pattern,
+	      bool is_wildcard);
+
+  // Return the output section name to use for FILE_NAME and
+  // SECTION_NAME, as for Script_sections::output_section_name.
+  // Returns NULL if no spec matches.
+  const char*
+  output_section_name(const char* file_name, const char* section_name,
+		      Output_section***, Script_sections::Section_type*,
+		      bool* keep) const;
+
+ private:
+  // A spec in the script.
+  struct Spec
+  {
+    Spec(Output_section_definition* osda,
+	 const Output_section_element_input* elementa)
+      : osd(osda), element(elementa)
+    { }
+
+    // The output section.
+    Output_section_definition* osd;
+    // The input section spec.
+    const Output_section_element_input* element;
+  };
+
+  // A node in the trie of wildcard pattern prefixes.
+  struct Trie_node
+  {
+    Trie_node()
+      : children(), specs()
+    { }
+
+    // The nodes for the prefixes one character longer.
+    std::map<char, unsigned int> children;
+    // The specs with a wildcard pattern whose prefix ends here.
+    std::vector<unsigned int> specs;
+  };
+
+  typedef Unordered_map<std::string, std::vector<unsigned int> > Exact_names;
+
+  // The specs, in script order.
+  std::vector<Spec> specs_;
+  // Specs by section names which they match exactly.
+  Exact_names exact_;
+  // The trie; trie_[0] is the root, which holds the specs with
+  // patterns that start with a wildcard character.
+  std::vector<Trie_node> trie_;
+};
+
 // An element in an output section in a SECTIONS clause.
 
 class Output_section_element
@@ -819,6 +906,14 @@ class Output_section_element
   match_name(const char*, const char*, bool *) const
   { return false; }
 
+  // Add this element to the index of input section specs, as part of
+  // output section OSD.  The only real implementation is in
+  // Output_section_element_input.
+  virtual void
+  add_to_spec_index(Input_section_spec_index*,
+		    Output_section_definition*) const
+  { }
+
   // Set section addresses.  This includes applying assignments if the
   // expression is an absolute value.
   virtual void
@@ -1259,6 +1354,11 @@ class Output_section_element_input : public Output_section_element
   bool
   match_name(const char* file_name, const char* section_name, bool* keep) const;
 
+  // Add this element to the index of input section specs.
+  void
+  add_to_spec_index(Input_section_spec_index*,
+		    Output_section_definition*) const;
+
   // Set the section address.
   void
   set_section_addresses(Symbol_table* symtab, Layout* layout, Output_section*,
@@ -1440,6 +1540,23 @@ Output_section_element_input::match_name(const char* file_name,
   return false;
 }
 
+// Add this element to the index of input section specs.
+
+void
+Output_section_element_input::add_to_spec_index(
+    Input_section_spec_index* index,
+    Output_section_definition* osd) const
+{
+  unsigned int spec = index->add_spec(osd, this);
+  if (this->input_section_patterns_.empty())
+    index->add_pattern(spec, "*", true);
+  for (Input_section_patterns::const_iterator p =
+	 this->input_section_patterns_.begin();
+       p != this->input_section_patterns_.end();
+       ++p)
+    index->add_pattern(spec, p->pattern, p->pattern_is_wildcard);
+}
+
 // Information we use to sort the input sections.
 
 class Input_section_info
@@ -1915,6 +2032,21 @@ class Output_section_definition : public Sections_element
 		      Output_section***, Script_sections::Section_type*,
 		      bool*);
 
+  // Return the output section name to use for an input section
+  // matched by one of our elements.
+  const char*
+  matched_section_name(Output_section*** slot,
+		       Script_sections::Section_type* psection_type)
+  {
+    *slot = &this->output_section_;
+    *psection_type = this->section_type();
+    return this->name_.c_str();
+  }
+
+  // Add the input section specs to INDEX.
+  void
+  add_to_spec_index(Input_section_spec_index* index);
+
   // Initialize OSP with an output section.
   void
   orphan_section_init(Orphan_section_placement* osp,
@@ -2210,9 +2342,7 @@ Output_section_definition::output_section_name(
 	{
 	  // We found a match for NAME, which means that it should go
 	  // into this output section.
-	  *slot = &this->output_section_;
-	  *psection_type = this->section_type();
-	  return this->name_.c_str();
+	  return this->matched_section_name(slot, psection_type);
 	}
     }
 
@@ -2220,6 +2350,127 @@ Output_section_definition::output_section_name(
   return NULL;
 }
 
+// Add the input section specs to INDEX.
+
+void
+Output_section_definition::add_to_spec_index(Input_section_spec_index* index)
+{
+  for (Output_section_elements::const_iterator p = this->elements_.begin();
+       p != this->elements_.end();
+       ++p)
+    (*p)->add_to_spec_index(index, this);
+}
+
+// Class Input_section_spec_index.
+
+// Add a spec.
+
+unsigned int
+Input_section_spec_index::add_spec(
+    Output_section_definition* osd,
+    const Output_section_element_input* element)
+{
+  this->specs_.push_back(Spec(osd, element));
+  return this->specs_.size() - 1;
+}
+
+// Add a pattern for SPEC.
+
+void
+Input_section_spec_index::add_pattern(unsigned int spec,
+				      const std::string& pattern,
+				      bool is_wildcard)
+{
+  if (!is_wildcard)
+    {
+      std::vector<unsigned int>& v(this->exact_[pattern]);
+      if (v.empty() || v.back() != spec)
+	v.push_back(spec);
+      return;
+    }
+
+  // Walk down the trie over the literal prefix of the pattern.  A
+  // backslash quotes the next character for fnmatch, so we stop there
+  // too.
+  unsigned int node = 0;
+  for (std::string::const_iterator p = pattern.begin();
+       p != pattern.end();
+       ++p)
+    {
+      char c = *p;
+      if (c == '*' || c == '?' || c == '[' || c == '\\')
+	break;
+      std::map<char, unsigned int>::const_iterator pc =
+	this->trie_[node].children.find(c);
+      if (pc != this->trie_[node].children.end())
+	node = pc->second;
+      else
+	{
+	  unsigned int child = this->trie_.size();
+	  this->trie_[node].children[c] = child;
+	  this->trie_.push_back(Trie_node());
+	  node = child;
+	}
+    }
+
+  std::vector<unsigned int>& v(this->trie_[node].specs);
+  if (v.empty() || v.back() != spec)
+    v.push_back(spec);
+}
+
+// Return the output section name to use for FILE_NAME and
+// SECTION_NAME, or NULL if no spec matches.
+
+const char*
+Input_section_spec_index::output_section_name(
+    const char* file_name,
+    const char* section_name,
+    Output_section*** slot,
+    Script_sections::Section_type* psection_type,
+    bool* keep) const
+{
+  // Gather the specs which may match.  Each list is in script order.
+  std::vector<unsigned int> candidates;
+  Exact_names::const_iterator pe = this->exact_.find(section_name);
+  if (pe != this->exact_.end())
+    candidates.insert(candidates.end(), pe->second.begin(),
+		      pe->second.end());
+  unsigned int node = 0;
+  const char* pn = section_name;
+  while (true)
+    {
+      const std::vector<unsigned int>& v(this->trie_[node].specs);
+      candidates.insert(candidates.end(), v.begin(), v.end());
+      if (*pn == '\0')
+	break;
+      std::map<char, unsigned int>::const_iterator pc =
+	this->trie_[node].children.find(*pn);
+      if (pc == this->trie_[node].children.end())
+	break;
+      node = pc->second;
+      ++pn;
+    }
+
+  std::sort(candidates.begin(), candidates.end());
+  candidates.erase(std::unique(candidates.begin(), candidates.end()),
+		   candidates.end());
+
+  for (std::vector<unsigned int>::const_iterator p = candidates.begin();
+       p != candidates.end();
+       ++p)
+    {
+      const Spec& spec(this->specs_[*p]);
+      bool spec_keep;
+      if (spec.element->match_name(file_name, section_name, &spec_keep))
+	{
+	  *keep = spec_keep;
+	  return spec.osd->matched_section_name(slot, psection_type);
+	}
+    }
+
+  return NULL;
+}
+
 // Return true if memory from START to START + LENGTH is contained
 // within a memory region.
 
@@ -3231,7 +3482,8 @@ Script_sections::Script_sections()
     saw_data_segment_align_(false),
     saw_relro_end_(false),
     saw_segment_start_expression_(false),
-    segments_created_(false)
+    segments_created_(false),
+    input_section_spec_index_(NULL)
 {
 }
 
@@ -3254,6 +3506,15 @@ Script_sections::finish_sections()
 {
   gold_assert(this->in_sections_clause_ && this->output_section_ == NULL);
   this->in_sections_clause_ = false;
+
+  // Index the input section specs seen so far, so that
+  // output_section_name does not have to try each of them in turn.
+  delete this->input_section_spec_index_;
+  this->input_section_spec_index_ = new Input_section_spec_index;
+  for (Sections_elements::const_iterator p = this->sections_elements_->begin();
+       p != this->sections_elements_->end();
+       ++p)
+    (*p)->add_to_spec_index(this->input_section_spec_index_);
 }
 
 // Add a symbol to be defined.
@@ -3455,26 +3716,31 @@ Script_sections::output_section_name(
     Script_sections::Section_type* psection_type,
     bool* keep)
 {
+  // Use the index to find the first matching spec.  If there is no
+  // match, we still make the linear search, as that is what sets
+  // *KEEP for an orphan section.
+  const char* ret = NULL;
+  if (this->input_section_spec_index_ != NULL && !this->in_sections_clause_)
+    ret = this->input_section_spec_index_->output_section_name(
+	file_name, section_name, output_section_slot, psection_type, keep);
+
   for (Sections_elements::const_iterator p = this->sections_elements_->begin();
-       p != this->sections_elements_->end();
+       ret == NULL && p != this->sections_elements_->end();
        ++p)
-    {
-      const char* ret = (*p)->output_section_name(file_name, section_name,
-						  output_section_slot,
-						  psection_type, keep);
+    ret = (*p)->output_section_name(file_name, section_name,
+				    output_section_slot, psection_type, keep);
 
-      if (ret != NULL)
+  if (ret != NULL)
+    {
+      // The special name /DISCARD/ means that the input section
+      // should be discarded.
+      if (strcmp(ret, "/DISCARD/") == 0)
 	{
-	  // The special name /DISCARD/ means that the input section
-	  // should be discarded.
-	  if (strcmp(ret, "/DISCARD/") == 0)
-	    {
-	      *output_section_slot = NULL;
-	      *psection_type = Script_sections::ST_NONE;
-	      return NULL;
-	    }
-	  return ret;
+	  *output_section_slot = NULL;
+	  *psection_type = Script_sections::ST_NONE;
+	  return NULL;
 	}
+      return ret;
     }
 
   // If we couldn't find a mapping for the name, the output section
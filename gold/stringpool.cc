@@ -28,6 +28,8 @@
 
 #include "output.h"
 #include "parameters.h"
+#include "gold-threads.h"
+#include "timer.h"
 #include "stringpool.h"
 
 namespace gold
@@ -37,7 +39,8 @@ template<typename Stringpool_char>
 Stringpool_template<Stringpool_char>::Stringpool_template(uint64_t addralign)
   : string_set_(), key_to_offset_(), strings_(), strtab_size_(0),
     zero_null_(true), optimize_(false), offset_(sizeof(Stringpool_char)),
-    addralign_(addralign)
+    addralign_(addralign), next_ordinal_(0), shards_(NULL), shard_count_(0),
+    ordinal_lock_(NULL), data_bytes_(0), offsets_usec_(0)
 {
   if (parameters->options_valid()
       && parameters->options().optimize() >= 2
@@ -56,12 +59,59 @@ Stringpool_template<Stringpool_char>::clear()
   this->strings_.clear();
   this->key_to_offset_.clear();
   this->string_set_.clear();
+  for (unsigned int i = 0; i < this->shard_count_; ++i)
+    {
+      this->shards_[i].pool->clear();
+      this->shards_[i].ordinals.clear();
+    }
 }
 
 template<typename Stringpool_char>
 Stringpool_template<Stringpool_char>::~Stringpool_template()
 {
   this->clear();
+  for (unsigned int i = 0; i < this->shard_count_; ++i)
+    {
+      delete this->shards_[i].pool;
+      delete this->shards_[i].lock;
+    }
+  delete[] this->shards_;
+  delete this->ordinal_lock_;
+}
+
+// Make this a concurrent stringpool.
+
+template<typename Stringpool_char>
+void
+Stringpool_template<Stringpool_char>::set_concurrent()
+{
+  // The number of shards.  This should be comfortably larger than
+  // the number of threads likely to be adding strings at once.
+  const unsigned int shard_count = 64;
+
+  gold_assert(this->shards_ == NULL
+	      && this->string_set_.empty()
+	      && this->strtab_size_ == 0);
+  this->shards_ = new Shard[shard_count];
+  this->shard_count_ = shard_count;
+  for (unsigned int i = 0; i < shard_count; ++i)
+    {
+      this->shards_[i].pool = new Stringpool_template(this->addralign_);
+      this->shards_[i].lock = new Lock();
+    }
+  this->ordinal_lock_ = new Lock();
+}
+
+// Reserve COUNT ordinals.
+
+template<typename Stringpool_char>
+uint64_t
+Stringpool_template<Stringpool_char>::reserve_ordinals(uint64_t count)
+{
+  Hold_optional_lock hl(this->ordinal_lock_);
+  uint64_t ret = this->next_ordinal_;
+  this->next_ordinal_ += count;
+  return ret;
 }
 
 // Resize the internal hashtable with the expectation we'll get n new
@@ -73,6 +123,13 @@ template<typename Stringpool_char>
 void
 Stringpool_template<Stringpool_char>::reserve(unsigned int n)
 {
+  if (this->shards_ != NULL)
+    {
+      for (unsigned int i = 0; i < this->shard_count_; ++i)
+	this->shards_[i].pool->reserve(n / this->shard_count_ + 1);
+      return;
+    }
+
   this->key_to_offset_.reserve(n);
 
 #if defined(HAVE_UNORDERED_MAP)
@@ -192,6 +249,7 @@ Stringpool_template<Stringpool_char>::add_string(const Stringpool_char* s,
     }
 
   Stringdata* psd = reinterpret_cast<Stringdata*>(new char[alc]);
+  this->data_bytes_ += alc;
   psd->alc = alc - sizeof(Stringdata);
   memcpy(psd->data, s, len - sizeof(Stringpool_char));
   memset(psd->data + len - sizeof(Stringpool_char), 0,
@@ -242,6 +300,23 @@ Stringpool_template<Stringpool_char>::add_with_length(const Stringpool_char* s,
 						      bool copy,
 						      Key* pkey)
 {
+  return this->add_prehashed(s, length, string_hash(s, length), copy, pkey);
+}
+
+// Add a string whose hash code has already been computed.
+
+template<typename Stringpool_char>
+const Stringpool_char*
+Stringpool_template<Stringpool_char>::add_prehashed(const Stringpool_char* s,
+						    size_t length,
+						    size_t hash_code,
+						    bool copy,
+						    Key* pkey)
+{
+  if (this->shards_ != NULL)
+    return this->add_to_shard(s, length, hash_code, this->reserve_ordinals(1),
+			      copy, pkey);
+
   typedef std::pair<typename String_set_type::iterator, bool> Insert_type;
 
   // We add 1 so that 0 is always invalid.
@@ -252,7 +327,7 @@ Stringpool_template<Stringpool_char>::add_with_length(const Stringpool_char* s,
       // When we don't need to copy the string, we can call insert
       // directly.
 
-      std::pair<Hashkey, Hashval> element(Hashkey(s, length), k);
+      std::pair<Hashkey, Hashval> element(Hashkey(s, length, hash_code), k);
 
       Insert_type ins = this->string_set_.insert(element);
 
@@ -279,7 +354,7 @@ Stringpool_template<Stringpool_char>::add_with_length(const Stringpool_char* s,
   // canonicalize it by copying it into the canonical list. The hash
   // code will only be computed once.
 
-  Hashkey hk(s, length);
+  Hashkey hk(s, length, hash_code);
   typename String_set_type::const_iterator p = this->string_set_.find(hk);
   if (p != this->string_set_.end())
     {
@@ -304,12 +379,77 @@ Stringpool_template<Stringpool_char>::add_with_length(const Stringpool_char* s,
   return hk.string;
 }
 
+// Add a string with a specific ordinal and a precomputed hash code.
+
+template<typename Stringpool_char>
+const Stringpool_char*
+Stringpool_template<Stringpool_char>::add_prehashed_with_ordinal(
+    const Stringpool_char* s,
+    size_t length,
+    size_t hash_code,
+    uint64_t ordinal,
+    bool copy,
+    Key* pkey)
+{
+  if (this->shards_ == NULL)
+    return this->add_prehashed(s, length, hash_code, copy, pkey);
+  return this->add_to_shard(s, length, hash_code, ordinal, copy, pkey);
+}
+
+// Add a string to a concurrent stringpool.  We add the string to the
+// shard chosen by the hash code, and remember the smallest ordinal
+// used for it.  The key for the shard is turned into a key for the
+// whole stringpool by interleaving the keys of all the shards.
+
+template<typename Stringpool_char>
+const Stringpool_char*
+Stringpool_template<Stringpool_char>::add_to_shard(const Stringpool_char* s,
+						   size_t length,
+						   size_t hash_code,
+						   uint64_t ordinal,
+						   bool copy,
+						   Key* pkey)
+{
+  const unsigned int index = this->shard_index(hash_code);
+  Shard& shard(this->shards_[index]);
+
+  Key k;
+  const Stringpool_char* ret;
+  {
+    Hold_lock hl(*shard.lock);
+    ret = shard.pool->add_prehashed(s, length, hash_code, copy, &k);
+    if (k > shard.ordinals.size())
+      shard.ordinals.push_back(ordinal);
+    else if (ordinal < shard.ordinals[k - 1])
+      shard.ordinals[k - 1] = ordinal;
+  }
+
+  if (pkey != NULL)
+    *pkey = (k - 1) * this->shard_count_ + index + 1;
+  return ret;
+}
+
 template<typename Stringpool_char>
 const Stringpool_char*
 Stringpool_template<Stringpool_char>::find(const Stringpool_char* s,
 					   Key* pkey) const
 {
   Hashkey hk(s);
+
+  if (this->shards_ != NULL)
+    {
+      const unsigned int index = this->shard_index(hk.hash_code);
+      const Shard& shard(this->shards_[index]);
+      Hold_lock hl(*shard.lock);
+      typename String_set_type::const_iterator p =
+	shard.pool->string_set_.find(hk);
+      if (p == shard.pool->string_set_.end())
+	return NULL;
+      if (pkey != NULL)
+	*pkey = (p->second - 1) * this->shard_count_ + index + 1;
+      return p->first.string;
+    }
+
   typename String_set_type::const_iterator p = this->string_set_.find(hk);
   if (p == this->string_set_.end())
     return NULL;
@@ -320,6 +460,18 @@ Stringpool_template<Stringpool_char>::find(const Stringpool_char* s,
   return p->first.string;
 }
 
+// Get the offset of a string in a concurrent stringpool given its
+// key.
+
+template<typename Stringpool_char>
+section_offset_type
+Stringpool_template<Stringpool_char>::get_shard_offset_from_key(Key k) const
+{
+  gold_assert(k != 0);
+  const Shard& shard(this->shards_[(k - 1) % this->shard_count_]);
+  return shard.pool->get_offset_from_key((k - 1) / this->shard_count_ + 1);
+}
+
 // Comparison routine used when sorting into an ELF strtab.  We want
 // to sort this so that when one string is a suffix of another, we
 // always see the shorter string immediately after the longer string.
@@ -354,6 +506,22 @@ Stringpool_template<Stringpool_char>::Stringpool_sort_comparison::operator()(
   return len1 > len2;
 }
 
+// When laying out a concurrent stringpool, sort by ordinal.  Distinct
+// strings should have distinct ordinals, but if they don't we fall
+// back on the string contents, so that the result does not depend on
+// the order of the hash tables.
+
+template<typename Stringpool_char>
+bool
+Stringpool_template<Stringpool_char>::Stringpool_ordinal_comparison::operator()(
+  const Stringpool_ordinal_info& oi1,
+  const Stringpool_ordinal_info& oi2) const
+{
+  if (oi1.ordinal != oi2.ordinal)
+    return oi1.ordinal < oi2.ordinal;
+  return Stringpool_sort_comparison()(oi1.info, oi2.info);
+}
+
 // Return whether s1 is a suffix of s2.
 
 template<typename Stringpool_char>
@@ -368,6 +536,65 @@ Stringpool_template<Stringpool_char>::is_suffix(const Stringpool_char* s1,
   return memcmp(s1, s2 + len2 - len1, len1 * sizeof(Stringpool_char)) == 0;
 }
 
+// Return the offset for the string table entry P.  For a concurrent
+// stringpool the entry lives in one of the shards.
+
+template<typename Stringpool_char>
+section_offset_type&
+Stringpool_template<Stringpool_char>::offset_for_entry(
+    const Stringpool_sort_info& p)
+{
+  if (this->shards_ == NULL)
+    return this->key_to_offset_[p->second - 1];
+  Stringpool_template* pool =
+    this->shards_[this->shard_index(p->first.hash_code)].pool;
+  return pool->key_to_offset_[p->second - 1];
+}
+
+// Assign offsets to the strings in V, which have been sorted so that
+// each string which is a suffix of another immediately follows it.
+// Such a string shares the storage of the longer one.  OFFSET is the
+// first free offset.  Return the size of the string table.
+
+template<typename Stringpool_char>
+section_offset_type
+Stringpool_template<Stringpool_char>::set_suffix_offsets(
+    const std::vector<Stringpool_sort_info>& v,
+    section_offset_type offset)
+{
+  const size_t charsize = sizeof(Stringpool_char);
+
+  section_offset_type last_offset = -1;
+  for (typename std::vector<Stringpool_sort_info>::const_iterator
+	 last = v.end(),
+	 curr = v.begin();
+       curr != v.end();
+       last = curr++)
+    {
+      section_offset_type this_offset;
+      if (this->zero_null_ && (*curr)->first.string[0] == 0)
+	this_offset = 0;
+      else if (last != v.end()
+	       && ((((*curr)->first.length - (*last)->first.length)
+		    % this->addralign_) == 0)
+	       && is_suffix((*curr)->first.string,
+			    (*curr)->first.length,
+			    (*last)->first.string,
+			    (*last)->first.length))
+	this_offset = (last_offset
+		       + (((*last)->first.length - (*curr)->first.length)
+			  * charsize));
+      else
+	{
+	  this_offset = align_address(offset, this->addralign_);
+	  offset = this_offset + ((*curr)->first.length + 1) * charsize;
+	}
+      this->offset_for_entry(*curr) = this_offset;
+      last_offset = this_offset;
+    }
+  return offset;
+}
+
 // Turn the stringpool into an ELF strtab: determine the offsets of
 // each string in the table.
 
@@ -381,65 +608,98 @@ Stringpool_template<Stringpool_char>::set_string_offsets()
       return;
     }
 
+  long long start_usec = Timer::current_wall_usec();
+
   const size_t charsize = sizeof(Stringpool_char);
 
   // Offset 0 may be reserved for the empty string.
   section_offset_type offset = this->zero_null_ ? charsize : 0;
 
+  const unsigned int pool_count =
+    this->shards_ == NULL ? 1 : this->shard_count_;
+  size_t count = 0;
+  for (unsigned int i = 0; i < pool_count; ++i)
+    count += (this->shards_ == NULL
+	      ? this->string_set_.size()
+	      : this->shards_[i].pool->string_set_.size());
+
   // Sorting to find suffixes can take over 25% of the total CPU time
   // used by the linker.  Since it's merely an optimization to reduce
   // the strtab size, and gives a relatively small benefit (it's
   // typically rare for a symbol to be a suffix of another), we only
   // take the time to sort when the user asks for heavy optimization.
-  if (!this->optimize_)
+  // When we do sort, we split the sort among several threads.
+  if (this->optimize_)
+    {
+      std::vector<Stringpool_sort_info> v;
+      v.reserve(count);
+
+      for (unsigned int i = 0; i < pool_count; ++i)
+	{
+	  String_set_type* string_set = (this->shards_ == NULL
+					 ? &this->string_set_
+					 : &this->shards_[i].pool->string_set_);
+	  for (typename String_set_type::iterator p = string_set->begin();
+	       p != string_set->end();
+	       ++p)
+	    v.push_back(Stringpool_sort_info(p));
+	}
+
+      parallel_sort(v.begin(), v.end(), Stringpool_sort_comparison());
+
+      offset = this->set_suffix_offsets(v, offset);
+    }
+  else if (this->shards_ == NULL)
     {
       // If we are not optimizing, the offsets are already assigned.
       offset = this->offset_;
     }
   else
     {
-      size_t count = this->string_set_.size();
-
-      std::vector<Stringpool_sort_info> v;
+      // The strings in a concurrent stringpool were added in an
+      // unpredictable order, so we lay them out in ordinal order.
+      // This gives the same string table as adding the strings one
+      // at a time in ordinal order.
+      std::vector<Stringpool_ordinal_info> v;
       v.reserve(count);
 
-      for (typename String_set_type::iterator p = this->string_set_.begin();
-           p != this->string_set_.end();
-           ++p)
-        v.push_back(Stringpool_sort_info(p));
+      for (unsigned int i = 0; i < pool_count; ++i)
+	{
+	  const Shard& shard(this->shards_[i]);
+	  String_set_type& string_set(shard.pool->string_set_);
+	  for (typename String_set_type::iterator p = string_set.begin();
+	       p != string_set.end();
+	       ++p)
+	    {
+	      Stringpool_ordinal_info oi;
+	      oi.ordinal = shard.ordinals[p->second - 1];
+	      oi.info = p;
+	      v.push_back(oi);
+	    }
+	}
 
-      std::sort(v.begin(), v.end(), Stringpool_sort_comparison());
+      parallel_sort(v.begin(), v.end(), Stringpool_ordinal_comparison());
 
-      section_offset_type last_offset = -1;
-      for (typename std::vector<Stringpool_sort_info>::iterator last = v.end(),
-             curr = v.begin();
-           curr != v.end();
-           last = curr++)
-        {
+      for (typename std::vector<Stringpool_ordinal_info>::const_iterator p =
+	     v.begin();
+	   p != v.end();
+	   ++p)
+	{
 	  section_offset_type this_offset;
-          if (this->zero_null_ && (*curr)->first.string[0] == 0)
-            this_offset = 0;
-          else if (last != v.end()
-                   && ((((*curr)->first.length - (*last)->first.length)
-			% this->addralign_) == 0)
-                   && is_suffix((*curr)->first.string,
-				(*curr)->first.length,
-                                (*last)->first.string,
-				(*last)->first.length))
-            this_offset = (last_offset
-			   + (((*last)->first.length - (*curr)->first.length)
-			      * charsize));
-          else
-            {
-              this_offset = align_address(offset, this->addralign_);
-              offset = this_offset + ((*curr)->first.length + 1) * charsize;
-            }
-	  this->key_to_offset_[(*curr)->second - 1] = this_offset;
-	  last_offset = this_offset;
-        }
+	  if (this->zero_null_ && p->info->first.length == 0)
+	    this_offset = 0;
+	  else
+	    {
+	      this_offset = align_address(offset, this->addralign_);
+	      offset = this_offset + (p->info->first.length + 1) * charsize;
+	    }
+	  this->offset_for_entry(p->info) = this_offset;
+	}
     }
 
   this->strtab_size_ = offset;
+
+  this->offsets_usec_ += Timer::current_wall_usec() - start_usec;
 }
 
 // Get the offset of a string in the ELF strtab.  The string must
@@ -461,9 +721,12 @@ Stringpool_template<Stringpool_char>::get_offset_with_length(
 {
   gold_assert(this->strtab_size_ != 0);
   Hashkey hk(s, length);
-  typename String_set_type::const_iterator p = this->string_set_.find(hk);
-  if (p != this->string_set_.end())
-    return this->key_to_offset_[p->second - 1];
+  const Stringpool_template* pool = this;
+  if (this->shards_ != NULL)
+    pool = this->shards_[this->shard_index(hk.hash_code)].pool;
+  typename String_set_type::const_iterator p = pool->string_set_.find(hk);
+  if (p != pool->string_set_.end())
+    return pool->key_to_offset_[p->second - 1];
   gold_unreachable();
 }
 
@@ -479,15 +742,25 @@ Stringpool_template<Stringpool_char>::write_to_buffer(
   gold_assert(bufsize >= this->strtab_size_);
   if (this->zero_null_)
     buffer[0] = '\0';
-  for (typename String_set_type::const_iterator p = this->string_set_.begin();
-       p != this->string_set_.end();
-       ++p)
+  const unsigned int pool_count =
+    this->shards_ == NULL ? 1 : this->shard_count_;
+  for (unsigned int i = 0; i < pool_count; ++i)
     {
-      const int len = (p->first.length + 1) * sizeof(Stringpool_char);
-      const section_offset_type offset = this->key_to_offset_[p->second - 1];
-      gold_assert(static_cast<section_size_type>(offset) + len
-		  <= this->strtab_size_);
-      memcpy(buffer + offset, p->first.string, len);
+      const Stringpool_template* pool = (this->shards_ == NULL
+					 ? this
+					 : this->shards_[i].pool);
+      for (typename String_set_type::const_iterator p =
+	     pool->string_set_.begin();
+	   p != pool->string_set_.end();
+	   ++p)
+	{
+	  const int len = (p->first.length + 1) * sizeof(Stringpool_char);
+	  const section_offset_type offset =
+	    pool->key_to_offset_[p->second - 1];
+	  gold_assert(static_cast<section_size_type>(offset) + len
+		      <= this->strtab_size_);
+	  memcpy(buffer + offset, p->first.string, len);
+	}
     }
 }
 
@@ -509,16 +782,40 @@ template<typename Stringpool_char>
 void
 Stringpool_template<Stringpool_char>::print_stats(const char* name) const
 {
+  const unsigned int pool_count =
+    this->shards_ == NULL ? 1 : this->shard_count_;
+  size_t entries = 0;
+  size_t buckets = 0;
+  size_t stringdata = 0;
+  unsigned long long data_bytes = 0;
+  for (unsigned int i = 0; i < pool_count; ++i)
+    {
+      const Stringpool_template* pool = (this->shards_ == NULL
+					 ? this
+					 : this->shards_[i].pool);
+      entries += pool->string_set_.size();
+#if defined(HAVE_UNORDERED_MAP) || defined(HAVE_TR1_UNORDERED_MAP) || defined(HAVE_EXT_HASH_MAP)
+      buckets += pool->string_set_.bucket_count();
+#endif
+      stringdata += pool->strings_.size();
+      data_bytes += pool->data_bytes_;
+    }
+
 #if defined(HAVE_UNORDERED_MAP) || defined(HAVE_TR1_UNORDERED_MAP) || defined(HAVE_EXT_HASH_MAP)
   fprintf(stderr, _("%s: %s entries: %zu; buckets: %zu\n"),
-	  program_name, name, this->string_set_.size(),
-	  this->string_set_.bucket_count());
+	  program_name, name, entries, buckets);
 #else
   fprintf(stderr, _("%s: %s entries: %zu\n"),
-	  program_name, name, this->table_.size());
+	  program_name, name, entries);
 #endif
-  fprintf(stderr, _("%s: %s Stringdata structures: %zu\n"),
-	  program_name, name, this->strings_.size());
+  if (this->shards_ != NULL)
+    fprintf(stderr, _("%s: %s shards: %u\n"),
+	    program_name, name, this->shard_count_);
+  fprintf(stderr, _("%s: %s Stringdata structures: %zu; bytes: %llu\n"),
+	  program_name, name, stringdata, data_bytes);
+  fprintf(stderr, _("%s: %s set_string_offsets time: %lld.%06lld\n"),
+	  program_name, name, this->offsets_usec_ / 1000000,
+	  this->offsets_usec_ % 1000000);
 }
 
 // Instantiate the templates we need.
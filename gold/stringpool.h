@@ -31,6 +31,7 @@ namespace gold
 {
 
 class Output_file;
+class Lock;
 
 // Return the length of a string in units of Char_type.
 
@@ -212,6 +213,26 @@ class Stringpool_template
   set_optimize()
   { this->optimize_ = true; }
 
+  // Indicate that strings may be added to this stringpool by several
+  // threads at once.  The strings are split by hash code among
+  // several shards, each with its own lock.  The string table does
+  // not depend on the order in which the threads add the strings; see
+  // reserve_ordinals.  This must be called before any strings are
+  // added.
+  void
+  set_concurrent();
+
+  // Reserve COUNT ordinals, and return the first one.  Unless the
+  // string table is optimized, strings are laid out in order of the
+  // smallest ordinal with which they were added.  add and
+  // add_with_length use the next unreserved ordinal.  Code which adds
+  // strings from several threads reserves ordinals ahead of time in
+  // the order in which it would add the strings from a single thread,
+  // so that the string table does not depend on the number of
+  // threads.
+  uint64_t
+  reserve_ordinals(uint64_t count);
+
   // Add the string S to the pool.  This returns a canonical permanent
   // pointer to the string in the pool.  If COPY is true, the string
   // is copied into permanent storage.  If PKEY is not NULL, this sets
@@ -229,6 +250,59 @@ class Stringpool_template
   const Stringpool_char*
   add_with_length(const Stringpool_char* s, size_t len, bool copy, Key* pkey);
 
+  // Add string S of length LEN characters to the pool, where
+  // HASH_CODE is the value which hash_string returns for S and LEN.
+  // This permits the hash code to be computed ahead of time.
+  const Stringpool_char*
+  add_prehashed(const Stringpool_char* s, size_t len, size_t hash_code,
+		bool copy, Key* pkey);
+
+  // Add string S of length LEN characters to the pool, using the
+  // ordinal ORDINAL, which should come from reserve_ordinals.  After
+  // set_concurrent, this may be called by several threads at once.
+  // Otherwise strings must be added in order of increasing ordinal.
+  const Stringpool_char*
+  add_with_ordinal(const Stringpool_char* s, size_t len, uint64_t ordinal,
+		   bool copy, Key* pkey)
+  {
+    return this->add_prehashed_with_ordinal(s, len, string_hash(s, len),
+					    ordinal, copy, pkey);
+  }
+
+  // Like add_with_ordinal, where HASH_CODE is the value which
+  // hash_string returns for S and LEN.
+  const Stringpool_char*
+  add_prehashed_with_ordinal(const Stringpool_char* s, size_t len,
+			     size_t hash_code, uint64_t ordinal, bool copy,
+			     Key* pkey);
+
+  // Return the hash code which the pool uses for string S of length
+  // LEN characters.  This does not look at the pool, so it may be
+  // called from any thread.
+  static size_t
+  hash_string(const Stringpool_char* s, size_t len)
+  { return string_hash(s, len); }
+
+  // Return the number of shards of a concurrent stringpool, or 0 if
+  // set_concurrent has not been called.
+  unsigned int
+  shard_count() const
+  { return this->shard_count_; }
+
+  // Return the shard of a concurrent stringpool which holds strings
+  // with hash code HASH_CODE.  Strings in different shards may be
+  // added by different threads without waiting for each other.
+  unsigned int
+  shard_index(size_t hash_code) const
+  { return (hash_code >> 8) % this->shard_count_; }
+
+  // Return the shard of a concurrent stringpool which holds the
+  // string with key K.  The keys of a shard depend only on the order
+  // in which strings were added to that shard.
+  unsigned int
+  key_shard_index(Key k) const
+  { return (k - 1) % this->shard_count_; }
+
   // If the string S is present in the pool, return the canonical
   // string pointer.  Otherwise, return NULL.  If PKEY is not NULL,
   // set *PKEY to the key.
@@ -261,6 +335,8 @@ class Stringpool_template
   section_offset_type
   get_offset_from_key(Key k) const
   {
+    if (this->shards_ != NULL)
+      return this->get_shard_offset_from_key(k);
     gold_assert(k <= this->key_to_offset_.size());
     return this->key_to_offset_[k - 1];
   }
@@ -326,6 +402,16 @@ class Stringpool_template
   is_suffix(const Stringpool_char* s1, size_t len1,
             const Stringpool_char* s2, size_t len2);
 
+  // Add a string to the appropriate shard of a concurrent stringpool.
+  const Stringpool_char*
+  add_to_shard(const Stringpool_char*, size_t, size_t, uint64_t, bool,
+	       Key*);
+
+  // Get the offset of a string in a concurrent stringpool given its
+  // key.
+  section_offset_type
+  get_shard_offset_from_key(Key) const;
+
   // The hash table key includes the string, the length of the string,
   // and the hash code for the string.  We put the hash code
   // explicitly into the key so that we can do a find()/insert()
@@ -353,6 +439,10 @@ class Stringpool_template
     Hashkey(const Stringpool_char* s, size_t len)
       : string(s), length(len), hash_code(string_hash(s, len))
     { }
+
+    Hashkey(const Stringpool_char* s, size_t len, size_t hash)
+      : string(s), length(len), hash_code(hash)
+    { }
   };
 
   // Hash function.  This is trivial, since we have already computed
@@ -388,6 +478,22 @@ class Stringpool_template
     operator()(const Stringpool_sort_info&, const Stringpool_sort_info&) const;
   };
 
+  // When laying out a concurrent stringpool which is not optimized,
+  // we sort the strings by ordinal.
+
+  struct Stringpool_ordinal_info
+  {
+    uint64_t ordinal;
+    Stringpool_sort_info info;
+  };
+
+  struct Stringpool_ordinal_comparison
+  {
+    bool
+    operator()(const Stringpool_ordinal_info&,
+	       const Stringpool_ordinal_info&) const;
+  };
+
   // Keys map to offsets via a Chunked_vector.  We only use the
   // offsets if we turn this into an string table section.
   typedef Chunked_vector<section_offset_type> Key_to_offset;
@@ -395,6 +501,35 @@ class Stringpool_template
   // List of Stringdata structures.
   typedef std::list<Stringdata*> Stringdata_list;
 
+  // A shard of a concurrent stringpool.  The key of a string in the
+  // shard is a key in POOL, which is converted to a key in the
+  // concurrent stringpool by interleaving the keys of all the shards.
+  struct Shard
+  {
+    Shard()
+      : pool(NULL), lock(NULL), ordinals()
+    { }
+
+    // The strings in this shard.
+    Stringpool_template* pool;
+    // The lock controlling access to this shard.
+    Lock* lock;
+    // The smallest ordinal used for each string, indexed by the key
+    // in POOL.
+    Chunked_vector<uint64_t> ordinals;
+  };
+
+  // Return the offset for the string table entry referred to by P.
+  section_offset_type&
+  offset_for_entry(const Stringpool_sort_info& p);
+
+  // Assign offsets to the sorted strings in V, starting at OFFSET,
+  // sharing the storage of strings which are suffixes of the
+  // preceding string.  Return the end of the string table.
+  section_offset_type
+  set_suffix_offsets(const std::vector<Stringpool_sort_info>& v,
+		     section_offset_type offset);
+
   // Mapping from const char* to namepool entry.
   String_set_type string_set_;
   // Mapping from Key to string table offset.
@@ -411,6 +546,19 @@ class Stringpool_template
   section_offset_type offset_;
   // The alignment of strings in the stringpool.
   uint64_t addralign_;
+  // The next ordinal to use.
+  uint64_t next_ordinal_;
+  // For a concurrent stringpool, the shards holding the strings, and
+  // the number of them.  string_set_ and key_to_offset_ are not used.
+  Shard* shards_;
+  unsigned int shard_count_;
+  // For a concurrent stringpool, lock controlling access to
+  // next_ordinal_.
+  Lock* ordinal_lock_;
+  // Total size of the Stringdata buffers, for statistics.
+  uint64_t data_bytes_;
+  // Time spent in set_string_offsets, in microseconds, for statistics.
+  long long offsets_usec_;
 };
 
 // The most common type of Stringpool.
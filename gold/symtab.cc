@@ -37,6 +37,7 @@
 #include "output.h"
 #include "target.h"
 #include "workqueue.h"
+#include "gold-threads.h"
 #include "symtab.h"
 #include "script.h"
 #include "plugin.h"
@@ -564,17 +565,43 @@ Symbol::set_undefined()
 
 Symbol_table::Symbol_table(unsigned int count,
                            const Version_script_info& version_script)
-  : saw_undefined_(0), offset_(0), table_(count), namepool_(),
-    forwarders_(), commons_(), tls_commons_(), small_commons_(),
-    large_commons_(), forced_locals_(), warnings_(),
+  : saw_undefined_(0), offset_(0), tables_(), namepool_(),
+    queued_relobjs_(), queued_symbol_count_(0), adding_shards_(NULL),
+    shared_lock_(NULL), forwarders_(), commons_(), tls_commons_(),
+    small_commons_(), large_commons_(), forced_locals_(), warnings_(),
     version_script_(version_script), gc_(NULL), icf_(NULL),
     target_symbols_()
 {
+  // With --concurrent-symbol-table the symbols of several objects are
+  // resolved at once, with the symbols split by the shard of the
+  // namepool which holds their names.  Plugins, incremental links,
+  // relocatable links, --wrap and --detect-odr-violations look at
+  // the symbol table in ways which don't fit that, so we don't do it
+  // for them.
+  const General_options& options(parameters->options());
+  if (options.concurrent_symbol_table()
+      && !options.has_plugins()
+      && !parameters->incremental()
+      && !options.relocatable()
+      && !options.any_wrap()
+      && !options.detect_odr_violations())
+    {
+      this->namepool_.set_concurrent();
+      this->shared_lock_ = new Lock();
+    }
+
+  const unsigned int table_count = std::max(this->namepool_.shard_count(),
+					    1U);
+  this->tables_.reserve(table_count);
+  for (unsigned int i = 0; i < table_count; ++i)
+    this->tables_.push_back(Symbol_table_type(count / table_count));
   namepool_.reserve(count);
 }
 
 Symbol_table::~Symbol_table()
 {
+  if (this->shared_lock_ != NULL)
+    delete this->shared_lock_;
 }
 
 // The symbol table key equality function.  This is called with
@@ -650,6 +677,8 @@ Symbol_table::gc_mark_undef_symbols(Layout* layout)
 void
 Symbol_table::gc_mark_symbol(Symbol* sym)
 {
+  Hold_optional_lock hl(this->shared_lock_);
+
   // Add the object and section to the work list.
   bool is_ordinary;
   unsigned int shndx = sym->shndx(&is_ordinary);
@@ -679,7 +708,10 @@ Symbol_table::make_forwarder(Symbol* from, Symbol* to)
 {
   gold_assert(from != to);
   gold_assert(!from->is_forwarder() && !to->is_forwarder());
-  this->forwarders_[from] = to;
+  {
+    Hold_optional_lock hl(this->shared_lock_);
+    this->forwarders_[from] = to;
+  }
   from->set_forwarder();
 }
 
@@ -700,6 +732,8 @@ Symbol_table::resolve_forwards(const Symbol* from) const
 Symbol*
 Symbol_table::lookup(const char* name, const char* version) const
 {
+  gold_assert(this->queued_relobjs_.empty());
+
   Stringpool::Key name_key;
   name = this->namepool_.find(name, &name_key);
   if (name == NULL)
@@ -714,8 +748,9 @@ Symbol_table::lookup(const char* name, const char* version) const
     }
 
   Symbol_table_key key(name_key, version_key);
-  Symbol_table::Symbol_table_type::const_iterator p = this->table_.find(key);
-  if (p == this->table_.end())
+  const Symbol_table_type& table(this->name_table(name_key));
+  Symbol_table::Symbol_table_type::const_iterator p = table.find(key);
+  if (p == table.end())
     return NULL;
   return p->second;
 }
@@ -753,7 +788,7 @@ Symbol_table::resolve(Sized_symbol<size>* to, const Sized_symbol<size>* from)
 // by visibility.
 
 void
-Symbol_table::force_local(Symbol* sym)
+Symbol_table::force_local(Symbol* sym, Symbol_shard* shard)
 {
   if (!sym->is_defined() && !sym->is_common())
     return;
@@ -763,7 +798,10 @@ Symbol_table::force_local(Symbol* sym)
       return;
     }
   sym->set_is_forced_local();
-  this->forced_locals_.push_back(sym);
+  if (shard == NULL)
+    this->forced_locals_.push_back(sym);
+  else
+    shard->forced_locals.push_back(sym);
 }
 
 // Adjust NAME for wrapping, and update *NAME_KEY if necessary.  This
@@ -967,19 +1005,22 @@ Symbol_table::add_from_object(Object* object,
 	}
     }
 
+  Symbol_table_type& table(this->name_table(name_key));
+  Symbol_shard* shard = this->adding_shard(name_key);
+
   Symbol* const snull = NULL;
   std::pair<typename Symbol_table_type::iterator, bool> ins =
-    this->table_.insert(std::make_pair(std::make_pair(name_key, version_key),
-				       snull));
+    table.insert(std::make_pair(std::make_pair(name_key, version_key),
+				snull));
 
   std::pair<typename Symbol_table_type::iterator, bool> insdefault =
-    std::make_pair(this->table_.end(), false);
+    std::make_pair(table.end(), false);
   if (is_default_version)
     {
       const Stringpool::Key vnull_key = 0;
-      insdefault = this->table_.insert(std::make_pair(std::make_pair(name_key,
-								     vnull_key),
-						      snull));
+      insdefault = table.insert(std::make_pair(std::make_pair(name_key,
+							      vnull_key),
+					       snull));
     }
 
   // ins.first: an iterator, which is a pointer to a pair.
@@ -1032,7 +1073,7 @@ Symbol_table::add_from_object(Object* object,
 	      // (See PR gold/18703.)
 	      ret->set_is_not_default();
 	      const Stringpool::Key vnull_key = 0;
-	      this->table_.erase(std::make_pair(name_key, vnull_key));
+	      table.erase(std::make_pair(name_key, vnull_key));
 	    }
 	}
     }
@@ -1075,13 +1116,12 @@ Symbol_table::add_from_object(Object* object,
 		  // This means that we don't want a symbol table
 		  // entry after all.
 		  if (!is_default_version)
-		    this->table_.erase(ins.first);
+		    table.erase(ins.first);
 		  else
 		    {
-		      this->table_.erase(insdefault.first);
+		      table.erase(insdefault.first);
 		      // Inserting INSDEFAULT invalidated INS.
-		      this->table_.erase(std::make_pair(name_key,
-							version_key));
+		      table.erase(std::make_pair(name_key, version_key));
 		    }
 		  return NULL;
 		}
@@ -1107,7 +1147,10 @@ Symbol_table::add_from_object(Object* object,
   // archive groups.
   if (!was_undefined && ret->is_undefined())
     {
-      ++this->saw_undefined_;
+      if (shard == NULL)
+	++this->saw_undefined_;
+      else
+	++shard->saw_undefined;
       if (parameters->options().has_plugins())
 	parameters->options().plugins()->new_undefined_symbol(ret);
     }
@@ -1119,15 +1162,21 @@ Symbol_table::add_from_object(Object* object,
   if (!was_common && ret->is_common() && ret->object()->pluginobj() == NULL)
     {
       if (ret->type() == elfcpp::STT_TLS)
-	this->tls_commons_.push_back(ret);
+	(shard == NULL
+	 ? this->tls_commons_
+	 : shard->tls_commons).push_back(ret);
       else if (!is_ordinary
 	       && st_shndx == parameters->target().small_common_shndx())
-	this->small_commons_.push_back(ret);
+	(shard == NULL
+	 ? this->small_commons_
+	 : shard->small_commons).push_back(ret);
       else if (!is_ordinary
 	       && st_shndx == parameters->target().large_common_shndx())
-	this->large_commons_.push_back(ret);
+	(shard == NULL
+	 ? this->large_commons_
+	 : shard->large_commons).push_back(ret);
       else
-	this->commons_.push_back(ret);
+	(shard == NULL ? this->commons_ : shard->commons).push_back(ret);
     }
 
   // If we're not doing a relocatable link, then any symbol with
@@ -1138,12 +1187,21 @@ Symbol_table::add_from_object(Object* object,
 	  || ret->binding() == elfcpp::STB_GNU_UNIQUE
 	  || ret->binding() == elfcpp::STB_WEAK)
       && !parameters->options().relocatable())
-    this->force_local(ret);
+    this->force_local(ret, shard);
 
   return ret;
 }
 
+// The largest number of symbols which add_from_relobj queues before
+// it calls add_queued_symbols.  This bounds the memory used by the
+// copies of the symbols and names.
+
+static const size_t max_queued_symbols = 1 << 20;
+
 // Add all the symbols in a relocatable object to the hash table.
+// With --concurrent-symbol-table we normally just queue them, to be
+// added by add_queued_symbols along with the symbols of the objects
+// which follow.
 
 template<int size, bool big_endian>
 void
@@ -1154,6 +1212,7 @@ Symbol_table::add_from_relobj(
     size_t symndx_offset,
     const char* sym_names,
     size_t sym_name_size,
+    const Symbol_name_hash* name_hashes,
     typename Sized_relobj_file<size, big_endian>::Symbols* sympointers,
     size_t* defined)
 {
@@ -1163,189 +1222,502 @@ Symbol_table::add_from_relobj(
 
   const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
 
-  const bool just_symbols = relobj->just_symbols();
+  // We can only queue the symbols if they can be resolved without
+  // looking at the object file or at symbols with other names.
+  // Targets which make their own symbols or resolve them themselves
+  // may do either, and so may weak aliases from dynamic objects.
+  if (this->shared_lock_ != NULL
+      && name_hashes != NULL
+      && count > 0
+      && !relobj->just_symbols()
+      && this->weak_aliases_.empty()
+      && !parameters->target().has_make_symbol()
+      && !parameters->target().has_resolve())
+    {
+      Queued_relobj* q = new Queued_relobj();
+      q->relobj = relobj;
+      q->syms.assign(syms, syms + count * sym_size);
+      q->count = count;
+      q->symndx_offset = symndx_offset;
+      q->sym_names.assign(sym_names, sym_name_size);
+      q->name_hashes.assign(name_hashes, name_hashes + count);
+      q->first_ordinal = this->namepool_.reserve_ordinals(count);
+      q->sympointers = sympointers;
+      q->defined = defined;
+      this->queued_relobjs_.push_back(q);
+      this->queued_symbol_count_ += count;
+      if (this->queued_symbol_count_ >= max_queued_symbols)
+	this->add_queued_symbols();
+      return;
+    }
+
+  this->add_queued_symbols();
 
+  const uint64_t ordinal = this->namepool_.reserve_ordinals(count);
   const unsigned char* p = syms;
   for (size_t i = 0; i < count; ++i, p += sym_size)
-    {
-      (*sympointers)[i] = NULL;
+    if (this->add_relobj_symbol(relobj, p, i, symndx_offset, sym_names,
+				sym_name_size, name_hashes, ordinal + i,
+				sympointers))
+      ++*defined;
+}
 
-      elfcpp::Sym<size, big_endian> sym(p);
+// Add one external symbol from a relocatable object.  While
+// add_queued_symbols runs, this is called by several threads at once
+// for symbols whose names are in different shards.
 
-      unsigned int st_name = sym.get_st_name();
-      if (st_name >= sym_name_size)
-	{
-	  relobj->error(_("bad global symbol name offset %u at %zu"),
-			st_name, i);
-	  continue;
-	}
+template<int size, bool big_endian>
+bool
+Symbol_table::add_relobj_symbol(
+    Sized_relobj_file<size, big_endian>* relobj,
+    const unsigned char* p,
+    size_t i,
+    size_t symndx_offset,
+    const char* sym_names,
+    size_t sym_name_size,
+    const Symbol_name_hash* name_hashes,
+    uint64_t ordinal,
+    typename Sized_relobj_file<size, big_endian>::Symbols* sympointers)
+{
+  const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
 
-      const char* name = sym_names + st_name;
+  (*sympointers)[i] = NULL;
 
-      if (!parameters->options().relocatable()
-	  && strcmp (name, "__gnu_lto_slim") == 0)
-        gold_info(_("%s: plugin needed to handle lto object"),
-		  relobj->name().c_str());
+  elfcpp::Sym<size, big_endian> sym(p);
 
-      bool is_ordinary;
-      unsigned int st_shndx = relobj->adjust_sym_shndx(i + symndx_offset,
-						       sym.get_st_shndx(),
-						       &is_ordinary);
-      unsigned int orig_st_shndx = st_shndx;
-      if (!is_ordinary)
-	orig_st_shndx = elfcpp::SHN_UNDEF;
+  unsigned int st_name = sym.get_st_name();
+  if (st_name >= sym_name_size)
+    {
+      relobj->error(_("bad global symbol name offset %u at %zu"),
+		    st_name, i);
+      return false;
+    }
 
-      if (st_shndx != elfcpp::SHN_UNDEF)
-	++*defined;
+  const char* name = sym_names + st_name;
 
-      // A symbol defined in a section which we are not including must
-      // be treated as an undefined symbol.
-      bool is_defined_in_discarded_section = false;
-      if (st_shndx != elfcpp::SHN_UNDEF
-	  && is_ordinary
-	  && !relobj->is_section_included(st_shndx)
-          && !this->is_section_folded(relobj, st_shndx))
-	{
-	  st_shndx = elfcpp::SHN_UNDEF;
-	  is_defined_in_discarded_section = true;
-	}
+  if (!parameters->options().relocatable()
+      && strcmp (name, "__gnu_lto_slim") == 0)
+    gold_info(_("%s: plugin needed to handle lto object"),
+	      relobj->name().c_str());
 
-      // In an object file, an '@' in the name separates the symbol
-      // name from the version name.  If there are two '@' characters,
-      // this is the default version.
-      const char* ver = strchr(name, '@');
-      Stringpool::Key ver_key = 0;
-      int namelen = 0;
-      // IS_DEFAULT_VERSION: is the version default?
-      // IS_FORCED_LOCAL: is the symbol forced local?
-      bool is_default_version = false;
-      bool is_forced_local = false;
-
-      // FIXME: For incremental links, we don't store version information,
-      // so we need to ignore version symbols for now.
-      if (parameters->incremental_update() && ver != NULL)
+  bool is_ordinary;
+  unsigned int st_shndx = relobj->adjust_sym_shndx(i + symndx_offset,
+						   sym.get_st_shndx(),
+						   &is_ordinary);
+  unsigned int orig_st_shndx = st_shndx;
+  if (!is_ordinary)
+    orig_st_shndx = elfcpp::SHN_UNDEF;
+
+  const bool is_defined = st_shndx != elfcpp::SHN_UNDEF;
+
+  // A symbol defined in a section which we are not including must
+  // be treated as an undefined symbol.
+  bool is_defined_in_discarded_section = false;
+  if (st_shndx != elfcpp::SHN_UNDEF
+      && is_ordinary
+      && !relobj->is_section_included(st_shndx)
+      && !this->is_section_folded(relobj, st_shndx))
+    {
+      st_shndx = elfcpp::SHN_UNDEF;
+      is_defined_in_discarded_section = true;
+    }
+
+  // In an object file, an '@' in the name separates the symbol
+  // name from the version name.  If there are two '@' characters,
+  // this is the default version.
+  const char* ver;
+  if (name_hashes == NULL)
+    ver = strchr(name, '@');
+  else
+    {
+      const char* end = name + name_hashes[i].length;
+      ver = *end == '@' ? end : NULL;
+    }
+  Stringpool::Key ver_key = 0;
+  int namelen = 0;
+  // IS_DEFAULT_VERSION: is the version default?
+  // IS_FORCED_LOCAL: is the symbol forced local?
+  bool is_default_version = false;
+  bool is_forced_local = false;
+
+  // FIXME: For incremental links, we don't store version information,
+  // so we need to ignore version symbols for now.
+  if (parameters->incremental_update() && ver != NULL)
+    {
+      namelen = ver - name;
+      ver = NULL;
+    }
+
+  if (ver != NULL)
+    {
+      // The symbol name is of the form foo@VERSION or foo@@VERSION
+      namelen = ver - name;
+      ++ver;
+      if (*ver == '@')
 	{
-	  namelen = ver - name;
-	  ver = NULL;
+	  is_default_version = true;
+	  ++ver;
 	}
-
-      if (ver != NULL)
-        {
-          // The symbol name is of the form foo@VERSION or foo@@VERSION
-          namelen = ver - name;
-          ++ver;
-	  if (*ver == '@')
-	    {
-	      is_default_version = true;
-	      ++ver;
-	    }
-	  ver = this->namepool_.add(ver, true, &ver_key);
-        }
-      // We don't want to assign a version to an undefined symbol,
-      // even if it is listed in the version script.  FIXME: What
-      // about a common symbol?
+      ver = this->namepool_.add_with_ordinal(ver, strlen(ver), ordinal, true,
+					     &ver_key);
+    }
+  // We don't want to assign a version to an undefined symbol,
+  // even if it is listed in the version script.  FIXME: What
+  // about a common symbol?
+  else
+    {
+      if (name_hashes != NULL && name[name_hashes[i].length] == '\0')
+	namelen = name_hashes[i].length;
       else
+	namelen = strlen(name);
+      if (!this->version_script_.empty()
+	  && st_shndx != elfcpp::SHN_UNDEF)
 	{
-	  namelen = strlen(name);
-	  if (!this->version_script_.empty()
-	      && st_shndx != elfcpp::SHN_UNDEF)
+	  // The symbol name did not have a version, but the
+	  // version script may assign a version anyway.
+	  std::string version;
+	  bool is_global;
+	  bool found;
+	  {
+	    Hold_optional_lock hl(this->shared_lock_);
+	    found = this->version_script_.get_symbol_version(name, &version,
+							     &is_global);
+	  }
+	  if (found)
 	    {
-	      // The symbol name did not have a version, but the
-	      // version script may assign a version anyway.
-	      std::string version;
-	      bool is_global;
-	      if (this->version_script_.get_symbol_version(name, &version,
-							   &is_global))
+	      if (!is_global)
+		is_forced_local = true;
+	      else if (!version.empty())
 		{
-		  if (!is_global)
-		    is_forced_local = true;
-		  else if (!version.empty())
-		    {
-		      ver = this->namepool_.add_with_length(version.c_str(),
-							    version.length(),
-							    true,
-							    &ver_key);
-		      is_default_version = true;
-		    }
+		  ver = this->namepool_.add_with_ordinal(version.c_str(),
+							 version.length(),
+							 ordinal, true,
+							 &ver_key);
+		  is_default_version = true;
 		}
 	    }
 	}
+    }
 
-      elfcpp::Sym<size, big_endian>* psym = &sym;
-      unsigned char symbuf[sym_size];
-      elfcpp::Sym<size, big_endian> sym2(symbuf);
-      if (just_symbols)
+  elfcpp::Sym<size, big_endian>* psym = &sym;
+  unsigned char symbuf[sym_size];
+  elfcpp::Sym<size, big_endian> sym2(symbuf);
+  if (relobj->just_symbols())
+    {
+      memcpy(symbuf, p, sym_size);
+      elfcpp::Sym_write<size, big_endian> sw(symbuf);
+      if (orig_st_shndx != elfcpp::SHN_UNDEF
+	  && is_ordinary
+	  && relobj->e_type() == elfcpp::ET_REL)
+	{
+	  // Symbol values in relocatable object files are section
+	  // relative.  This is normally what we want, but since here
+	  // we are converting the symbol to absolute we need to add
+	  // the section address.  The section address in an object
+	  // file is normally zero, but people can use a linker
+	  // script to change it.
+	  sw.put_st_value(sym.get_st_value()
+			  + relobj->section_address(orig_st_shndx));
+	}
+      st_shndx = elfcpp::SHN_ABS;
+      is_ordinary = false;
+      psym = &sym2;
+    }
+
+  // Fix up visibility if object has no-export set.
+  if (relobj->no_export()
+      && (orig_st_shndx != elfcpp::SHN_UNDEF || !is_ordinary))
+    {
+      // We may have copied symbol already above.
+      if (psym != &sym2)
 	{
 	  memcpy(symbuf, p, sym_size);
-	  elfcpp::Sym_write<size, big_endian> sw(symbuf);
-	  if (orig_st_shndx != elfcpp::SHN_UNDEF
-	      && is_ordinary
-	      && relobj->e_type() == elfcpp::ET_REL)
-	    {
-	      // Symbol values in relocatable object files are section
-	      // relative.  This is normally what we want, but since here
-	      // we are converting the symbol to absolute we need to add
-	      // the section address.  The section address in an object
-	      // file is normally zero, but people can use a linker
-	      // script to change it.
-	      sw.put_st_value(sym.get_st_value()
-			      + relobj->section_address(orig_st_shndx));
-	    }
-	  st_shndx = elfcpp::SHN_ABS;
-	  is_ordinary = false;
 	  psym = &sym2;
 	}
 
-      // Fix up visibility if object has no-export set.
-      if (relobj->no_export()
-	  && (orig_st_shndx != elfcpp::SHN_UNDEF || !is_ordinary))
-        {
-	  // We may have copied symbol already above.
-	  if (psym != &sym2)
-	    {
-	      memcpy(symbuf, p, sym_size);
-	      psym = &sym2;
-	    }
+      elfcpp::STV visibility = sym2.get_st_visibility();
+      if (visibility == elfcpp::STV_DEFAULT
+	  || visibility == elfcpp::STV_PROTECTED)
+	{
+	  elfcpp::Sym_write<size, big_endian> sw(symbuf);
+	  unsigned char nonvis = sym2.get_st_nonvis();
+	  sw.put_st_other(elfcpp::STV_HIDDEN, nonvis);
+	}
+    }
 
-	  elfcpp::STV visibility = sym2.get_st_visibility();
-	  if (visibility == elfcpp::STV_DEFAULT
-	      || visibility == elfcpp::STV_PROTECTED)
-	    {
-	      elfcpp::Sym_write<size, big_endian> sw(symbuf);
-	      unsigned char nonvis = sym2.get_st_nonvis();
-	      sw.put_st_other(elfcpp::STV_HIDDEN, nonvis);
-	    }
-        }
+  Stringpool::Key name_key;
+  if (name_hashes == NULL
+      || static_cast<size_t>(namelen) != name_hashes[i].length)
+    name = this->namepool_.add_with_ordinal(name, namelen, ordinal, true,
+					    &name_key);
+  else
+    name = this->namepool_.add_prehashed_with_ordinal(name, namelen,
+						      name_hashes[i].hash_code,
+						      ordinal, true,
+						      &name_key);
 
-      Stringpool::Key name_key;
-      name = this->namepool_.add_with_length(name, namelen, true,
-					     &name_key);
+  Sized_symbol<size>* res;
+  res = this->add_from_object(relobj, name, name_key, ver, ver_key,
+			      is_default_version, *psym, st_shndx,
+			      is_ordinary, orig_st_shndx);
 
-      Sized_symbol<size>* res;
-      res = this->add_from_object(relobj, name, name_key, ver, ver_key,
-				  is_default_version, *psym, st_shndx,
-				  is_ordinary, orig_st_shndx);
-      
-      if (is_forced_local)
-	this->force_local(res);
+  if (is_forced_local)
+    this->force_local(res, this->adding_shard(name_key));
+
+  // Do not treat this symbol as garbage if this symbol will be
+  // exported to the dynamic symbol table.  This is true when
+  // building a shared library or using --export-dynamic and
+  // the symbol is externally visible.
+  if (parameters->options().gc_sections()
+      && res->is_externally_visible()
+      && !res->is_from_dynobj()
+      && (parameters->options().shared()
+	  || parameters->options().export_dynamic()
+	  || parameters->options().in_dynamic_list(res->name())))
+    this->gc_mark_symbol(res);
+
+  if (is_defined_in_discarded_section)
+    res->set_is_defined_in_discarded_section();
+
+  (*sympointers)[i] = res;
+
+  return is_defined;
+}
+
+// The Parallel_jobs which sort the symbols of the objects queued by
+// add_from_relobj by shard.  Job I handles the I'th object.
+
+template<int size, bool big_endian>
+class Symbol_table::Sort_queued_symbols_jobs : public Parallel_jobs
+{
+ public:
+  Sort_queued_symbols_jobs(const Symbol_table* symtab,
+			   const Queued_relobjs& queued_relobjs)
+    : symtab_(symtab), queued_relobjs_(queued_relobjs)
+  { }
+
+ protected:
+  void
+  do_run_job(unsigned int index)
+  {
+    this->symtab_->sort_queued_symbols<size, big_endian>(
+	this->queued_relobjs_[index]);
+  }
 
-      // Do not treat this symbol as garbage if this symbol will be
-      // exported to the dynamic symbol table.  This is true when
-      // building a shared library or using --export-dynamic and
-      // the symbol is externally visible.
-      if (parameters->options().gc_sections()
-	  && res->is_externally_visible()
-	  && !res->is_from_dynobj()
-          && (parameters->options().shared()
-	      || parameters->options().export_dynamic()
-	      || parameters->options().in_dynamic_list(res->name())))
-        this->gc_mark_symbol(res);
+ private:
+  const Symbol_table* symtab_;
+  const Queued_relobjs& queued_relobjs_;
+};
 
-      if (is_defined_in_discarded_section)
-	res->set_is_defined_in_discarded_section();
+// The Parallel_jobs which add the symbols of the queued objects.  Job
+// I adds the symbols whose names are in the I'th shard, in the order
+// of the objects and of the symbols within each object.  Since all
+// the symbols with the same name are in the same shard, they are
+// resolved in the same order as when adding one object at a time.
 
-      (*sympointers)[i] = res;
+template<int size, bool big_endian>
+class Symbol_table::Add_queued_symbols_jobs : public Parallel_jobs
+{
+ public:
+  Add_queued_symbols_jobs(Symbol_table* symtab,
+			  const Queued_relobjs& queued_relobjs)
+    : symtab_(symtab), queued_relobjs_(queued_relobjs)
+  { }
+
+ protected:
+  void
+  do_run_job(unsigned int index)
+  {
+    const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
+    for (Queued_relobjs::const_iterator p = this->queued_relobjs_.begin();
+	 p != this->queued_relobjs_.end();
+	 ++p)
+      {
+	const Queued_relobj* q = *p;
+	Sized_relobj_file<size, big_endian>* relobj =
+	  static_cast<Sized_relobj_file<size, big_endian>*>(q->relobj);
+	for (size_t j = q->shard_starts[index];
+	     j < q->shard_starts[index + 1];
+	     ++j)
+	  {
+	    const size_t i = q->shard_symndx[j];
+	    this->symtab_->add_relobj_symbol(relobj, &q->syms[i * sym_size], i,
+					     q->symndx_offset,
+					     q->sym_names.data(),
+					     q->sym_names.size(),
+					     &q->name_hashes[0],
+					     q->first_ordinal + i,
+					     q->sympointers);
+	  }
+      }
+  }
+
+ private:
+  Symbol_table* symtab_;
+  const Queued_relobjs& queued_relobjs_;
+};
+
+// Sort the symbols of the queued object Q by the shard which holds
+// their names, and count the defined symbols as add_relobj_symbol
+// would.  A symbol with a bad name goes in shard 0, where
+// add_relobj_symbol reports the error.
+
+template<int size, bool big_endian>
+void
+Symbol_table::sort_queued_symbols(Queued_relobj* q) const
+{
+  const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
+  const unsigned int shard_count = this->tables_.size();
+
+  std::vector<unsigned int> shards(q->count);
+  q->shard_starts.assign(shard_count + 1, 0);
+  size_t defined = 0;
+  const unsigned char* p = &q->syms[0];
+  for (size_t i = 0; i < q->count; ++i, p += sym_size)
+    {
+      elfcpp::Sym<size, big_endian> sym(p);
+      unsigned int shard = 0;
+      unsigned int st_name = sym.get_st_name();
+      if (st_name < q->sym_names.size())
+	{
+	  shard = this->namepool_.shard_index(q->name_hashes[i].hash_code);
+	  if (sym.get_st_shndx() != elfcpp::SHN_UNDEF)
+	    ++defined;
+	  if (q->sym_names[st_name + q->name_hashes[i].length] == '@')
+	    q->versioned.push_back(i);
+	}
+      shards[i] = shard;
+      ++q->shard_starts[shard + 1];
     }
+
+  for (unsigned int i = 0; i < shard_count; ++i)
+    q->shard_starts[i + 1] += q->shard_starts[i];
+
+  std::vector<size_t> next(q->shard_starts.begin(),
+			   q->shard_starts.end() - 1);
+  q->shard_symndx.resize(q->count);
+  for (size_t i = 0; i < q->count; ++i)
+    q->shard_symndx[next[shards[i]]++] = i;
+
+  *q->defined = defined;
+}
+
+// Add the symbols queued by add_from_relobj.
+
+void
+Symbol_table::add_queued_symbols()
+{
+  if (this->queued_relobjs_.empty())
+    return;
+
+  switch (parameters->size_and_endianness())
+    {
+#ifdef HAVE_TARGET_32_LITTLE
+    case Parameters::TARGET_32_LITTLE:
+      this->sized_add_queued_symbols<32, false>();
+      break;
+#endif
+#ifdef HAVE_TARGET_32_BIG
+    case Parameters::TARGET_32_BIG:
+      this->sized_add_queued_symbols<32, true>();
+      break;
+#endif
+#ifdef HAVE_TARGET_64_LITTLE
+    case Parameters::TARGET_64_LITTLE:
+      this->sized_add_queued_symbols<64, false>();
+      break;
+#endif
+#ifdef HAVE_TARGET_64_BIG
+    case Parameters::TARGET_64_BIG:
+      this->sized_add_queued_symbols<64, true>();
+      break;
+#endif
+    default:
+      gold_unreachable();
+    }
+}
+
+// Add the symbols queued by add_from_relobj, sized version.  Only the
+// jobs which add the symbols of each shard touch the symbol table
+// concurrently.  Everything which does not depend on the shard is
+// done here in the order of the objects, so that the result does not
+// depend on the number of threads.
+
+template<int size, bool big_endian>
+void
+Symbol_table::sized_add_queued_symbols()
+{
+  const int sym_size = elfcpp::Elf_sizes<size>::sym_size;
+  const unsigned int shard_count = this->tables_.size();
+
+  Sort_queued_symbols_jobs<size, big_endian> sort_jobs(this,
+						       this->queued_relobjs_);
+  sort_jobs.run(this->queued_relobjs_.size());
+
+  // The keys of the names in each shard of the namepool must be
+  // assigned in the same order every time.  The jobs only add names
+  // to their own shard, but versions may be in any shard, so add
+  // those first.
+  for (Queued_relobjs::const_iterator p = this->queued_relobjs_.begin();
+       p != this->queued_relobjs_.end();
+       ++p)
+    {
+      const Queued_relobj* q = *p;
+      for (std::vector<unsigned int>::const_iterator v = q->versioned.begin();
+	   v != q->versioned.end();
+	   ++v)
+	{
+	  elfcpp::Sym<size, big_endian> sym(&q->syms[*v * sym_size]);
+	  const char* ver = (q->sym_names.data() + sym.get_st_name()
+			     + q->name_hashes[*v].length + 1);
+	  if (*ver == '@')
+	    ++ver;
+	  this->namepool_.add_with_ordinal(ver, strlen(ver),
+					   q->first_ordinal + *v, true, NULL);
+	}
+    }
+  if (!this->version_script_.empty())
+    {
+      std::vector<std::string> versions = this->version_script_.get_versions();
+      for (std::vector<std::string>::const_iterator p = versions.begin();
+	   p != versions.end();
+	   ++p)
+	this->namepool_.add(*p, true, NULL);
+    }
+
+  this->adding_shards_ = new Symbol_shard[shard_count];
+  Add_queued_symbols_jobs<size, big_endian> add_jobs(this,
+						     this->queued_relobjs_);
+  add_jobs.run(shard_count);
+
+  for (unsigned int i = 0; i < shard_count; ++i)
+    {
+      const Symbol_shard& shard(this->adding_shards_[i]);
+      this->saw_undefined_ += shard.saw_undefined;
+      this->commons_.insert(this->commons_.end(), shard.commons.begin(),
+			    shard.commons.end());
+      this->tls_commons_.insert(this->tls_commons_.end(),
+				shard.tls_commons.begin(),
+				shard.tls_commons.end());
+      this->small_commons_.insert(this->small_commons_.end(),
+				  shard.small_commons.begin(),
+				  shard.small_commons.end());
+      this->large_commons_.insert(this->large_commons_.end(),
+				  shard.large_commons.begin(),
+				  shard.large_commons.end());
+      this->forced_locals_.insert(this->forced_locals_.end(),
+				  shard.forced_locals.begin(),
+				  shard.forced_locals.end());
+    }
+  delete[] this->adding_shards_;
+  this->adding_shards_ = NULL;
+
+  for (Queued_relobjs::iterator p = this->queued_relobjs_.begin();
+       p != this->queued_relobjs_.end();
+       ++p)
+    delete *p;
+  this->queued_relobjs_.clear();
+  this->queued_symbol_count_ = 0;
 }
 
 // Add a symbol from a plugin-claimed file.
@@ -1432,6 +1804,8 @@ Symbol_table::add_from_dynobj(
 
   gold_assert(size == parameters->target().get_size());
 
+  this->add_queued_symbols();
+
   if (dynobj->just_symbols())
     {
       gold_error(_("--just-symbols does not make sense with a shared object"));
@@ -1781,9 +2155,9 @@ Symbol_table::define_special_symbol(const char** pname, const char** pversion,
   Sized_symbol<size>* sym;
 
   bool add_to_table = false;
-  typename Symbol_table_type::iterator add_loc = this->table_.end();
+  typename Symbol_table_type::iterator add_loc;
   bool add_def_to_table = false;
-  typename Symbol_table_type::iterator add_def_loc = this->table_.end();
+  typename Symbol_table_type::iterator add_def_loc;
 
   if (only_if_ref)
     {
@@ -1809,21 +2183,20 @@ Symbol_table::define_special_symbol(const char** pname, const char** pversion,
       if (*pversion != NULL)
 	*pversion = this->namepool_.add(*pversion, true, &version_key);
 
+      Symbol_table_type& table(this->name_table(name_key));
       Symbol* const snull = NULL;
       std::pair<typename Symbol_table_type::iterator, bool> ins =
-	this->table_.insert(std::make_pair(std::make_pair(name_key,
-							  version_key),
-					   snull));
+	table.insert(std::make_pair(std::make_pair(name_key, version_key),
+				    snull));
 
       std::pair<typename Symbol_table_type::iterator, bool> insdefault =
-	std::make_pair(this->table_.end(), false);
+	std::make_pair(table.end(), false);
       if (is_default_version)
 	{
 	  const Stringpool::Key vnull = 0;
-	  insdefault =
-	    this->table_.insert(std::make_pair(std::make_pair(name_key,
-							      vnull),
-					       snull));
+	  insdefault = table.insert(std::make_pair(std::make_pair(name_key,
+								  vnull),
+						   snull));
 	}
 
       if (!ins.second)
@@ -2478,63 +2851,69 @@ Symbol_table::set_dynsym_indexes(unsigned int index,
   if (parameters->target().has_custom_set_dynsym_indexes())
     {
       std::vector<Symbol*> dyn_symbols;
-      for (Symbol_table_type::iterator p = this->table_.begin();
-           p != this->table_.end();
-           ++p)
-        {
-          Symbol* sym = p->second;
-          if (!sym->should_add_dynsym_entry(this))
-            sym->set_dynsym_index(-1U);
-          else
-            dyn_symbols.push_back(sym);
-        }
+      for (Symbol_tables::iterator t = this->tables_.begin();
+	   t != this->tables_.end();
+	   ++t)
+	for (Symbol_table_type::iterator p = t->begin();
+	     p != t->end();
+	     ++p)
+	  {
+	    Symbol* sym = p->second;
+	    if (!sym->should_add_dynsym_entry(this))
+	      sym->set_dynsym_index(-1U);
+	    else
+	      dyn_symbols.push_back(sym);
+	  }
 
       return parameters->target().set_dynsym_indexes(&dyn_symbols, index, syms,
                                                      dynpool, versions, this);
     }
 
-  for (Symbol_table_type::iterator p = this->table_.begin();
-       p != this->table_.end();
-       ++p)
-    {
-      Symbol* sym = p->second;
+  for (Symbol_tables::iterator t = this->tables_.begin();
+       t != this->tables_.end();
+       ++t)
+    for (Symbol_table_type::iterator p = t->begin();
+	 p != t->end();
+	 ++p)
+      {
+	Symbol* sym = p->second;
 
-      // Note that SYM may already have a dynamic symbol index, since
-      // some symbols appear more than once in the symbol table, with
-      // and without a version.
+	// Note that SYM may already have a dynamic symbol index, since
+	// some symbols appear more than once in the symbol table, with
+	// and without a version.
 
-      if (!sym->should_add_dynsym_entry(this))
-	sym->set_dynsym_index(-1U);
-      else if (!sym->has_dynsym_index())
-	{
-	  sym->set_dynsym_index(index);
-	  ++index;
-	  syms->push_back(sym);
-	  dynpool->add(sym->name(), false, NULL);
-
-	  // If the symbol is defined in a dynamic object and is
-	  // referenced strongly in a regular object, then mark the
-	  // dynamic object as needed.  This is used to implement
-	  // --as-needed.
-	  if (sym->is_from_dynobj()
-	      && sym->in_reg()
-	      && !sym->is_undef_binding_weak())
-	    sym->object()->set_is_needed();
-
-	  // Record any version information, except those from
-	  // as-needed libraries not seen to be needed.  Note that the
-	  // is_needed state for such libraries can change in this loop.
-	  if (sym->version() != NULL)
-	    {
-	      if (!sym->is_from_dynobj()
-		  || !sym->object()->as_needed()
-		  || sym->object()->is_needed())
-		versions->record_version(this, dynpool, sym);
-	      else
-		as_needed_sym.push_back(sym);
-	    }
-	}
-    }
+	if (!sym->should_add_dynsym_entry(this))
+	  sym->set_dynsym_index(-1U);
+	else if (!sym->has_dynsym_index())
+	  {
+	    sym->set_dynsym_index(index);
+	    ++index;
+	    syms->push_back(sym);
+	    dynpool->add(sym->name(), false, NULL);
+
+	    // If the symbol is defined in a dynamic object and is
+	    // referenced strongly in a regular object, then mark the
+	    // dynamic object as needed.  This is used to implement
+	    // --as-needed.
+	    if (sym->is_from_dynobj()
+		&& sym->in_reg()
+		&& !sym->is_undef_binding_weak())
+	      sym->object()->set_is_needed();
+
+	    // Record any version information, except those from
+	    // as-needed libraries not seen to be needed.  Note that the
+	    // is_needed state for such libraries can change in this loop.
+	    if (sym->version() != NULL)
+	      {
+		if (!sym->is_from_dynobj()
+		    || !sym->object()->as_needed()
+		    || sym->object()->is_needed())
+		  versions->record_version(this, dynpool, sym);
+		else
+		  as_needed_sym.push_back(sym);
+	      }
+	  }
+      }
 
   // Process version information for symbols from as-needed libraries.
   for (std::vector<Symbol*>::iterator p = as_needed_sym.begin();
@@ -2660,14 +3039,17 @@ Symbol_table::sized_finalize(off_t off, Stringpool* pool,
     }
 
   // Now do all the remaining symbols.
-  for (Symbol_table_type::iterator p = this->table_.begin();
-       p != this->table_.end();
-       ++p)
-    {
-      Symbol* sym = p->second;
-      if (this->sized_finalize_symbol<size>(sym))
-	this->add_to_final_symtab<size>(sym, pool, &index, &off);
-    }
+  for (Symbol_tables::iterator t = this->tables_.begin();
+       t != this->tables_.end();
+       ++t)
+    for (Symbol_table_type::iterator p = t->begin();
+	 p != t->end();
+	 ++p)
+      {
+	Symbol* sym = p->second;
+	if (this->sized_finalize_symbol<size>(sym))
+	  this->add_to_final_symtab<size>(sym, pool, &index, &off);
+      }
 
   // Now do target-specific symbols.
   for (std::vector<Symbol*>::iterator p = this->target_symbols_.begin();
@@ -2976,175 +3358,178 @@ Symbol_table::sized_write_globals(const Stringpool* sympool,
   else
     dynamic_view = of->get_output_view(this->dynamic_offset_, dynamic_size);
 
-  for (Symbol_table_type::const_iterator p = this->table_.begin();
-       p != this->table_.end();
-       ++p)
-    {
-      Sized_symbol<size>* sym = static_cast<Sized_symbol<size>*>(p->second);
+  for (Symbol_tables::const_iterator t = this->tables_.begin();
+       t != this->tables_.end();
+       ++t)
+    for (Symbol_table_type::const_iterator p = t->begin();
+	 p != t->end();
+	 ++p)
+      {
+	Sized_symbol<size>* sym = static_cast<Sized_symbol<size>*>(p->second);
 
-      // Possibly warn about unresolved symbols in shared libraries.
-      this->warn_about_undefined_dynobj_symbol(sym);
+	// Possibly warn about unresolved symbols in shared libraries.
+	this->warn_about_undefined_dynobj_symbol(sym);
 
-      unsigned int sym_index = sym->symtab_index();
-      unsigned int dynsym_index;
-      if (dynamic_view == NULL)
-	dynsym_index = -1U;
-      else
-	dynsym_index = sym->dynsym_index();
+	unsigned int sym_index = sym->symtab_index();
+	unsigned int dynsym_index;
+	if (dynamic_view == NULL)
+	  dynsym_index = -1U;
+	else
+	  dynsym_index = sym->dynsym_index();
 
-      if (sym_index == -1U && dynsym_index == -1U)
-	{
-	  // This symbol is not included in the output file.
-	  continue;
-	}
+	if (sym_index == -1U && dynsym_index == -1U)
+	  {
+	    // This symbol is not included in the output file.
+	    continue;
+	  }
 
-      unsigned int shndx;
-      typename elfcpp::Elf_types<size>::Elf_Addr sym_value = sym->value();
-      typename elfcpp::Elf_types<size>::Elf_Addr dynsym_value = sym_value;
-      elfcpp::STB binding = sym->binding();
-
-      // If --weak-unresolved-symbols is set, change binding of unresolved
-      // global symbols to STB_WEAK.
-      if (parameters->options().weak_unresolved_symbols()
-	  && binding == elfcpp::STB_GLOBAL
-	  && sym->is_undefined())
-	binding = elfcpp::STB_WEAK;
-
-      // If --no-gnu-unique is set, change STB_GNU_UNIQUE to STB_GLOBAL.
-      if (binding == elfcpp::STB_GNU_UNIQUE
-	  && !parameters->options().gnu_unique())
-	binding = elfcpp::STB_GLOBAL;
+	unsigned int shndx;
+	typename elfcpp::Elf_types<size>::Elf_Addr sym_value = sym->value();
+	typename elfcpp::Elf_types<size>::Elf_Addr dynsym_value = sym_value;
+	elfcpp::STB binding = sym->binding();
 
-      switch (sym->source())
-	{
-	case Symbol::FROM_OBJECT:
+	// If --weak-unresolved-symbols is set, change binding of unresolved
+	// global symbols to STB_WEAK.
+	if (parameters->options().weak_unresolved_symbols()
+	    && binding == elfcpp::STB_GLOBAL
+	    && sym->is_undefined())
+	  binding = elfcpp::STB_WEAK;
+
+	// If --no-gnu-unique is set, change STB_GNU_UNIQUE to STB_GLOBAL.
+	if (binding == elfcpp::STB_GNU_UNIQUE
+	    && !parameters->options().gnu_unique())
+	  binding = elfcpp::STB_GLOBAL;
+
+	switch (sym->source())
 	  {
-	    bool is_ordinary;
-	    unsigned int in_shndx = sym->shndx(&is_ordinary);
+	  case Symbol::FROM_OBJECT:
+	    {
+	      bool is_ordinary;
+	      unsigned int in_shndx = sym->shndx(&is_ordinary);
 
-	    if (!is_ordinary
-		&& in_shndx != elfcpp::SHN_ABS
-		&& !Symbol::is_common_shndx(in_shndx))
-	      {
-		gold_error(_("%s: unsupported symbol section 0x%x"),
-			   sym->demangled_name().c_str(), in_shndx);
-		shndx = in_shndx;
-	      }
-	    else
-	      {
-		Object* symobj = sym->object();
-		if (symobj->is_dynamic())
-		  {
-		    if (sym->needs_dynsym_value())
-		      dynsym_value = target.dynsym_value(sym);
-		    shndx = elfcpp::SHN_UNDEF;
-		    if (sym->is_undef_binding_weak())
-		      binding = elfcpp::STB_WEAK;
-		    else
-		      binding = elfcpp::STB_GLOBAL;
-		  }
-		else if (symobj->pluginobj() != NULL)
-		  shndx = elfcpp::SHN_UNDEF;
-		else if (in_shndx == elfcpp::SHN_UNDEF
-			 || (!is_ordinary
-			     && (in_shndx == elfcpp::SHN_ABS
-				 || Symbol::is_common_shndx(in_shndx))))
+	      if (!is_ordinary
+		  && in_shndx != elfcpp::SHN_ABS
+		  && !Symbol::is_common_shndx(in_shndx))
+		{
+		  gold_error(_("%s: unsupported symbol section 0x%x"),
+			     sym->demangled_name().c_str(), in_shndx);
 		  shndx = in_shndx;
-		else
-		  {
-		    Relobj* relobj = static_cast<Relobj*>(symobj);
-		    Output_section* os = relobj->output_section(in_shndx);
-                    if (this->is_section_folded(relobj, in_shndx))
-                      {
-                        // This global symbol must be written out even though
-                        // it is folded.
-                        // Get the os of the section it is folded onto.
-                        Section_id folded =
-                             this->icf_->get_folded_section(relobj, in_shndx);
-                        gold_assert(folded.first !=NULL);
-                        Relobj* folded_obj = 
-                          reinterpret_cast<Relobj*>(folded.first);
-                        os = folded_obj->output_section(folded.second);  
-                        gold_assert(os != NULL);
-                      }
-		    gold_assert(os != NULL);
-		    shndx = os->out_shndx();
-
-		    if (shndx >= elfcpp::SHN_LORESERVE)
-		      {
-			if (sym_index != -1U)
-			  symtab_xindex->add(sym_index, shndx);
-			if (dynsym_index != -1U)
-			  dynsym_xindex->add(dynsym_index, shndx);
-			shndx = elfcpp::SHN_XINDEX;
-		      }
-
-		    // In object files symbol values are section
-		    // relative.
-		    if (parameters->options().relocatable())
-		      sym_value -= os->address();
-		  }
-	      }
-	  }
-	  break;
+		}
+	      else
+		{
+		  Object* symobj = sym->object();
+		  if (symobj->is_dynamic())
+		    {
+		      if (sym->needs_dynsym_value())
+			dynsym_value = target.dynsym_value(sym);
+		      shndx = elfcpp::SHN_UNDEF;
+		      if (sym->is_undef_binding_weak())
+			binding = elfcpp::STB_WEAK;
+		      else
+			binding = elfcpp::STB_GLOBAL;
+		    }
+		  else if (symobj->pluginobj() != NULL)
+		    shndx = elfcpp::SHN_UNDEF;
+		  else if (in_shndx == elfcpp::SHN_UNDEF
+			   || (!is_ordinary
+			       && (in_shndx == elfcpp::SHN_ABS
+				   || Symbol::is_common_shndx(in_shndx))))
+		    shndx = in_shndx;
+		  else
+		    {
+		      Relobj* relobj = static_cast<Relobj*>(symobj);
+		      Output_section* os = relobj->output_section(in_shndx);
+		      if (this->is_section_folded(relobj, in_shndx))
+			{
+			  // This global symbol must be written out even though
+			  // it is folded.
+			  // Get the os of the section it is folded onto.
+			  Section_id folded =
+			       this->icf_->get_folded_section(relobj, in_shndx);
+			  gold_assert(folded.first !=NULL);
+			  Relobj* folded_obj = 
+			    reinterpret_cast<Relobj*>(folded.first);
+			  os = folded_obj->output_section(folded.second);  
+			  gold_assert(os != NULL);
+			}
+		      gold_assert(os != NULL);
+		      shndx = os->out_shndx();
+
+		      if (shndx >= elfcpp::SHN_LORESERVE)
+			{
+			  if (sym_index != -1U)
+			    symtab_xindex->add(sym_index, shndx);
+			  if (dynsym_index != -1U)
+			    dynsym_xindex->add(dynsym_index, shndx);
+			  shndx = elfcpp::SHN_XINDEX;
+			}
+
+		      // In object files symbol values are section
+		      // relative.
+		      if (parameters->options().relocatable())
+			sym_value -= os->address();
+		    }
+		}
+	    }
+	    break;
 
-	case Symbol::IN_OUTPUT_DATA:
-	  {
-	    Output_data* od = sym->output_data();
+	  case Symbol::IN_OUTPUT_DATA:
+	    {
+	      Output_data* od = sym->output_data();
 
-	    shndx = od->out_shndx();
-	    if (shndx >= elfcpp::SHN_LORESERVE)
-	      {
-		if (sym_index != -1U)
-		  symtab_xindex->add(sym_index, shndx);
-		if (dynsym_index != -1U)
-		  dynsym_xindex->add(dynsym_index, shndx);
-		shndx = elfcpp::SHN_XINDEX;
-	      }
+	      shndx = od->out_shndx();
+	      if (shndx >= elfcpp::SHN_LORESERVE)
+		{
+		  if (sym_index != -1U)
+		    symtab_xindex->add(sym_index, shndx);
+		  if (dynsym_index != -1U)
+		    dynsym_xindex->add(dynsym_index, shndx);
+		  shndx = elfcpp::SHN_XINDEX;
+		}
 
-	    // In object files symbol values are section
-	    // relative.
-	    if (parameters->options().relocatable())
-	      sym_value -= od->address();
-	  }
-	  break;
+	      // In object files symbol values are section
+	      // relative.
+	      if (parameters->options().relocatable())
+		sym_value -= od->address();
+	    }
+	    break;
 
-	case Symbol::IN_OUTPUT_SEGMENT:
-	  shndx = elfcpp::SHN_ABS;
-	  break;
+	  case Symbol::IN_OUTPUT_SEGMENT:
+	    shndx = elfcpp::SHN_ABS;
+	    break;
 
-	case Symbol::IS_CONSTANT:
-	  shndx = elfcpp::SHN_ABS;
-	  break;
+	  case Symbol::IS_CONSTANT:
+	    shndx = elfcpp::SHN_ABS;
+	    break;
 
-	case Symbol::IS_UNDEFINED:
-	  shndx = elfcpp::SHN_UNDEF;
-	  break;
+	  case Symbol::IS_UNDEFINED:
+	    shndx = elfcpp::SHN_UNDEF;
+	    break;
 
-	default:
-	  gold_unreachable();
-	}
+	  default:
+	    gold_unreachable();
+	  }
 
-      if (sym_index != -1U)
-	{
-	  sym_index -= first_global_index;
-	  gold_assert(sym_index < output_count);
-	  unsigned char* ps = psyms + (sym_index * sym_size);
-	  this->sized_write_symbol<size, big_endian>(sym, sym_value, shndx,
-						     binding, sympool, ps);
-	}
+	if (sym_index != -1U)
+	  {
+	    sym_index -= first_global_index;
+	    gold_assert(sym_index < output_count);
+	    unsigned char* ps = psyms + (sym_index * sym_size);
+	    this->sized_write_symbol<size, big_endian>(sym, sym_value, shndx,
+						       binding, sympool, ps);
+	  }
 
-      if (dynsym_index != -1U)
-	{
-	  dynsym_index -= first_dynamic_global_index;
-	  gold_assert(dynsym_index < dynamic_count);
-	  unsigned char* pd = dynamic_view + (dynsym_index * sym_size);
-	  this->sized_write_symbol<size, big_endian>(sym, dynsym_value, shndx,
-						     binding, dynpool, pd);
-          // Allow a target to adjust dynamic symbol value.
-          parameters->target().adjust_dyn_symbol(sym, pd);
-	}
-    }
+	if (dynsym_index != -1U)
+	  {
+	    dynsym_index -= first_dynamic_global_index;
+	    gold_assert(dynsym_index < dynamic_count);
+	    unsigned char* pd = dynamic_view + (dynsym_index * sym_size);
+	    this->sized_write_symbol<size, big_endian>(sym, dynsym_value, shndx,
+						       binding, dynpool, pd);
+	    // Allow a target to adjust dynamic symbol value.
+	    parameters->target().adjust_dyn_symbol(sym, pd);
+	  }
+      }
 
   // Write the target-specific symbols.
   for (std::vector<Symbol*>::const_iterator p = this->target_symbols_.begin();
@@ -3346,12 +3731,25 @@ Symbol_table::sized_write_section_symbol(const Output_section* os,
 void
 Symbol_table::print_stats() const
 {
+  size_t entries = 0;
+#if defined(HAVE_TR1_UNORDERED_MAP) || defined(HAVE_EXT_HASH_MAP)
+  size_t buckets = 0;
+#endif
+  for (Symbol_tables::const_iterator p = this->tables_.begin();
+       p != this->tables_.end();
+       ++p)
+    {
+      entries += p->size();
+#if defined(HAVE_TR1_UNORDERED_MAP) || defined(HAVE_EXT_HASH_MAP)
+      buckets += p->bucket_count();
+#endif
+    }
 #if defined(HAVE_TR1_UNORDERED_MAP) || defined(HAVE_EXT_HASH_MAP)
   fprintf(stderr, _("%s: symbol table entries: %zu; buckets: %zu\n"),
-	  program_name, this->table_.size(), this->table_.bucket_count());
+	  program_name, entries, buckets);
 #else
   fprintf(stderr, _("%s: symbol table entries: %zu\n"),
-	  program_name, this->table_.size());
+	  program_name, entries);
 #endif
   this->namepool_.print_stats("symbol table stringpool");
 }
@@ -3613,6 +4011,7 @@ Symbol_table::add_from_relobj<32, false>(
     size_t symndx_offset,
     const char* sym_names,
     size_t sym_name_size,
+    const Symbol_name_hash* name_hashes,
     Sized_relobj_file<32, false>::Symbols* sympointers,
     size_t* defined);
 #endif
@@ -3627,6 +4026,7 @@ Symbol_table::add_from_relobj<32, true>(
     size_t symndx_offset,
     const char* sym_names,
     size_t sym_name_size,
+    const Symbol_name_hash* name_hashes,
     Sized_relobj_file<32, true>::Symbols* sympointers,
     size_t* defined);
 #endif
@@ -3641,6 +4041,7 @@ Symbol_table::add_from_relobj<64, false>(
     size_t symndx_offset,
     const char* sym_names,
     size_t sym_name_size,
+    const Symbol_name_hash* name_hashes,
     Sized_relobj_file<64, false>::Symbols* sympointers,
     size_t* defined);
 #endif
@@ -3655,6 +4056,7 @@ Symbol_table::add_from_relobj<64, true>(
     size_t symndx_offset,
     const char* sym_names,
     size_t sym_name_size,
+    const Symbol_name_hash* name_hashes,
     Sized_relobj_file<64, true>::Symbols* sympointers,
     size_t* defined);
 #endif
@@ -1418,18 +1418,33 @@ class Symbol_table
   // Add COUNT external symbols from the relocatable object RELOBJ to
   // the symbol table.  SYMS is the symbols, SYMNDX_OFFSET is the
   // offset in the symbol table of the first symbol, SYM_NAMES is
-  // their names, SYM_NAME_SIZE is the size of SYM_NAMES.  This sets
-  // SYMPOINTERS to point to the symbols in the symbol table.  It sets
-  // *DEFINED to the number of defined symbols.
+  // their names, SYM_NAME_SIZE is the size of SYM_NAMES.
+  // NAME_HASHES, if not NULL, holds the precomputed lengths and hash
+  // codes of the names.  This sets SYMPOINTERS to point to the
+  // symbols in the symbol table.  It sets *DEFINED to the number of
+  // defined symbols.  With --concurrent-symbol-table this may just
+  // queue the symbols; SYMPOINTERS and *DEFINED are then set by
+  // add_queued_symbols.
   template<int size, bool big_endian>
   void
   add_from_relobj(Sized_relobj_file<size, big_endian>* relobj,
 		  const unsigned char* syms, size_t count,
 		  size_t symndx_offset, const char* sym_names,
 		  size_t sym_name_size,
+		  const Symbol_name_hash* name_hashes,
 		  typename Sized_relobj_file<size, big_endian>::Symbols*,
 		  size_t* defined);
 
+  // Add the symbols queued by add_from_relobj.  The symbols of each
+  // name are resolved in the order of the objects, but symbols with
+  // different names are resolved by several threads at once.  This
+  // must be called before looking at the symbols of the queued
+  // objects, or at anything else which they change, such as
+  // saw_undefined.  add_from_relobj and add_from_dynobj call it
+  // themselves before adding symbols which are not queued.
+  void
+  add_queued_symbols();
+
   // Add one external symbol from the plugin object OBJ to the symbol table.
   // Returns a pointer to the resolved symbol in the symbol table.
   template<int size, bool big_endian>
@@ -1532,7 +1547,10 @@ class Symbol_table
   // Return the count of undefined symbols seen.
   size_t
   saw_undefined() const
-  { return this->saw_undefined_; }
+  {
+    gold_assert(this->queued_relobjs_.empty());
+    return this->saw_undefined_;
+  }
 
   // Allocate the common symbols
   void
@@ -1646,13 +1664,17 @@ class Symbol_table
   void
   for_all_symbols(F f) const
   {
-    for (Symbol_table_type::const_iterator p = this->table_.begin();
-         p != this->table_.end();
-         ++p)
-      {
-	Sized_symbol<size>* sym = static_cast<Sized_symbol<size>*>(p->second);
-	f(sym);
-      }
+    for (Symbol_tables::const_iterator t = this->tables_.begin();
+	 t != this->tables_.end();
+	 ++t)
+      for (Symbol_table_type::const_iterator p = t->begin();
+	   p != t->end();
+	   ++p)
+	{
+	  Sized_symbol<size>* sym =
+	    static_cast<Sized_symbol<size>*>(p->second);
+	  f(sym);
+	}
   }
 
   // Dump statistical information to stderr.
@@ -1694,6 +1716,96 @@ class Symbol_table
   typedef Unordered_map<Symbol_table_key, Symbol*, Symbol_table_hash,
 			Symbol_table_eq> Symbol_table_type;
 
+  // With --concurrent-symbol-table there is a hash table for each
+  // shard of the namepool, holding the symbols whose names are in
+  // that shard.  Otherwise there is just one.
+  typedef std::vector<Symbol_table_type> Symbol_tables;
+
+  // The external symbols of a relocatable object queued by
+  // add_from_relobj.  The symbols and names are copied, since the
+  // views of the object are released before add_queued_symbols runs.
+  struct Queued_relobj
+  {
+    // The object.
+    Relobj* relobj;
+    // The external symbols.
+    std::vector<unsigned char> syms;
+    // The number of external symbols.
+    size_t count;
+    // The index of the first external symbol.
+    size_t symndx_offset;
+    // The symbol names.
+    std::string sym_names;
+    // The lengths and hash codes of the names.
+    std::vector<Symbol_name_hash> name_hashes;
+    // The first of COUNT ordinals reserved in NAMEPOOL_.
+    uint64_t first_ordinal;
+    // Where to store pointers to the symbols in the symbol table.
+    std::vector<Symbol*>* sympointers;
+    // Where to store the number of defined symbols.
+    size_t* defined;
+    // The indexes of the symbols, sorted by shard.  The symbols whose
+    // names are in shard I are SHARD_SYMNDX[SHARD_STARTS[I]] up to
+    // SHARD_SYMNDX[SHARD_STARTS[I + 1]].
+    std::vector<unsigned int> shard_symndx;
+    std::vector<size_t> shard_starts;
+    // The indexes of the symbols with a version in their name.
+    std::vector<unsigned int> versioned;
+  };
+
+  typedef std::vector<Queued_relobj*> Queued_relobjs;
+
+  // While add_queued_symbols runs, the lists which add_from_object
+  // and force_local would change, for the symbols of one shard.  They
+  // are appended to the lists in this object in shard order.
+  struct Symbol_shard
+  {
+    Symbol_shard()
+      : saw_undefined(0), commons(), tls_commons(), small_commons(),
+	large_commons(), forced_locals()
+    { }
+
+    size_t saw_undefined;
+    std::vector<Symbol*> commons;
+    std::vector<Symbol*> tls_commons;
+    std::vector<Symbol*> small_commons;
+    std::vector<Symbol*> large_commons;
+    std::vector<Symbol*> forced_locals;
+  };
+
+  // The Parallel_jobs used by add_queued_symbols.
+  template<int size, bool big_endian>
+  class Sort_queued_symbols_jobs;
+  template<int size, bool big_endian>
+  class Add_queued_symbols_jobs;
+
+  // Return the hash table which holds the symbols named by NAME_KEY.
+  Symbol_table_type&
+  name_table(Stringpool::Key name_key)
+  {
+    if (this->tables_.size() == 1)
+      return this->tables_[0];
+    return this->tables_[this->namepool_.key_shard_index(name_key)];
+  }
+
+  const Symbol_table_type&
+  name_table(Stringpool::Key name_key) const
+  {
+    if (this->tables_.size() == 1)
+      return this->tables_[0];
+    return this->tables_[this->namepool_.key_shard_index(name_key)];
+  }
+
+  // While add_queued_symbols runs, return the shard which holds the
+  // symbols named by NAME_KEY.  Otherwise return NULL.
+  Symbol_shard*
+  adding_shard(Stringpool::Key name_key)
+  {
+    if (this->adding_shards_ == NULL)
+      return NULL;
+    return &this->adding_shards_[this->namepool_.key_shard_index(name_key)];
+  }
+
   // A map from symbol name (as a pointer into the namepool) to all
   // the locations the symbols is (weakly) defined (and certain other
   // conditions are met).  This map will be used later to detect
@@ -1742,9 +1854,31 @@ class Symbol_table
   resolve(Sized_symbol<size>* to, const Sized_symbol<size>* from);
 
   // Record that a symbol is forced to be local by a version script or
-  // by visibility.
+  // by visibility.  SHARD is from adding_shard.
+  void
+  force_local(Symbol*, Symbol_shard* shard = NULL);
+
+  // Add the external symbol at P, the I'th of those given to
+  // add_from_relobj, using ORDINAL for its name.  Return whether it
+  // is defined in RELOBJ.
+  template<int size, bool big_endian>
+  bool
+  add_relobj_symbol(Sized_relobj_file<size, big_endian>* relobj,
+		    const unsigned char* p, size_t i, size_t symndx_offset,
+		    const char* sym_names, size_t sym_name_size,
+		    const Symbol_name_hash* name_hashes, uint64_t ordinal,
+		    typename Sized_relobj_file<size, big_endian>::Symbols*);
+
+  // Sort the symbols of a queued object by shard.
+  template<int size, bool big_endian>
+  void
+  sort_queued_symbols(Queued_relobj*) const;
+
+  // Add the symbols of the queued objects, specialized for size and
+  // endianness.
+  template<int size, bool big_endian>
   void
-  force_local(Symbol*);
+  sized_add_queued_symbols();
 
   // Adjust NAME and *NAME_KEY for wrapping.
   const char*
@@ -1932,11 +2066,21 @@ class Symbol_table
   unsigned int first_dynamic_global_index_;
   // The number of global dynamic symbols, or 0 if none.
   unsigned int dynamic_count_;
-  // The symbol hash table.
-  Symbol_table_type table_;
+  // The symbol hash tables.
+  Symbol_tables tables_;
   // A pool of symbol names.  This is used for all global symbols.
   // Entries in the hash table point into this pool.
   Stringpool namepool_;
+  // With --concurrent-symbol-table, the objects whose symbols have
+  // been queued by add_from_relobj, and the number of those symbols.
+  Queued_relobjs queued_relobjs_;
+  size_t queued_symbol_count_;
+  // While add_queued_symbols runs, the state of each shard.
+  Symbol_shard* adding_shards_;
+  // With --concurrent-symbol-table, the lock controlling the state
+  // shared by all shards: the forwarders, the garbage collection
+  // worklist and the version script.  NULL otherwise.
+  Lock* shared_lock_;
   // Forwarding symbols.
   Unordered_map<const Symbol*, Symbol*> forwarders_;
   // Weak aliases.  A symbol in this list points to the next alias.
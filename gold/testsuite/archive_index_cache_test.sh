@@ -0,0 +1,83 @@
+#!/bin/sh
+
+# archive_index_cache_test.sh -- test --archive-index-cache
+
+# Copyright (C) 2016 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The first link should write the index of the archive to the cache,
+# creating the cache directory.  The second link should read the
+# index from the cache.  The archive is touched before the third
+# link, so the cached index is out of date and should be written
+# again.  All three links should produce the same output as a link
+# without the cache.
+
+check()
+{
+    if ! grep -q "$2" "$1"
+    then
+	echo "Did not find expected output in $1:"
+	echo "   $2"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+check_missing()
+{
+    if grep -q "$2" "$1"
+    then
+	echo "Found unexpected output in $1:"
+	echo "   $2"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+check_cmp()
+{
+    if ! cmp -s "$1" "$2"
+    then
+	echo "$1 and $2 differ"
+	exit 1
+    fi
+}
+
+# Other archives, such as libgcc.a, use the cache too.
+wrote_index='Wrote archive index for ".*/archive_index_cache_test.a"'
+read_index='Read archive index for ".*/archive_index_cache_test.a"'
+
+check archive_index_cache_test_1.err "$wrote_index"
+check_missing archive_index_cache_test_1.err "$read_index"
+
+check archive_index_cache_test_2.err "$read_index"
+check_missing archive_index_cache_test_2.err "$wrote_index"
+
+check archive_index_cache_test_3.err "$wrote_index"
+check_missing archive_index_cache_test_3.err "$read_index"
+
+check_cmp archive_order_test archive_index_cache_test_1
+check_cmp archive_order_test archive_index_cache_test_2
+check_cmp archive_order_test archive_index_cache_test_3
+
+exit 0
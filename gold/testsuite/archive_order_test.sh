@@ -0,0 +1,41 @@
+#!/bin/sh
+
+# archive_order_test.sh -- test the order of archive members
+
+# Copyright (C) 2016 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# This file goes with archive_order_test_main.c.  The members of
+# archive_order_test.a must be included in the order 4, 1, 3, 2, the
+# order in which repeated passes over the archive symbol table would
+# include them.  Check that their functions appear in the output in
+# that order.
+
+order=`grep "archive_order_f[0-9]" archive_order_test.stdout \
+       | sed -e 's/.*archive_order_f\([0-9]\).*/\1/' | tr -d '\n'`
+
+if test "$order" != "4132"; then
+    echo "Wrong order of archive members: $order, expected 4132"
+    echo ""
+    echo "Actual output below:"
+    cat archive_order_test.stdout
+    exit 1
+fi
+
+exit 0
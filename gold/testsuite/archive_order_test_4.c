@@ -0,0 +1,31 @@
+/* archive_order_test_4.c -- part of a test case for gold
+
+   Copyright (C) 2016 Free Software Foundation, Inc.
+
+   This file is part of gold.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.
+
+   See archive_order_test_main.c.  */
+
+extern int archive_order_f1 (void);
+extern int archive_order_f3 (void);
+
+int
+archive_order_f4 (void)
+{
+  return archive_order_f3 () + archive_order_f1 () + 4;
+}
@@ -0,0 +1,40 @@
+/* archive_order_test_main.c -- a test case for gold
+
+   Copyright (C) 2016 Free Software Foundation, Inc.
+
+   This file is part of gold.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+   MA 02110-1301, USA.
+
+   This tests the order in which gold includes archive members.
+   archive_order_test.a holds archive_order_test_1.o through
+   archive_order_test_4.o, in that order.  The main program refers to
+   archive_order_f4, which refers to archive_order_f3 and
+   archive_order_f1; archive_order_f3 refers to archive_order_f2.
+
+   gold used to sweep the whole archive symbol table again after each
+   pass that included a member.  That includes member 4 in the first
+   pass, members 1 and 3 in the second pass, and member 2 in the third
+   pass.  The members must still be included in that order, so their
+   .text sections appear in the output in the order 4, 1, 3, 2.  */
+
+extern int archive_order_f4 (void);
+
+int
+main (void)
+{
+  return archive_order_f4 () == 10 ? 0 : 1;
+}
@@ -0,0 +1,62 @@
+#!/bin/sh
+
+# incremental_checksum_test.sh -- test that an incremental update
+# does not relink an input file which was touched but not changed.
+
+# Copyright (C) 2016 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# incremental_checksum_test.err holds the --debug=incremental,files
+# output of an incremental update after two_file_test_tmp_7.o was
+# touched.  The checksum recorded in the base file should show that
+# its contents did not change, so its contributions should be taken
+# from the base file instead of the file being opened as an input and
+# relinked.
+
+check()
+{
+    if ! grep -q "$2" "$1"
+    then
+	echo "Did not find expected output in $1:"
+	echo "   $2"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+check_missing()
+{
+    if grep -q "$2" "$1"
+    then
+	echo "Found unexpected output in $1:"
+	echo "   $2"
+	echo ""
+	echo "Actual output below:"
+	cat "$1"
+	exit 1
+    fi
+}
+
+check incremental_checksum_test.err "Incremental object: two_file_test_tmp_7.o, type 1"
+check incremental_checksum_test.err "two_file_test_tmp_7.o: contents unchanged"
+check_missing incremental_checksum_test.err "Attempt to open two_file_test_tmp_7.o succeeded"
+
+exit 0
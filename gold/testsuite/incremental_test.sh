@@ -74,6 +74,7 @@ awk '
     /^ / { print section, subsection, $0; }
 ' < incremental_test.stdout > incremental_test.dump
 
+check incremental_test.dump "Input files: .*incremental_test_1.o .*Checksum: [0-9a-f]*[1-9a-f]"
 check incremental_test.dump "Input sections: .* incremental_test_1.o  *1 "
 check incremental_test.dump "Input sections: .* incremental_test_2.o  *1 "
 check incremental_test.dump "Global symbol table: .* main  .* relocation type "
@@ -0,0 +1,45 @@
+#!/bin/sh
+
+# output_stdout_test.sh -- test -o - when stdout is a regular file
+
+# Copyright (C) 2016 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# output_stdout_test_append.out was written by "printf PREFIX" and then
+# a link with -o - appending to it, and output_stdout_test_offset.out
+# by "printf PREFIX" followed by a link with -o - to the same file
+# descriptor.  In both cases the linker output must follow the prefix
+# and be the same as output_stdout_test, linked with a file name.
+
+check()
+{
+    if test "`head -c 6 $1`" != "PREFIX"; then
+	echo "Prefix overwritten in $1"
+	exit 1
+    fi
+    if ! tail -c +7 $1 | cmp - output_stdout_test; then
+	echo "Linker output in $1 differs from output_stdout_test"
+	exit 1
+    fi
+}
+
+check output_stdout_test_append.out
+check output_stdout_test_offset.out
+
+exit 0
@@ -68,6 +68,11 @@ static ld_plugin_get_input_section_name get_input_section_name = NULL;
 static ld_plugin_get_input_section_contents get_input_section_contents = NULL;
 static ld_plugin_update_section_order update_section_order = NULL;
 static ld_plugin_allow_section_ordering allow_section_ordering = NULL;
+static ld_plugin_allow_concurrent_claim_file allow_concurrent_claim_file = NULL;
+
+/* The claim file hook may be called for several files at once, so
+   this protects the list of claimed files.  */
+static volatile int claimed_file_lock = 0;
 
 #define MAXOPTS 10
 
@@ -158,6 +163,10 @@ onload(struct ld_plugin_tv *tv)
 	case LDPT_ALLOW_SECTION_ORDERING:
 	  allow_section_ordering = *entry->tv_u.tv_allow_section_ordering;
 	  break;
+	case LDPT_ALLOW_CONCURRENT_CLAIM_FILE:
+	  allow_concurrent_claim_file =
+	    *entry->tv_u.tv_allow_concurrent_claim_file;
+	  break;
         default:
           break;
         }
@@ -199,6 +208,16 @@ onload(struct ld_plugin_tv *tv)
       return LDPS_ERR;
     }
 
+  if (allow_concurrent_claim_file != NULL)
+    {
+      if ((*allow_concurrent_claim_file)() != LDPS_OK)
+        {
+          (*message)(LDPL_ERROR, "error allowing concurrent claim file");
+          return LDPS_ERR;
+        }
+      (*message)(LDPL_INFO, "concurrent claim file allowed");
+    }
+
   if ((*register_all_symbols_read_hook)(all_symbols_read_hook) != LDPS_OK)
     {
       (*message)(LDPL_ERROR, "error registering all symbols read hook");
@@ -389,11 +408,14 @@ claim_file_hook (const struct ld_plugin_input_file* file, int* claimed)
   claimed_file->nsyms = nsyms;
   claimed_file->syms = syms;
   claimed_file->next = NULL;
+  while (__sync_lock_test_and_set(&claimed_file_lock, 1))
+    ;
   if (last_claimed_file == NULL)
     first_claimed_file = claimed_file;
   else
     last_claimed_file->next = claimed_file;
   last_claimed_file = claimed_file;
+  __sync_lock_release(&claimed_file_lock);
 
   (*message)(LDPL_INFO, "%s: claiming file, adding %d symbols",
              file->name, nsyms);
@@ -0,0 +1,77 @@
+#!/bin/sh
+
+# trace_tasks_test.sh -- test --trace-tasks
+
+# Copyright (C) 2016 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# The link that produces trace_tasks_test.json uses
+# --trace-tasks=trace_tasks_test.json.  Check that the file is a JSON
+# object in the Chrome trace format: a traceEvents array holding one
+# complete ("X") event per task and the metadata naming the process
+# and threads, one object per line, separated by commas.
+
+file=trace_tasks_test.json
+
+fail()
+{
+    echo "$1"
+    echo ""
+    echo "Actual output below:"
+    cat $file
+    exit 1
+}
+
+string='"([^"\\]|\\.)*"'
+event="{\"name\":$string,\"cat\":\"task\",\"ph\":\"X\",\"pid\":1,\"tid\":[0-9]+,\"ts\":[0-9]+,\"dur\":[0-9]+(,\"args\":{\"blocker\":$string})?}"
+process="{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":$string}}"
+thread="{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":[0-9]+,\"args\":{\"name\":$string}}"
+
+if test "`sed -n -e '1p' $file`" != '{"traceEvents":['; then
+    fail "Missing traceEvents array at the start of $file"
+fi
+
+if test "`sed -n -e '$p' $file`" != '],"displayTimeUnit":"ms"}'; then
+    fail "Missing end of traceEvents array at the end of $file"
+fi
+
+# Every line but the first, the last and the one before it is an
+# element followed by a comma.  The one before the last has no comma.
+lines=`wc -l < $file`
+body=`expr $lines - 2`
+last=`expr $lines - 1`
+if sed -n -e "2,${body}p" $file \
+   | egrep -v "^($event|$process|$thread),\$" > /dev/null; then
+    fail "Malformed trace event in $file"
+fi
+if sed -n -e "${last}p" $file | egrep -v "^$thread\$" > /dev/null; then
+    fail "Malformed last trace event in $file"
+fi
+
+if ! egrep "^$event,\$" $file > /dev/null; then
+    fail "No task events in $file"
+fi
+if ! egrep "\"name\":\"Relocate_task " $file > /dev/null; then
+    fail "No Relocate_task event in $file"
+fi
+if ! egrep "^$process,\$" $file > /dev/null; then
+    fail "No process name in $file"
+fi
+
+exit 0
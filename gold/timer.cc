@@ -23,6 +23,7 @@
 #include "gold.h"
 
 #include <unistd.h>
+#include <sys/time.h>
 
 #ifdef HAVE_TIMES
 #include <sys/times.h>
@@ -104,6 +105,15 @@ Timer::get_time(TimeStats *now)
 #endif
 }
 
+// Return the current wall clock time in microseconds.
+long long
+Timer::current_wall_usec()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return static_cast<long long>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
 // Return the stats since start was called.
 Timer::TimeStats
 Timer::get_elapsed_time()
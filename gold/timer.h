@@ -60,6 +60,12 @@ class Timer
   void
   stamp(int n);
 
+  // Return the current wall clock time in microseconds.  This is
+  // finer grained than the wall time in TimeStats, and is meant for
+  // measuring short intervals such as lock waits.
+  static long long
+  current_wall_usec();
+
  private:
   // This class cannot be copied.
   Timer(const Timer&);
@@ -24,6 +24,7 @@
 #define GOLD_WORKQUEUE_INTERNAL_H
 
 #include <queue>
+#include <deque>
 #include <csignal>
 
 #include "gold-threads.h"
@@ -58,6 +59,16 @@ class Workqueue_threader
   virtual bool
   should_cancel_thread(int thread_number) = 0;
 
+  // Return whether runnable tasks should be kept on per-thread run
+  // queues, with idle threads stealing work from busy ones.
+  virtual bool
+  use_run_queues() const = 0;
+
+  // Return the thread number of the calling thread.  Threads which
+  // are not running the workqueue are treated as thread 0.
+  virtual int
+  current_thread_number() const = 0;
+
  protected:
   // Get the Workqueue.
   Workqueue*
@@ -86,10 +97,18 @@ class Workqueue_threader_threadpool : public Workqueue_threader
   bool
   should_cancel_thread(int thread_number);
 
+  // We always use per-thread run queues.
+  bool
+  use_run_queues() const
+  { return true; }
+
+  // Return the thread number of the calling thread.
+  int
+  current_thread_number() const;
+
   // Process all tasks.  This keeps running until told to cancel.
   void
-  process(int thread_number)
-  { this->get_workqueue()->process(thread_number); }
+  process(int thread_number);
 
  private:
   // This is set if we need to check the thread count.
@@ -104,6 +123,92 @@ class Workqueue_threader_threadpool : public Workqueue_threader
   int threads_;
 };
 
+// A queue of runnable tasks owned by a single thread.  This is used
+// by the threaded workqueue.  When a running task makes other tasks
+// runnable, they are added to the run queue of the thread which ran
+// it.  The owning thread takes tasks from the front of its queue
+// without holding the Workqueue lock.  A thread with an empty run
+// queue steals work from the other threads while holding the
+// Workqueue lock; it takes tasks which should run soon first, and
+// otherwise takes from the back of the queue, away from the owner.
+
+class Workqueue_run_queue
+{
+ public:
+  Workqueue_run_queue()
+    : lock_(), first_tasks_(), tasks_()
+  { }
+
+  // Add a runnable task.  If FRONT is true, put it at the front of
+  // its queue.
+  void
+  push(Task* t, bool front)
+  {
+    Hold_lock hl(this->lock_);
+    std::deque<Task*>* q = (t->should_run_soon()
+			    ? &this->first_tasks_
+			    : &this->tasks_);
+    if (front)
+      q->push_front(t);
+    else
+      q->push_back(t);
+  }
+
+  // Remove and return the next task for the owning thread, or NULL
+  // if the queue is empty.
+  Task*
+  pop()
+  {
+    Hold_lock hl(this->lock_);
+    return this->pop_locked(false);
+  }
+
+  // Remove and return a task for some other thread, or NULL if the
+  // queue is empty.
+  Task*
+  steal()
+  {
+    Hold_lock hl(this->lock_);
+    return this->pop_locked(true);
+  }
+
+ private:
+  Workqueue_run_queue(const Workqueue_run_queue&);
+  Workqueue_run_queue& operator=(const Workqueue_run_queue&);
+
+  Task*
+  pop_locked(bool from_back)
+  {
+    Task* t;
+    if (!this->first_tasks_.empty())
+      {
+	t = this->first_tasks_.front();
+	this->first_tasks_.pop_front();
+      }
+    else if (this->tasks_.empty())
+      t = NULL;
+    else if (from_back)
+      {
+	t = this->tasks_.back();
+	this->tasks_.pop_back();
+      }
+    else
+      {
+	t = this->tasks_.front();
+	this->tasks_.pop_front();
+      }
+    return t;
+  }
+
+  // Lock controlling access to the queues.  This may be acquired
+  // while holding the Workqueue lock, but not the other way around.
+  Lock lock_;
+  // Tasks which should run soon.
+  std::deque<Task*> first_tasks_;
+  // Other tasks.
+  std::deque<Task*> tasks_;
+};
+
 } // End namespace gold.
 
 #endif // !defined(GOLD_WORKQUEUE_INTERNAL_H)
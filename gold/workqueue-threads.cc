@@ -124,6 +124,27 @@ Workqueue_thread::thread_body(void* arg)
 
 // Class Workqueue_threader_threadpool.
 
+// The key for the thread-specific data which records the thread
+// number of each workqueue thread, plus one.  This is how a Task
+// running on a thread finds that thread's run queue when it queues
+// more Tasks.
+
+static pthread_key_t thread_number_key;
+static pthread_once_t thread_number_key_once = PTHREAD_ONCE_INIT;
+
+extern "C"
+{
+
+static void
+create_thread_number_key()
+{
+  int err = pthread_key_create(&thread_number_key, NULL);
+  if (err != 0)
+    gold_fatal(_("pthread_key_create failed: %s"), strerror(err));
+}
+
+}
+
 // Constructor.
 
 Workqueue_threader_threadpool::Workqueue_threader_threadpool(
@@ -134,6 +155,9 @@ Workqueue_threader_threadpool::Workqueue_threader_threadpool(
     desired_thread_count_(1),
     threads_(1)
 {
+  int err = pthread_once(&thread_number_key_once, create_thread_number_key);
+  if (err != 0)
+    gold_fatal(_("pthread_once failed: %s"), strerror(err));
 }
 
 // Destructor.
@@ -171,6 +195,33 @@ Workqueue_threader_threadpool::set_thread_count(int thread_count)
     }
 }
 
+// Return the thread number of the calling thread.  The main thread
+// never sets the key, so it is thread 0.
+
+int
+Workqueue_threader_threadpool::current_thread_number() const
+{
+  void* p = pthread_getspecific(thread_number_key);
+  if (p == NULL)
+    return 0;
+  return reinterpret_cast<intptr_t>(p) - 1;
+}
+
+// Process all tasks, recording the thread number so that tasks can
+// find their run queue.
+
+void
+Workqueue_threader_threadpool::process(int thread_number)
+{
+  intptr_t key_value = static_cast<intptr_t>(thread_number) + 1;
+  int err = pthread_setspecific(thread_number_key,
+				reinterpret_cast<void*>(key_value));
+  if (err != 0)
+    gold_fatal(_("pthread_setspecific failed: %s"), strerror(err));
+
+  this->get_workqueue()->process(thread_number);
+}
+
 // Return whether the current thread should be cancelled.
 
 bool
@@ -22,6 +22,9 @@
 
 #include "gold.h"
 
+#include <cerrno>
+#include <cstring>
+
 #include "debug.h"
 #include "options.h"
 #include "timer.h"
@@ -112,6 +115,14 @@ class Workqueue_threader_single : public Workqueue_threader
   bool
   should_cancel_thread(int)
   { return false; }
+
+  bool
+  use_run_queues() const
+  { return false; }
+
+  int
+  current_thread_number() const
+  { return 0; }
 };
 
 // Workqueue methods.
@@ -123,8 +134,25 @@ Workqueue::Workqueue(const General_options& options)
     running_(0),
     waiting_(0),
     condvar_(this->lock_),
-    threader_(NULL)
+    idle_(0),
+    run_queues_(),
+    active_(0),
+    tasks_run_(0),
+    tasks_stolen_(0),
+    lock_acquisitions_(0),
+    lock_contentions_(0),
+    lock_wait_usec_(0),
+    idle_usec_(0),
+    trace_events_(),
+    trace_start_usec_(0),
+    threader_(NULL),
+    use_run_queues_(false),
+    collect_stats_(options.stats()),
+    trace_tasks_(options.user_set_trace_tasks())
 {
+  if (this->trace_tasks_)
+    this->trace_start_usec_ = Timer::current_wall_usec();
+
   bool threads = options.threads();
 #ifndef ENABLE_THREADS
   threads = false;
@@ -139,10 +167,121 @@ Workqueue::Workqueue(const General_options& options)
       gold_unreachable();
 #endif
     }
+  this->use_run_queues_ = this->threader_->use_run_queues();
 }
 
 Workqueue::~Workqueue()
 {
+  for (std::vector<Workqueue_run_queue*>::iterator p =
+	 this->run_queues_.begin();
+       p != this->run_queues_.end();
+       ++p)
+    delete *p;
+}
+
+// Acquire the Workqueue lock.  When collecting statistics, first try
+// to get the lock without blocking, so that we can tell how often and
+// for how long threads wait for it.
+
+inline void
+Workqueue::acquire_lock()
+{
+  if (!this->collect_stats_)
+    this->lock_.acquire();
+  else if (!this->lock_.try_acquire())
+    {
+      long long start = Timer::current_wall_usec();
+      this->lock_.acquire();
+      ++this->lock_contentions_;
+      this->lock_wait_usec_ += Timer::current_wall_usec() - start;
+    }
+  ++this->lock_acquisitions_;
+}
+
+// Queue T on TOKEN, which blocks it.  The workqueue lock must be held
+// when this is called.
+
+inline void
+Workqueue::add_waiting(Task_token* token, Task* t, bool front)
+{
+  if (front)
+    token->add_waiting_front(t);
+  else
+    token->add_waiting(t);
+  t->set_blocker(token);
+  ++this->waiting_;
+}
+
+// Return the run queue for THREAD_NUMBER, creating it if it does not
+// exist yet.  The workqueue lock must be held when this is called.
+
+Workqueue_run_queue*
+Workqueue::run_queue(int thread_number)
+{
+  gold_assert(thread_number >= 0);
+  while (this->run_queues_.size() <= static_cast<size_t>(thread_number))
+    this->run_queues_.push_back(new Workqueue_run_queue());
+  return this->run_queues_[thread_number];
+}
+
+// Add the runnable task T to the run queue of the current thread, and
+// wake up an idle thread to steal it if there is one.  The workqueue
+// lock must be held when this is called.
+
+void
+Workqueue::push_runnable(Task* t, bool front)
+{
+  int thread_number = this->threader_->current_thread_number();
+  this->run_queue(thread_number)->push(t, front);
+  ++this->active_;
+  if (this->idle_ > 0)
+    this->condvar_.signal();
+}
+
+// T was taken from a run queue.  Check that it can still run, since a
+// write lock it needs may have been taken since it was queued.  If it
+// can not run, add it to the list for the blocking Token and return
+// NULL.  The workqueue lock must be held when this is called.
+
+Task*
+Workqueue::check_runnable(Task* t)
+{
+  gold_assert(this->use_run_queues_);
+  Task_token* token = t->is_runnable();
+  if (token == NULL)
+    return t;
+  this->add_waiting(token, t, false);
+  --this->active_;
+  return NULL;
+}
+
+// Find a runnable task on the run queues, starting with the queue of
+// THREAD_NUMBER, and then stealing from the other threads.  Return
+// NULL if none could be found.  The workqueue lock must be held when
+// this is called.
+
+Task*
+Workqueue::steal_runnable(int thread_number)
+{
+  size_t count = this->run_queues_.size();
+  for (size_t i = 0; i < count; ++i)
+    {
+      size_t n = (thread_number + i) % count;
+      Workqueue_run_queue* rq = this->run_queues_[n];
+      bool is_own = i == 0 && static_cast<size_t>(thread_number) < count;
+      Task* t;
+      while ((t = is_own ? rq->pop() : rq->steal()) != NULL)
+	{
+	  t = this->check_runnable(t);
+	  if (t != NULL)
+	    {
+	      if (!is_own)
+		++this->tasks_stolen_;
+	      return t;
+	    }
+	}
+    }
+  return NULL;
 }
 
 // Add a task to the end of a specific queue, or put it on the list
@@ -151,17 +290,13 @@ Workqueue::~Workqueue()
 void
 Workqueue::add_to_queue(Task_list* queue, Task* t, bool front)
 {
-  Hold_lock hl(this->lock_);
+  Hold_workqueue_lock hl(this);
 
   Task_token* token = t->is_runnable();
   if (token != NULL)
-    {
-      if (front)
-	token->add_waiting_front(t);
-      else
-	token->add_waiting(t);
-      ++this->waiting_;
-    }
+    this->add_waiting(token, t, front);
+  else if (this->use_run_queues_)
+    this->push_runnable(t, front);
   else
     {
       if (front)
@@ -222,8 +357,7 @@ Workqueue::find_runnable_in_list(Task_list* tasks)
       if (token == NULL)
 	return t;
 
-      token->add_waiting(t);
-      ++this->waiting_;
+      this->add_waiting(token, t, false);
     }
 
   // We couldn't find any runnable task.
@@ -234,8 +368,11 @@ Workqueue::find_runnable_in_list(Task_list* tasks)
 // workqueue lock must be held when this is called.
 
 Task*
-Workqueue::find_runnable()
+Workqueue::find_runnable(int thread_number)
 {
+  if (this->use_run_queues_)
+    return this->steal_runnable(thread_number);
+
   Task* t = this->find_runnable_in_list(&this->first_tasks_);
   if (t == NULL)
     t = this->find_runnable_in_list(&this->tasks_);
@@ -249,13 +386,18 @@ Workqueue::find_runnable()
 Task*
 Workqueue::find_runnable_or_wait(int thread_number)
 {
-  Task* t = this->find_runnable();
+  Task* t = this->find_runnable(thread_number);
 
   while (t == NULL)
     {
-      if (this->running_ == 0
-	  && this->first_tasks_.empty()
-	  && this->tasks_.empty())
+      bool done;
+      if (this->use_run_queues_)
+	done = this->active_ == 0;
+      else
+	done = (this->running_ == 0
+		&& this->first_tasks_.empty()
+		&& this->tasks_.empty());
+      if (done)
 	{
 	  // Kick all the threads to make them exit.
 	  this->condvar_.broadcast();
@@ -269,11 +411,18 @@ Workqueue::find_runnable_or_wait(int thread_number)
 
       gold_debug(DEBUG_TASK, "%3d sleeping", thread_number);
 
+      ++this->idle_;
+      long long start = this->collect_stats_ ? Timer::current_wall_usec() : 0;
+
       this->condvar_.wait();
 
+      if (this->collect_stats_)
+	this->idle_usec_ += Timer::current_wall_usec() - start;
+      --this->idle_;
+
       gold_debug(DEBUG_TASK, "%3d awake", thread_number);
 
-      t = this->find_runnable();
+      t = this->find_runnable(thread_number);
     }
 
   return t;
@@ -283,19 +432,29 @@ Workqueue::find_runnable_or_wait(int thread_number)
 // to become available.  If we run a task, and it frees up another
 // runnable task, then run that one too.  This returns true if we
 // should look for another task, false if we are cancelling this
-// thread.
+// thread.  RQ is the run queue of this thread, or NULL if we are not
+// using run queues.
 
 bool
-Workqueue::find_and_run_task(int thread_number)
+Workqueue::find_and_run_task(int thread_number, Workqueue_run_queue* rq)
 {
-  Task* t;
+  Task* t = NULL;
   Task_locker tl;
 
+  // Take a task from our own run queue before acquiring the
+  // Workqueue lock, to keep the time we hold that lock short.
+  if (rq != NULL)
+    t = rq->pop();
+
   {
-    Hold_lock hl(this->lock_);
+    Hold_workqueue_lock hl(this);
+
+    if (t != NULL)
+      t = this->check_runnable(t);
 
     // Find a runnable task.
-    t = this->find_runnable_or_wait(thread_number);
+    if (t == NULL)
+      t = this->find_runnable_or_wait(thread_number);
 
     if (t == NULL)
       return false;
@@ -316,8 +475,21 @@ Workqueue::find_and_run_task(int thread_number)
       if (is_debugging_enabled(DEBUG_TASK))
         timer.start();
 
+      long long trace_start = 0;
+      if (this->trace_tasks_)
+	{
+	  // Get the name before running the Task, as it may refer to
+	  // data which the Task frees.
+	  t->name();
+	  trace_start = Timer::current_wall_usec();
+	}
+
       t->run(this);
 
+      long long trace_end = 0;
+      if (this->trace_tasks_)
+	trace_end = Timer::current_wall_usec();
+
       if (is_debugging_enabled(DEBUG_TASK))
         {
           Timer::TimeStats elapsed = timer.get_elapsed_time();
@@ -333,16 +505,35 @@ Workqueue::find_and_run_task(int thread_number)
 
       Task* next;
       {
-	Hold_lock hl(this->lock_);
+	Hold_workqueue_lock hl(this);
 
 	--this->running_;
+	++this->tasks_run_;
+	if (this->use_run_queues_)
+	  --this->active_;
+
+	if (this->trace_tasks_)
+	  {
+	    Trace_event ev;
+	    ev.name = t->name();
+	    ev.thread_number = thread_number;
+	    ev.start_usec = trace_start - this->trace_start_usec_;
+	    ev.end_usec = trace_end - this->trace_start_usec_;
+	    ev.blocker = t->blocker();
+	    this->trace_events_.push_back(ev);
+	  }
 
 	// Release the locks for the task.  This must be done with the
 	// workqueue lock held.  Get the next Task to run if any.
 	next = this->release_locks(t, &tl);
 
+	// A Task returned by release_locks did not go through a run
+	// queue, so it is not yet counted as active.
+	if (next != NULL && this->use_run_queues_)
+	  ++this->active_;
+
 	if (next == NULL)
-	  next = this->find_runnable();
+	  next = this->find_runnable(thread_number);
 
 	// If we have another Task to run, get the Locks.  This must
 	// be called while we are still holding the Workqueue lock.
@@ -400,8 +591,7 @@ Workqueue::return_or_queue(Task* t, bool is_blocker, Task** pret)
 
   if (token != NULL)
     {
-      token->add_waiting(t);
-      ++this->waiting_;
+      this->add_waiting(token, t, false);
       return false;
     }
 
@@ -414,7 +604,9 @@ Workqueue::return_or_queue(Task* t, bool is_blocker, Task** pret)
     should_return = true;
   else if (t->should_run_soon())
     should_return = true;
-  else if (!this->first_tasks_.empty() || !this->tasks_.empty())
+  else if (this->use_run_queues_
+	   ? this->active_ > this->running_
+	   : !this->first_tasks_.empty() || !this->tasks_.empty())
     should_queue = true;
   else
     should_return = true;
@@ -427,6 +619,11 @@ Workqueue::return_or_queue(Task* t, bool is_blocker, Task** pret)
     }
   else if (should_queue)
     {
+      if (this->use_run_queues_)
+	{
+	  this->push_runnable(t, false);
+	  return false;
+	}
       if (t->should_run_soon())
 	this->first_tasks_.push_back(t);
       else
@@ -492,7 +689,14 @@ Workqueue::release_locks(Task* t, Task_locker* tl)
 void
 Workqueue::process(int thread_number)
 {
-  while (this->find_and_run_task(thread_number))
+  Workqueue_run_queue* rq = NULL;
+  if (this->use_run_queues_)
+    {
+      Hold_lock hl(this->lock_);
+      rq = this->run_queue(thread_number);
+    }
+
+  while (this->find_and_run_task(thread_number, rq))
     ;
 }
 
@@ -518,4 +722,103 @@ Workqueue::add_blocker(Task_token* token)
   token->add_blocker();
 }
 
+// Print statistical information to stderr.  This is used for --stats.
+
+void
+Workqueue::print_stats() const
+{
+  fprintf(stderr, _("%s: workqueue tasks run: %u\n"),
+	  program_name, this->tasks_run_);
+  if (!this->use_run_queues_)
+    return;
+  fprintf(stderr, _("%s: workqueue run queues: %zu\n"),
+	  program_name, this->run_queues_.size());
+  fprintf(stderr, _("%s: workqueue tasks stolen: %u\n"),
+	  program_name, this->tasks_stolen_);
+  fprintf(stderr, _("%s: workqueue thread idle time: %lld.%06lld\n"),
+	  program_name, this->idle_usec_ / 1000000,
+	  this->idle_usec_ % 1000000);
+  fprintf(stderr, _("%s: workqueue lock acquisitions: %u; contended: %u\n"),
+	  program_name, this->lock_acquisitions_, this->lock_contentions_);
+  fprintf(stderr, _("%s: workqueue lock wait time: %lld.%06lld\n"),
+	  program_name, this->lock_wait_usec_ / 1000000,
+	  this->lock_wait_usec_ % 1000000);
+}
+
+// Write S to F as a JSON string.
+
+static void
+write_json_string(FILE* f, const std::string& s)
+{
+  putc('"', f);
+  for (std::string::const_iterator p = s.begin(); p != s.end(); ++p)
+    {
+      unsigned char c = *p;
+      if (c == '"' || c == '\\')
+	fprintf(f, "\\%c", c);
+      else if (c < 0x20)
+	fprintf(f, "\\u%04x", c);
+      else
+	putc(c, f);
+    }
+  putc('"', f);
+}
+
+// Write the tasks run to the file named by --trace-tasks, in the
+// Chrome trace event format, which can be loaded into chrome://tracing
+// or Perfetto.  Each Task is a complete event on the track of the
+// thread which ran it.  The token which last blocked the Task, if any,
+// is recorded as an argument, so that the Tasks which wait for the
+// same token can be found.
+
+void
+Workqueue::write_trace() const
+{
+  if (!this->trace_tasks_)
+    return;
+
+  const char* filename = parameters->options().trace_tasks();
+  FILE* f = fopen(filename, "w");
+  if (f == NULL)
+    {
+      gold_error(_("cannot open task trace file %s: %s"), filename,
+		 strerror(errno));
+      return;
+    }
+
+  fprintf(f, "{\"traceEvents\":[\n");
+  int max_thread = 0;
+  for (std::vector<Trace_event>::const_iterator p =
+	 this->trace_events_.begin();
+       p != this->trace_events_.end();
+       ++p)
+    {
+      fprintf(f, "{\"name\":");
+      write_json_string(f, p->name);
+      fprintf(f, ",\"cat\":\"task\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,"
+	      "\"ts\":%lld,\"dur\":%lld",
+	      p->thread_number, p->start_usec, p->end_usec - p->start_usec);
+      if (p->blocker != NULL)
+	fprintf(f, ",\"args\":{\"blocker\":\"%p\"}",
+		static_cast<const void*>(p->blocker));
+      fprintf(f, "},\n");
+      if (p->thread_number > max_thread)
+	max_thread = p->thread_number;
+    }
+
+  // Name the process and thread tracks.
+  fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+	  "\"args\":{\"name\":");
+  write_json_string(f, program_name);
+  fprintf(f, "}}");
+  for (int i = 0; i <= max_thread; ++i)
+    fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+	    "\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}", i, i);
+  fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+  if (fclose(f) != 0)
+    gold_error(_("cannot write task trace file %s: %s"), filename,
+	       strerror(errno));
+}
+
 } // End namespace gold.
@@ -28,6 +28,7 @@
 #define GOLD_WORKQUEUE_H
 
 #include <string>
+#include <vector>
 
 #include "gold-threads.h"
 #include "token.h"
@@ -45,7 +46,7 @@ class Task
 {
  public:
   Task()
-    : list_next_(NULL), name_(), should_run_soon_(false)
+    : list_next_(NULL), name_(), blocker_(NULL), should_run_soon_(false)
   { }
   virtual ~Task()
   { }
@@ -96,6 +97,18 @@ class Task
   clear_list_next()
   { this->list_next_ = NULL; }
 
+  // Return the last token which blocked this Task, or NULL if it
+  // never had to wait.  This is only used for --trace-tasks.
+  const Task_token*
+  blocker() const
+  { return this->blocker_; }
+
+  // Record that this Task is waiting for TOKEN.  Called by Workqueue
+  // with the workqueue lock held.
+  void
+  set_blocker(const Task_token* token)
+  { this->blocker_ = token; }
+
   // Return the name of the Task.  This is only used for debugging
   // purposes.
   const std::string&
@@ -124,6 +137,8 @@ class Task
   Task* list_next_;
   // Task name, for debugging purposes.
   std::string name_;
+  // The last token this Task waited for, for --trace-tasks.
+  const Task_token* blocker_;
   // Whether this Task should be executed soon.  This is used for
   // Tasks which can be run after some data is read.
   bool should_run_soon_;
@@ -194,6 +209,7 @@ class Task_function : public Task
 // The workqueue itself.
 
 class Workqueue_threader;
+class Workqueue_run_queue;
 
 class Workqueue
 {
@@ -233,11 +249,62 @@ class Workqueue
   void
   add_blocker(Task_token*);
 
+  // Print statistical information to stderr.  This is used for
+  // --stats.
+  void
+  print_stats() const;
+
+  // Write the task trace for --trace-tasks.
+  void
+  write_trace() const;
+
  private:
   // This class can not be copied.
   Workqueue(const Workqueue&);
   Workqueue& operator=(const Workqueue&);
 
+  // RAII for the Workqueue lock which records lock contention when
+  // collecting statistics.
+  class Hold_workqueue_lock
+  {
+   public:
+    Hold_workqueue_lock(Workqueue* workqueue)
+      : workqueue_(workqueue)
+    { workqueue->acquire_lock(); }
+
+    ~Hold_workqueue_lock()
+    { this->workqueue_->lock_.release(); }
+
+   private:
+    Hold_workqueue_lock(const Hold_workqueue_lock&);
+    Hold_workqueue_lock& operator=(const Hold_workqueue_lock&);
+
+    Workqueue* workqueue_;
+  };
+
+  friend class Hold_workqueue_lock;
+
+  // Acquire the Workqueue lock.
+  void
+  acquire_lock();
+
+  // Return the run queue for a thread, creating it if necessary.
+  Workqueue_run_queue*
+  run_queue(int thread_number);
+
+  // Add a runnable task to the run queue of the current thread.
+  void
+  push_runnable(Task*, bool front);
+
+  // If T can run, return it.  Otherwise queue it on the token which
+  // blocks it and return NULL.
+  Task*
+  check_runnable(Task* t);
+
+  // Steal a runnable task from any run queue.
+  Task*
+  steal_runnable(int thread_number);
+
   // Add a task to a queue.
   void
   add_to_queue(Task_list* queue, Task* t, bool front);
@@ -248,7 +315,7 @@ class Workqueue
 
   // Find a runnable task.
   Task*
-  find_runnable();
+  find_runnable(int thread_number);
 
   // Find a runnable task in a list.
   Task*
@@ -256,12 +323,16 @@ class Workqueue
 
   // Find an run a task.
   bool
-  find_and_run_task(int);
+  find_and_run_task(int, Workqueue_run_queue*);
 
   // Release the locks for a Task.  Return the next Task to run.
   Task*
   release_locks(Task*, Task_locker*);
 
+  // Queue T on TOKEN, which blocks it.
+  void
+  add_waiting(Task_token* token, Task* t, bool front);
+
   // Store T into *PRET, or queue it as appropriate.
   bool
   return_or_queue(Task* t, bool is_blocker, Task** pret);
@@ -284,10 +355,60 @@ class Workqueue
   // Condition variable associated with lock_.  This is signalled when
   // there may be a new Task to execute.
   Condvar condvar_;
+  // Number of threads waiting on condvar_.
+  int idle_;
+  // Per-thread queues of runnable tasks, indexed by thread number.
+  // These are used instead of first_tasks_ and tasks_ when
+  // use_run_queues_ is true.
+  std::vector<Workqueue_run_queue*> run_queues_;
+  // Number of tasks which are either on a run queue or running.
+  // This is only used with run queues.
+  int active_;
+
+  // Statistics, protected by lock_.  Times are only collected for
+  // --stats.
+  // Number of tasks run.
+  unsigned int tasks_run_;
+  // Number of tasks stolen from the run queue of another thread.
+  unsigned int tasks_stolen_;
+  // Number of times the Workqueue lock was acquired.
+  unsigned int lock_acquisitions_;
+  // Number of times the Workqueue lock was held by another thread
+  // when we tried to acquire it.
+  unsigned int lock_contentions_;
+  // Microseconds spent waiting for the Workqueue lock.
+  long long lock_wait_usec_;
+  // Microseconds spent by threads waiting for a task to run.
+  long long idle_usec_;
+
+  // A task run, recorded for --trace-tasks.
+  struct Trace_event
+  {
+    // The name of the Task.
+    std::string name;
+    // The thread which ran it.
+    int thread_number;
+    // Start and end times, in microseconds since trace_start_usec_.
+    long long start_usec;
+    long long end_usec;
+    // The last token the Task waited for, or NULL.
+    const Task_token* blocker;
+  };
+
+  // Tasks run, protected by lock_.  Only used for --trace-tasks.
+  std::vector<Trace_event> trace_events_;
+  // Time at which the Workqueue was created.
+  long long trace_start_usec_;
 
   // The threading implementation.  This is set at construction time
   // and not changed thereafter.
   Workqueue_threader* threader_;
+  // Whether the threader uses per-thread run queues.
+  bool use_run_queues_;
+  // Whether to collect times for --stats.
+  bool collect_stats_;
+  // Whether to record task runs for --trace-tasks.
+  bool trace_tasks_;
 };
 
 } // End namespace gold.
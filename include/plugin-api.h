@@ -365,6 +365,16 @@ enum ld_plugin_status
 (*ld_plugin_get_input_section_size) (const struct ld_plugin_section section,
                                      uint64_t *secsize);
 
+/* The linker's interface for declaring that the plugin's claim-file
+   handler may be called for different input files at the same time,
+   from different threads.  Callbacks made from the handler then refer
+   only to the file being claimed.  The plugin must call this function
+   when it is first loaded.  */
+
+typedef
+enum ld_plugin_status
+(*ld_plugin_allow_concurrent_claim_file) (void);
+
 enum ld_plugin_level
 {
   LDPL_INFO,
@@ -407,7 +417,8 @@ enum ld_plugin_tag
   LDPT_UNIQUE_SEGMENT_FOR_SECTIONS = 27,
   LDPT_GET_SYMBOLS_V3 = 28,
   LDPT_GET_INPUT_SECTION_ALIGNMENT = 29,
-  LDPT_GET_INPUT_SECTION_SIZE = 30
+  LDPT_GET_INPUT_SECTION_SIZE = 30,
+  LDPT_ALLOW_CONCURRENT_CLAIM_FILE = 31
 };
 
 /* The plugin transfer vector.  */
@@ -441,6 +452,7 @@ struct ld_plugin_tv
     ld_plugin_unique_segment_for_sections tv_unique_segment_for_sections;
     ld_plugin_get_input_section_alignment tv_get_input_section_alignment;
     ld_plugin_get_input_section_size tv_get_input_section_size;
+    ld_plugin_allow_concurrent_claim_file tv_allow_concurrent_claim_file;
   } tv_u;
 };
 